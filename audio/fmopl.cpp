@@ -23,6 +23,7 @@
 #include "audio/fmopl.h"
 
 #include "audio/mixer.h"
+#include "audio/trace.h"
 #include "audio/softsynth/opl/dosbox.h"
 #include "audio/softsynth/opl/mame.h"
 
@@ -51,12 +52,15 @@ enum OplEmulator {
 	kALSA = 3
 };
 
-OPL::OPL() {
+OPL::OPL() : _isInstance(true) {
 	if (_hasInstance)
 		error("There are multiple OPL output instances running");
 	_hasInstance = true;
 }
 
+OPL::OPL(ForwardingTag) : _isInstance(false) {
+}
+
 const Config::EmulatorDescription Config::_drivers[] = {
 	{ "auto", "<default>", kAuto, kFlagOpl2 | kFlagDualOpl2 | kFlagOpl3 },
 	{ "mame", _s("MAME OPL emulator"), kMame, kFlagOpl2 },
@@ -165,30 +169,41 @@ OPL *Config::create(DriverId driver, OplType type) {
 		}
 	}
 
+	OPL *opl = 0;
+
 	switch (driver) {
 	case kMame:
 		if (type == kOpl2)
-			return new MAME::OPL();
+			opl = new MAME::OPL();
 		else
 			warning("MAME OPL emulator only supports OPL2 emulation");
-		return 0;
+		break;
 
 #ifndef DISABLE_DOSBOX_OPL
 	case kDOSBox:
-		return new DOSBox::OPL(type);
+		opl = new DOSBox::OPL(type);
+		break;
 #endif
 
 #ifdef USE_ALSA
 	case kALSA:
-		return ALSA::create(type);
+		opl = ALSA::create(type);
+		break;
 #endif
 
 	default:
 		warning("Unsupported OPL emulator %d", driver);
 		// TODO: Maybe we should add some dummy emulator too, which just outputs
 		// silence as sound?
-		return 0;
+		break;
 	}
+
+	// Record what the engine sends to the chip, if requested
+	Audio::TraceRecorder *recorder = Audio::TraceRecorder::getConfigured();
+	if (opl && recorder)
+		opl = recorder->wrapOPL(opl, type);
+
+	return opl;
 }
 
 void OPL::start(TimerCallback *callback, int timerFrequency) {
@@ -117,9 +117,13 @@ typedef Common::Functor0<void> TimerCallback;
 class OPL {
 private:
 	static bool _hasInstance;
+	const bool _isInstance;
 public:
 	OPL();
-	virtual ~OPL() { _hasInstance = false; }
+	virtual ~OPL() {
+		if (_isInstance)
+			_hasInstance = false;
+	}
 
 	/**
 	 * Initializes the OPL emulator.
@@ -184,6 +188,13 @@ public:
 	};
 
 protected:
+	/**
+	 * Constructor for OPLs which forward everything to another OPL
+	 * instance, and thus do not count as an instance of their own.
+	 */
+	struct ForwardingTag {};
+	explicit OPL(ForwardingTag);
+
 	/**
 	 * Start the callbacks.
 	 */
@@ -31,6 +31,7 @@
 #include "gui/message.h"
 #include "audio/mididrv.h"
 #include "audio/musicplugin.h"
+#include "audio/trace.h"
 
 const byte MidiDriver::_mt32ToGm[128] = {
 //	  0    1    2    3    4    5    6    7    8    9    A    B    C    D    E    F
@@ -371,6 +372,11 @@ MidiDriver *MidiDriver::createMidi(MidiDriver::DeviceHandle handle) {
 			(**m)->createInstance(&driver, handle);
 	}
 
+	// Record what the engine sends to the driver, if requested
+	Audio::TraceRecorder *recorder = Audio::TraceRecorder::getConfigured();
+	if (driver && recorder)
+		driver = recorder->wrapMidiDriver(driver);
+
 	return driver;
 }
 
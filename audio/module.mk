@@ -16,7 +16,10 @@ MODULE_OBJS := \
 	mpu401.o \
 	musicplugin.o \
 	null.o \
+	rate_mix.o \
 	timestamp.o \
+	trace.o \
+	trace_replay.o \
 	decoders/3do.o \
 	decoders/aac.o \
 	decoders/adpcm.o \
@@ -65,6 +65,49 @@ static inline void clampedAdd(int16& a, int b) {
 #endif
 }
 
+/**
+ * Scales a block of sample frames by the given left/right volumes and adds
+ * them, clamped, to an interleaved stereo output buffer. This is the inner
+ * loop shared by all rate converters.
+ *
+ * @param obuf   output buffer, receiving 2 * frames samples
+ * @param in     input frames, one sample each for mono, two for stereo
+ * @param frames number of frames to mix
+ * @param vol_l  left volume, 0 - Mixer::kMaxMixerVolume
+ * @param vol_r  right volume, 0 - Mixer::kMaxMixerVolume
+ */
+typedef void (*MixProc)(st_sample_t *obuf, const st_sample_t *in, st_size_t frames, st_volume_t vol_l, st_volume_t vol_r);
+
+/**
+ * Implementations of the mixing inner loop. All of them produce exactly
+ * the same output as the scalar one, which is kept as the reference.
+ */
+enum MixKernel {
+	kMixKernelScalar,
+	kMixKernelSSE2,
+	kMixKernelAVX2,
+	kMixKernelNEON,
+
+	kMixKernelCount
+};
+
+/**
+ * Return the fastest mix kernel which is compiled in and supported by the
+ * CPU we are running on. The result is determined once and then cached.
+ */
+MixKernel getBestMixKernel();
+
+/**
+ * Return a human readable name of the specified mix kernel.
+ */
+const char *getMixKernelName(MixKernel kernel);
+
+/**
+ * Return the mix procedure of the specified kernel for the given channel
+ * layout, or 0 if the kernel is not available on this CPU.
+ */
+MixProc getMixProc(MixKernel kernel, bool stereo, bool reverseStereo);
+
 class RateConverter {
 public:
 	RateConverter() {}
@@ -80,6 +123,12 @@ public:
 
 RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo = false);
 
+/**
+ * Create a RateConverter which mixes using the specified kernel instead of
+ * the best available one. Meant for tests and benchmarks.
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, MixKernel kernel);
+
 } // End of namespace Audio
 
 #endif
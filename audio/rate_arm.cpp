@@ -477,4 +477,11 @@ RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stere
 	}
 }
 
+/**
+ * The ARM assembler routines do their own mixing, so the kernel is ignored.
+ */
+RateConverter *makeRateConverter(st_rate_t inrate, st_rate_t outrate, bool stereo, bool reverseStereo, MixKernel kernel) {
+	return makeRateConverter(inrate, outrate, stereo, reverseStereo);
+}
+
 } // End of namespace Audio
@@ -0,0 +1,289 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Volume scaling and clamped accumulation of sample frames into the mixer
+ * output buffer, the inner loop of all rate converters.
+ *
+ * Every vector kernel reproduces the scalar one bit for bit: the product of
+ * sample and volume is divided by kMaxMixerVolume rounding towards zero,
+ * just like the C division does, and the accumulation saturates exactly
+ * like clampedAdd(). The SIMD kernels rely on kMaxMixerVolume being 256.
+ */
+
+// Allow use of the compiler intrinsic headers
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "audio/rate.h"
+#include "audio/mixer.h"
+
+// The vector kernels only produce signed samples
+#ifndef OUTPUT_UNSIGNED_AUDIO
+#include "common/cpu-features.h"
+#endif
+
+namespace Audio {
+
+template<bool stereo, bool reverseStereo>
+static void mixScalar(st_sample_t *obuf, const st_sample_t *in, st_size_t frames, st_volume_t vol_l, st_volume_t vol_r) {
+	for (; frames > 0; --frames) {
+		st_sample_t out0, out1;
+		out0 = *in++;
+		out1 = (stereo ? *in++ : out0);
+
+		// output left channel
+		clampedAdd(obuf[reverseStereo    ], (out0 * (int)vol_l) / Audio::Mixer::kMaxMixerVolume);
+
+		// output right channel
+		clampedAdd(obuf[reverseStereo ^ 1], (out1 * (int)vol_r) / Audio::Mixer::kMaxMixerVolume);
+
+		obuf += 2;
+	}
+}
+
+#pragma mark -
+
+#ifdef SIMD_SSE2
+
+/**
+ * Multiply eight samples by eight volumes and divide by 256, rounding
+ * towards zero.
+ */
+SIMD_TARGET("sse2") static inline __m128i scaleSSE2(__m128i samples, __m128i volumes) {
+	const __m128i lo = _mm_mullo_epi16(samples, volumes);
+	const __m128i hi = _mm_mulhi_epi16(samples, volumes);
+	__m128i p0 = _mm_unpacklo_epi16(lo, hi);
+	__m128i p1 = _mm_unpackhi_epi16(lo, hi);
+
+	// Add 255 to negative products, so the shift truncates like a division
+	const __m128i bias = _mm_set1_epi32(255);
+	p0 = _mm_srai_epi32(_mm_add_epi32(p0, _mm_and_si128(_mm_srai_epi32(p0, 31), bias)), 8);
+	p1 = _mm_srai_epi32(_mm_add_epi32(p1, _mm_and_si128(_mm_srai_epi32(p1, 31), bias)), 8);
+
+	return _mm_packs_epi32(p0, p1);
+}
+
+template<bool stereo, bool reverseStereo>
+SIMD_TARGET("sse2") static void mixSSE2(st_sample_t *obuf, const st_sample_t *in, st_size_t frames, st_volume_t vol_l, st_volume_t vol_r) {
+	const __m128i volumes = _mm_set1_epi32((int)(vol_l | (vol_r << 16)));
+
+	if (stereo) {
+		for (; frames >= 4; frames -= 4) {
+			__m128i out = scaleSSE2(_mm_loadu_si128((const __m128i *)in), volumes);
+			if (reverseStereo) {
+				out = _mm_shufflelo_epi16(out, _MM_SHUFFLE(2, 3, 0, 1));
+				out = _mm_shufflehi_epi16(out, _MM_SHUFFLE(2, 3, 0, 1));
+			}
+			_mm_storeu_si128((__m128i *)obuf, _mm_adds_epi16(_mm_loadu_si128((const __m128i *)obuf), out));
+			in += 8;
+			obuf += 8;
+		}
+	} else {
+		for (; frames >= 8; frames -= 8) {
+			const __m128i samples = _mm_loadu_si128((const __m128i *)in);
+			const __m128i out0 = scaleSSE2(_mm_unpacklo_epi16(samples, samples), volumes);
+			const __m128i out1 = scaleSSE2(_mm_unpackhi_epi16(samples, samples), volumes);
+			_mm_storeu_si128((__m128i *)obuf, _mm_adds_epi16(_mm_loadu_si128((const __m128i *)obuf), out0));
+			_mm_storeu_si128((__m128i *)(obuf + 8), _mm_adds_epi16(_mm_loadu_si128((const __m128i *)(obuf + 8)), out1));
+			in += 8;
+			obuf += 16;
+		}
+	}
+
+	mixScalar<stereo, reverseStereo>(obuf, in, frames, vol_l, vol_r);
+}
+
+#endif // SIMD_SSE2
+
+#ifdef SIMD_AVX2
+
+/**
+ * The AVX2 counterpart of scaleSSE2(). Unpacking and packing both work
+ * within 128 bit lanes, so the sample order is preserved.
+ */
+SIMD_TARGET("avx2") static inline __m256i scaleAVX2(__m256i samples, __m256i volumes) {
+	const __m256i lo = _mm256_mullo_epi16(samples, volumes);
+	const __m256i hi = _mm256_mulhi_epi16(samples, volumes);
+	__m256i p0 = _mm256_unpacklo_epi16(lo, hi);
+	__m256i p1 = _mm256_unpackhi_epi16(lo, hi);
+
+	const __m256i bias = _mm256_set1_epi32(255);
+	p0 = _mm256_srai_epi32(_mm256_add_epi32(p0, _mm256_and_si256(_mm256_srai_epi32(p0, 31), bias)), 8);
+	p1 = _mm256_srai_epi32(_mm256_add_epi32(p1, _mm256_and_si256(_mm256_srai_epi32(p1, 31), bias)), 8);
+
+	return _mm256_packs_epi32(p0, p1);
+}
+
+template<bool stereo, bool reverseStereo>
+SIMD_TARGET("avx2") static void mixAVX2(st_sample_t *obuf, const st_sample_t *in, st_size_t frames, st_volume_t vol_l, st_volume_t vol_r) {
+	const __m256i volumes = _mm256_set1_epi32((int)(vol_l | (vol_r << 16)));
+
+	if (stereo) {
+		for (; frames >= 8; frames -= 8) {
+			__m256i out = scaleAVX2(_mm256_loadu_si256((const __m256i *)in), volumes);
+			if (reverseStereo) {
+				out = _mm256_shufflelo_epi16(out, _MM_SHUFFLE(2, 3, 0, 1));
+				out = _mm256_shufflehi_epi16(out, _MM_SHUFFLE(2, 3, 0, 1));
+			}
+			_mm256_storeu_si256((__m256i *)obuf, _mm256_adds_epi16(_mm256_loadu_si256((const __m256i *)obuf), out));
+			in += 16;
+			obuf += 16;
+		}
+	} else {
+		for (; frames >= 8; frames -= 8) {
+			// Put samples 0-3 into the low lane and 4-7 into the high lane,
+			// then duplicate each of them within its lane
+			__m256i samples = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)in));
+			samples = _mm256_permute4x64_epi64(samples, 0x50);
+			const __m256i out = scaleAVX2(_mm256_unpacklo_epi16(samples, samples), volumes);
+			_mm256_storeu_si256((__m256i *)obuf, _mm256_adds_epi16(_mm256_loadu_si256((const __m256i *)obuf), out));
+			in += 8;
+			obuf += 16;
+		}
+	}
+
+	mixScalar<stereo, reverseStereo>(obuf, in, frames, vol_l, vol_r);
+}
+
+#endif // SIMD_AVX2
+
+#ifdef SIMD_NEON
+
+/**
+ * Multiply four samples by four volumes and divide by 256, rounding
+ * towards zero.
+ */
+static inline int16x4_t scaleNEON(int16x4_t samples, int16x4_t volumes) {
+	int32x4_t p = vmull_s16(samples, volumes);
+	// Add 255 to negative products, so the shift truncates like a division
+	p = vaddq_s32(p, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(vshrq_n_s32(p, 31)), 24)));
+	return vmovn_s32(vshrq_n_s32(p, 8));
+}
+
+template<bool stereo, bool reverseStereo>
+static void mixNEON(st_sample_t *obuf, const st_sample_t *in, st_size_t frames, st_volume_t vol_l, st_volume_t vol_r) {
+	const int16x4_t volumes = vreinterpret_s16_s32(vdup_n_s32((int)(vol_l | (vol_r << 16))));
+
+	if (stereo) {
+		for (; frames >= 4; frames -= 4) {
+			const int16x8_t samples = vld1q_s16(in);
+			int16x8_t out = vcombine_s16(scaleNEON(vget_low_s16(samples), volumes), scaleNEON(vget_high_s16(samples), volumes));
+			if (reverseStereo)
+				out = vrev32q_s16(out);
+			vst1q_s16(obuf, vqaddq_s16(vld1q_s16(obuf), out));
+			in += 8;
+			obuf += 8;
+		}
+	} else {
+		for (; frames >= 4; frames -= 4) {
+			const int16x4x2_t samples = vzip_s16(vld1_s16(in), vld1_s16(in));
+			const int16x8_t out = vcombine_s16(scaleNEON(samples.val[0], volumes), scaleNEON(samples.val[1], volumes));
+			vst1q_s16(obuf, vqaddq_s16(vld1q_s16(obuf), out));
+			in += 4;
+			obuf += 8;
+		}
+	}
+
+	mixScalar<stereo, reverseStereo>(obuf, in, frames, vol_l, vol_r);
+}
+
+#endif // SIMD_NEON
+
+#pragma mark -
+
+static bool isMixKernelSupported(MixKernel kernel) {
+	switch (kernel) {
+	case kMixKernelScalar:
+		return true;
+#ifdef SIMD_SSE2
+	case kMixKernelSSE2:
+		return Audio::Mixer::kMaxMixerVolume == 256 && SIMD_CPU_SUPPORTS("sse2");
+#endif
+#ifdef SIMD_AVX2
+	case kMixKernelAVX2:
+		return Audio::Mixer::kMaxMixerVolume == 256 && SIMD_CPU_SUPPORTS("avx2");
+#endif
+#ifdef SIMD_NEON
+	case kMixKernelNEON:
+		return Audio::Mixer::kMaxMixerVolume == 256;
+#endif
+	default:
+		return false;
+	}
+}
+
+MixKernel getBestMixKernel() {
+	static int best = -1;
+
+	if (best < 0) {
+		int kernel = kMixKernelCount - 1;
+		while (!isMixKernelSupported((MixKernel)kernel))
+			--kernel;
+		best = kernel;
+	}
+
+	return (MixKernel)best;
+}
+
+const char *getMixKernelName(MixKernel kernel) {
+	switch (kernel) {
+	case kMixKernelScalar:
+		return "scalar";
+	case kMixKernelSSE2:
+		return "SSE2";
+	case kMixKernelAVX2:
+		return "AVX2";
+	case kMixKernelNEON:
+		return "NEON";
+	default:
+		return "unknown";
+	}
+}
+
+#define MIX_PROC(name) \
+	(stereo ? (reverseStereo ? &name<true, true> : &name<true, false>) : &name<false, false>)
+
+MixProc getMixProc(MixKernel kernel, bool stereo, bool reverseStereo) {
+	if (!isMixKernelSupported(kernel))
+		return 0;
+
+	switch (kernel) {
+#ifdef SIMD_SSE2
+	case kMixKernelSSE2:
+		return MIX_PROC(mixSSE2);
+#endif
+#ifdef SIMD_AVX2
+	case kMixKernelAVX2:
+		return MIX_PROC(mixAVX2);
+#endif
+#ifdef SIMD_NEON
+	case kMixKernelNEON:
+		return MIX_PROC(mixNEON);
+#endif
+	default:
+		return MIX_PROC(mixScalar);
+	}
+}
+
+#undef MIX_PROC
+
+} // End of namespace Audio
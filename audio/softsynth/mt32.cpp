@@ -35,12 +35,14 @@
 #include "common/config-manager.h"
 #include "common/debug.h"
 #include "common/error.h"
+#include "common/list.h"
 #include "common/events.h"
 #include "common/file.h"
 #include "common/system.h"
 #include "common/util.h"
 #include "common/archive.h"
 #include "common/textconsole.h"
+#include "common/threadpool.h"
 #include "common/translation.h"
 
 #include "graphics/fontman.h"
@@ -102,6 +104,54 @@ private:
 
 	int _outputRate;
 
+	enum {
+		/** Frames rendered ahead of the mixer, which is also the added MIDI latency */
+		kRenderAheadFrames = 2048,
+		/** Frames rendered by the worker thread at once */
+		kRenderChunkFrames = 256,
+		/** Room for the MIDI events sent within the render-ahead time */
+		kRenderAheadQueueSize = 4096
+	};
+
+	// Render-ahead mode: a worker thread renders into a ring buffer, from
+	// which generateSamples() only copies. The ring positions count frames
+	// since open(), and everything but the ring contents is guarded by
+	// _renderMutex.
+	Common::NativeThread _renderThread;
+	Common::NativeMutex _renderMutex;
+	Common::NativeCondition _renderCond;
+	Common::NativeCondition _readCond;
+	Common::NativeMutex _midiMutex;
+
+	/** An event which did not fit into the event queue of the synth */
+	struct PendingEvent {
+		uint32 timestamp;
+		uint32 msg;
+		/** Framed SysEx data, or NULL for a short message */
+		byte *sysex;
+		uint32 sysexLength;
+	};
+
+	/**
+	 * The events waiting for room in the event queue, oldest first. The
+	 * worker adds them after rendering each chunk. Guarded by _midiMutex.
+	 */
+	Common::List<PendingEvent> _pendingEvents;
+
+	int16 *_ring;
+	uint32 _ringWritePos;
+	uint32 _ringReadPos;
+	bool _stopRendering;
+
+	bool startRenderThread();
+	void stopRenderThread();
+	static void renderThreadProc(void *data);
+	void renderAhead();
+	uint32 getRenderAheadTimestamp();
+	bool queueEvent(const PendingEvent &event);
+	void queueRenderAheadEvent(uint32 msg, const byte *sysex, uint32 sysexLength);
+	void queuePendingEvents();
+
 protected:
 	void generateSamples(int16 *buf, int len);
 
@@ -143,6 +193,11 @@ MidiDriver_MT32::MidiDriver_MT32(Audio::Mixer *mixer) : MidiDriver_Emulated(mixe
 	_outputRate = 0;
 	_initializing = false;
 
+	_ring = NULL;
+	_ringWritePos = 0;
+	_ringReadPos = 0;
+	_stopRendering = false;
+
 	// Initialized in open()
 	_controlROM = NULL;
 	_pcmROM = NULL;
@@ -151,6 +206,7 @@ MidiDriver_MT32::MidiDriver_MT32(Audio::Mixer *mixer) : MidiDriver_Emulated(mixe
 }
 
 MidiDriver_MT32::~MidiDriver_MT32() {
+	stopRenderThread();
 	deleteMuntStructures();
 }
 
@@ -221,6 +277,14 @@ int MidiDriver_MT32::open() {
 	_outputRate = _synth->getStereoOutputSampleRate();
 	MidiDriver_Emulated::open();
 
+	// Move rendering off the mixer thread, if we have a core to spare
+	if (ConfMan.getBool("mt32_render_ahead") && Common::ThreadPool::getCPUCount() > 1) {
+		if (startRenderThread())
+			debug(4, "MT32emu: Rendering %d frames ahead on a worker thread", kRenderAheadFrames);
+		else
+			warning("MT32emu: Could not start the render thread, rendering on the mixer thread");
+	}
+
 	_initializing = false;
 
 	if (screenFormat.bytesPerPixel > 1)
@@ -236,7 +300,14 @@ int MidiDriver_MT32::open() {
 }
 
 void MidiDriver_MT32::send(uint32 b) {
-	_synth->playMsg(b);
+	if (_renderThread.isRunning()) {
+		queueRenderAheadEvent(b, NULL, 0);
+	} else if (!_synth->playMsg(b)) {
+		// The queue is full. Without a delay, its events are due anyway, so
+		// play them right away to make room.
+		_synth->flushMIDIQueue();
+		_synth->playMsg(b);
+	}
 }
 
 void MidiDriver_MT32::setPitchBendRange(byte channel, uint range) {
@@ -257,8 +328,24 @@ void MidiDriver_MT32::setPitchBendRange(byte channel, uint range) {
 }
 
 void MidiDriver_MT32::sysEx(const byte *msg, uint16 length) {
-	if (msg[0] == 0xf0) {
-		_synth->playSysex(msg, length);
+	if (_renderThread.isRunning()) {
+		if (msg[0] == 0xf0) {
+			queueRenderAheadEvent(0, msg, length);
+		} else {
+			// Only the event queue is safe to use from this thread, and it
+			// wants framed messages
+			byte *framed = new byte[length + 2];
+			framed[0] = 0xf0;
+			memcpy(framed + 1, msg, length);
+			framed[length + 1] = 0xf7;
+			queueRenderAheadEvent(0, framed, length + 2);
+			delete[] framed;
+		}
+	} else if (msg[0] == 0xf0) {
+		if (!_synth->playSysex(msg, length)) {
+			_synth->flushMIDIQueue();
+			_synth->playSysex(msg, length);
+		}
 	} else {
 		_synth->playSysexWithoutFraming(msg, length);
 	}
@@ -274,12 +361,159 @@ void MidiDriver_MT32::close() {
 	// Detach the mixer callback handler
 	_mixer->stopHandle(_mixerSoundHandle);
 
+	stopRenderThread();
 	_synth->close();
 	deleteMuntStructures();
 }
 
 void MidiDriver_MT32::generateSamples(int16 *data, int len) {
-	_synth->render(data, len);
+	if (!_renderThread.isRunning()) {
+		_synth->render(data, len);
+		return;
+	}
+
+	Common::NativeStackLock lock(_renderMutex);
+	while (len > 0) {
+		const uint32 available = _ringWritePos - _ringReadPos;
+		if (!available) {
+			// The worker fell behind, wait for it rather than skipping
+			_readCond.wait(_renderMutex);
+			continue;
+		}
+
+		const uint32 start = _ringReadPos & (kRenderAheadFrames - 1);
+		const uint32 frames = MIN<uint32>(MIN<uint32>(available, kRenderAheadFrames - start), len);
+		memcpy(data, _ring + start * 2, frames * 2 * sizeof(int16));
+
+		_ringReadPos += frames;
+		data += frames * 2;
+		len -= frames;
+
+		if (kRenderAheadFrames - (_ringWritePos - _ringReadPos) >= kRenderChunkFrames)
+			_renderCond.signal();
+	}
+}
+
+bool MidiDriver_MT32::startRenderThread() {
+	// The queue is flushed on resize, so this has to happen before any
+	// events are sent
+	_synth->setMIDIEventQueueSize(kRenderAheadQueueSize);
+
+	_ring = new int16[kRenderAheadFrames * 2];
+	_ringWritePos = 0;
+	_ringReadPos = 0;
+	_stopRendering = false;
+
+	if (!_renderThread.start(renderThreadProc, this)) {
+		delete[] _ring;
+		_ring = NULL;
+		return false;
+	}
+
+	return true;
+}
+
+void MidiDriver_MT32::stopRenderThread() {
+	if (!_renderThread.isRunning())
+		return;
+
+	_renderMutex.lock();
+	_stopRendering = true;
+	_renderCond.signal();
+	_renderMutex.unlock();
+
+	_renderThread.join();
+
+	for (Common::List<PendingEvent>::iterator i = _pendingEvents.begin(); i != _pendingEvents.end(); ++i)
+		delete[] i->sysex;
+	_pendingEvents.clear();
+
+	delete[] _ring;
+	_ring = NULL;
+}
+
+void MidiDriver_MT32::renderThreadProc(void *data) {
+	((MidiDriver_MT32 *)data)->renderAhead();
+}
+
+void MidiDriver_MT32::renderAhead() {
+	Common::NativeStackLock lock(_renderMutex);
+	while (!_stopRendering) {
+		if (kRenderAheadFrames - (_ringWritePos - _ringReadPos) < kRenderChunkFrames) {
+			_renderCond.wait(_renderMutex);
+			continue;
+		}
+
+		// The chunk is outside of the part the mixer reads from, so it can
+		// be rendered unlocked
+		const uint32 start = _ringWritePos & (kRenderAheadFrames - 1);
+		_renderMutex.unlock();
+		_synth->render(_ring + start * 2, kRenderChunkFrames);
+		_midiMutex.lock();
+		queuePendingEvents();
+		_midiMutex.unlock();
+		_renderMutex.lock();
+
+		_ringWritePos += kRenderChunkFrames;
+		_readCond.signal();
+	}
+}
+
+/**
+ * Returns the synth timestamp for a MIDI event sent now. It is as far
+ * ahead of the mixer as the worker may render, so that the event is played
+ * exactly kRenderAheadFrames after the sample which the mixer is at.
+ */
+uint32 MidiDriver_MT32::getRenderAheadTimestamp() {
+	Common::NativeStackLock lock(_renderMutex);
+	const uint32 frame = _ringReadPos + kRenderAheadFrames;
+
+	// Synth timestamps count samples at the native rate, which differs from
+	// the output rate in the analog emulation modes which upsample
+	if ((uint)_outputRate == MT32Emu::SAMPLE_RATE)
+		return frame;
+	return (uint32)((uint64)frame * MT32Emu::SAMPLE_RATE / _outputRate);
+}
+
+bool MidiDriver_MT32::queueEvent(const PendingEvent &event) {
+	if (event.sysex)
+		return _synth->playSysex(event.sysex, event.sysexLength, event.timestamp);
+	return _synth->playMsg(event.msg, event.timestamp);
+}
+
+/**
+ * Adds an event to the event queue of the synth in render-ahead mode. If the
+ * queue is full, the event waits in _pendingEvents until the worker has
+ * played some. Waiting here instead could block the mixer thread, on which
+ * the music timers run, while the worker waits for the mixer.
+ */
+void MidiDriver_MT32::queueRenderAheadEvent(uint32 msg, const byte *sysex, uint32 sysexLength) {
+	Common::NativeStackLock lock(_midiMutex);
+
+	PendingEvent event;
+	event.timestamp = getRenderAheadTimestamp();
+	event.msg = msg;
+	event.sysex = const_cast<byte *>(sysex);
+	event.sysexLength = sysexLength;
+
+	// Later events must not overtake the pending ones
+	queuePendingEvents();
+	if (_pendingEvents.empty() && queueEvent(event))
+		return;
+
+	if (sysex) {
+		event.sysex = new byte[sysexLength];
+		memcpy(event.sysex, sysex, sysexLength);
+	}
+	_pendingEvents.push_back(event);
+}
+
+/** Moves as many pending events as fit into the event queue of the synth. Called locked. */
+void MidiDriver_MT32::queuePendingEvents() {
+	while (!_pendingEvents.empty() && queueEvent(_pendingEvents.front())) {
+		delete[] _pendingEvents.front().sysex;
+		_pendingEvents.pop_front();
+	}
 }
 
 uint32 MidiDriver_MT32::property(int prop, uint32 param) {
@@ -18,6 +18,7 @@
 //#include <cstring>
 #include "mt32emu.h"
 #include "BReverbModel.h"
+#include "VectorOps.h"
 
 // Analysing of state of reverb RAM address lines gives exact sizes of the buffers of filters used. This also indicates that
 // the reverb model implemented in the real devices consists of three series allpass filters preceded by a non-feedback comb (or a delay with a LPF)
@@ -34,6 +35,9 @@ static const Bit32u PROCESS_DELAY = 1;
 static const Bit32u MODE_3_ADDITIONAL_DELAY = 1;
 static const Bit32u MODE_3_FEEDBACK_DELAY = 1;
 
+// Number of samples processed at once by the block based path. Must not exceed the length of the shortest filter.
+static const Bit32u BLOCK_LENGTH = 64;
+
 // Default reverb settings for "new" reverb model implemented in CM-32L / LAPC-I.
 // Found by tracing reverb RAM data lines (thanks go to Lord_Nightmare & balrog).
 const BReverbSettings &BReverbModel::getCM32L_LAPCSettings(const ReverbMode mode) {
@@ -252,6 +256,27 @@ Sample AllpassFilter::process(const Sample in) {
 #endif
 }
 
+#if !MT32EMU_USE_FLOAT_SAMPLES
+void AllpassFilter::processBlock(Sample *io, Bit32u length) {
+	// Each sample only depends on the buffer contents stored a full filter length ago,
+	// so every contiguous run of the ring can be processed at once
+	while (length > 0) {
+		Bit32u start = index + 1;
+		if (start >= size) {
+			start = 0;
+		}
+		Bit32u run = size - start;
+		if (run > length) {
+			run = length;
+		}
+		VectorOps::allpass(buffer + start, io, run);
+		index = start + run - 1;
+		io += run;
+		length -= run;
+	}
+}
+#endif
+
 CombFilter::CombFilter(const Bit32u useSize, const Bit32u useFilterFactor) : RingBuffer(useSize), filterFactor(useFilterFactor) {}
 
 void CombFilter::process(const Sample in) {
@@ -271,6 +296,28 @@ Sample CombFilter::getOutputAt(const Bit32u outIndex) const {
 	return buffer[(size + index - outIndex) % size];
 }
 
+void CombFilter::processBlock(const Sample *in, const Bit32u length) {
+	for (Bit32u i = 0; i < length; i++) {
+		CombFilter::process(in[i]);
+	}
+}
+
+void CombFilter::getOutputsAt(Sample *out, const Bit32u length, const Bit32u outIndex, const bool afterProcess, const bool blockProcessed) const {
+	// The position read for sample i lies "delay" samples before the one stored by that sample. Those samples that read
+	// positions stored earlier than the block are picked up beforehand, the rest are only there once the block is processed.
+	const Bit32s delay = Bit32s(outIndex % size) - (afterProcess ? 1 : 0);
+	const Bit32u firstStored = delay < 0 ? 0 : Bit32u(delay) + 1;
+	if (!blockProcessed) {
+		for (Bit32u i = 0; i < length && i < firstStored; i++) {
+			out[i] = getOutputAt(Bit32u(delay) - i);
+		}
+	} else {
+		for (Bit32u i = firstStored; i < length; i++) {
+			out[i] = getOutputAt(Bit32u(Bit32s(length - i) + delay));
+		}
+	}
+}
+
 void CombFilter::setFeedbackFactor(const Bit32u useFeedbackFactor) {
 	feedbackFactor = useFeedbackFactor;
 }
@@ -292,6 +339,12 @@ void DelayWithLowPassFilter::process(const Sample in) {
 	buffer[index] = weirdMul(lpfOut, amp, 0xFF);
 }
 
+void DelayWithLowPassFilter::processBlock(const Sample *in, const Bit32u length) {
+	for (Bit32u i = 0; i < length; i++) {
+		DelayWithLowPassFilter::process(in[i]);
+	}
+}
+
 TapDelayCombFilter::TapDelayCombFilter(const Bit32u useSize, const Bit32u useFilterFactor) : CombFilter(useSize, useFilterFactor) {}
 
 void TapDelayCombFilter::process(const Sample in) {
@@ -431,6 +484,70 @@ bool BReverbModel::isMT32Compatible(const ReverbMode mode) const {
 }
 
 void BReverbModel::process(const Sample *inLeft, const Sample *inRight, Sample *outLeft, Sample *outRight, unsigned long numSamples) {
+#if !MT32EMU_USE_FLOAT_SAMPLES && !MT32EMU_BOSS_REVERB_PRECISE_MODE
+	if (combs != NULL && !tapDelayMode) {
+		while (numSamples > 0) {
+			const Bit32u length = numSamples < BLOCK_LENGTH ? Bit32u(numSamples) : BLOCK_LENGTH;
+			processBlock(inLeft, inRight, outLeft, outRight, length);
+			inLeft += length;
+			inRight += length;
+			if (outLeft != NULL) {
+				outLeft += length;
+			}
+			if (outRight != NULL) {
+				outRight += length;
+			}
+			numSamples -= length;
+		}
+		return;
+	}
+#endif
+	processReference(inLeft, inRight, outLeft, outRight, numSamples);
+}
+
+#if !MT32EMU_USE_FLOAT_SAMPLES
+void BReverbModel::processBlock(const Sample *inLeft, const Sample *inRight, Sample *outLeft, Sample *outRight, const Bit32u length) {
+	// Same processing as in processReference(), only each filter runs through the whole block before the next one does.
+	// The samples taken off the combs are collected by getOutputsAt() around processing the block.
+	Sample dry[BLOCK_LENGTH];
+	Sample link[BLOCK_LENGTH];
+	Sample outL[3][BLOCK_LENGTH];
+	Sample outR[3][BLOCK_LENGTH];
+
+	VectorOps::mixDown(dry, inLeft, inRight, length, 2, dryAmp);
+
+	DelayWithLowPassFilter *entrance = static_cast<DelayWithLowPassFilter *> (combs[0]);
+	entrance->getOutputsAt(link, length, currentSettings.combSizes[0] - 1, false, false);
+	entrance->processBlock(dry, length);
+	entrance->getOutputsAt(link, length, currentSettings.combSizes[0] - 1, false, true);
+
+	// This introduces reverb noise which actually makes output from the real Boss chip nondeterministic
+	VectorOps::decrement(link, length);
+	allpasses[0]->processBlock(link, length);
+	allpasses[1]->processBlock(link, length);
+	allpasses[2]->processBlock(link, length);
+
+	for (Bit32u i = 0; i < 3; i++) {
+		CombFilter *comb = combs[i + 1];
+		// The first left output is read before the sample is processed, see processReference()
+		const Bit32u outLIndex = i == 0 ? currentSettings.outLPositions[0] - 1 : currentSettings.outLPositions[i];
+		comb->getOutputsAt(outL[i], length, outLIndex, i != 0, false);
+		comb->getOutputsAt(outR[i], length, currentSettings.outRPositions[i], true, false);
+		comb->processBlock(link, length);
+		comb->getOutputsAt(outL[i], length, outLIndex, i != 0, true);
+		comb->getOutputsAt(outR[i], length, currentSettings.outRPositions[i], true, true);
+	}
+
+	if (outLeft != NULL) {
+		VectorOps::mixCombOutputs(outLeft, outL[0], outL[1], outL[2], length, wetLevel);
+	}
+	if (outRight != NULL) {
+		VectorOps::mixCombOutputs(outRight, outR[0], outR[1], outR[2], length, wetLevel);
+	}
+}
+#endif
+
+void BReverbModel::processReference(const Sample *inLeft, const Sample *inRight, Sample *outLeft, Sample *outRight, unsigned long numSamples) {
 	if (combs == NULL) {
 		Synth::muteSampleBuffer(outLeft, numSamples);
 		Synth::muteSampleBuffer(outRight, numSamples);
@@ -52,6 +52,11 @@ class AllpassFilter : public RingBuffer {
 public:
 	AllpassFilter(const Bit32u size);
 	Sample process(const Sample in);
+#if !MT32EMU_USE_FLOAT_SAMPLES
+	// Same as calling process() for each sample of io in turn, replacing it with the result.
+	// The block may not be longer than the filter.
+	void processBlock(Sample *io, Bit32u length);
+#endif
 };
 
 class CombFilter : public RingBuffer {
@@ -63,6 +68,11 @@ public:
 	CombFilter(const Bit32u size, const Bit32u useFilterFactor);
 	virtual void process(const Sample in);
 	Sample getOutputAt(const Bit32u outIndex) const;
+	void processBlock(const Sample *in, const Bit32u length);
+	// Fills out with the values getOutputAt(outIndex) would return for each sample of a block, when called before
+	// (or after, if afterProcess is set) that sample is processed. Must be called both before and after
+	// the block is processed, with blockProcessed set accordingly. The block may not be longer than the filter.
+	void getOutputsAt(Sample *out, const Bit32u length, const Bit32u outIndex, const bool afterProcess, const bool blockProcessed) const;
 	void setFeedbackFactor(const Bit32u useFeedbackFactor);
 };
 
@@ -72,6 +82,7 @@ class DelayWithLowPassFilter : public CombFilter {
 public:
 	DelayWithLowPassFilter(const Bit32u useSize, const Bit32u useFilterFactor, const Bit32u useAmp);
 	void process(const Sample in);
+	void processBlock(const Sample *in, const Bit32u length);
 	void setFeedbackFactor(const Bit32u) {}
 };
 
@@ -99,6 +110,10 @@ class BReverbModel {
 	static const BReverbSettings &getCM32L_LAPCSettings(const ReverbMode mode);
 	static const BReverbSettings &getMT32Settings(const ReverbMode mode);
 
+#if !MT32EMU_USE_FLOAT_SAMPLES
+	void processBlock(const Sample *inLeft, const Sample *inRight, Sample *outLeft, Sample *outRight, const Bit32u length);
+#endif
+
 public:
 	BReverbModel(const ReverbMode mode, const bool mt32CompatibleModel = false);
 	~BReverbModel();
@@ -109,6 +124,9 @@ public:
 	void mute();
 	void setParameters(Bit8u time, Bit8u level);
 	void process(const Sample *inLeft, const Sample *inRight, Sample *outLeft, Sample *outRight, unsigned long numSamples);
+	// Straightforward sample by sample implementation, which process() uses for the tap delay mode.
+	// The block based path taken otherwise must produce exactly the same output.
+	void processReference(const Sample *inLeft, const Sample *inRight, Sample *outLeft, Sample *outRight, unsigned long numSamples);
 	bool isActive() const;
 	bool isMT32Compatible(const ReverbMode mode) const;
 };
@@ -22,6 +22,7 @@
 #include "mt32emu.h"
 #include "mmath.h"
 #include "internals.h"
+#include "VectorOps.h"
 
 namespace MT32Emu {
 
@@ -30,6 +31,9 @@ static const Bit8u PAN_NUMERATOR_SLAVE[]  = {0, 1, 2, 3, 4, 5, 6, 7, 7, 7, 7, 7,
 
 static const Bit32s PAN_FACTORS[] = {0, 18, 37, 55, 73, 91, 110, 128, 146, 165, 183, 201, 219, 238, 256};
 
+// Number of samples produceOutput() generates before panning and mixing them into the output
+static const Bit32u MIX_CHUNK_LENGTH = 128;
+
 Partial::Partial(Synth *useSynth, int useDebugPartialNum) :
 	synth(useSynth), debugPartialNum(useDebugPartialNum), sampleNum(0) {
 	// Initialisation of tva, tvp and tvf uses 'this' pointer
@@ -276,6 +280,12 @@ bool Partial::produceOutput(Sample *leftBuf, Sample *rightBuf, unsigned long len
 	}
 	alreadyOutputed = true;
 
+#if !MT32EMU_USE_FLOAT_SAMPLES
+	// The samples are generated one by one into a chunk which is then panned and mixed into the output at once
+	Sample chunk[MIX_CHUNK_LENGTH];
+	Bit32u chunkLength = 0;
+#endif
+
 	for (sampleNum = 0; sampleNum < length; sampleNum++) {
 		if (!tva->isPlaying() || !la32Pair.isActive(LA32PartialPair::MASTER)) {
 			deactivate();
@@ -311,14 +321,19 @@ bool Partial::produceOutput(Sample *leftBuf, Sample *rightBuf, unsigned long len
 		// From analysis of this overflow, it is obvious that the right channel output is actually found
 		// by subtraction of the left channel output from the input.
 		// Though, it is unknown whether this overflow is exploited somewhere.
-		Sample leftOut = Sample((sample * leftPanValue) >> 8);
-		Sample rightOut = Sample((sample * rightPanValue) >> 8);
-		*leftBuf = Synth::clipSampleEx((SampleEx)*leftBuf + (SampleEx)leftOut);
-		*rightBuf = Synth::clipSampleEx((SampleEx)*rightBuf + (SampleEx)rightOut);
-		leftBuf++;
-		rightBuf++;
+		// The output is Sample((sample * panValue) >> 8) added with clipping, see VectorOps::mixPanned().
+		chunk[chunkLength++] = sample;
+		if (chunkLength == MIX_CHUNK_LENGTH) {
+			VectorOps::mixPanned(leftBuf, rightBuf, chunk, chunkLength, leftPanValue, rightPanValue);
+			leftBuf += chunkLength;
+			rightBuf += chunkLength;
+			chunkLength = 0;
+		}
 #endif
 	}
+#if !MT32EMU_USE_FLOAT_SAMPLES
+	VectorOps::mixPanned(leftBuf, rightBuf, chunk, chunkLength, leftPanValue, rightPanValue);
+#endif
 	sampleNum = 0;
 	return true;
 }
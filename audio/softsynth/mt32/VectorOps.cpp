@@ -0,0 +1,232 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011, 2012, 2013, 2014 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "mt32emu.h"
+
+#if !MT32EMU_USE_FLOAT_SAMPLES
+
+#include "VectorOps.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MT32EMU_VECTOR_SSE2 1
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define MT32EMU_VECTOR_NEON 1
+#endif
+
+namespace MT32Emu {
+
+namespace VectorOps {
+
+// Sample((a * m) >> 8), keeping only the low 16 bits like the cast does
+static inline Sample mulShr8(const Sample a, const Bit32s m) {
+	return Sample(((Bit32s)a * m) >> 8);
+}
+
+#if MT32EMU_VECTOR_SSE2
+
+// Bits 8..23 of the 32-bit products a * m, which is what the scalar cast keeps
+static inline __m128i mulShr8(const __m128i a, const __m128i m) {
+	return _mm_or_si128(_mm_srli_epi16(_mm_mullo_epi16(a, m), 8), _mm_slli_epi16(_mm_mulhi_epi16(a, m), 8));
+}
+
+static inline __m128i widenLow(const __m128i a) {
+	return _mm_srai_epi32(_mm_unpacklo_epi16(a, a), 16);
+}
+
+static inline __m128i widenHigh(const __m128i a) {
+	return _mm_srai_epi32(_mm_unpackhi_epi16(a, a), 16);
+}
+
+#elif MT32EMU_VECTOR_NEON
+
+static inline int16x8_t mulShr8(const int16x8_t a, const int16x4_t m) {
+	return vcombine_s16(vshrn_n_s32(vmull_s16(vget_low_s16(a), m), 8), vshrn_n_s32(vmull_s16(vget_high_s16(a), m), 8));
+}
+
+#endif
+
+const char *getName() {
+#if MT32EMU_VECTOR_SSE2
+	return "SSE2";
+#elif MT32EMU_VECTOR_NEON
+	return "NEON";
+#else
+	return "scalar";
+#endif
+}
+
+void mixPanned(Sample *leftBuf, Sample *rightBuf, const Sample *in, Bit32u len, Bit32s leftPanValue, Bit32s rightPanValue) {
+#if MT32EMU_VECTOR_SSE2
+	const __m128i leftPan = _mm_set1_epi16((short)leftPanValue);
+	const __m128i rightPan = _mm_set1_epi16((short)rightPanValue);
+	for (; len >= 8; len -= 8) {
+		const __m128i sample = _mm_loadu_si128((const __m128i *)in);
+		_mm_storeu_si128((__m128i *)leftBuf, _mm_adds_epi16(_mm_loadu_si128((const __m128i *)leftBuf), mulShr8(sample, leftPan)));
+		_mm_storeu_si128((__m128i *)rightBuf, _mm_adds_epi16(_mm_loadu_si128((const __m128i *)rightBuf), mulShr8(sample, rightPan)));
+		in += 8;
+		leftBuf += 8;
+		rightBuf += 8;
+	}
+#elif MT32EMU_VECTOR_NEON
+	const int16x4_t leftPan = vdup_n_s16((Bit16s)leftPanValue);
+	const int16x4_t rightPan = vdup_n_s16((Bit16s)rightPanValue);
+	for (; len >= 8; len -= 8) {
+		const int16x8_t sample = vld1q_s16(in);
+		vst1q_s16(leftBuf, vqaddq_s16(vld1q_s16(leftBuf), mulShr8(sample, leftPan)));
+		vst1q_s16(rightBuf, vqaddq_s16(vld1q_s16(rightBuf), mulShr8(sample, rightPan)));
+		in += 8;
+		leftBuf += 8;
+		rightBuf += 8;
+	}
+#endif
+	while (len--) {
+		const Sample sample = *(in++);
+		*leftBuf = Synth::clipSampleEx((SampleEx)*leftBuf + (SampleEx)mulShr8(sample, leftPanValue));
+		*rightBuf = Synth::clipSampleEx((SampleEx)*rightBuf + (SampleEx)mulShr8(sample, rightPanValue));
+		leftBuf++;
+		rightBuf++;
+	}
+}
+
+void mixDown(Sample *out, const Sample *inLeft, const Sample *inRight, Bit32u len, Bit32u shift, Bit32u amp) {
+#if MT32EMU_VECTOR_SSE2
+	const __m128i vAmp = _mm_set1_epi16((short)amp);
+	const __m128i vShift = _mm_cvtsi32_si128(shift);
+	for (; len >= 8; len -= 8) {
+		const __m128i left = _mm_sra_epi16(_mm_loadu_si128((const __m128i *)inLeft), vShift);
+		const __m128i right = _mm_sra_epi16(_mm_loadu_si128((const __m128i *)inRight), vShift);
+		_mm_storeu_si128((__m128i *)out, mulShr8(_mm_add_epi16(left, right), vAmp));
+		inLeft += 8;
+		inRight += 8;
+		out += 8;
+	}
+#elif MT32EMU_VECTOR_NEON
+	const int16x4_t vAmp = vdup_n_s16((Bit16s)amp);
+	const int16x8_t vShift = vdupq_n_s16(-(Bit16s)shift);
+	for (; len >= 8; len -= 8) {
+		const int16x8_t left = vshlq_s16(vld1q_s16(inLeft), vShift);
+		const int16x8_t right = vshlq_s16(vld1q_s16(inRight), vShift);
+		vst1q_s16(out, mulShr8(vaddq_s16(left, right), vAmp));
+		inLeft += 8;
+		inRight += 8;
+		out += 8;
+	}
+#endif
+	while (len--) {
+		*(out++) = mulShr8(Sample((*(inLeft++) >> shift) + (*(inRight++) >> shift)), amp);
+	}
+}
+
+void allpass(Sample *buffer, Sample *io, Bit32u len) {
+#if MT32EMU_VECTOR_SSE2
+	for (; len >= 8; len -= 8) {
+		const __m128i bufferOut = _mm_loadu_si128((const __m128i *)buffer);
+		const __m128i bufferIn = _mm_sub_epi16(_mm_loadu_si128((const __m128i *)io), _mm_srai_epi16(bufferOut, 1));
+		_mm_storeu_si128((__m128i *)buffer, bufferIn);
+		_mm_storeu_si128((__m128i *)io, _mm_add_epi16(bufferOut, _mm_srai_epi16(bufferIn, 1)));
+		buffer += 8;
+		io += 8;
+	}
+#elif MT32EMU_VECTOR_NEON
+	for (; len >= 8; len -= 8) {
+		const int16x8_t bufferOut = vld1q_s16(buffer);
+		const int16x8_t bufferIn = vsubq_s16(vld1q_s16(io), vshrq_n_s16(bufferOut, 1));
+		vst1q_s16(buffer, bufferIn);
+		vst1q_s16(io, vaddq_s16(bufferOut, vshrq_n_s16(bufferIn, 1)));
+		buffer += 8;
+		io += 8;
+	}
+#endif
+	while (len--) {
+		const Sample bufferOut = *buffer;
+		*buffer = *io - (bufferOut >> 1);
+		*io = bufferOut + (*buffer >> 1);
+		buffer++;
+		io++;
+	}
+}
+
+void decrement(Sample *io, Bit32u len) {
+#if MT32EMU_VECTOR_SSE2
+	const __m128i one = _mm_set1_epi16(1);
+	for (; len >= 8; len -= 8) {
+		_mm_storeu_si128((__m128i *)io, _mm_sub_epi16(_mm_loadu_si128((const __m128i *)io), one));
+		io += 8;
+	}
+#elif MT32EMU_VECTOR_NEON
+	const int16x8_t one = vdupq_n_s16(1);
+	for (; len >= 8; len -= 8) {
+		vst1q_s16(io, vsubq_s16(vld1q_s16(io), one));
+		io += 8;
+	}
+#endif
+	while (len--) {
+		*io = *io - 1;
+		io++;
+	}
+}
+
+void mixCombOutputs(Sample *out, const Sample *a, const Sample *b, const Sample *c, Bit32u len, Bit32u amp) {
+#if MT32EMU_VECTOR_SSE2
+	const __m128i vAmp = _mm_set1_epi16((short)amp);
+	for (; len >= 8; len -= 8) {
+		const __m128i va = _mm_loadu_si128((const __m128i *)a);
+		const __m128i vb = _mm_loadu_si128((const __m128i *)b);
+		const __m128i vc = _mm_loadu_si128((const __m128i *)c);
+		const __m128i halves = _mm_add_epi16(_mm_srai_epi16(va, 1), _mm_srai_epi16(vb, 1));
+		const __m128i sumLow = _mm_add_epi32(_mm_add_epi32(widenLow(va), widenLow(vb)), _mm_add_epi32(widenLow(vc), widenLow(halves)));
+		const __m128i sumHigh = _mm_add_epi32(_mm_add_epi32(widenHigh(va), widenHigh(vb)), _mm_add_epi32(widenHigh(vc), widenHigh(halves)));
+		_mm_storeu_si128((__m128i *)out, mulShr8(_mm_packs_epi32(sumLow, sumHigh), vAmp));
+		a += 8;
+		b += 8;
+		c += 8;
+		out += 8;
+	}
+#elif MT32EMU_VECTOR_NEON
+	const int16x4_t vAmp = vdup_n_s16((Bit16s)amp);
+	for (; len >= 8; len -= 8) {
+		const int16x8_t va = vld1q_s16(a);
+		const int16x8_t vb = vld1q_s16(b);
+		const int16x8_t vc = vld1q_s16(c);
+		const int16x8_t halves = vaddq_s16(vshrq_n_s16(va, 1), vshrq_n_s16(vb, 1));
+		int32x4_t sumLow = vaddl_s16(vget_low_s16(va), vget_low_s16(vb));
+		sumLow = vaddq_s32(sumLow, vaddl_s16(vget_low_s16(vc), vget_low_s16(halves)));
+		int32x4_t sumHigh = vaddl_s16(vget_high_s16(va), vget_high_s16(vb));
+		sumHigh = vaddq_s32(sumHigh, vaddl_s16(vget_high_s16(vc), vget_high_s16(halves)));
+		vst1q_s16(out, mulShr8(vcombine_s16(vqmovn_s32(sumLow), vqmovn_s32(sumHigh)), vAmp));
+		a += 8;
+		b += 8;
+		c += 8;
+		out += 8;
+	}
+#endif
+	while (len--) {
+		const Sample sum = Synth::clipSampleEx((SampleEx)*a + SampleEx(*a >> 1) + (SampleEx)*b + SampleEx(*b >> 1) + (SampleEx)*c);
+		*(out++) = mulShr8(sum, amp);
+		a++;
+		b++;
+		c++;
+	}
+}
+
+}
+
+}
+
+#endif // #if !MT32EMU_USE_FLOAT_SAMPLES
@@ -0,0 +1,53 @@
+/* Copyright (C) 2003, 2004, 2005, 2006, 2008, 2009 Dean Beeler, Jerome Fisher
+ * Copyright (C) 2011, 2012, 2013, 2014 Dean Beeler, Jerome Fisher, Sergey V. Mikayev
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation, either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MT32EMU_VECTOR_OPS_H
+#define MT32EMU_VECTOR_OPS_H
+
+namespace MT32Emu {
+
+// Operations on blocks of integer samples, used by the partial render loop and the reverb model.
+// Where the compiler targets SSE2 or NEON, they are vectorised. In any case, the results are exactly
+// the same as of the per sample code they replace, including its wraparounds and clipping.
+// Not available with MT32EMU_USE_FLOAT_SAMPLES.
+namespace VectorOps {
+
+// Returns the name of the instruction set in use: "SSE2", "NEON" or "scalar".
+const char *getName();
+
+// leftBuf[i] = clip(leftBuf[i] + Sample((in[i] * leftPanValue) >> 8)), likewise for the right channel.
+// The pan values must fit in 16 bits.
+void mixPanned(Sample *leftBuf, Sample *rightBuf, const Sample *in, Bit32u len, Bit32s leftPanValue, Bit32s rightPanValue);
+
+// out[i] = Sample((((inLeft[i] >> shift) + (inRight[i] >> shift)) * amp) >> 8), with 1 <= shift <= 15 and amp < 256.
+void mixDown(Sample *out, const Sample *inLeft, const Sample *inRight, Bit32u len, Bit32u shift, Bit32u amp);
+
+// Runs an allpass filter over len consecutive buffer slots, see AllpassFilter::process().
+// The samples in io are replaced by the filter output.
+void allpass(Sample *buffer, Sample *io, Bit32u len);
+
+// io[i] = io[i] - 1, wrapping around.
+void decrement(Sample *io, Bit32u len);
+
+// out[i] = Sample((clip(a[i] + (a[i] >> 1) + b[i] + (b[i] >> 1) + c[i]) * amp) >> 8), with amp < 256.
+void mixCombOutputs(Sample *out, const Sample *a, const Sample *b, const Sample *c, Bit32u len, Bit32u amp);
+
+}
+
+}
+
+#endif
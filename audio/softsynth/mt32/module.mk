@@ -14,7 +14,8 @@ MODULE_OBJS := \
 	Tables.o \
 	TVA.o \
 	TVF.o \
-	TVP.o
+	TVP.o \
+	VectorOps.o
 
 # Include common rules
 include $(srcdir)/rules.mk
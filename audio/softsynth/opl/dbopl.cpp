@@ -90,6 +90,9 @@ namespace DBOPL {
 //Has to fit within 16bit lookuptable
 #define MUL_SH		16
 
+//Samples per block when operators are run a block at a time
+#define BLOCK_SAMPLES	64
+
 //Check some ranges
 #if ENV_EXTRA > 3
 #error Too many envelope bits
@@ -582,8 +585,7 @@ INLINE Bits Operator::GetWave( Bitu index, Bitu vol ) {
 #endif
 }
 
-INLINE Bits Operator::GetSample( Bits modulation ) {
-	Bitu vol = ForwardVolume();
+INLINE Bits Operator::ForwardSample( Bits modulation, Bitu vol ) {
 	if ( ENV_SILENT( vol ) ) {
 		//Simply forward the wave
 		waveIndex += waveCurrent;
@@ -595,6 +597,79 @@ INLINE Bits Operator::GetSample( Bits modulation ) {
 	}
 }
 
+INLINE Bits Operator::GetSample( Bits modulation ) {
+	return ForwardSample( modulation, ForwardVolume() );
+}
+
+template< Operator::State yes >
+INLINE Bitu Operator::ForwardVolumes( Bitu* vol, Bitu i, Bitu samples ) {
+	//Stops early when the envelope moves on to another state
+	while ( i < samples ) {
+		vol[ i++ ] = currentLevel + TemplateVolume< yes >();
+		if ( state != yes )
+			break;
+	}
+	return i;
+}
+
+void Operator::ForwardVolumes( Bitu* vol, Bitu samples ) {
+	Bitu i = 0;
+	while ( i < samples ) {
+		switch ( state ) {
+		case OFF:
+			for ( ; i < samples; i++ ) {
+				vol[ i ] = currentLevel + ENV_MAX;
+			}
+			break;
+		case RELEASE:
+			i = ForwardVolumes< RELEASE >( vol, i, samples );
+			break;
+		case SUSTAIN:
+			if ( reg20 & MASK_SUSTAIN ) {
+				//Stays at the same level until the next key off
+				for ( ; i < samples; i++ ) {
+					vol[ i ] = currentLevel + volume;
+				}
+			} else {
+				i = ForwardVolumes< SUSTAIN >( vol, i, samples );
+			}
+			break;
+		case DECAY:
+			i = ForwardVolumes< DECAY >( vol, i, samples );
+			break;
+		case ATTACK:
+			i = ForwardVolumes< ATTACK >( vol, i, samples );
+			break;
+		}
+	}
+}
+
+void Operator::GetSamples( Bits* output, const Bits* modulation, Bitu samples ) {
+	Bitu vol[ BLOCK_SAMPLES ];
+	ForwardVolumes( vol, samples );
+	//Keep the wave counter local, so the loops don't have to store it on every sample
+	Bit32u index = waveIndex;
+	const Bit32u add = waveCurrent;
+	if ( modulation ) {
+		for ( Bitu i = 0; i < samples; i++ ) {
+			index += add;
+			output[ i ] = ENV_SILENT( vol[ i ] ) ? 0 : GetWave( ( index >> WAVE_SH ) + modulation[ i ], vol[ i ] );
+		}
+	} else {
+		for ( Bitu i = 0; i < samples; i++ ) {
+			index += add;
+			output[ i ] = ENV_SILENT( vol[ i ] ) ? 0 : GetWave( index >> WAVE_SH, vol[ i ] );
+		}
+	}
+	waveIndex = index;
+}
+
+static INLINE void AddSamples( Bits* output, const Bits* input, Bitu samples ) {
+	for ( Bitu i = 0; i < samples; i++ ) {
+		output[ i ] += input[ i ];
+	}
+}
+
 Operator::Operator() {
 	chanData = 0;
 	freqMul = 0;
@@ -911,49 +986,68 @@ Channel* Channel::BlockTemplate( Chip* chip, Bit32u samples, Bit32s* output ) {
 		Op( 4 )->Prepare( chip );
 		Op( 5 )->Prepare( chip );
 	}
-	for ( Bitu i = 0; i < samples; i++ ) {
-		//Early out for percussion handlers
-		if ( mode == sm2Percussion ) {
-			GeneratePercussion<false>( chip, output + i );
-			continue;	//Prevent some unitialized value bitching
-		} else if ( mode == sm3Percussion ) {
-			GeneratePercussion<true>( chip, output + i * 2 );
-			continue;	//Prevent some unitialized value bitching
+	//Percussion is generated sample by sample
+	if ( mode == sm2Percussion || mode == sm3Percussion ) {
+		for ( Bitu i = 0; i < samples; i++ ) {
+			if ( mode == sm2Percussion ) {
+				GeneratePercussion<false>( chip, output + i );
+			} else {
+				GeneratePercussion<true>( chip, output + i * 2 );
+			}
+		}
+		return ( this + 3 );
+	}
+	//Otherwise only the first operator has feedback, all the others run over a whole block at once
+	for ( Bitu done = 0; done < samples; ) {
+		Bitu count = samples - done;
+		if ( count > BLOCK_SAMPLES )
+			count = BLOCK_SAMPLES;
+		Bits out0[ BLOCK_SAMPLES ];
+		Bits next[ BLOCK_SAMPLES ];
+		Bits sample[ BLOCK_SAMPLES ];
+		Bitu vol[ BLOCK_SAMPLES ];
+
+		Operator* op0 = Op( 0 );
+		op0->ForwardVolumes( vol, count );
+		for ( Bitu i = 0; i < count; i++ ) {
+			//Do unsigned shift so we can shift out all bits but still stay in 10 bit range otherwise
+			Bit32s mod = (Bit32u)((old[0] + old[1])) >> feedback;
+			old[0] = old[1];
+			old[1] = op0->ForwardSample( mod, vol[ i ] );
+			out0[ i ] = old[0];
 		}
-
-		//Do unsigned shift so we can shift out all bits but still stay in 10 bit range otherwise
-		Bit32s mod = (Bit32u)((old[0] + old[1])) >> feedback;
-		old[0] = old[1];
-		old[1] = Op(0)->GetSample( mod );
-		Bit32s sample;
-		Bit32s out0 = old[0];
 		if ( mode == sm2AM || mode == sm3AM ) {
-			sample = out0 + Op(1)->GetSample( 0 );
+			Op(1)->GetSamples( sample, 0, count );
+			AddSamples( sample, out0, count );
 		} else if ( mode == sm2FM || mode == sm3FM ) {
-			sample = Op(1)->GetSample( out0 );
+			Op(1)->GetSamples( sample, out0, count );
 		} else if ( mode == sm3FMFM ) {
-			Bits next = Op(1)->GetSample( out0 );
-			next = Op(2)->GetSample( next );
-			sample = Op(3)->GetSample( next );
+			Op(1)->GetSamples( next, out0, count );
+			Op(2)->GetSamples( out0, next, count );
+			Op(3)->GetSamples( sample, out0, count );
 		} else if ( mode == sm3AMFM ) {
-			sample = out0;
-			Bits next = Op(1)->GetSample( 0 );
-			next = Op(2)->GetSample( next );
-			sample += Op(3)->GetSample( next );
+			Op(1)->GetSamples( sample, 0, count );
+			Op(2)->GetSamples( next, sample, count );
+			Op(3)->GetSamples( sample, next, count );
+			AddSamples( sample, out0, count );
 		} else if ( mode == sm3FMAM ) {
-			sample = Op(1)->GetSample( out0 );
-			Bits next = Op(2)->GetSample( 0 );
-			sample += Op(3)->GetSample( next );
+			Op(1)->GetSamples( sample, out0, count );
+			Op(2)->GetSamples( next, 0, count );
+			Op(3)->GetSamples( out0, next, count );
+			AddSamples( sample, out0, count );
 		} else if ( mode == sm3AMAM ) {
-			sample = out0;
-			Bits next = Op(1)->GetSample( 0 );
-			sample += Op(2)->GetSample( next );
-			sample += Op(3)->GetSample( 0 );
+			Op(1)->GetSamples( next, 0, count );
+			Op(2)->GetSamples( sample, next, count );
+			AddSamples( sample, out0, count );
+			Op(3)->GetSamples( next, 0, count );
+			AddSamples( sample, next, count );
 		}
 		switch( mode ) {
 		case sm2AM:
 		case sm2FM:
-			output[ i ] += sample;
+			for ( Bitu i = 0; i < count; i++ ) {
+				output[ done + i ] += sample[ i ];
+			}
 			break;
 		case sm3AM:
 		case sm3FM:
@@ -961,30 +1055,15 @@ Channel* Channel::BlockTemplate( Chip* chip, Bit32u samples, Bit32s* output ) {
 		case sm3AMFM:
 		case sm3FMAM:
 		case sm3AMAM:
-			output[ i * 2 + 0 ] += sample & maskLeft;
-			output[ i * 2 + 1 ] += sample & maskRight;
-			break;
-		case sm2Percussion:
-			// This case was not handled in the DOSBox code either
-			// thus we leave this blank.
-			// TODO: Consider checking this.
-			break;
-		case sm3Percussion:
-			// This case was not handled in the DOSBox code either
-			// thus we leave this blank.
-			// TODO: Consider checking this.
-			break;
-		case sm4Start:
-			// This case was not handled in the DOSBox code either
-			// thus we leave this blank.
-			// TODO: Consider checking this.
+			for ( Bitu i = 0; i < count; i++ ) {
+				output[ ( done + i ) * 2 + 0 ] += sample[ i ] & maskLeft;
+				output[ ( done + i ) * 2 + 1 ] += sample[ i ] & maskRight;
+			}
 			break;
-		case sm6Start:
-			// This case was not handled in the DOSBox code either
-			// thus we leave this blank.
-			// TODO: Consider checking this.
+		default:
 			break;
 		}
+		done += count;
 	}
 	switch( mode ) {
 	case sm2AM:
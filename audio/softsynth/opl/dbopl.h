@@ -178,6 +178,13 @@ public:
 
 	Bits GetSample( Bits modulation );
 	Bits GetWave( Bitu index, Bitu vol );
+
+	//Block versions of ForwardVolume and GetSample, for up to BLOCK_SAMPLES samples
+	template< State state>
+	Bitu ForwardVolumes( Bitu* vol, Bitu i, Bitu samples );
+	void ForwardVolumes( Bitu* vol, Bitu samples );
+	Bits ForwardSample( Bits modulation, Bitu vol );
+	void GetSamples( Bits* output, const Bits* modulation, Bitu samples );
 public:
 	Operator();
 };
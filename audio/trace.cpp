@@ -0,0 +1,715 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/trace.h"
+
+#include "common/config-manager.h"
+#include "common/endian.h"
+#include "common/file.h"
+#include "common/func.h"
+#include "common/stream.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+namespace Audio {
+
+enum {
+	kTraceVersion = 1,
+	/** Amount of pending records for which the writer thread wakes up */
+	kTraceWriteThreshold = 64 * 1024
+};
+
+namespace {
+
+/**
+ * An OPL recording everything sent to another one.
+ */
+class TracingOPL : public OPL::OPL {
+public:
+	TracingOPL(TraceRecorder *recorder, ::OPL::OPL *opl, ::OPL::Config::OplType type) :
+		OPL(ForwardingTag()), _recorder(recorder), _opl(opl), _device(recorder->addDevice()) {
+		const byte payload = type;
+		_recorder->record(_device, kTraceOpenOPL, &payload, 1);
+	}
+
+	~TracingOPL() {
+		stop();
+		delete _opl;
+
+		_recorder->record(_device, kTraceClose);
+		_recorder->flush();
+	}
+
+	// OPL API
+	bool init() {
+		_recorder->record(_device, kTraceOPLInit);
+		return _opl->init();
+	}
+
+	void reset() {
+		_recorder->record(_device, kTraceOPLReset);
+		_opl->reset();
+	}
+
+	void write(int a, int v) {
+		byte payload[3];
+		WRITE_LE_UINT16(payload, a);
+		payload[2] = v;
+		_recorder->record(_device, kTraceOPLWrite, payload, 3);
+		_opl->write(a, v);
+	}
+
+	byte read(int a) {
+		return _opl->read(a);
+	}
+
+	void writeReg(int r, int v) {
+		byte payload[3];
+		WRITE_LE_UINT16(payload, r);
+		payload[2] = v;
+		_recorder->record(_device, kTraceOPLWriteReg, payload, 3);
+		_opl->writeReg(r, v);
+	}
+
+	void setCallbackFrequency(int timerFrequency) {
+		recordFrequency(timerFrequency);
+		_opl->setCallbackFrequency(timerFrequency);
+	}
+
+protected:
+	void startCallbacks(int timerFrequency) {
+		recordFrequency(timerFrequency);
+		_opl->start(new Common::Functor0Mem<void, TracingOPL>(this, &TracingOPL::onTimer), timerFrequency);
+	}
+
+	void stopCallbacks() {
+		_opl->stop();
+	}
+
+private:
+	void recordFrequency(int timerFrequency) {
+		byte payload[4];
+		WRITE_LE_UINT32(payload, timerFrequency);
+		_recorder->record(_device, kTraceFrequency, payload, 4);
+	}
+
+	void onTimer() {
+		_recorder->record(_device, kTraceTick);
+		if (_callback && _callback->isValid())
+			(*_callback)();
+	}
+
+	TraceRecorder *_recorder;
+	::OPL::OPL *_opl;
+	const byte _device;
+};
+
+/**
+ * A channel of a TracingMidiDriver, recording what is sent to it as the
+ * messages to the driver which have the same effect.
+ */
+class TracingMidiChannel : public MidiChannel {
+public:
+	TracingMidiChannel(MidiDriver *driver, MidiChannel *channel, TraceRecorder *recorder, byte device) :
+		_driver(driver), _channel(channel), _recorder(recorder), _device(device) {
+	}
+
+	MidiChannel *getChannel() const { return _channel; }
+
+	// MidiChannel API
+	MidiDriver *device() { return _driver; }
+	byte getNumber() { return _channel->getNumber(); }
+	void release() { _channel->release(); }
+
+	void send(uint32 b) {
+		record(b);
+		_channel->send(b);
+	}
+
+	void noteOff(byte note) {
+		record(0x80, note, 0);
+		_channel->noteOff(note);
+	}
+
+	void noteOn(byte note, byte velocity) {
+		record(0x90, note, velocity);
+		_channel->noteOn(note, velocity);
+	}
+
+	void programChange(byte program) {
+		record(0xC0, program, 0);
+		_channel->programChange(program);
+	}
+
+	void pitchBend(int16 bend) {
+		const uint16 value = bend + 0x2000;
+		record(0xE0, value & 0x7F, (value >> 7) & 0x7F);
+		_channel->pitchBend(bend);
+	}
+
+	void controlChange(byte control, byte value) {
+		record(0xB0, control, value);
+		_channel->controlChange(control, value);
+	}
+
+	void modulationWheel(byte value) {
+		record(0xB0, 1, value);
+		_channel->modulationWheel(value);
+	}
+
+	void volume(byte value) {
+		record(0xB0, 7, value);
+		_channel->volume(value);
+	}
+
+	void panPosition(byte value) {
+		record(0xB0, 10, value);
+		_channel->panPosition(value);
+	}
+
+	void pitchBendFactor(byte value) {
+		// The registered parameter sequence of MidiDriver::setPitchBendRange()
+		record(0xB0, 101, 0);
+		record(0xB0, 100, 0);
+		record(0xB0, 6, value);
+		record(0xB0, 38, 0);
+		record(0xB0, 101, 127);
+		record(0xB0, 100, 127);
+		_channel->pitchBendFactor(value);
+	}
+
+	void detune(byte value) {
+		record(0xB0, 17, value);
+		_channel->detune(value);
+	}
+
+	void priority(byte value) { _channel->priority(value); }
+
+	void sustain(bool value) {
+		record(0xB0, 64, value ? 1 : 0);
+		_channel->sustain(value);
+	}
+
+	void effectLevel(byte value) {
+		record(0xB0, 91, value);
+		_channel->effectLevel(value);
+	}
+
+	void chorusLevel(byte value) {
+		record(0xB0, 93, value);
+		_channel->chorusLevel(value);
+	}
+
+	void allNotesOff() {
+		record(0xB0, 123, 0);
+		_channel->allNotesOff();
+	}
+
+	void sysEx_customInstrument(uint32 type, const byte *instr) { _channel->sysEx_customInstrument(type, instr); }
+
+private:
+	void record(byte status, byte firstOp, byte secondOp) {
+		record(status | (firstOp << 8) | (secondOp << 16));
+	}
+
+	void record(uint32 b) {
+		byte payload[4];
+		WRITE_LE_UINT32(payload, (b & 0xFFFFFFF0) | (_channel->getNumber() & 0x0F));
+		_recorder->record(_device, kTraceMidiSend, payload, 4);
+	}
+
+	MidiDriver *_driver;
+	MidiChannel *_channel;
+	TraceRecorder *_recorder;
+	const byte _device;
+};
+
+/**
+ * A MIDI driver recording everything sent to another one.
+ */
+class TracingMidiDriver : public MidiDriver {
+public:
+	TracingMidiDriver(TraceRecorder *recorder, MidiDriver *driver) :
+		_recorder(recorder), _driver(driver), _device(recorder->addDevice()),
+		_timerParam(0), _timerProc(0) {
+	}
+
+	~TracingMidiDriver() {
+		if (_driver->isOpen())
+			close();
+		delete _driver;
+
+		for (uint i = 0; i < _channels.size(); ++i)
+			delete _channels[i];
+	}
+
+	// MidiDriver API
+	int open() {
+		const int result = _driver->open();
+		if (result == 0) {
+			byte payload[4];
+			WRITE_LE_UINT32(payload, _driver->getBaseTempo());
+			_recorder->record(_device, kTraceOpenMidi, payload, 4);
+		}
+		return result;
+	}
+
+	bool isOpen() const { return _driver->isOpen(); }
+
+	void close() {
+		_driver->close();
+		_recorder->record(_device, kTraceClose);
+		_recorder->flush();
+	}
+
+	uint32 property(int prop, uint32 param) { return _driver->property(prop, param); }
+
+	void send(uint32 b) {
+		byte payload[4];
+		WRITE_LE_UINT32(payload, b);
+		_recorder->record(_device, kTraceMidiSend, payload, 4);
+		_driver->send(b);
+	}
+
+	void sysEx(const byte *msg, uint16 length) {
+		byte payload[2];
+		WRITE_LE_UINT16(payload, length);
+		_recorder->record(_device, kTraceMidiSysEx, payload, 2, msg, length);
+		_driver->sysEx(msg, length);
+	}
+
+	void metaEvent(byte type, byte *data, uint16 length) { _driver->metaEvent(type, data, length); }
+
+	void setPitchBendRange(byte channel, uint range) { _driver->setPitchBendRange(channel, range); }
+
+	void sysEx_customInstrument(byte channel, uint32 type, const byte *instr) {
+		_driver->sysEx_customInstrument(channel, type, instr);
+	}
+
+	void setTimerCallback(void *timer_param, Common::TimerManager::TimerProc timer_proc) {
+		_timerParam = timer_param;
+		_timerProc = timer_proc;
+		if (timer_proc)
+			_driver->setTimerCallback(this, &TracingMidiDriver::timerProc);
+		else
+			_driver->setTimerCallback(0, 0);
+	}
+
+	uint32 getBaseTempo() { return _driver->getBaseTempo(); }
+
+	MidiChannel *allocateChannel() { return wrapChannel(_driver->allocateChannel()); }
+	MidiChannel *getPercussionChannel() { return wrapChannel(_driver->getPercussionChannel()); }
+
+private:
+	/** Return the wrapper of a channel of the driver, created on first use. */
+	MidiChannel *wrapChannel(MidiChannel *channel) {
+		if (!channel)
+			return 0;
+
+		for (uint i = 0; i < _channels.size(); ++i) {
+			if (_channels[i]->getChannel() == channel)
+				return _channels[i];
+		}
+
+		_channels.push_back(new TracingMidiChannel(this, channel, _recorder, _device));
+		return _channels.back();
+	}
+
+	static void timerProc(void *refCon) {
+		TracingMidiDriver *driver = static_cast<TracingMidiDriver *>(refCon);
+		if (driver->_timerProc) {
+			driver->_recorder->record(driver->_device, kTraceTick);
+			driver->_timerProc(driver->_timerParam);
+		}
+	}
+
+	TraceRecorder *_recorder;
+	MidiDriver *_driver;
+	const byte _device;
+
+	void *_timerParam;
+	Common::TimerManager::TimerProc _timerProc;
+
+	Common::Array<TracingMidiChannel *> _channels;
+};
+
+/** Return the size of the fixed part of the payload of a record, or -1 for an unknown type */
+int getPayloadSize(byte type) {
+	switch (type) {
+	case kTraceOpenOPL:
+		return 1;
+	case kTraceClose:
+	case kTraceTick:
+	case kTraceOPLInit:
+	case kTraceOPLReset:
+		return 0;
+	case kTraceOPLWrite:
+	case kTraceOPLWriteReg:
+		return 3;
+	case kTraceOpenMidi:
+	case kTraceFrequency:
+	case kTraceMidiSend:
+		return 4;
+	case kTraceMidiSysEx:
+		return 2;
+	default:
+		return -1;
+	}
+}
+
+} // End of anonymous namespace
+
+TraceRecorder::TraceRecorder(Common::WriteStream *stream) : _stream(stream), _devices(0), _quit(false) {
+	_pending.data = _writing.data = 0;
+	_pending.size = _writing.size = 0;
+	_pending.capacity = _writing.capacity = 0;
+
+	_stream->write("SVAT", 4);
+	_stream->writeByte(kTraceVersion);
+
+	_writer.start(writerMain, this);
+}
+
+TraceRecorder::~TraceRecorder() {
+	_mutex.lock();
+	_quit = true;
+	_wakeUp.signal();
+	_mutex.unlock();
+	_writer.join();
+
+	writePending();
+	_stream->finalize();
+	delete _stream;
+
+	free(_pending.data);
+	free(_writing.data);
+}
+
+/** The recorder returned by getConfigured() */
+static TraceRecorder *s_configuredRecorder = 0;
+
+TraceRecorder *TraceRecorder::getConfigured() {
+	if (!s_configuredRecorder && ConfMan.hasKey("audio_trace")) {
+		const Common::String &fileName = ConfMan.get("audio_trace");
+
+		Common::DumpFile *file = new Common::DumpFile();
+		if (!file->open(fileName)) {
+			warning("Could not open '%s' to record the audio trace", fileName.c_str());
+			delete file;
+			return 0;
+		}
+		s_configuredRecorder = new TraceRecorder(file);
+	}
+
+	return s_configuredRecorder;
+}
+
+void TraceRecorder::destroyConfigured() {
+	delete s_configuredRecorder;
+	s_configuredRecorder = 0;
+}
+
+OPL::OPL *TraceRecorder::wrapOPL(OPL::OPL *opl, OPL::Config::OplType type) {
+	if (_devices == 0xFF) {
+		warning("Too many devices to trace");
+		return opl;
+	}
+	return new TracingOPL(this, opl, type);
+}
+
+MidiDriver *TraceRecorder::wrapMidiDriver(MidiDriver *driver) {
+	if (_devices == 0xFF) {
+		warning("Too many devices to trace");
+		return driver;
+	}
+	return new TracingMidiDriver(this, driver);
+}
+
+byte TraceRecorder::addDevice() {
+	Common::NativeStackLock lock(_mutex);
+	return _devices++;
+}
+
+void TraceRecorder::record(byte device, TraceRecordType type, const byte *data, uint size, const byte *tail, uint tailSize) {
+	const uint32 recordSize = 2 + size + tailSize;
+
+	Common::NativeStackLock lock(_mutex);
+
+	if (_pending.size + recordSize > _pending.capacity) {
+		// Rarely needed, as the buffers are swapped rather than freed
+		uint32 capacity = MAX<uint32>(_pending.capacity, kTraceWriteThreshold);
+		while (capacity < _pending.size + recordSize)
+			capacity *= 2;
+
+		byte *newData = (byte *)realloc(_pending.data, capacity);
+		if (!newData)
+			return;
+		_pending.data = newData;
+		_pending.capacity = capacity;
+	}
+
+	byte *dst = _pending.data + _pending.size;
+	dst[0] = type;
+	dst[1] = device;
+	if (size)
+		memcpy(dst + 2, data, size);
+	if (tailSize)
+		memcpy(dst + 2 + size, tail, tailSize);
+
+	const bool wake = _pending.size < kTraceWriteThreshold && _pending.size + recordSize >= kTraceWriteThreshold;
+	_pending.size += recordSize;
+	if (wake)
+		_wakeUp.signal();
+}
+
+void TraceRecorder::flush() {
+	writePending();
+
+	Common::NativeStackLock lock(_streamMutex);
+	_stream->flush();
+}
+
+void TraceRecorder::writerMain(void *data) {
+	TraceRecorder *recorder = (TraceRecorder *)data;
+
+	recorder->_mutex.lock();
+	while (!recorder->_quit) {
+		if (recorder->_pending.size < kTraceWriteThreshold) {
+			recorder->_wakeUp.wait(recorder->_mutex);
+			continue;
+		}
+
+		recorder->_mutex.unlock();
+		recorder->writePending();
+		recorder->_mutex.lock();
+	}
+	recorder->_mutex.unlock();
+}
+
+void TraceRecorder::writePending() {
+	Common::NativeStackLock streamLock(_streamMutex);
+
+	// Only the pointers are exchanged under the lock the records are added with
+	_mutex.lock();
+	SWAP(_pending, _writing);
+	_mutex.unlock();
+
+	if (_writing.size)
+		_stream->write(_writing.data, _writing.size);
+	_writing.size = 0;
+}
+
+bool loadTrace(Common::ReadStream &stream, Common::Array<TraceDevice> &devices) {
+	char magic[4];
+	if (stream.read(magic, 4) != 4 || memcmp(magic, "SVAT", 4) || stream.readByte() != kTraceVersion)
+		return false;
+
+	// Index into devices for each device number of the trace
+	int index[256];
+	for (int i = 0; i < 256; ++i)
+		index[i] = -1;
+
+	byte payload[4];
+
+	while (true) {
+		const byte type = stream.readByte();
+		const byte device = stream.readByte();
+		if (stream.eos())
+			break;
+
+		const int size = getPayloadSize(type);
+		if (size < 0)
+			return false;
+		if (stream.read(payload, size) != (uint32)size)
+			break;
+
+		if (type == kTraceOpenOPL || type == kTraceOpenMidi) {
+			if (type == kTraceOpenOPL && payload[0] > OPL::Config::kOpl3)
+				return false;
+
+			TraceDevice dev;
+			dev.isOPL = type == kTraceOpenOPL;
+			dev.oplType = dev.isOPL ? (OPL::Config::OplType)payload[0] : OPL::Config::kOpl2;
+			dev.tempo = dev.isOPL ? 0 : READ_LE_UINT32(payload);
+
+			// A device number may be used again after the device was closed
+			index[device] = devices.size();
+			devices.push_back(dev);
+			continue;
+		}
+
+		// Records of a device we did not see open are useless
+		if (index[device] < 0) {
+			if (type == kTraceMidiSysEx) {
+				for (uint length = READ_LE_UINT16(payload); length; --length)
+					stream.readByte();
+			}
+			continue;
+		}
+
+		Common::Array<byte> &records = devices[index[device]].records;
+		records.push_back(type);
+		for (int i = 0; i < size; ++i)
+			records.push_back(payload[i]);
+
+		if (type == kTraceMidiSysEx) {
+			const uint length = READ_LE_UINT16(payload);
+			const uint pos = records.size();
+			records.resize(pos + length);
+			if (length && stream.read(&records[pos], length) != length) {
+				// Cut off in the middle of the trace
+				records.resize(pos - 3);
+				break;
+			}
+		}
+
+		if (type == kTraceClose)
+			index[device] = -1;
+	}
+
+	return true;
+}
+
+TracePlayer::TracePlayer(const TraceDevice &device) : _device(device), _opl(0), _driver(0),
+	_pos(0), _ticks(0), _frequency(0), _elapsed(0), _started(false) {
+}
+
+TracePlayer::~TracePlayer() {
+	stop();
+}
+
+void TracePlayer::start(OPL::OPL *opl) {
+	_opl = opl;
+	play();
+
+	// The callbacks only start once the initial records are sent, so that
+	// the first tick does not run in parallel to them
+	if (_frequency) {
+		_started = true;
+		_opl->start(new Common::Functor0Mem<void, TracePlayer>(this, &TracePlayer::onTimer), _frequency);
+	}
+}
+
+void TracePlayer::start(MidiDriver *driver) {
+	_driver = driver;
+	play();
+
+	_started = true;
+	_driver->setTimerCallback(this, &TracePlayer::midiTimerProc);
+}
+
+void TracePlayer::stop() {
+	if (!_started)
+		return;
+
+	if (_opl)
+		_opl->stop();
+	if (_driver)
+		_driver->setTimerCallback(0, 0);
+	_started = false;
+}
+
+void TracePlayer::midiTimerProc(void *refCon) {
+	static_cast<TracePlayer *>(refCon)->onTimer();
+}
+
+void TracePlayer::onTimer() {
+	if (_driver) {
+		// Play as many recorded ticks as fit into the time passed
+		_elapsed += _driver->getBaseTempo();
+		while (!isFinished() && (uint64)(_ticks + 1) * _device.tempo <= _elapsed) {
+			++_pos;
+			++_ticks;
+			play();
+		}
+	} else if (!isFinished()) {
+		++_pos;
+		++_ticks;
+		play();
+	}
+}
+
+void TracePlayer::play() {
+	const Common::Array<byte> &records = _device.records;
+
+	while (_pos < records.size()) {
+		const byte type = records[_pos];
+		const byte *payload = &records[_pos] + 1;
+
+		if (type == kTraceTick)
+			return;
+
+		switch (type) {
+		case kTraceClose:
+			// Anything after this is of no interest
+			_pos = records.size();
+			return;
+
+		case kTraceFrequency:
+			if (!_opl)
+				break;
+			if (_started)
+				_opl->setCallbackFrequency(READ_LE_UINT32(payload));
+			else
+				_frequency = READ_LE_UINT32(payload);
+			break;
+
+		case kTraceOPLInit:
+			if (_opl)
+				_opl->init();
+			break;
+
+		case kTraceOPLReset:
+			if (_opl)
+				_opl->reset();
+			break;
+
+		case kTraceOPLWrite:
+			if (_opl)
+				_opl->write(READ_LE_UINT16(payload), payload[2]);
+			break;
+
+		case kTraceOPLWriteReg:
+			if (_opl)
+				_opl->writeReg(READ_LE_UINT16(payload), payload[2]);
+			break;
+
+		case kTraceMidiSend:
+			if (_driver)
+				_driver->send(READ_LE_UINT32(payload));
+			break;
+
+		case kTraceMidiSysEx:
+			if (_driver)
+				_driver->sysEx(payload + 2, READ_LE_UINT16(payload));
+			_pos += READ_LE_UINT16(payload);
+			break;
+
+		default:
+			break;
+		}
+
+		_pos += 1 + getPayloadSize(type);
+	}
+}
+
+} // End of namespace Audio
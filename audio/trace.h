@@ -0,0 +1,244 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef AUDIO_TRACE_H
+#define AUDIO_TRACE_H
+
+#include "audio/fmopl.h"
+#include "audio/mididrv.h"
+
+#include "common/array.h"
+#include "common/scummsys.h"
+#include "common/str.h"
+#include "common/threadpool.h"
+
+namespace Common {
+class ReadStream;
+class WriteStream;
+}
+
+namespace Audio {
+
+/**
+ * The records of an audio trace.
+ *
+ * A trace starts with the four bytes "SVAT" and a version byte, followed by
+ * records. Each record consists of its type byte, the number of the device
+ * it belongs to and a type specific payload. All values are little endian.
+ */
+enum TraceRecordType {
+	kTraceOpenOPL = 1,		///< uint8 OPL::Config::OplType
+	kTraceOpenMidi = 2,		///< uint32 microseconds per timer tick
+	kTraceClose = 3,		///< -
+	kTraceTick = 4,			///< - (the timer callback of the device was invoked)
+	kTraceFrequency = 5,	///< uint32 OPL timer callback frequency
+	kTraceOPLInit = 6,		///< -
+	kTraceOPLReset = 7,		///< -
+	kTraceOPLWrite = 8,		///< uint16 port, uint8 value
+	kTraceOPLWriteReg = 9,	///< uint16 register, uint8 value
+	kTraceMidiSend = 10,	///< uint32 packed MIDI message
+	kTraceMidiSysEx = 11	///< uint16 length, SysEx data without framing
+};
+
+/**
+ * Records everything sent to OPL chips and MIDI drivers into a trace, along
+ * with the timer callbacks pacing it, so that the music of a game can be
+ * replayed without the engine. Set the "audio_trace" config key to the file
+ * to record to.
+ *
+ * MidiChannel traffic is recorded as the equivalent messages to the driver.
+ * Custom instruments and channel priorities have no such equivalent and are
+ * not recorded.
+ *
+ * Records are collected in memory, as many of them come from the mixer
+ * thread, and written to the stream by a thread of the recorder. Without
+ * thread support, they are written by flush().
+ */
+class TraceRecorder {
+public:
+	/** Start a trace on the given stream, of which the recorder takes ownership. */
+	explicit TraceRecorder(Common::WriteStream *stream);
+	~TraceRecorder();
+
+	/**
+	 * Return the recorder writing to the file set in "audio_trace", or 0 if
+	 * no trace is to be recorded. The file is created on first use.
+	 */
+	static TraceRecorder *getConfigured();
+
+	/**
+	 * Finish the trace of the recorder returned by getConfigured(), once all
+	 * devices using it are gone.
+	 */
+	static void destroyConfigured();
+
+	/** Wrap an OPL into one which records what is sent to it. Takes ownership of opl. */
+	OPL::OPL *wrapOPL(OPL::OPL *opl, OPL::Config::OplType type);
+
+	/** Wrap a MIDI driver into one which records what is sent to it. Takes ownership of driver. */
+	MidiDriver *wrapMidiDriver(MidiDriver *driver);
+
+	/** Allocate a device number for a wrapper. */
+	byte addDevice();
+
+	/**
+	 * Add a record; safe to call from any thread, and does not wait for the
+	 * stream. The payload may be passed in two parts, which are written one
+	 * after the other.
+	 */
+	void record(byte device, TraceRecordType type, const byte *data = 0, uint size = 0,
+	            const byte *tail = 0, uint tailSize = 0);
+
+	/** Write the records added so far to the stream. */
+	void flush();
+
+private:
+	/** A growing block of records */
+	struct Buffer {
+		byte *data;
+		uint32 size;
+		uint32 capacity;
+	};
+
+	static void writerMain(void *data);
+
+	/** Write the pending records to the stream. */
+	void writePending();
+
+	/** Guards _pending, _quit and _devices */
+	Common::NativeMutex _mutex;
+	/** Guards the stream and _writing, held while writing to the stream */
+	Common::NativeMutex _streamMutex;
+	/** Signaled when there is enough to write, or on quitting */
+	Common::NativeCondition _wakeUp;
+	Common::NativeThread _writer;
+
+	Common::WriteStream *_stream;
+	/** The records not written yet */
+	Buffer _pending;
+	/** The records being written, swapped with _pending */
+	Buffer _writing;
+	byte _devices;
+	bool _quit;
+};
+
+/**
+ * The records of one device of a trace.
+ */
+struct TraceDevice {
+	/** Whether the device is an OPL, as opposed to a MIDI driver */
+	bool isOPL;
+	OPL::Config::OplType oplType;
+	/** Microseconds per timer tick of a MIDI driver */
+	uint32 tempo;
+	/** The records in their order, without the device numbers and the open record */
+	Common::Array<byte> records;
+};
+
+/**
+ * Load all devices of a trace.
+ *
+ * @return false if the stream does not contain a valid trace
+ */
+bool loadTrace(Common::ReadStream &stream, Common::Array<TraceDevice> &devices);
+
+/**
+ * Feeds the records of a traced device to an OPL or MIDI driver, driven by
+ * the timer callbacks of that.
+ *
+ * Timer ticks of a MIDI driver are matched up by time, so that the trace
+ * plays at the right speed on a driver with another tempo.
+ */
+class TracePlayer {
+public:
+	explicit TracePlayer(const TraceDevice &device);
+	~TracePlayer();
+
+	/**
+	 * Play the trace on an OPL which has not been initialized yet. Everything
+	 * up to the first tick is sent at once, then the timer callbacks are
+	 * started.
+	 */
+	void start(OPL::OPL *opl);
+
+	/** Play the trace on an open MIDI driver. */
+	void start(MidiDriver *driver);
+
+	/** Stop the timer callbacks of the OPL or MIDI driver. */
+	void stop();
+
+	/** Return whether all records have been played. */
+	bool isFinished() const { return _pos >= _device.records.size(); }
+
+	/** Return the number of ticks of the trace played so far. */
+	uint32 getTicks() const { return _ticks; }
+
+	/** The timer callback, public for the tests. */
+	void onTimer();
+
+private:
+	static void midiTimerProc(void *refCon);
+
+	/** Send the records up to the next tick. */
+	void play();
+
+	const TraceDevice &_device;
+	OPL::OPL *_opl;
+	MidiDriver *_driver;
+	uint _pos;
+	uint32 _ticks;
+	/** The callback frequency of the OPL, or 0 before it is known */
+	uint32 _frequency;
+	/** Microseconds passed on the MIDI driver */
+	uint64 _elapsed;
+	bool _started;
+};
+
+/**
+ * The outcome of replaying one device of a trace.
+ */
+struct TraceReplayStats {
+	Common::String description;
+	/** Output frames rendered, or 0 if the mixer was driven by the backend */
+	uint32 frames;
+	uint32 millis;
+	/** Checksum of the rendered output */
+	uint32 checksum;
+	bool complete;
+};
+
+/**
+ * Replay the devices of a trace one after another, through the configured
+ * OPL emulator resp. music driver.
+ *
+ * If the backend does not mix audio on its own, like the null backend, the
+ * mixer is driven here as fast as possible, which gives reproducible output
+ * for benchmarking and comparing emulators. Otherwise, the trace is simply
+ * played in real time.
+ *
+ * @return false if the stream does not contain a valid trace
+ */
+bool replayTrace(Common::ReadStream &stream, Common::Array<TraceReplayStats> &stats);
+
+} // End of namespace Audio
+
+#endif
@@ -0,0 +1,154 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "audio/trace.h"
+
+#include "audio/mixer_intern.h"
+
+#include "common/system.h"
+
+namespace Audio {
+
+enum {
+	/** Replaying gives up when the device did not tick for this long */
+	kStallSeconds = 10
+};
+
+namespace {
+
+/**
+ * Wait for the player to finish, rendering the output if the backend does
+ * not drive the mixer.
+ */
+void runPlayer(TracePlayer &player, bool headless, TraceReplayStats &stats) {
+	MixerImpl *mixer = static_cast<MixerImpl *>(g_system->getMixer());
+
+	uint32 ticks = player.getTicks();
+	const uint32 start = g_system->getMillis();
+
+	if (headless) {
+		// Render as fast as possible, pacing by the output only
+		const uint32 rate = mixer->getOutputRate();
+		const uint kFrames = 1024;
+		int16 buffer[kFrames * 2];
+
+		uint32 lastTick = 0;
+		uint32 hash = 2166136261u;
+
+		while (!player.isFinished() && stats.frames - lastTick < rate * kStallSeconds) {
+			mixer->mixCallback((byte *)buffer, sizeof(buffer));
+			stats.frames += kFrames;
+
+			// FNV-1a over the samples
+			for (uint i = 0; i < kFrames * 2; ++i)
+				hash = (hash ^ (uint16)buffer[i]) * 16777619u;
+
+			if (player.getTicks() != ticks) {
+				ticks = player.getTicks();
+				lastTick = stats.frames;
+			}
+		}
+
+		stats.checksum = hash;
+	} else {
+		uint32 lastTick = start;
+		while (!player.isFinished() && g_system->getMillis() - lastTick < kStallSeconds * 1000) {
+			g_system->delayMillis(10);
+			if (player.getTicks() != ticks) {
+				ticks = player.getTicks();
+				lastTick = g_system->getMillis();
+			}
+		}
+	}
+
+	stats.millis = g_system->getMillis() - start;
+	stats.complete = player.isFinished();
+	player.stop();
+}
+
+void replayOPL(const TraceDevice &device, bool headless, TraceReplayStats &stats) {
+	static const char *const typeNames[] = { "OPL2", "Dual OPL2", "OPL3" };
+	const OPL::Config::EmulatorDescription *emulator = OPL::Config::findDriver(OPL::Config::detect(device.oplType));
+	stats.description = Common::String::format("%s on %s", typeNames[device.oplType],
+	                                           emulator ? emulator->description : "<none>");
+
+	OPL::OPL *opl = OPL::Config::create(device.oplType);
+	if (!opl)
+		return;
+
+	TracePlayer player(device);
+	player.start(opl);
+	runPlayer(player, headless, stats);
+	delete opl;
+}
+
+void replayMidi(const TraceDevice &device, bool headless, TraceReplayStats &stats) {
+	const MidiDriver::DeviceHandle handle = MidiDriver::detectDevice(MDT_MIDI | MDT_ADLIB | MDT_PCSPK | MDT_PREFER_MT32);
+	stats.description = Common::String::format("MIDI on %s", MidiDriver::getDeviceString(handle, MidiDriver::kDeviceName).c_str());
+
+	MidiDriver *driver = MidiDriver::createMidi(handle);
+	if (!driver)
+		return;
+
+	if (driver->open() == 0) {
+		TracePlayer player(device);
+		player.start(driver);
+		runPlayer(player, headless, stats);
+		driver->close();
+	}
+	delete driver;
+}
+
+} // End of anonymous namespace
+
+bool replayTrace(Common::ReadStream &stream, Common::Array<TraceReplayStats> &stats) {
+	Common::Array<TraceDevice> devices;
+	if (!loadTrace(stream, devices))
+		return false;
+
+	// A mixer the backend does not drive, like the one of the null backend,
+	// is driven from here
+	MixerImpl *mixer = static_cast<MixerImpl *>(g_system->getMixer());
+	const bool headless = !mixer->isReady();
+	mixer->setReady(true);
+
+	for (uint i = 0; i < devices.size(); ++i) {
+		TraceReplayStats deviceStats;
+		deviceStats.frames = 0;
+		deviceStats.millis = 0;
+		deviceStats.checksum = 0;
+		deviceStats.complete = false;
+
+		// The devices play one after another
+		if (devices[i].isOPL)
+			replayOPL(devices[i], headless, deviceStats);
+		else
+			replayMidi(devices[i], headless, deviceStats);
+
+		stats.push_back(deviceStats);
+	}
+
+	mixer->setReady(!headless);
+	return true;
+}
+
+} // End of namespace Audio
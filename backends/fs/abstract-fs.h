@@ -173,6 +173,13 @@ public:
 	 */
 	virtual bool isWritable() const = 0;
 
+	/**
+	 * Returns the time of the last modification of the file or directory, in
+	 * seconds since some epoch. Only meant to detect changes, and 0 if the
+	 * backend cannot tell.
+	 */
+	virtual uint32 getModificationTime() const { return 0; }
+
 
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
@@ -38,6 +38,9 @@
 #include "../../platform/libretro/libretro-common/include/retro_dirent.h"
 #include "../../platform/libretro/libretro-common/include/retro_stat.h"
 #include "../../platform/libretro/libretro-common/include/file/file_path.h"
+#if !defined(VITA) && !defined(PSP)
+#include <sys/stat.h>
+#endif
 #else
 #include <sys/param.h>
 #include <sys/stat.h>
@@ -67,6 +70,18 @@ void POSIXFilesystemNode::setFlags() {
 #endif
 }
 
+uint32 POSIXFilesystemNode::getModificationTime() const {
+#if defined(__LIBRETRO__) && (defined(VITA) || defined(PSP))
+	return 0;
+#else
+	struct stat st;
+
+	if (stat(_path.c_str(), &st) != 0)
+		return 0;
+	return (uint32)st.st_mtime;
+#endif
+}
+
 POSIXFilesystemNode::POSIXFilesystemNode(const Common::String &p) {
 	assert(p.size() > 0);
 
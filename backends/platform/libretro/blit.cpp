@@ -0,0 +1,477 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include <retro_inline.h>
+
+#include "blit.h"
+#include "libretro.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define RETRO_BLIT_SSE2
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RETRO_BLIT_NEON
+#endif
+
+/**
+ * Everything needed to move the color channels of one direct color format
+ * into another one. Source channels are widened to 8 bits the same way
+ * Graphics::PixelFormat::colorToRGB() does, so all kernels produce the same
+ * output as the per pixel reference path.
+ */
+struct RetroChannelMap
+{
+   int inShift[3];
+   uint32 inMask[3];
+   int expandLeft[3];
+   int expandRight[3];
+   int outLoss[3];
+   int outShift[3];
+   uint32 outAlpha;
+
+   RetroChannelMap(const Graphics::PixelFormat& aIn, const Graphics::PixelFormat& aOut)
+   {
+      const int inBits[3] = { aIn.rBits(), aIn.gBits(), aIn.bBits() };
+
+      inShift[0] = aIn.rShift;
+      inShift[1] = aIn.gShift;
+      inShift[2] = aIn.bShift;
+      outLoss[0] = aOut.rLoss;
+      outLoss[1] = aOut.gLoss;
+      outLoss[2] = aOut.bLoss;
+      outShift[0] = aOut.rShift;
+      outShift[1] = aOut.gShift;
+      outShift[2] = aOut.bShift;
+
+      for (int i = 0; i < 3; i++)
+      {
+         inMask[i] = (1 << inBits[i]) - 1;
+         expandLeft[i] = 8 - inBits[i];
+         expandRight[i] = 2 * inBits[i] - 8;
+      }
+
+      outAlpha = aOut.RGBToColor(0, 0, 0);
+   }
+
+   /** The expansion above is exact for channels of 4 to 8 bits */
+   static bool supports(const Graphics::PixelFormat& aFormat)
+   {
+      return aFormat.rBits() >= 4 && aFormat.rBits() <= 8 &&
+         aFormat.gBits() >= 4 && aFormat.gBits() <= 8 &&
+         aFormat.bBits() >= 4 && aFormat.bBits() <= 8;
+   }
+
+   INLINE uint32 convert(uint32 aColor) const
+   {
+      uint32 color = outAlpha;
+
+      for (int i = 0; i < 3; i++)
+      {
+         const uint32 c = (aColor >> inShift[i]) & inMask[i];
+         color |= (((c << expandLeft[i]) | (c >> expandRight[i])) >> outLoss[i]) << outShift[i];
+      }
+
+      return color;
+   }
+};
+
+typedef void (*RetroRowKernel)(byte *aOut, const byte *aIn, uint aCount, const RetroChannelMap& aMap);
+
+template<int InBpp, int OutBpp>
+static void row_rgb(byte *aOut, const byte *aIn, uint aCount, const RetroChannelMap& aMap)
+{
+   for (uint i = 0; i < aCount; i++)
+   {
+      const uint32 color = aMap.convert((InBpp == 2) ? ((const uint16 *)aIn)[i] : ((const uint32 *)aIn)[i]);
+
+      if (OutBpp == 2)
+         ((uint16 *)aOut)[i] = color;
+      else
+         ((uint32 *)aOut)[i] = color;
+   }
+}
+
+#ifdef RETRO_BLIT_SSE2
+struct RetroChannelMapSSE2
+{
+   __m128i inShift[3];
+   __m128i inMask[3];
+   __m128i expandLeft[3];
+   __m128i expandRight[3];
+   __m128i outLoss[3];
+   __m128i outShift[3];
+   __m128i outAlpha;
+
+   RetroChannelMapSSE2(const RetroChannelMap& aMap)
+   {
+      for (int i = 0; i < 3; i++)
+      {
+         inShift[i] = _mm_cvtsi32_si128(aMap.inShift[i]);
+         inMask[i] = _mm_set1_epi32(aMap.inMask[i]);
+         expandLeft[i] = _mm_cvtsi32_si128(aMap.expandLeft[i]);
+         expandRight[i] = _mm_cvtsi32_si128(aMap.expandRight[i]);
+         outLoss[i] = _mm_cvtsi32_si128(aMap.outLoss[i]);
+         outShift[i] = _mm_cvtsi32_si128(aMap.outShift[i]);
+      }
+
+      outAlpha = _mm_set1_epi32(aMap.outAlpha);
+   }
+
+   INLINE __m128i convert(__m128i aColors) const
+   {
+      __m128i colors = outAlpha;
+
+      for (int i = 0; i < 3; i++)
+      {
+         __m128i c = _mm_and_si128(_mm_srl_epi32(aColors, inShift[i]), inMask[i]);
+         c = _mm_or_si128(_mm_sll_epi32(c, expandLeft[i]), _mm_srl_epi32(c, expandRight[i]));
+         colors = _mm_or_si128(colors, _mm_sll_epi32(_mm_srl_epi32(c, outLoss[i]), outShift[i]));
+      }
+
+      return colors;
+   }
+};
+
+template<int InBpp, int OutBpp>
+static void row_sse2(byte *aOut, const byte *aIn, uint aCount, const RetroChannelMap& aMap)
+{
+   const RetroChannelMapSSE2 map(aMap);
+   const __m128i zero = _mm_setzero_si128();
+   uint i = 0;
+
+   for (; i + 8 <= aCount; i += 8)
+   {
+      __m128i lo, hi;
+
+      if (InBpp == 2)
+      {
+         const __m128i in = _mm_loadu_si128((const __m128i *)(aIn + i * 2));
+         lo = _mm_unpacklo_epi16(in, zero);
+         hi = _mm_unpackhi_epi16(in, zero);
+      }
+      else
+      {
+         lo = _mm_loadu_si128((const __m128i *)(aIn + i * 4));
+         hi = _mm_loadu_si128((const __m128i *)(aIn + i * 4 + 16));
+      }
+
+      lo = map.convert(lo);
+      hi = map.convert(hi);
+
+      if (OutBpp == 2)
+      {
+         /* SSE2 has no unsigned 32->16 pack, so sign extend first */
+         lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+         hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+         _mm_storeu_si128((__m128i *)(aOut + i * 2), _mm_packs_epi32(lo, hi));
+      }
+      else
+      {
+         _mm_storeu_si128((__m128i *)(aOut + i * 4), lo);
+         _mm_storeu_si128((__m128i *)(aOut + i * 4 + 16), hi);
+      }
+   }
+
+   row_rgb<InBpp, OutBpp>(aOut + i * OutBpp, aIn + i * InBpp, aCount - i, aMap);
+}
+#endif
+
+#ifdef RETRO_BLIT_NEON
+struct RetroChannelMapNEON
+{
+   int32x4_t inShift[3];
+   uint32x4_t inMask[3];
+   int32x4_t expandLeft[3];
+   int32x4_t expandRight[3];
+   int32x4_t outLoss[3];
+   int32x4_t outShift[3];
+   uint32x4_t outAlpha;
+
+   RetroChannelMapNEON(const RetroChannelMap& aMap)
+   {
+      /* vshlq shifts right for negative counts */
+      for (int i = 0; i < 3; i++)
+      {
+         inShift[i] = vdupq_n_s32(-aMap.inShift[i]);
+         inMask[i] = vdupq_n_u32(aMap.inMask[i]);
+         expandLeft[i] = vdupq_n_s32(aMap.expandLeft[i]);
+         expandRight[i] = vdupq_n_s32(-aMap.expandRight[i]);
+         outLoss[i] = vdupq_n_s32(-aMap.outLoss[i]);
+         outShift[i] = vdupq_n_s32(aMap.outShift[i]);
+      }
+
+      outAlpha = vdupq_n_u32(aMap.outAlpha);
+   }
+
+   INLINE uint32x4_t convert(uint32x4_t aColors) const
+   {
+      uint32x4_t colors = outAlpha;
+
+      for (int i = 0; i < 3; i++)
+      {
+         uint32x4_t c = vandq_u32(vshlq_u32(aColors, inShift[i]), inMask[i]);
+         c = vorrq_u32(vshlq_u32(c, expandLeft[i]), vshlq_u32(c, expandRight[i]));
+         colors = vorrq_u32(colors, vshlq_u32(vshlq_u32(c, outLoss[i]), outShift[i]));
+      }
+
+      return colors;
+   }
+};
+
+template<int InBpp, int OutBpp>
+static void row_neon(byte *aOut, const byte *aIn, uint aCount, const RetroChannelMap& aMap)
+{
+   const RetroChannelMapNEON map(aMap);
+   uint i = 0;
+
+   for (; i + 8 <= aCount; i += 8)
+   {
+      uint32x4_t lo, hi;
+
+      if (InBpp == 2)
+      {
+         const uint16x8_t in = vld1q_u16((const uint16_t *)(aIn + i * 2));
+         lo = vmovl_u16(vget_low_u16(in));
+         hi = vmovl_u16(vget_high_u16(in));
+      }
+      else
+      {
+         lo = vld1q_u32((const uint32_t *)(aIn + i * 4));
+         hi = vld1q_u32((const uint32_t *)(aIn + i * 4 + 16));
+      }
+
+      lo = map.convert(lo);
+      hi = map.convert(hi);
+
+      if (OutBpp == 2)
+         vst1q_u16((uint16_t *)(aOut + i * 2), vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)));
+      else
+      {
+         vst1q_u32((uint32_t *)(aOut + i * 4), lo);
+         vst1q_u32((uint32_t *)(aOut + i * 4 + 16), hi);
+      }
+   }
+
+   row_rgb<InBpp, OutBpp>(aOut + i * OutBpp, aIn + i * InBpp, aCount - i, aMap);
+}
+#endif
+
+template<typename T>
+static void row_clut8(byte *aOut, const byte *aIn, uint aCount, const uint32 *aLUT)
+{
+   T *out = (T *)aOut;
+   uint i = 0;
+
+   /* Unrolling keeps the table loads independent */
+   for (; i + 4 <= aCount; i += 4)
+   {
+      out[i + 0] = aLUT[aIn[i + 0]];
+      out[i + 1] = aLUT[aIn[i + 1]];
+      out[i + 2] = aLUT[aIn[i + 2]];
+      out[i + 3] = aLUT[aIn[i + 3]];
+   }
+
+   for (; i < aCount; i++)
+      out[i] = aLUT[aIn[i]];
+}
+
+/* Neither SSE2 nor NEON can gather, so the vector kernels below still look
+ * up one pixel at a time, but assemble and write 8 pixels per store. */
+#ifdef RETRO_BLIT_SSE2
+template<typename T>
+static void row_clut8_sse2(byte *aOut, const byte *aIn, uint aCount, const uint32 *aLUT)
+{
+   uint i = 0;
+
+   for (; i + 8 <= aCount; i += 8)
+   {
+      const byte *in = aIn + i;
+      __m128i lo = _mm_setr_epi32(aLUT[in[0]], aLUT[in[1]], aLUT[in[2]], aLUT[in[3]]);
+      __m128i hi = _mm_setr_epi32(aLUT[in[4]], aLUT[in[5]], aLUT[in[6]], aLUT[in[7]]);
+
+      if (sizeof(T) == 2)
+      {
+         lo = _mm_srai_epi32(_mm_slli_epi32(lo, 16), 16);
+         hi = _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16);
+         _mm_storeu_si128((__m128i *)(aOut + i * 2), _mm_packs_epi32(lo, hi));
+      }
+      else
+      {
+         _mm_storeu_si128((__m128i *)(aOut + i * 4), lo);
+         _mm_storeu_si128((__m128i *)(aOut + i * 4 + 16), hi);
+      }
+   }
+
+   row_clut8<T>(aOut + i * sizeof(T), aIn + i, aCount - i, aLUT);
+}
+#endif
+
+#ifdef RETRO_BLIT_NEON
+template<typename T>
+static void row_clut8_neon(byte *aOut, const byte *aIn, uint aCount, const uint32 *aLUT)
+{
+   uint i = 0;
+
+   for (; i + 8 <= aCount; i += 8)
+   {
+      const byte *in = aIn + i;
+      uint32x4_t lo = vdupq_n_u32(aLUT[in[0]]);
+      uint32x4_t hi = vdupq_n_u32(aLUT[in[4]]);
+      lo = vsetq_lane_u32(aLUT[in[1]], lo, 1);
+      hi = vsetq_lane_u32(aLUT[in[5]], hi, 1);
+      lo = vsetq_lane_u32(aLUT[in[2]], lo, 2);
+      hi = vsetq_lane_u32(aLUT[in[6]], hi, 2);
+      lo = vsetq_lane_u32(aLUT[in[3]], lo, 3);
+      hi = vsetq_lane_u32(aLUT[in[7]], hi, 3);
+
+      if (sizeof(T) == 2)
+         vst1q_u16((uint16_t *)(aOut + i * 2), vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)));
+      else
+      {
+         vst1q_u32((uint32_t *)(aOut + i * 4), lo);
+         vst1q_u32((uint32_t *)(aOut + i * 4 + 16), hi);
+      }
+   }
+
+   row_clut8<T>(aOut + i * sizeof(T), aIn + i, aCount - i, aLUT);
+}
+#endif
+
+/* Kernels for 16/32 bit sources to 16/32 bit targets, indexed by bpp / 4 */
+static RetroRowKernel s_rowKernels[2][2] =
+{
+   { row_rgb<2, 2>, row_rgb<2, 4> },
+   { row_rgb<4, 2>, row_rgb<4, 4> }
+};
+
+typedef void (*RetroClutKernel)(byte *aOut, const byte *aIn, uint aCount, const uint32 *aLUT);
+
+/* Kernels for CLUT8 sources to 16/32 bit targets, indexed by bpp / 4 */
+static RetroClutKernel s_clutKernels[2] = { row_clut8<uint16>, row_clut8<uint32> };
+
+void retroBlitInit(uint64 aCPUFeatures)
+{
+#ifdef RETRO_BLIT_SSE2
+   if (aCPUFeatures & RETRO_SIMD_SSE2)
+   {
+      s_rowKernels[0][0] = row_sse2<2, 2>;
+      s_rowKernels[0][1] = row_sse2<2, 4>;
+      s_rowKernels[1][0] = row_sse2<4, 2>;
+      s_rowKernels[1][1] = row_sse2<4, 4>;
+      s_clutKernels[0] = row_clut8_sse2<uint16>;
+      s_clutKernels[1] = row_clut8_sse2<uint32>;
+   }
+#endif
+
+#ifdef RETRO_BLIT_NEON
+   if (aCPUFeatures & RETRO_SIMD_NEON)
+   {
+      s_rowKernels[0][0] = row_neon<2, 2>;
+      s_rowKernels[0][1] = row_neon<2, 4>;
+      s_rowKernels[1][0] = row_neon<4, 2>;
+      s_rowKernels[1][1] = row_neon<4, 4>;
+      s_clutKernels[0] = row_clut8_neon<uint16>;
+      s_clutKernels[1] = row_clut8_neon<uint32>;
+   }
+#endif
+}
+
+void retroBuildPaletteLUT(uint32 *aLUT, const byte *aColors, const Graphics::PixelFormat& aFormat)
+{
+   for (int i = 0; i < 256; i++, aColors += 3)
+      aLUT[i] = aFormat.RGBToColor(aColors[0], aColors[1], aColors[2]);
+}
+
+static INLINE uint32 readPixel(const byte *aIn, int aBpp)
+{
+   switch (aBpp)
+   {
+      case 1:
+         return *aIn;
+      case 2:
+         return *(const uint16 *)aIn;
+      case 3:
+#ifdef SCUMM_BIG_ENDIAN
+         return (aIn[0] << 16) | (aIn[1] << 8) | aIn[2];
+#else
+         return (aIn[2] << 16) | (aIn[1] << 8) | aIn[0];
+#endif
+      default:
+         return *(const uint32 *)aIn;
+   }
+}
+
+static void row_generic(byte *aOut, const Graphics::PixelFormat& aOutFormat, const byte *aIn, const Graphics::PixelFormat& aInFormat, uint aCount)
+{
+   for (uint i = 0; i < aCount; i++, aIn += aInFormat.bytesPerPixel)
+   {
+      uint8 r, g, b;
+      aInFormat.colorToRGB(readPixel(aIn, aInFormat.bytesPerPixel), r, g, b);
+
+      const uint32 color = aOutFormat.RGBToColor(r, g, b);
+      if (aOutFormat.bytesPerPixel == 2)
+         ((uint16 *)aOut)[i] = color;
+      else
+         ((uint32 *)aOut)[i] = color;
+   }
+}
+
+void retroBlitRect(Graphics::Surface& aOut, const Graphics::Surface& aIn, const uint32 *aLUT, const Common::Rect& aRect)
+{
+   const int inBpp = aIn.format.bytesPerPixel;
+   const int outBpp = aOut.format.bytesPerPixel;
+   const uint count = aRect.width();
+
+   const byte *in = (const byte *)aIn.getBasePtr(aRect.left, aRect.top);
+   byte *out = (byte *)aOut.getBasePtr(aRect.left, aRect.top);
+
+   if (inBpp == 1)
+   {
+      const RetroClutKernel kernel = s_clutKernels[outBpp / 4];
+
+      for (int i = aRect.top; i < aRect.bottom; i++, in += aIn.pitch, out += aOut.pitch)
+         kernel(out, in, count, aLUT);
+   }
+   else if (aIn.format == aOut.format)
+   {
+      for (int i = aRect.top; i < aRect.bottom; i++, in += aIn.pitch, out += aOut.pitch)
+         memcpy(out, in, count * outBpp);
+   }
+   else if ((inBpp == 2 || inBpp == 4) && RetroChannelMap::supports(aIn.format))
+   {
+      const RetroChannelMap map(aIn.format, aOut.format);
+      const RetroRowKernel kernel = s_rowKernels[inBpp / 4][outBpp / 4];
+
+      for (int i = aRect.top; i < aRect.bottom; i++, in += aIn.pitch, out += aOut.pitch)
+         kernel(out, in, count, map);
+   }
+   else
+   {
+      for (int i = aRect.top; i < aRect.bottom; i++, in += aIn.pitch, out += aOut.pitch)
+         row_generic(out, aOut.format, in, aIn.format, count);
+   }
+}
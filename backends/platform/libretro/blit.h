@@ -0,0 +1,49 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_LIBRETRO_BLIT_H
+#define BACKENDS_LIBRETRO_BLIT_H
+
+#include "common/scummsys.h"
+#include "common/rect.h"
+#include "graphics/surface.libretro.h"
+
+/**
+ * Select the conversion kernels once at startup. aCPUFeatures is a mask of
+ * RETRO_SIMD_* flags; vector kernels are only used when they were compiled
+ * in and the matching flag is set.
+ */
+void retroBlitInit(uint64 aCPUFeatures);
+
+/**
+ * Fill aLUT with the 256 colors of a VGA style palette, converted to aFormat.
+ */
+void retroBuildPaletteLUT(uint32 *aLUT, const byte *aColors, const Graphics::PixelFormat& aFormat);
+
+/**
+ * Convert aRect of aIn into the same area of aOut. Both surfaces must have
+ * the same dimensions. aLUT is the palette as returned by
+ * retroBuildPaletteLUT() and is only used for CLUT8 sources.
+ */
+void retroBlitRect(Graphics::Surface& aOut, const Graphics::Surface& aIn, const uint32 *aLUT, const Common::Rect& aRect);
+
+#endif
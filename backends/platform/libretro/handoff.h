@@ -0,0 +1,170 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef BACKENDS_LIBRETRO_HANDOFF_H
+#define BACKENDS_LIBRETRO_HANDOFF_H
+
+/*
+ * Single producer / single consumer structures used to pass frames, audio
+ * and state from the engine thread to the frontend thread without locking.
+ * They rely on the GCC __sync builtins for atomicity and memory ordering.
+ */
+
+#include "common/scummsys.h"
+#include "common/util.h"
+#include "graphics/surface.libretro.h"
+
+/**
+ * A flag raised by one thread and polled by another. Both sides are full
+ * memory barriers, so whatever was written before raising the flag is seen
+ * by the thread which finds it raised. Being a POD, it is zero initialized
+ * as a global without a constructor.
+ */
+struct RetroAtomicFlag
+{
+   volatile int value;
+
+   void raise() { __sync_fetch_and_or(&value, 1); }
+   bool isRaised() { return __sync_fetch_and_or(&value, 0) != 0; }
+};
+
+/**
+ * Triple buffered frame handoff. The producer always owns one buffer to draw
+ * into, the consumer owns the one it displays, and the third one holds the
+ * newest completed frame. Neither side ever waits for the other.
+ */
+class RetroTripleBuffer
+{
+   private:
+      enum
+      {
+         kIndexMask = 3,
+         kFresh = 4
+      };
+
+      Graphics::Surface _buffers[3];
+      int _back;
+      int _front;
+      /* Index of the middle buffer, plus kFresh if it was not consumed yet */
+      volatile int _state;
+
+   public:
+      RetroTripleBuffer() : _back(0), _front(1), _state(2)
+      {
+      }
+
+      ~RetroTripleBuffer()
+      {
+         for (int i = 0; i < 3; i++)
+            _buffers[i].free();
+      }
+
+      /** Copy aFrame into the back buffer and make it the newest frame */
+      void publish(const Graphics::Surface& aFrame)
+      {
+         Graphics::Surface& back = _buffers[_back];
+
+         if (back.w != aFrame.w || back.h != aFrame.h || back.format != aFrame.format)
+            back.create(aFrame.w, aFrame.h, aFrame.format);
+
+         for (int i = 0; i < aFrame.h; i++)
+            memcpy(back.getBasePtr(0, i), aFrame.getBasePtr(0, i), aFrame.w * aFrame.format.bytesPerPixel);
+
+         /* Make the pixels visible before handing the buffer over */
+         __sync_synchronize();
+         _back = __sync_lock_test_and_set(&_state, _back | kFresh) & kIndexMask;
+      }
+
+      /** Take the newest frame if there is one. Returns false if not. */
+      bool consume()
+      {
+         if (!(_state & kFresh))
+            return false;
+
+         _front = __sync_lock_test_and_set(&_state, _front) & kIndexMask;
+         __sync_synchronize();
+         return true;
+      }
+
+      const Graphics::Surface& front() const { return _buffers[_front]; }
+};
+
+/**
+ * Ring buffer of interleaved stereo 16 bit sample frames.
+ */
+class RetroAudioRing
+{
+   private:
+      int16 *_buffer;
+      const uint32 _size;
+      /* Free running frame counters, only ever advanced by their owner */
+      volatile uint32 _readPos;
+      volatile uint32 _writePos;
+
+   public:
+      /** aSize is in sample frames and must be a power of two */
+      RetroAudioRing(uint32 aSize) : _size(aSize), _readPos(0), _writePos(0)
+      {
+         _buffer = new int16[aSize * 2];
+      }
+
+      ~RetroAudioRing()
+      {
+         delete[] _buffer;
+      }
+
+      uint32 available() const { return _writePos - _readPos; }
+      uint32 space() const { return _size - available(); }
+
+      /** Producer side. Returns the number of frames actually queued. */
+      uint32 write(const int16 *aData, uint32 aFrames)
+      {
+         aFrames = MIN(aFrames, space());
+
+         const uint32 start = _writePos & (_size - 1);
+         const uint32 first = MIN(aFrames, _size - start);
+         memcpy(_buffer + start * 2, aData, first * 4);
+         memcpy(_buffer, aData + first * 2, (aFrames - first) * 4);
+
+         __sync_synchronize();
+         _writePos += aFrames;
+         return aFrames;
+      }
+
+      /** Consumer side. Returns the number of frames actually read. */
+      uint32 read(int16 *aData, uint32 aFrames)
+      {
+         aFrames = MIN(aFrames, available());
+         __sync_synchronize();
+
+         const uint32 start = _readPos & (_size - 1);
+         const uint32 first = MIN(aFrames, _size - start);
+         memcpy(aData, _buffer + start * 2, first * 4);
+         memcpy(aData + first * 2, _buffer, (aFrames - first) * 4);
+
+         __sync_synchronize();
+         _readPos += aFrames;
+         return aFrames;
+      }
+};
+
+#endif
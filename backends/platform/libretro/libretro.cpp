@@ -6,6 +6,7 @@
 #include "audio/mixer_intern.h"
 
 #include "os.h"
+#include "handoff.h"
 #include <libco.h>
 #include "libretro.h"
 
@@ -17,12 +18,44 @@
 #include <libgen.h>
 #include <string.h>
 
+#ifdef HAVE_THREADS
+#include <pthread.h>
+#endif
+
 retro_log_printf_t log_cb = NULL;
 static retro_video_refresh_t video_cb = NULL;
 static retro_audio_sample_batch_t audio_batch_cb = NULL;
 static retro_environment_t environ_cb = NULL;
 static retro_input_poll_t poll_cb = NULL;
 static retro_input_state_t input_cb = NULL;
+static bool can_dupe = false;
+/* Black in both output formats, with a pitch wide enough for either */
+static uint32 blank_frame[RES_W * RES_H];
+
+/* Audio is paced by the timing reported in retro_get_system_av_info.
+ *
+ * Engines have no frame rate of their own to report: they redraw whenever
+ * they like and keep time through getMillis() and delayMillis(), which
+ * follow the wall clock rather than retro_run. The rate only decides how
+ * often the latest frame is handed over, and how much audio goes along
+ * with it. 60 Hz is the refresh rate frontends sync to on nearly every
+ * display, so no frame needs to be repeated or dropped by the frontend and
+ * its audio rate control stays idle. Games redrawing faster, like those
+ * paced for 70 Hz VGA, just have their intermediate frames skipped, as
+ * they would on such a display with the SDL backend. */
+static double frame_rate = 60.0;
+static unsigned sample_rate = 44100;
+static double audio_frames_pending = 0.0;
+static int16_t *audio_buffer = NULL;
+static unsigned audio_buffer_frames = 0;
+
+/* Per frame timings are summed up and logged every TIMING_LOG_FRAMES */
+#define TIMING_LOG_FRAMES 600
+static unsigned timing_frames = 0;
+static unsigned timing_over_budget = 0;
+static uint64 timing_engine = 0;
+static uint64 timing_convert = 0;
+static uint64 timing_mix = 0;
 
 void retro_set_video_refresh(retro_video_refresh_t cb) { video_cb = cb; }
 void retro_set_audio_sample(retro_audio_sample_t cb) { }
@@ -35,14 +68,35 @@ void retro_set_environment(retro_environment_t cb)
    environ_cb = cb;
    bool tmp = true;
    environ_cb(RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME, &tmp);
+
+   static const struct retro_variable vars[] = {
+      { "scummvm_pixel_format", "Output pixel format (restart); RGB565|XRGB8888" },
+      { "scummvm_audio_rate", "Mixer output rate (restart); 44100|48000|32000|22050|11025" },
+      { "scummvm_frame_budget", "Engine time budget per frame in ms; 16|8|12|20|25|33|50" },
+#ifdef HAVE_THREADS
+      { "scummvm_threaded", "Run engine on its own thread (restart); disabled|enabled" },
+#endif
+      { NULL, NULL },
+   };
+   environ_cb(RETRO_ENVIRONMENT_SET_VARIABLES, (void*)vars);
 }
 
 bool FRONTENDwantsExit;
-bool EMULATORexited;
+/* Raised on the engine thread in threaded mode */
+RetroAtomicFlag EMULATORexited;
 
 cothread_t mainThread;
 cothread_t emuThread;
 
+/* In threaded mode the engine runs on a real thread instead of a cothread
+ * and retro_run only collects the frames and audio it produced. */
+static bool threaded = false;
+#ifdef HAVE_THREADS
+static pthread_t engineThread;
+static volatile bool engineRunning = false;
+static bool shutdownSent = false;
+#endif
+
 static char cmd_params[20][200];
 static char cmd_params_num;
 
@@ -53,14 +107,15 @@ void retro_leave_thread(void)
 
 static void retro_start_emulator(void)
 {
-   g_system = retroBuildOS();
+   if (!g_system)
+      g_system = retroBuildOS();
 
    static const char* argv[20];
    for(int i=0; i<cmd_params_num; i++)
       argv[i] = cmd_params[i];
 
    scummvm_main(cmd_params_num, argv);
-   EMULATORexited = true;
+   EMULATORexited.raise();
 
    if (log_cb)
       log_cb(RETRO_LOG_INFO, "Emulator loop has ended.\n");
@@ -87,6 +142,14 @@ static void retro_wrap_emulator()
    }
 }
 
+#ifdef HAVE_THREADS
+static void *retro_engine_thread(void *)
+{
+   retro_start_emulator();
+   return 0;
+}
+#endif
+
 unsigned retro_api_version(void)
 {
    return RETRO_API_VERSION;
@@ -111,8 +174,8 @@ void retro_get_system_av_info(struct retro_system_av_info *info)
    info->geometry.max_width = RES_W;
    info->geometry.max_height = RES_H;
    info->geometry.aspect_ratio = 4.0f / 3.0f;
-   info->timing.fps = 60.0;
-   info->timing.sample_rate = 44100.0;
+   info->timing.fps = frame_rate;
+   info->timing.sample_rate = sample_rate;
 }
 
 void retro_init (void)
@@ -127,6 +190,9 @@ void retro_init (void)
 
 void retro_deinit(void)
 {
+   free(audio_buffer);
+   audio_buffer = NULL;
+   audio_buffer_frames = 0;
 }
 
 void parse_command_params(char* cmdline)
@@ -236,23 +302,56 @@ bool retro_load_game(const struct retro_game_info *game)
 
    environ_cb(RETRO_ENVIRONMENT_SET_INPUT_DESCRIPTORS, desc);
 
-   /* Get color mode: 32 first as VGA has 6 bits per pixel */
-#if 0
-   RDOSGFXcolorMode = RETRO_PIXEL_FORMAT_XRGB8888;
-   if(!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &RDOSGFXcolorMode))
+   /* XRGB8888 keeps the full color depth of high color games */
+   enum retro_pixel_format pixelFormat = RETRO_PIXEL_FORMAT_0RGB1555;
+   struct retro_variable var = { "scummvm_pixel_format", NULL };
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value && !strcmp(var.value, "XRGB8888"))
    {
-      RDOSGFXcolorMode = RETRO_PIXEL_FORMAT_RGB565;
-      if(!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &RDOSGFXcolorMode))
-         RDOSGFXcolorMode = RETRO_PIXEL_FORMAT_0RGB1555;
+      pixelFormat = RETRO_PIXEL_FORMAT_XRGB8888;
+      if (!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &pixelFormat))
+         pixelFormat = RETRO_PIXEL_FORMAT_0RGB1555;
    }
-#endif
 
 #ifdef FRONTEND_SUPPORTS_RGB565
-   enum retro_pixel_format rgb565 = RETRO_PIXEL_FORMAT_RGB565;
-   if (!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &rgb565) && log_cb)
-      log_cb(RETRO_LOG_INFO, "Frontend supports RGB565 -will use that instead of XRGB1555.\n");
+   if (pixelFormat != RETRO_PIXEL_FORMAT_XRGB8888)
+   {
+      pixelFormat = RETRO_PIXEL_FORMAT_RGB565;
+      if (!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &pixelFormat) && log_cb)
+         log_cb(RETRO_LOG_INFO, "Frontend supports RGB565 -will use that instead of XRGB1555.\n");
+   }
 #endif
 
+   /* Trust the compiler flags unless the frontend knows the actual CPU */
+   uint64 cpuFeatures = RETRO_SIMD_SSE2 | RETRO_SIMD_NEON;
+   struct retro_perf_callback perf;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_PERF_INTERFACE, &perf) && perf.get_cpu_features)
+      cpuFeatures = perf.get_cpu_features();
+
+   retroSetPixelFormat(pixelFormat, cpuFeatures);
+
+   /* Mixing at the rate most of a game's samples use saves a resampling
+    * pass, as the frontend resamples to the host rate anyway. */
+   var.key = "scummvm_audio_rate";
+   var.value = NULL;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      sample_rate = atoi(var.value);
+   if (!sample_rate)
+      sample_rate = 44100;
+   retroSetAudioRate(sample_rate);
+
+   var.key = "scummvm_frame_budget";
+   var.value = NULL;
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value && atoi(var.value) > 0)
+      retroSetFrameBudget(atoi(var.value));
+
+   /* Worst case is one frame plus the fraction carried over */
+   audio_buffer_frames = (unsigned)(sample_rate / frame_rate) + 1;
+   audio_buffer = (int16_t*)realloc(audio_buffer, audio_buffer_frames * 2 * sizeof(int16_t));
+   audio_frames_pending = 0.0;
+
+   if (!environ_cb(RETRO_ENVIRONMENT_GET_CAN_DUPE, &can_dupe))
+      can_dupe = false;
+
    retro_keyboard_callback cb = {retroKeyEvent};
    environ_cb(RETRO_ENVIRONMENT_SET_KEYBOARD_CALLBACK, &cb);
 
@@ -274,6 +373,32 @@ bool retro_load_game(const struct retro_game_info *game)
       retroSetSaveDir(".");
    }
 
+#ifdef HAVE_THREADS
+   var.key = "scummvm_threaded";
+   var.value = NULL;
+   threaded = environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value && !strcmp(var.value, "enabled");
+   retroSetThreaded(threaded);
+
+   if (threaded && !engineRunning)
+   {
+      /* The OS has to exist before retro_run starts feeding it input. The
+       * one of the last game is done with, as its thread was joined, and
+       * may have been built for the other threading mode. */
+      retroDestroyOS(g_system);
+      g_system = retroBuildOS();
+      shutdownSent = false;
+      if (pthread_create(&engineThread, NULL, retro_engine_thread, NULL) == 0)
+         engineRunning = true;
+      else
+      {
+         if (log_cb)
+            log_cb(RETRO_LOG_ERROR, "Could not create the engine thread.\n");
+         return false;
+      }
+      return true;
+   }
+#endif
+
    if(!emuThread && !mainThread)
    {
       mainThread = co_active();
@@ -290,6 +415,22 @@ bool retro_load_game_special(unsigned game_type, const struct retro_game_info *i
 
 void retro_run (void)
 {
+#ifdef HAVE_THREADS
+   if (threaded)
+   {
+      if (!engineRunning)
+         return;
+
+      /* The engine thread must not call into the frontend itself */
+      if (EMULATORexited.isRaised() && !shutdownSent)
+      {
+         shutdownSent = true;
+         if (!FRONTENDwantsExit)
+            environ_cb(RETRO_ENVIRONMENT_SHUTDOWN, 0);
+      }
+   }
+   else
+#endif
    if(!emuThread)
       return;
 
@@ -301,28 +442,81 @@ void retro_run (void)
    }
 
    /* Run emu */
-   co_switch(emuThread);
+   if (!threaded)
+      co_switch(emuThread);
 
    if(g_system)
    {
-      /* Upload video: TODO: Check the CANDUPE env value */
+      /* Upload video, or ask the frontend to repeat the last frame. In
+       * threaded mode there is nothing to show before the first frame, so
+       * frontends that cannot repeat one get a black screen. */
       const Graphics::Surface& screen = getScreen();
-      video_cb(screen.pixels, screen.w, screen.h, screen.pitch);
+      if (screen.pixels && (retroScreenUpdated() || !can_dupe))
+         video_cb(screen.pixels, screen.w, screen.h, screen.pitch);
+      else if (can_dupe)
+         video_cb(NULL, screen.w, screen.h, screen.pitch);
+      else
+         video_cb(blank_frame, RES_W, RES_H, RES_W * sizeof(*blank_frame));
+
+      /* Upload audio. Always hand over a full frame's worth, even when no
+       * channel is playing, so the frontend never runs dry. */
+      audio_frames_pending += sample_rate / frame_rate;
+      unsigned frames = (unsigned)audio_frames_pending;
+      if (frames > audio_buffer_frames)
+         frames = audio_buffer_frames;
+      audio_frames_pending -= frames;
+
+      if (audio_buffer && frames)
+      {
+         retroMixAudio(audio_buffer, frames);
+         audio_batch_cb(audio_buffer, frames);
+      }
+
+      const RetroFrameTimings timings = retroTakeFrameTimings();
+      timing_engine += timings.engineUsecs;
+      timing_convert += timings.convertUsecs;
+      timing_mix += timings.mixUsecs;
+      timing_over_budget += timings.budgetExceeded;
 
-      // Upload audio
-      static uint32 buf[735];
-      int count = ((Audio::MixerImpl*)g_system->getMixer())->mixCallback((byte*)buf, 735*4);
-      audio_batch_cb((int16_t*)buf, count);
+      if (++timing_frames == TIMING_LOG_FRAMES)
+      {
+         if (log_cb)
+            log_cb(RETRO_LOG_DEBUG, "Frame timings (avg us): engine %u, convert %u, mix %u; budget exceeded %u times in %u frames.\n",
+                   (unsigned)(timing_engine / timing_frames), (unsigned)(timing_convert / timing_frames),
+                   (unsigned)(timing_mix / timing_frames), timing_over_budget, timing_frames);
+
+         timing_frames = timing_over_budget = 0;
+         timing_engine = timing_convert = timing_mix = 0;
+      }
    }
 }
 
 void retro_unload_game (void)
 {
+#ifdef HAVE_THREADS
+   if (threaded)
+   {
+      if (!engineRunning)
+         return;
+
+      FRONTENDwantsExit = true;
+      while (!EMULATORexited.isRaised())
+      {
+         retroPostQuit();
+         usleep(10000);
+      }
+
+      pthread_join(engineThread, NULL);
+      engineRunning = false;
+      return;
+   }
+#endif
+
    if(!emuThread)
       return;
 
    FRONTENDwantsExit = true;
-   while(!EMULATORexited)
+   while(!EMULATORexited.isRaised())
    {
       retroPostQuit();
       co_switch(emuThread);
@@ -332,14 +526,26 @@ void retro_unload_game (void)
    emuThread = 0;
 }
 
+size_t retro_serialize_size (void)
+{
+   return retroStateSize();
+}
+
+bool retro_serialize(void *data, size_t size)
+{
+   return retroSaveState(data, size);
+}
+
+bool retro_unserialize(const void * data, size_t size)
+{
+   return retroLoadState(data, size);
+}
+
 // Stubs
 void retro_set_controller_port_device(unsigned in_port, unsigned device) { }
 void *retro_get_memory_data(unsigned type) { return 0; }
 size_t retro_get_memory_size(unsigned type) { return 0; }
 void retro_reset (void) { }
-size_t retro_serialize_size (void) { return 0; }
-bool retro_serialize(void *data, size_t size) { return false; }
-bool retro_unserialize(const void * data, size_t size) { return false; }
 void retro_cheat_reset(void) { }
 void retro_cheat_set(unsigned unused, bool unused1, const char* unused2) { }
 
@@ -31,8 +31,14 @@
 
 #include "graphics/surface.libretro.h"
 #include "backends/base-backend.h"
+#include "backends/platform/libretro/blit.h"
+#include "backends/platform/libretro/handoff.h"
 #include "common/events.h"
+#include "common/error.h"
+#include "common/mutex.h"
+#include "common/stream.h"
 #include "audio/mixer_intern.h"
+#include "engines/engine.h"
 
 #if defined(_WIN32)
 #include "backends/fs/windows/windows-fs-factory.h"
@@ -61,15 +67,23 @@
 #include <time.h>
 #endif
 
+#ifdef HAVE_THREADS
+#include <pthread.h>
+#endif
+
 #include "libretro.h"
+#include "os.h"
 
 extern retro_log_printf_t log_cb;
 
 struct RetroPalette
 {
    unsigned char _colors[256 * 3];
+   uint32 _lut[256];
+   Graphics::PixelFormat _lutFormat;
+   bool _lutDirty;
 
-   RetroPalette()
+   RetroPalette() : _lutDirty(true)
    {
       memset(_colors, 0, sizeof(_colors));
    }
@@ -77,6 +91,7 @@ struct RetroPalette
    void set(const byte *colors, uint start, uint num)
    {
       memcpy(_colors + start * 3, colors, num * 3);
+      _lutDirty = true;
    }
 
    void get(byte* colors, uint start, uint num)
@@ -88,169 +103,249 @@ struct RetroPalette
    {
       return (unsigned char*)&_colors[aIndex * 3];
    }
+
+   /* The palette converted to aFormat, rebuilt only after changes */
+   const uint32 *getLUT(const Graphics::PixelFormat& aFormat)
+   {
+      if (_lutDirty || _lutFormat != aFormat)
+      {
+         retroBuildPaletteLUT(_lut, _colors, aFormat);
+         _lutFormat = aFormat;
+         _lutDirty = false;
+      }
+
+      return _lut;
+   }
 };
 
-static INLINE void blit_uint8_uint16_fast(Graphics::Surface& aOut, const Graphics::Surface& aIn, const RetroPalette& aColors)
+template<typename T>
+static void blit_uint8(Graphics::Surface& aOut, const Graphics::Surface& aIn, int aX, int aY, const uint32 *aLUT, uint32 aKeyColor)
 {
    for(int i = 0; i < aIn.h; i ++)
    {
-      if(i >= aOut.h)
+      if((i + aY) < 0 || (i + aY) >= aOut.h)
          continue;
 
-      uint8_t * const in  = (uint8_t*)aIn.pixels + (i * aIn.w);
-      uint16_t* const out = (uint16_t*)aOut.pixels + (i * aOut.w);
+      const uint8_t* const in = (const uint8_t*)aIn.getBasePtr(0, i);
+      T* const out = (T*)aOut.getBasePtr(0, i + aY);
 
       for(int j = 0; j < aIn.w; j ++)
       {
-         if (j >= aOut.w)
+         if((j + aX) < 0 || (j + aX) >= aOut.w)
             continue;
 
-         uint8 r, g, b;
-
          const uint8_t val = in[j];
-         if(val != 0xFFFFFFFF)
-         {
-            if(aIn.format.bytesPerPixel == 1)
-            {
-               unsigned char *col = aColors.getColor(val);
-               r = *col++;
-               g = *col++;
-               b = *col++;
-            }
-            else
-               aIn.format.colorToRGB(in[j], r, g, b);
-
-            out[j] = aOut.format.RGBToColor(r, g, b);
-         }
+         if(val != aKeyColor)
+            out[j + aX] = aLUT[val];
       }
    }
 }
 
-static INLINE void blit_uint32_uint16(Graphics::Surface& aOut, const Graphics::Surface& aIn, const RetroPalette& aColors)
+template<typename T, typename S>
+static void blit_rgb(Graphics::Surface& aOut, const Graphics::Surface& aIn, int aX, int aY, uint32 aKeyColor)
 {
    for(int i = 0; i < aIn.h; i ++)
    {
-      if(i >= aOut.h)
+      if((i + aY) < 0 || (i + aY) >= aOut.h)
          continue;
 
-      uint32_t* const in = (uint32_t*)aIn.pixels + (i * aIn.w);
-      uint16_t* const out = (uint16_t*)aOut.pixels + (i * aOut.w);
+      const S* const in = (const S*)aIn.getBasePtr(0, i);
+      T* const out = (T*)aOut.getBasePtr(0, i + aY);
 
       for(int j = 0; j < aIn.w; j ++)
       {
-         if(j >= aOut.w)
+         if((j + aX) < 0 || (j + aX) >= aOut.w)
             continue;
 
          uint8 r, g, b;
 
-         const uint32_t val = in[j];
-         if(val != 0xFFFFFFFF)
+         const S val = in[j];
+         if(val != aKeyColor)
          {
-            aIn.format.colorToRGB(in[j], r, g, b);
-            out[j] = aOut.format.RGBToColor(r, g, b);
+            aIn.format.colorToRGB(val, r, g, b);
+            out[j + aX] = aOut.format.RGBToColor(r, g, b);
          }
       }
    }
 }
 
-static INLINE void blit_uint16_uint16(Graphics::Surface& aOut, const Graphics::Surface& aIn, const RetroPalette& aColors)
+static INLINE void copyRectToSurface(uint8_t *pixels, int out_pitch, const uint8_t *src, int pitch, int x, int y, int w, int h, int out_bpp)
 {
-   for(int i = 0; i < aIn.h; i ++)
+   uint8_t *dst = pixels + y * out_pitch + x * out_bpp;
+
+   do
    {
-      if(i >= aOut.h)
-         continue;
+      memcpy(dst, src, w * out_bpp);
+      src += pitch;
+      dst += out_pitch;
+   }while(--h);
+}
 
-      uint16_t* const in = (uint16_t*)aIn.pixels + (i * aIn.w);
-      uint16_t* const out = (uint16_t*)aOut.pixels + (i * aOut.w);
+/**
+ * Write stream used to capture a save state into a caller supplied buffer.
+ * Writes past the end of the buffer are dropped but still counted, so a
+ * capture into a too small (or NULL) buffer reports the size it would need.
+ * One instance is reused for every capture.
+ */
+class RetroStateWriteStream : public Common::WriteStream
+{
+   private:
+      byte *_buffer;
+      uint32 _capacity;
+      uint32 _size;
 
-      for(int j = 0; j < aIn.w; j ++)
+   public:
+      RetroStateWriteStream() : _buffer(0), _capacity(0), _size(0)
       {
-         if(j >= aOut.w)
-            continue;
+      }
 
-         uint8 r, g, b;
+      void reset(byte *buffer, uint32 capacity)
+      {
+         _buffer = buffer;
+         _capacity = capacity;
+         _size = 0;
+      }
 
-         const uint16_t val = in[j];
-         if(val != 0xFFFFFFFF)
-         {
-            aIn.format.colorToRGB(in[j], r, g, b);
-            out[j] = aOut.format.RGBToColor(r, g, b);
-         }
+      virtual uint32 write(const void *dataPtr, uint32 dataSize)
+      {
+         if (_size < _capacity)
+            memcpy(_buffer + _size, dataPtr, MIN(dataSize, _capacity - _size));
+
+         _size += dataSize;
+         return dataSize;
       }
-   }
-}
 
-static void blit_uint8_uint16(Graphics::Surface& aOut, const Graphics::Surface& aIn, int aX, int aY, const RetroPalette& aColors, uint32 aKeyColor)
+      virtual int32 pos() const { return _size; }
+
+      /* The size the state needs, which can exceed the capacity */
+      uint32 size() const { return _size; }
+};
+
+/**
+ * Read stream over a restored save state. Engines may load the state later
+ * from their main loop, so it reads from a copy owned by the backend rather
+ * than from the frontend's buffer. One instance is reused for every restore.
+ */
+class RetroStateReadStream : public Common::SeekableReadStream
 {
-   for(int i = 0; i < aIn.h; i ++)
-   {
-      if((i + aY) < 0 || (i + aY) >= aOut.h)
-         continue;
+   private:
+      byte *_buffer;
+      uint32 _capacity;
+      uint32 _size;
+      uint32 _pos;
+      bool _eos;
 
-      uint8_t* const in = (uint8_t*)aIn.pixels + (i * aIn.w);
-      uint16_t* const out = (uint16_t*)aOut.pixels + ((i + aY) * aOut.w);
+   public:
+      RetroStateReadStream() : _buffer(0), _capacity(0), _size(0), _pos(0), _eos(false)
+      {
+      }
 
-      for(int j = 0; j < aIn.w; j ++)
+      virtual ~RetroStateReadStream()
       {
-         if((j + aX) < 0 || (j + aX) >= aOut.w)
-            continue;
+         free(_buffer);
+      }
 
-         uint8 r, g, b;
+      /**
+       * Make sure a state of up to the given size can be held without
+       * further allocations.
+       */
+      void reserve(uint32 capacity)
+      {
+         if (capacity <= _capacity)
+            return;
 
-         const uint8_t val = in[j];
-         if(val != aKeyColor)
-         {
-            unsigned char *col = aColors.getColor(val);
-            r = *col++;
-            g = *col++;
-            b = *col++;
-            out[j + aX] = aOut.format.RGBToColor(r, g, b);
-         }
+         byte *buffer = (byte *)realloc(_buffer, capacity);
+         if (!buffer)
+            return;
+
+         _buffer = buffer;
+         _capacity = capacity;
       }
-   }
-}
 
-static void blit_uint16_uint16(Graphics::Surface& aOut, const Graphics::Surface& aIn, int aX, int aY, const RetroPalette& aColors, uint32 aKeyColor)
-{
-   for(int i = 0; i < aIn.h; i ++)
-   {
-      if((i + aY) < 0 || (i + aY) >= aOut.h)
-         continue;
+      bool reset(const byte *data, uint32 size)
+      {
+         reserve(size);
+         if (size > _capacity)
+            return false;
+
+         memcpy(_buffer, data, size);
+         _size = size;
+         _pos = 0;
+         _eos = false;
+         return true;
+      }
+
+      virtual uint32 read(void *dataPtr, uint32 dataSize)
+      {
+         if (dataSize > _size - _pos)
+         {
+            dataSize = _size - _pos;
+            _eos = true;
+         }
 
-      uint16_t* const in = (uint16_t*)aIn.pixels + (i * aIn.w);
-      uint16_t* const out = (uint16_t*)aOut.pixels + ((i + aY) * aOut.w);
+         memcpy(dataPtr, _buffer + _pos, dataSize);
+         _pos += dataSize;
+         return dataSize;
+      }
 
-      for(int j = 0; j < aIn.w; j ++)
+      virtual bool seek(int32 offset, int whence = SEEK_SET)
       {
-         if((j + aX) < 0 || (j + aX) >= aOut.w)
-            continue;
+         if (whence == SEEK_CUR)
+            offset += _pos;
+         else if (whence == SEEK_END)
+            offset += _size;
 
-         uint8 r, g, b;
+         if (offset < 0 || (uint32)offset > _size)
+            return false;
 
-         const uint16_t val = in[j];
-         if(val != aKeyColor)
-         {
-            aIn.format.colorToRGB(in[j], r, g, b);
-            out[j + aX] = aOut.format.RGBToColor(r, g, b);
-         }
+         _pos = offset;
+         _eos = false;
+         return true;
       }
-   }
-}
 
-static INLINE void copyRectToSurface(uint8_t *pixels, int out_pitch, const uint8_t *src, int pitch, int x, int y, int w, int h, int out_bpp)
-{
-   uint8_t *dst = pixels + y * out_pitch + x * out_bpp;
+      virtual bool eos() const { return _eos; }
+      virtual void clearErr() { _eos = false; }
+      virtual int32 pos() const { return _pos; }
+      virtual int32 size() const { return _size; }
+};
 
-   do
-   {
-      memcpy(dst, src, w * out_bpp);
-      src += pitch;
-      dst += out_pitch;
-   }while(--h);
-}
+/* Save state layout: magic, payload size, payload */
+#define STATE_MAGIC       MKTAG('S', 'V', 'M', 'R')
+#define STATE_HEADER_SIZE 8
+#define STATE_ALIGN       0x10000
+
+/* Beyond this many separate dirty rects the whole screen is converted */
+#define MAX_DIRTY_RECTS 32
+
+/* Threaded mode audio queue, in sample frames */
+#define AUDIO_RING_FRAMES  8192
+#define AUDIO_CHUNK_FRAMES 256
 
 static Common::String s_systemDir;
 static Common::String s_saveDir;
+static uint s_audioRate = 44100;
+static bool s_threaded = false;
+/* Longest the engine may run without presenting a frame, in ms */
+static uint32 s_frameBudget = 16;
+
+static uint64 retroMicros()
+{
+#if defined(GEKKO)
+   return ticks_to_microsecs(gettime());
+#elif defined(__CELLOS_LV2__)
+   return sys_time_get_system_time();
+#else
+   struct timeval t;
+   gettimeofday(&t, 0);
+
+   return ((uint64)t.tv_sec * 1000000) + t.tv_usec;
+#endif
+}
+#ifdef FRONTEND_SUPPORTS_RGB565
+static Graphics::PixelFormat s_screenFormat(2, 5, 6, 5, 0, 11, 5, 0, 0);
+#else
+static Graphics::PixelFormat s_screenFormat(2, 5, 5, 5, 1, 10, 5, 0, 15);
+#endif
 
 #ifdef FRONTEND_SUPPORTS_RGB565
 #define SURF_BPP 2
@@ -287,6 +382,9 @@ std::list<Common::Event> _events;
 class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
    public:
       Graphics::Surface _screen;
+      Common::Array<Common::Rect> _dirtyRects;
+      bool _screenDirty;
+      bool _screenUpdated;
 
       Graphics::Surface _gameScreen;
       RetroPalette _gamePalette;
@@ -298,33 +396,73 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
       RetroPalette _mousePalette;
       bool _mousePaletteEnabled;
       bool _mouseVisible;
+      /* The cursor position, and the screen size it is kept within, are
+       * shared with processMouse() and guarded by _eventMutex */
       int _mouseX;
       int _mouseY;
+      int _mouseRangeW;
+      int _mouseRangeH;
       int _mouseHotspotX;
       int _mouseHotspotY;
       int _mouseKeyColor;
+      Common::Rect _mouseRect;
+      bool _mouseDirty;
       bool _mouseDontScale;
       bool _mouseButtons[2];
       bool _joypadmouseButtons[2];
       bool _joypadstartButton;
 
       uint32 _startTime;
-      uint32 _threadExitTime;
+      uint32 _sliceEndTime;
+      uint64 _sliceStart;
+      bool _frameReady;
+
+      /* Where the time of the running slice went so far, see endSlice() */
+      uint64 _sliceIdle;
+      uint32 _sliceConvert;
+      uint32 _sliceMix;
+      /* The timings since retroTakeFrameTimings(), which runs on the
+       * frontend thread in threaded mode */
+      MutexRef _timingsMutex;
+      RetroFrameTimings _timings;
+
+      RetroStateWriteStream _stateWriter;
+      RetroStateReadStream _stateReader;
+      Engine *_stateEngine;
+      uint32 _stateBound;
+      bool _stateUnsupported; /* saveGameStream() said kUnsupportedFeature */
 
 
       Audio::MixerImpl* _mixer;
 
+      /* Threaded mode: handoff from the engine thread to retro_run */
+      MutexRef _eventMutex;
+      RetroTripleBuffer _frames;
+      bool _frameFresh;
+      RetroAudioRing *_audioRing;
+      int16 _audioChunk[AUDIO_CHUNK_FRAMES * 2];
+
 
       OSystem_RETRO() :
-         _mousePaletteEnabled(false), _mouseVisible(false), _mouseX(0), _mouseY(0), _mouseHotspotX(0), _mouseHotspotY(0),
-         _mouseKeyColor(0), _mouseDontScale(false), _mixer(0), _startTime(0), _threadExitTime(10)
+         _screenDirty(true), _screenUpdated(true), _overlayVisible(false),
+         _mousePaletteEnabled(false), _mouseVisible(false), _mouseX(0), _mouseY(0), _mouseRangeW(0), _mouseRangeH(0), _mouseHotspotX(0), _mouseHotspotY(0),
+         _mouseKeyColor(0), _mouseDirty(true), _mouseDontScale(false), _mixer(0), _startTime(0), _sliceEndTime(0), _sliceStart(0), _frameReady(false),
+         _sliceIdle(0), _sliceConvert(0), _sliceMix(0),
+         _stateEngine(0), _stateBound(0), _stateUnsupported(false), _frameFresh(false), _audioRing(0)
    {
       _fsFactory = new FS_SYSTEM_FACTORY();
+      _eventMutex = createMutex();
+      _timingsMutex = createMutex();
+      memset(&_timings, 0, sizeof(_timings));
+      if (s_threaded)
+         _audioRing = new RetroAudioRing(AUDIO_RING_FRAMES);
+      _dirtyRects.reserve(MAX_DIRTY_RECTS);
       memset(_mouseButtons, 0, sizeof(_mouseButtons));
       memset(_joypadmouseButtons, 0, sizeof(_joypadmouseButtons));
       _joypadstartButton = false;
 
       _startTime = getMillis();
+      startSlice();
 
       if(s_systemDir.empty())
          s_systemDir = ".";
@@ -341,6 +479,9 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
          _screen.free();
 
          delete _mixer;
+         delete _audioRing;
+         deleteMutex(_eventMutex);
+         deleteMutex(_timingsMutex);
       }
 
       virtual void initBackend()
@@ -351,7 +492,7 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
 #else
          _overlay.create(RES_W, RES_H, Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15));
 #endif
-         _mixer = new Audio::MixerImpl(this, 44100);
+         _mixer = new Audio::MixerImpl(this, s_audioRate);
          _timerManager = new DefaultTimerManager();
 
          _mixer->setReady(true);
@@ -367,7 +508,10 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
       virtual void setFeatureState(Feature f, bool enable)
       {
          if (f == kFeatureCursorPalette)
+         {
             _mousePaletteEnabled = enable;
+            _mouseDirty = true;
+         }
       }
 
       virtual bool getFeatureState(Feature f)
@@ -399,6 +543,7 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
       virtual void initSize(uint width, uint height, const Graphics::PixelFormat *format)
       {
          _gameScreen.create(width, height, format ? *format : Graphics::PixelFormat::createFormatCLUT8());
+         _screenDirty = true;
       }
 
       virtual int16 getHeight()
@@ -443,6 +588,8 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
       virtual void setPalette(const byte *colors, uint start, uint num)
       {
          _gamePalette.set(colors, start, num);
+         if (!_overlayVisible)
+            _screenDirty = true;
       }
 
       virtual void grabPalette(byte *colors, uint start, uint num)
@@ -457,39 +604,143 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
          const uint8_t *src = (const uint8_t*)buf;
          uint8_t *pix = (uint8_t*)_gameScreen.pixels;
          copyRectToSurface(pix, _gameScreen.pitch, src, pitch, x, y, w, h, _gameScreen.format.bytesPerPixel);
+
+         if (!_overlayVisible)
+            addDirtyRect(Common::Rect(x, y, x + w, y + h));
       }
 
-      virtual void updateScreen()
+      virtual void fillScreen(uint32 col)
       {
-         const Graphics::Surface& srcSurface = (_overlayVisible) ? _overlay : _gameScreen;
-         if(srcSurface.w && srcSurface.h)
+         _gameScreen.fillRect(Common::Rect(_gameScreen.w, _gameScreen.h), col);
+
+         if (!_overlayVisible)
+            _screenDirty = true;
+      }
+
+      void addDirtyRect(const Common::Rect& aRect)
+      {
+         if (_screenDirty || aRect.isEmpty())
+            return;
+
+         for (uint i = 0; i < _dirtyRects.size(); i++)
          {
-            switch(srcSurface.format.bytesPerPixel)
+            if (_dirtyRects[i].intersects(aRect))
             {
-               case 1:
-               case 3:
-                  blit_uint8_uint16_fast(_screen, srcSurface, _gamePalette);
-                  break;
-               case 2:
-                  blit_uint16_uint16(_screen, srcSurface, _gamePalette);
-                  break;
-               case 4:
-                  blit_uint32_uint16(_screen, srcSurface, _gamePalette);
-                  break;
+               _dirtyRects[i].extend(aRect);
+               return;
             }
          }
 
-         // Draw Mouse
+         if (_dirtyRects.size() >= MAX_DIRTY_RECTS)
+            _screenDirty = true;
+         else
+            _dirtyRects.push_back(aRect);
+      }
+
+      void blitRect(const Graphics::Surface& aSurface, Common::Rect aRect)
+      {
+         aRect.clip(MIN<int>(aSurface.w, _screen.w), MIN<int>(aSurface.h, _screen.h));
+         if (aRect.isEmpty())
+            return;
+
+         retroBlitRect(_screen, aSurface, _gamePalette.getLUT(_screen.format), aRect);
+      }
+
+      virtual void updateScreen()
+      {
+         const uint64 start = retroMicros();
+         presentScreen();
+         _sliceConvert += (uint32)(retroMicros() - start);
+
+         /* Hand the frame to the frontend at the next yield point */
+         _frameReady = true;
+      }
+
+      void presentScreen()
+      {
+         const Graphics::Surface& srcSurface = (_overlayVisible) ? _overlay : _gameScreen;
+
+         resizeScreen(srcSurface);
+
+         int mouseX, mouseY;
+         {
+            Common::StackLock lock(_eventMutex);
+            mouseX = _mouseX;
+            mouseY = _mouseY;
+            _mouseRangeW = _screen.w;
+            _mouseRangeH = _screen.h;
+         }
+
+         Common::Rect mouseRect;
          if(_mouseVisible && _mouseImage.w && _mouseImage.h)
          {
-            const int x = _mouseX - _mouseHotspotX;
-            const int y = _mouseY - _mouseHotspotY;
+            mouseRect.left = mouseX - _mouseHotspotX;
+            mouseRect.top = mouseY - _mouseHotspotY;
+            mouseRect.setWidth(_mouseImage.w);
+            mouseRect.setHeight(_mouseImage.h);
+         }
+
+         /* Restore what was under the cursor if it moved or changed */
+         if (_mouseDirty || mouseRect != _mouseRect)
+         {
+            addDirtyRect(_mouseRect);
+            addDirtyRect(mouseRect);
+            _mouseRect = mouseRect;
+            _mouseDirty = false;
+         }
+
+         if (!_screenDirty && _dirtyRects.empty())
+            return;
+
+         if (_screenDirty)
+            blitRect(srcSurface, Common::Rect(srcSurface.w, srcSurface.h));
+         else
+         {
+            for (uint i = 0; i < _dirtyRects.size(); i++)
+               blitRect(srcSurface, _dirtyRects[i]);
+         }
+
+         /* resize() keeps the storage around for the next frame */
+         _dirtyRects.resize(0);
+         _screenDirty = false;
+         _screenUpdated = true;
+
+         // Draw Mouse
+         if(!mouseRect.isEmpty())
+         {
+            const int x = mouseRect.left;
+            const int y = mouseRect.top;
+
+            const bool screen32 = (_screen.format.bytesPerPixel == 4);
 
             if(_mouseImage.format.bytesPerPixel == 1)
-               blit_uint8_uint16(_screen, _mouseImage, x, y, _mousePaletteEnabled ? _mousePalette : _gamePalette, _mouseKeyColor);
+            {
+               RetroPalette& palette = _mousePaletteEnabled ? _mousePalette : _gamePalette;
+               const uint32 *lut = palette.getLUT(_screen.format);
+
+               if (screen32)
+                  blit_uint8<uint32>(_screen, _mouseImage, x, y, lut, _mouseKeyColor);
+               else
+                  blit_uint8<uint16>(_screen, _mouseImage, x, y, lut, _mouseKeyColor);
+            }
+            else if(_mouseImage.format.bytesPerPixel == 4)
+            {
+               if (screen32)
+                  blit_rgb<uint32, uint32>(_screen, _mouseImage, x, y, _mouseKeyColor);
+               else
+                  blit_rgb<uint16, uint32>(_screen, _mouseImage, x, y, _mouseKeyColor);
+            }
             else
-               blit_uint16_uint16(_screen, _mouseImage, x, y, _mousePaletteEnabled ? _mousePalette : _gamePalette, _mouseKeyColor);
+            {
+               if (screen32)
+                  blit_rgb<uint32, uint16>(_screen, _mouseImage, x, y, _mouseKeyColor);
+               else
+                  blit_rgb<uint16, uint16>(_screen, _mouseImage, x, y, _mouseKeyColor);
+            }
          }
+
+         if (s_threaded)
+            _frames.publish(_screen);
       }
 
       virtual Graphics::Surface *lockScreen()
@@ -499,7 +750,8 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
 
       virtual void unlockScreen()
       {
-         /* EMPTY */
+         if (!_overlayVisible)
+            _screenDirty = true;
       }
 
       virtual void setShakePos(int shakeOffset)
@@ -509,17 +761,22 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
 
       virtual void showOverlay()
       {
+         _screenDirty |= !_overlayVisible;
          _overlayVisible = true;
       }
 
       virtual void hideOverlay()
       {
+         _screenDirty |= _overlayVisible;
          _overlayVisible = false;
       }
 
       virtual void clearOverlay()
       {
          _overlay.fillRect(Common::Rect(_overlay.w, _overlay.h), 0);
+
+         if (_overlayVisible)
+            _screenDirty = true;
       }
 
       virtual void grabOverlay(void *buf, int pitch)
@@ -540,6 +797,9 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
          const uint8_t *src = (const uint8_t*)buf;
          uint8_t *pix = (uint8_t*)_overlay.pixels;
          copyRectToSurface(pix, _overlay.pitch, src, pitch, x, y, w, h, _overlay.format.bytesPerPixel);
+
+         if (_overlayVisible)
+            addDirtyRect(Common::Rect(x, y, x + w, y + h));
       }
 
       virtual int16 getOverlayHeight()
@@ -563,11 +823,13 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
       {
          const bool wasVisible = _mouseVisible;
          _mouseVisible = visible;
+         _mouseDirty |= (wasVisible != visible);
          return wasVisible;
       }
 
       virtual void warpMouse(int x, int y)
       {
+         Common::StackLock lock(_eventMutex);
          _mouseX = x;
          _mouseY = y;
       }
@@ -587,25 +849,64 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
          _mouseHotspotY = hotspotY;
          _mouseKeyColor = keycolor;
          _mouseDontScale = dontScale;
+         _mouseDirty = true;
       }
 
       virtual void setCursorPalette(const byte *colors, uint start, uint num)
       {
          _mousePalette.set(colors, start, num);
          _mousePaletteEnabled = true;
+         _mouseDirty = true;
+      }
+
+      /* Engine side: account for the slice of engine time which just
+       * ended, with a presented frame or at the budget */
+      void endSlice(bool overBudget)
+      {
+         const uint32 busy = (uint32)(retroMicros() - _sliceStart - _sliceIdle);
+         const uint32 phases = _sliceConvert + _sliceMix;
+
+         Common::StackLock lock(_timingsMutex);
+         _timings.engineUsecs += busy - MIN(busy, phases);
+         _timings.convertUsecs += _sliceConvert;
+         _timings.mixUsecs += _sliceMix;
+         _timings.budgetExceeded += overBudget;
+      }
+
+      void startSlice()
+      {
+         _sliceStart = retroMicros();
+         _sliceEndTime = getMillis() + s_frameBudget;
+         _sliceIdle = 0;
+         _sliceConvert = 0;
+         _sliceMix = 0;
       }
 
       bool retroCheckThread(uint32 offset = 0)
       {
-         if(_threadExitTime <= (getMillis() + offset))
+         /* A slice ends with each presented frame. The budget only matters
+          * for engines that keep running without updating the screen. */
+         const bool overBudget = (_sliceEndTime <= (getMillis() + offset));
+         if(_frameReady || overBudget)
          {
-            extern void retro_leave_thread();
-            retro_leave_thread();
+            endSlice(!_frameReady);
+            _frameReady = false;
 
-            _threadExitTime = getMillis() + 10;
-            return true;
+            /* Yield to the frontend, which a real thread never does */
+            if (!s_threaded)
+            {
+               extern void retro_leave_thread();
+               retro_leave_thread();
+               startSlice();
+               return true;
+            }
+
+            startSlice();
          }
 
+         /* Keep the frontend supplied with audio */
+         if (s_threaded)
+            produceAudio();
          return false;
       }
 
@@ -615,7 +916,7 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
 
          ((DefaultTimerManager*)_timerManager)->handler();
 
-
+         Common::StackLock lock(_eventMutex);
          if(!_events.empty())
          {
             event = _events.front();
@@ -643,28 +944,65 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
       virtual void delayMillis(uint msecs)
       {
          if(!retroCheckThread(msecs))
+         {
+            const uint64 start = retroMicros();
             retro_sleep(msecs);
+            _sliceIdle += retroMicros() - start;
+         }
       }
 
 
+      /* With libco everything runs on one OS thread and mutexes are not
+       * needed. The threaded mode uses recursive pthread mutexes. */
       virtual MutexRef createMutex(void)
       {
+#ifdef HAVE_THREADS
+         if (s_threaded)
+         {
+            pthread_mutexattr_t attr;
+
+            pthread_mutexattr_init(&attr);
+            pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+
+            pthread_mutex_t *mutex = new pthread_mutex_t;
+            if (pthread_mutex_init(mutex, &attr) != 0)
+            {
+               warning("pthread_mutex_init() failed");
+               delete mutex;
+               mutex = 0;
+            }
+
+            pthread_mutexattr_destroy(&attr);
+            return (MutexRef)mutex;
+         }
+#endif
          return MutexRef();
       }
 
       virtual void lockMutex(MutexRef mutex)
       {
-         /* EMPTY */
+#ifdef HAVE_THREADS
+         if (mutex && pthread_mutex_lock((pthread_mutex_t *)mutex) != 0)
+            warning("pthread_mutex_lock() failed");
+#endif
       }
 
       virtual void unlockMutex(MutexRef mutex)
       {
-         /* EMPTY */
+#ifdef HAVE_THREADS
+         if (mutex && pthread_mutex_unlock((pthread_mutex_t *)mutex) != 0)
+            warning("pthread_mutex_unlock() failed");
+#endif
       }
 
       virtual void deleteMutex(MutexRef mutex)
       {
-         /* EMPTY */
+#ifdef HAVE_THREADS
+         pthread_mutex_t *m = (pthread_mutex_t *)mutex;
+         if (m && pthread_mutex_destroy(m) != 0)
+            warning("pthread_mutex_destroy() failed");
+         delete m;
+#endif
       }
 
       virtual void quit()
@@ -729,21 +1067,83 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
 
       //
 
+      void resizeScreen(const Graphics::Surface& aSurface)
+      {
+         if(aSurface.w != _screen.w || aSurface.h != _screen.h)
+         {
+            _screen.create(aSurface.w, aSurface.h, s_screenFormat);
+            _screenDirty = true;
+            _screenUpdated = true;
+         }
+      }
+
       const Graphics::Surface& getScreen()
       {
-         const Graphics::Surface& srcSurface = (_overlayVisible) ? _overlay : _gameScreen;
+         if (s_threaded)
+         {
+            _frameFresh |= _frames.consume();
+            return _frames.front();
+         }
+
+         resizeScreen((_overlayVisible) ? _overlay : _gameScreen);
+         return _screen;
+      }
+
+      bool screenUpdated()
+      {
+         bool& updated = s_threaded ? _frameFresh : _screenUpdated;
+         const bool result = updated;
+         updated = false;
+         return result;
+      }
+
+      /* Engine thread: keep a few frames of audio queued up */
+      void produceAudio()
+      {
+         if (!_mixer)
+            return;
 
-         if(srcSurface.w != _screen.w || srcSurface.h != _screen.h)
+         const uint32 target = 3 * s_audioRate / 60;
+         if (_audioRing->available() >= target)
+            return;
+
+         const uint64 start = retroMicros();
+         while (_audioRing->available() < target)
          {
-#ifdef FRONTEND_SUPPORTS_RGB565
-            _screen.create(srcSurface.w, srcSurface.h, Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0));
-#else
-            _screen.create(srcSurface.w, srcSurface.h, Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15));
-#endif
+            _mixer->mixCallback((byte *)_audioChunk, sizeof(_audioChunk));
+            _audioRing->write(_audioChunk, AUDIO_CHUNK_FRAMES);
          }
+         _sliceMix += (uint32)(retroMicros() - start);
+      }
 
+      /* Frontend thread: take the timings since the last call */
+      RetroFrameTimings takeFrameTimings()
+      {
+         Common::StackLock lock(_timingsMutex);
+         const RetroFrameTimings timings = _timings;
+         memset(&_timings, 0, sizeof(_timings));
+         return timings;
+      }
 
-         return _screen;
+      /* Frontend thread: fetch the audio for one retro_run */
+      void mixAudio(int16 *aBuffer, uint aFrames)
+      {
+         if (!s_threaded)
+         {
+            const uint64 start = retroMicros();
+            if (_mixer)
+               _mixer->mixCallback((byte *)aBuffer, aFrames * 4);
+            else
+               memset(aBuffer, 0, aFrames * 4);
+
+            Common::StackLock lock(_timingsMutex);
+            _timings.mixUsecs += (uint32)(retroMicros() - start);
+            return;
+         }
+
+         /* Pad with silence if the engine thread fell behind */
+         const uint32 read = _audioRing->read(aBuffer, aFrames);
+         memset(aBuffer + read * 2, 0, (aFrames - read) * 4);
       }
 
 #define ANALOG_VALUE_X_ADD 1
@@ -754,6 +1154,8 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
 
       void processMouse(retro_input_state_t aCallback)
       {
+         Common::StackLock lock(_eventMutex);
+
          int16_t joy_x, joy_y, x, y;
          bool do_joystick, down;
 
@@ -775,42 +1177,42 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
          {
             _mouseX += 4*ANALOG_VALUE_X_ADD;
             _mouseX = (_mouseX < 0) ? 0 : _mouseX;
-            _mouseX = (_mouseX >= _screen.w) ? _screen.w : _mouseX;
+            _mouseX = (_mouseX >= _mouseRangeW) ? _mouseRangeW : _mouseX;
             do_joystick = true;
          }
          else if (joy_x < -ANALOG_THRESHOLD3)
          {
             _mouseX -= 4*ANALOG_VALUE_X_ADD;
             _mouseX = (_mouseX < 0) ? 0 : _mouseX;
-            _mouseX = (_mouseX >= _screen.w) ? _screen.w : _mouseX;
+            _mouseX = (_mouseX >= _mouseRangeW) ? _mouseRangeW : _mouseX;
             do_joystick = true;
          }
          else if (joy_x > ANALOG_THRESHOLD2)
          {
             _mouseX += 2*ANALOG_VALUE_X_ADD;
             _mouseX = (_mouseX < 0) ? 0 : _mouseX;
-            _mouseX = (_mouseX >= _screen.w) ? _screen.w : _mouseX;
+            _mouseX = (_mouseX >= _mouseRangeW) ? _mouseRangeW : _mouseX;
             do_joystick = true;
          }
          else if (joy_x < -ANALOG_THRESHOLD2)
          {
             _mouseX -= 2*ANALOG_VALUE_X_ADD;
             _mouseX = (_mouseX < 0) ? 0 : _mouseX;
-            _mouseX = (_mouseX >= _screen.w) ? _screen.w : _mouseX;
+            _mouseX = (_mouseX >= _mouseRangeW) ? _mouseRangeW : _mouseX;
             do_joystick = true;
          }
          else if (joy_x > ANALOG_THRESHOLD1)
          {
             _mouseX += ANALOG_VALUE_X_ADD;
             _mouseX = (_mouseX < 0) ? 0 : _mouseX;
-            _mouseX = (_mouseX >= _screen.w) ? _screen.w : _mouseX;
+            _mouseX = (_mouseX >= _mouseRangeW) ? _mouseRangeW : _mouseX;
             do_joystick = true;
          }
          else if (joy_x < -ANALOG_THRESHOLD1)
          {
             _mouseX -= ANALOG_VALUE_X_ADD;
             _mouseX = (_mouseX < 0) ? 0 : _mouseX;
-            _mouseX = (_mouseX >= _screen.w) ? _screen.w : _mouseX;
+            _mouseX = (_mouseX >= _mouseRangeW) ? _mouseRangeW : _mouseX;
             do_joystick = true;
          }
 
@@ -818,42 +1220,42 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
          {
             _mouseY += 4*ANALOG_VALUE_Y_ADD;
             _mouseY = (_mouseY < 0) ? 0 : _mouseY;
-            _mouseY = (_mouseY >= _screen.h) ? _screen.h : _mouseY;
+            _mouseY = (_mouseY >= _mouseRangeH) ? _mouseRangeH : _mouseY;
             do_joystick = true;
          }
          else if (joy_y < -ANALOG_THRESHOLD3)
          {
             _mouseY -= 4*ANALOG_VALUE_Y_ADD;
             _mouseY = (_mouseY < 0) ? 0 : _mouseY;
-            _mouseY = (_mouseY >= _screen.h) ? _screen.h : _mouseY;
+            _mouseY = (_mouseY >= _mouseRangeH) ? _mouseRangeH : _mouseY;
             do_joystick = true;
          }
          else if (joy_y > ANALOG_THRESHOLD2)
          {
             _mouseY += 2*ANALOG_VALUE_Y_ADD;
             _mouseY = (_mouseY < 0) ? 0 : _mouseY;
-            _mouseY = (_mouseY >= _screen.h) ? _screen.h : _mouseY;
+            _mouseY = (_mouseY >= _mouseRangeH) ? _mouseRangeH : _mouseY;
             do_joystick = true;
          }
          else if (joy_y < -ANALOG_THRESHOLD2)
          {
             _mouseY -= 2*ANALOG_VALUE_Y_ADD;
             _mouseY = (_mouseY < 0) ? 0 : _mouseY;
-            _mouseY = (_mouseY >= _screen.h) ? _screen.h : _mouseY;
+            _mouseY = (_mouseY >= _mouseRangeH) ? _mouseRangeH : _mouseY;
             do_joystick = true;
          }
          else if (joy_y > ANALOG_THRESHOLD1)
          {
             _mouseY += ANALOG_VALUE_Y_ADD; 
             _mouseY = (_mouseY < 0) ? 0 : _mouseY;
-            _mouseY = (_mouseY >= _screen.h) ? _screen.h : _mouseY;
+            _mouseY = (_mouseY >= _mouseRangeH) ? _mouseRangeH : _mouseY;
             do_joystick = true;
          }
          else if (joy_y < -ANALOG_THRESHOLD1)
          {
             _mouseY -= ANALOG_VALUE_Y_ADD; 
             _mouseY = (_mouseY < 0) ? 0 : _mouseY;
-            _mouseY = (_mouseY >= _screen.h) ? _screen.h : _mouseY;
+            _mouseY = (_mouseY >= _mouseRangeH) ? _mouseRangeH : _mouseY;
             do_joystick = true;
          }
 
@@ -862,7 +1264,7 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
             {
                _mouseX -= 2*ANALOG_VALUE_X_ADD;
                _mouseX = (_mouseX < 0) ? 0 : _mouseX;
-               _mouseX = (_mouseX >= _screen.w) ? _screen.w : _mouseX;
+               _mouseX = (_mouseX >= _mouseRangeW) ? _mouseRangeW : _mouseX;
                do_joystick = true;
             }
 
@@ -870,7 +1272,7 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
             {
                _mouseX += 2*ANALOG_VALUE_X_ADD;
                _mouseX = (_mouseX < 0) ? 0 : _mouseX;
-               _mouseX = (_mouseX >= _screen.w) ? _screen.w : _mouseX;
+               _mouseX = (_mouseX >= _mouseRangeW) ? _mouseRangeW : _mouseX;
                do_joystick = true;
             }
 
@@ -878,7 +1280,7 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
             {
                _mouseY -= 2*ANALOG_VALUE_Y_ADD; 
                _mouseY = (_mouseY < 0) ? 0 : _mouseY;
-               _mouseY = (_mouseY >= _screen.h) ? _screen.h : _mouseY;
+               _mouseY = (_mouseY >= _mouseRangeH) ? _mouseRangeH : _mouseY;
                do_joystick = true;
             }
 
@@ -886,7 +1288,7 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
             {
                _mouseY += 2*ANALOG_VALUE_Y_ADD; 
                _mouseY = (_mouseY < 0) ? 0 : _mouseY;
-               _mouseY = (_mouseY >= _screen.h) ? _screen.h : _mouseY;
+               _mouseY = (_mouseY >= _mouseRangeH) ? _mouseRangeH : _mouseY;
                do_joystick = true;
             }
          }
@@ -945,11 +1347,11 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
          {
             _mouseX += x;
             _mouseX = (_mouseX < 0) ? 0 : _mouseX;
-            _mouseX = (_mouseX >= _screen.w) ? _screen.w : _mouseX;
+            _mouseX = (_mouseX >= _mouseRangeW) ? _mouseRangeW : _mouseX;
 
             _mouseY += y;
             _mouseY = (_mouseY < 0) ? 0 : _mouseY;
-            _mouseY = (_mouseY >= _screen.h) ? _screen.h : _mouseY;
+            _mouseY = (_mouseY >= _mouseRangeH) ? _mouseRangeH : _mouseY;
 
             Common::Event ev;
             ev.type = Common::EVENT_MOUSEMOVE;
@@ -978,6 +1380,8 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
 
       void processKeyEvent(bool down, unsigned keycode, uint32_t character, uint16_t key_modifiers)
       {
+         Common::StackLock lock(_eventMutex);
+
          int _keyflags = 0;
          _keyflags |= (key_modifiers & RETROKMOD_CTRL) ? Common::KBD_CTRL : 0;
          _keyflags |= (key_modifiers & RETROKMOD_ALT) ? Common::KBD_ALT : 0;
@@ -1005,10 +1409,128 @@ class OSystem_RETRO : public EventsBaseBackend, public PaletteManager {
 
       void postQuit()
       {
+         Common::StackLock lock(_eventMutex);
+
          Common::Event ev;
          ev.type = Common::EVENT_QUIT;
          _events.push_back(ev);
       }
+
+      /* Save states */
+
+      void stateEngineChanged()
+      {
+         if (g_engine == _stateEngine)
+            return;
+
+         _stateEngine = g_engine;
+         _stateBound = 0;
+         _stateUnsupported = false;
+      }
+
+      /*
+       * States are saved through Engine::saveGameStream(), which writes the
+       * state before it returns. Engines which only save from their main
+       * loop, as saveGameState() may, don't support it and get no states.
+       */
+      bool canSaveState()
+      {
+         /* The engine can only be called into while it is suspended */
+         if (s_threaded)
+            return false;
+
+         stateEngineChanged();
+         return _stateEngine && _stateEngine->hasFeature(Engine::kSupportsSavingToStream) &&
+            _stateEngine->canSaveGameStateCurrently();
+      }
+
+      bool canLoadState()
+      {
+         if (s_threaded)
+            return false;
+
+         stateEngineChanged();
+         return _stateEngine && _stateEngine->hasFeature(Engine::kSupportsSavingToStream) &&
+            _stateEngine->canLoadGameStateCurrently();
+      }
+
+      void growStateBound(uint32 size)
+      {
+         const uint32 bound = STATE_HEADER_SIZE + ((size + size / 2 + STATE_ALIGN - 1) & ~(STATE_ALIGN - 1));
+         if (bound <= _stateBound)
+            return;
+
+         _stateBound = bound;
+         _stateReader.reserve(_stateBound - STATE_HEADER_SIZE);
+      }
+
+      size_t getStateSize()
+      {
+         /* The bound is measured once per engine with a dry run and only
+          * grows afterwards, so this is cheap to call every frame. */
+         stateEngineChanged();
+         if (!_stateBound && !_stateUnsupported && canSaveState())
+         {
+            _stateWriter.reset(0, 0);
+            const Common::ErrorCode error = _stateEngine->saveGameStream(&_stateWriter).getCode();
+            if (error == Common::kNoError)
+               growStateBound(_stateWriter.size());
+            else if (error == Common::kUnsupportedFeature)
+               _stateUnsupported = true;
+         }
+
+         /* No size tells the frontend that there are no states at all */
+         return _stateUnsupported ? 0 : _stateBound;
+      }
+
+      bool saveState(void *data, size_t size)
+      {
+         if (size <= STATE_HEADER_SIZE || !canSaveState() || _stateUnsupported)
+            return false;
+
+         byte *out = (byte *)data;
+         const uint32 capacity = size - STATE_HEADER_SIZE;
+
+         _stateWriter.reset(out + STATE_HEADER_SIZE, capacity);
+         const Common::Error error = _stateEngine->saveGameStream(&_stateWriter);
+         const uint32 written = _stateWriter.size();
+
+         if (error.getCode() == Common::kUnsupportedFeature)
+         {
+            _stateUnsupported = true;
+            return false;
+         }
+
+         if (written > capacity)
+         {
+            growStateBound(written);
+            return false;
+         }
+
+         if (error.getCode() != Common::kNoError)
+            return false;
+
+         WRITE_BE_UINT32(out, STATE_MAGIC);
+         WRITE_BE_UINT32(out + 4, written);
+         return true;
+      }
+
+      bool loadState(const void *data, size_t size)
+      {
+         const byte *in = (const byte *)data;
+
+         if (size <= STATE_HEADER_SIZE || READ_BE_UINT32(in) != STATE_MAGIC || !canLoadState())
+            return false;
+
+         const uint32 payloadSize = READ_BE_UINT32(in + 4);
+         if (payloadSize > size - STATE_HEADER_SIZE)
+            return false;
+
+         if (!_stateReader.reset(in + STATE_HEADER_SIZE, payloadSize))
+            return false;
+
+         return _stateEngine->loadGameStream(&_stateReader).getCode() == Common::kNoError;
+      }
 };
 
 OSystem* retroBuildOS()
@@ -1016,11 +1538,21 @@ OSystem* retroBuildOS()
    return new OSystem_RETRO();
 }
 
+void retroDestroyOS(OSystem* aSystem)
+{
+   delete (OSystem_RETRO *)aSystem;
+}
+
 const Graphics::Surface& getScreen()
 {
    return ((OSystem_RETRO*)g_system)->getScreen();
 }
 
+bool retroScreenUpdated()
+{
+   return ((OSystem_RETRO*)g_system)->screenUpdated();
+}
+
 void retroProcessMouse(retro_input_state_t aCallback)
 {
    ((OSystem_RETRO*)g_system)->processMouse(aCallback);
@@ -1041,7 +1573,65 @@ void retroSetSaveDir(const char* aPath)
    s_saveDir = Common::String(aPath ? aPath : ".");
 }
 
+void retroSetThreaded(bool aThreaded)
+{
+   s_threaded = aThreaded;
+}
+
+void retroMixAudio(int16_t *aBuffer, unsigned aFrames)
+{
+   ((OSystem_RETRO*)g_system)->mixAudio(aBuffer, aFrames);
+}
+
+void retroSetFrameBudget(uint aMillis)
+{
+   s_frameBudget = aMillis;
+}
+
+RetroFrameTimings retroTakeFrameTimings()
+{
+   return ((OSystem_RETRO*)g_system)->takeFrameTimings();
+}
+
+void retroSetAudioRate(uint aRate)
+{
+   s_audioRate = aRate;
+}
+
+void retroSetPixelFormat(enum retro_pixel_format aFormat, uint64 aCPUFeatures)
+{
+   switch (aFormat)
+   {
+      case RETRO_PIXEL_FORMAT_XRGB8888:
+         s_screenFormat = Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0);
+         break;
+      case RETRO_PIXEL_FORMAT_RGB565:
+         s_screenFormat = Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0);
+         break;
+      default:
+         s_screenFormat = Graphics::PixelFormat(2, 5, 5, 5, 1, 10, 5, 0, 15);
+         break;
+   }
+
+   retroBlitInit(aCPUFeatures);
+}
+
 void retroKeyEvent(bool down, unsigned keycode, uint32_t character, uint16_t key_modifiers)
 {
    ((OSystem_RETRO*)g_system)->processKeyEvent(down, keycode, character, key_modifiers);
 }
+
+size_t retroStateSize()
+{
+   return g_system ? ((OSystem_RETRO*)g_system)->getStateSize() : 0;
+}
+
+bool retroSaveState(void *data, size_t size)
+{
+   return g_system ? ((OSystem_RETRO*)g_system)->saveState(data, size) : false;
+}
+
+bool retroLoadState(const void *data, size_t size)
+{
+   return g_system ? ((OSystem_RETRO*)g_system)->loadState(data, size) : false;
+}
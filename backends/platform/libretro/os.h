@@ -42,15 +42,39 @@
 extern int access(const char *path, int amode);
 #endif
 
+/* Where the time since the previous retroTakeFrameTimings() went, in
+ * microseconds. The engine time leaves out the other phases and the time
+ * the engine slept. */
+struct RetroFrameTimings
+{
+   uint32 engineUsecs;
+   uint32 convertUsecs;
+   uint32 mixUsecs;
+   /* Times the engine hit the frame budget instead of presenting a frame */
+   uint32 budgetExceeded;
+};
+
 OSystem* retroBuildOS();
+void retroDestroyOS(OSystem* aSystem);
 const Graphics::Surface& getScreen();
+bool retroScreenUpdated();
 
 void retroProcessMouse(retro_input_state_t aCallback);
 void retroPostQuit();
 
 void retroSetSystemDir(const char* aPath);
 void retroSetSaveDir(const char* aPath);
+void retroSetAudioRate(uint aRate);
+void retroSetThreaded(bool aThreaded);
+void retroSetFrameBudget(uint aMillis);
+RetroFrameTimings retroTakeFrameTimings();
+void retroMixAudio(int16_t *aBuffer, unsigned aFrames);
+void retroSetPixelFormat(enum retro_pixel_format aFormat, uint64 aCPUFeatures);
 
 void retroKeyEvent(bool down, unsigned keycode, uint32_t character, uint16_t key_modifiers);
 
+size_t retroStateSize();
+bool retroSaveState(void *data, size_t size);
+bool retroLoadState(const void *data, size_t size);
+
 #endif
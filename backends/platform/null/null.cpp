@@ -27,6 +27,7 @@
 #define FORBIDDEN_SYMBOL_EXCEPTION_stdout
 #define FORBIDDEN_SYMBOL_EXCEPTION_stderr
 #define FORBIDDEN_SYMBOL_EXCEPTION_fputs
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
 
 #include "backends/modular-backend.h"
 #include "base/main.h"
@@ -40,6 +41,10 @@
 #include "audio/mixer_intern.h"
 #include "common/scummsys.h"
 
+#ifdef POSIX
+#include <sys/time.h>
+#endif
+
 /*
  * Include header files needed for the getFilesystemFactory() method.
  */
@@ -66,6 +71,11 @@ public:
 	virtual void getTimeAndDate(TimeDate &t) const {}
 
 	virtual void logMessage(LogMessageType::Type type, const char *message);
+
+private:
+#ifdef POSIX
+	timeval _startTime;
+#endif
 };
 
 OSystem_NULL::OSystem_NULL() {
@@ -78,9 +88,18 @@ OSystem_NULL::OSystem_NULL() {
 	#else
 		#error Unknown and unsupported FS backend
 	#endif
+
+	#ifdef POSIX
+		gettimeofday(&_startTime, 0);
+	#endif
 }
 
 OSystem_NULL::~OSystem_NULL() {
+	// The managers using mutexes must be gone before the mutex manager
+	delete _eventManager;
+	_eventManager = 0;
+	delete _timerManager;
+	_timerManager = 0;
 }
 
 void OSystem_NULL::initBackend() {
@@ -105,7 +124,16 @@ bool OSystem_NULL::pollEvent(Common::Event &event) {
 }
 
 uint32 OSystem_NULL::getMillis(bool skipRecord) {
+#ifdef POSIX
+	// Real time, so that headless runs like audio trace replays can be timed
+	timeval curTime;
+	gettimeofday(&curTime, 0);
+
+	return (uint32)(((curTime.tv_sec - _startTime.tv_sec) * 1000) +
+			((curTime.tv_usec - _startTime.tv_usec) / 1000));
+#else
 	return 0;
+#endif
 }
 
 void OSystem_NULL::delayMillis(uint msecs) {
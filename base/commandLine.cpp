@@ -33,6 +33,7 @@
 #include "base/version.h"
 
 #include "common/config-manager.h"
+#include "common/file.h"
 #include "common/fs.h"
 #include "common/rendermode.h"
 #include "common/system.h"
@@ -41,6 +42,7 @@
 #include "gui/ThemeEngine.h"
 
 #include "audio/musicplugin.h"
+#include "audio/trace.h"
 
 #define DETECTOR_TESTING_HACK
 #define UPGRADE_ALL_TARGETS_HACK
@@ -68,6 +70,9 @@ static const char HELP_STRING[] =
 	"  -z, --list-games         Display list of supported games and exit\n"
 	"  -t, --list-targets       Display list of configured targets and exit\n"
 	"  --list-saves=TARGET      Display a list of saved games for the game (TARGET) specified\n"
+	"  --replay-audio-trace=FILE\n"
+	"                           Replay a trace recorded with --audio-trace through\n"
+	"                           the selected music driver and OPL emulator\n"
 #if defined(WIN32) && !defined(_WIN32_WCE) && !defined(__SYMBIAN32__)
 	"  --console                Enable the console window (default:enabled)\n"
 #endif
@@ -117,6 +122,7 @@ static const char HELP_STRING[] =
 	"  --enable-gs              Enable Roland GS mode for MIDI playback\n"
 	"  --output-rate=RATE       Select output sample rate in Hz (e.g. 22050)\n"
 	"  --opl-driver=DRIVER      Select AdLib (OPL) emulator (db, mame)\n"
+	"  --audio-trace=FILE       Record everything sent to the music drivers to FILE\n"
 	"  --aspect-ratio           Enable aspect ratio correction\n"
 	"  --render-mode=MODE       Enable additional render modes (hercGreen, hercAmber,\n"
 	"                           cga, ega, vga, amiga, fmtowns, pc9821, pc9801, 2gs,\n"
@@ -197,6 +203,7 @@ void registerDefaults() {
 	ConfMan.registerDefault("native_mt32", false);
 	ConfMan.registerDefault("enable_gs", false);
 	ConfMan.registerDefault("midi_gain", 100);
+	ConfMan.registerDefault("mt32_render_ahead", false);
 
 	ConfMan.registerDefault("music_driver", "auto");
 	ConfMan.registerDefault("mt32_device", "null");
@@ -422,6 +429,9 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 				return "list-saves";
 			END_OPTION
 
+			DO_LONG_OPTION("replay-audio-trace")
+			END_OPTION
+
 			DO_OPTION('c', "config")
 			END_OPTION
 
@@ -446,6 +456,9 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 			DO_LONG_OPTION_INT("output-rate")
 			END_OPTION
 
+			DO_LONG_OPTION("audio-trace")
+			END_OPTION
+
 			DO_OPTION_BOOL('f', "fullscreen")
 			END_OPTION
 
@@ -623,6 +636,11 @@ unknownOption:
 		}
 	}
 
+	// Replaying an audio trace uses the music options given along with it,
+	// so it only becomes the command once all of them are parsed
+	if (settings.contains("replay-audio-trace"))
+		return "replay-audio-trace";
+
 	return Common::String();
 }
 
@@ -749,6 +767,33 @@ static void listThemes() {
 		printf("%-14s %s\n", i->id.c_str(), i->name.c_str());
 }
 
+/** Replay an audio trace and print how it went. */
+static Common::Error replayAudioTrace(const char *fileName) {
+	Common::File file;
+	if (!file.open(Common::FSNode(fileName)))
+		return Common::Error(Common::kReadingFailed, fileName);
+
+	Common::Array<Audio::TraceReplayStats> stats;
+	if (!Audio::replayTrace(file, stats))
+		return Common::Error(Common::kUnknownError, Common::String::format("'%s' is not an audio trace", fileName));
+
+	printf("Device                                    Frames  Time (ms)  Frames/s  Checksum\n"
+	       "----------------------------------------- -------- --------- --------- --------\n");
+	for (uint i = 0; i < stats.size(); ++i) {
+		const Audio::TraceReplayStats &s = stats[i];
+		if (s.frames) {
+			printf("%-41s %8u %9u %9u %08x%s\n", s.description.c_str(), s.frames, s.millis,
+			       s.millis ? (uint)((uint64)s.frames * 1000 / s.millis) : 0, s.checksum,
+			       s.complete ? "" : " (incomplete)");
+		} else {
+			printf("%-41s %8s %9u %9s %8s%s\n", s.description.c_str(), "-", s.millis, "-", "-",
+			       s.complete ? "" : " (incomplete)");
+		}
+	}
+
+	return Common::kNoError;
+}
+
 /** Lists all output devices */
 static void listAudioDevices() {
 	MusicPlugin::List pluginList = MusicMan.getPlugins();
@@ -960,6 +1005,22 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
 #endif // DISABLE_COMMAND_LINE
 
 
+/** Store the command line settings into the config manager */
+static void storeSettings(const Common::StringMap &settings) {
+	for (Common::StringMap::const_iterator x = settings.begin(); x != settings.end(); ++x) {
+		Common::String key(x->_key);
+		Common::String value(x->_value);
+
+		// Replace any "-" in the key by "_" (e.g. change "save-slot" to "save_slot").
+		for (Common::String::iterator c = key.begin(); c != key.end(); ++c)
+			if (*c == '-')
+				*c = '_';
+
+		// Store it into ConfMan.
+		ConfMan.set(key, value, Common::ConfigManager::kTransientDomain);
+	}
+}
+
 bool processSettings(Common::String &command, Common::StringMap &settings, Common::Error &err) {
 	err = Common::kNoError;
 
@@ -980,6 +1041,12 @@ bool processSettings(Common::String &command, Common::StringMap &settings, Commo
 	} else if (command == "list-themes") {
 		listThemes();
 		return true;
+	} else if (command == "replay-audio-trace") {
+		// The replay needs the mixer, so processBackendCommand() runs it once
+		// the backend is up. The music driver and OPL emulator can be selected
+		// on the command line.
+		storeSettings(settings);
+		return false;
 	} else if (command == "list-audio-devices") {
 		listAudioDevices();
 		return true;
@@ -1039,18 +1106,20 @@ bool processSettings(Common::String &command, Common::StringMap &settings, Commo
 
 
 	// Finally, store the command line settings into the config manager.
-	for (Common::StringMap::const_iterator x = settings.begin(); x != settings.end(); ++x) {
-		Common::String key(x->_key);
-		Common::String value(x->_value);
+	storeSettings(settings);
 
-		// Replace any "-" in the key by "_" (e.g. change "save-slot" to "save_slot").
-		for (Common::String::iterator c = key.begin(); c != key.end(); ++c)
-			if (*c == '-')
-				*c = '_';
+	return false;
+}
 
-		// Store it into ConfMan.
-		ConfMan.set(key, value, Common::ConfigManager::kTransientDomain);
+bool processBackendCommand(const Common::String &command, Common::Error &err) {
+	err = Common::kNoError;
+
+#ifndef DISABLE_COMMAND_LINE
+	if (command == "replay-audio-trace") {
+		err = replayAudioTrace(ConfMan.get("replay_audio_trace").c_str());
+		return true;
 	}
+#endif // DISABLE_COMMAND_LINE
 
 	return false;
 }
@@ -55,6 +55,17 @@ Common::String parseCommandLine(Common::StringMap &settings, int argc, const cha
  */
 bool processSettings(Common::String &command, Common::StringMap &settings, Common::Error &err);
 
+/**
+ * Process the commands which need an initialized backend, like replaying an
+ * audio trace. Called once the backend is initialized, if processSettings()
+ * returned false.
+ *
+ * @param[in] command	the command as returned by parseCommandLine
+ * @param[out] err		indicates whether any error occurred, and which
+ * @return true if the command was completely processed and ScummVM should quit, false otherwise
+ */
+bool processBackendCommand(const Common::String &command, Common::Error &err);
+
 } // End of namespace Base
 
 #endif
@@ -57,6 +57,7 @@
 
 #include "audio/mididrv.h"
 #include "audio/musicplugin.h"  /* for music manager */
+#include "audio/trace.h"
 
 #include "graphics/cursorman.h"
 #include "graphics/fontman.h"
@@ -430,6 +431,12 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	// the command line params) was read.
 	system.initBackend();
 
+	if (Base::processBackendCommand(command, res)) {
+		if (res.getCode() != Common::kNoError)
+			warning("%s", res.getDesc().c_str());
+		return res.getCode();
+	}
+
 #ifdef SCUMMVMKOR
 	// KOR: 한글 폰트를 로드한다
 	Graphics::loadKoreanGUIFont();
@@ -628,6 +635,7 @@ extern "C" int scummvm_main(int argc, const char * const argv[]) {
 	Common::TranslationManager::destroy();
 #endif
 	MusicManager::destroy();
+	Audio::TraceRecorder::destroyConfigured();
 	Graphics::CursorManager::destroy();
 	Graphics::FontManager::destroy();
 #ifdef USE_FREETYPE2
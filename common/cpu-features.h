@@ -0,0 +1,66 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_CPU_FEATURES_H
+#define COMMON_CPU_FEATURES_H
+
+/**
+ * @file
+ * The vector instruction sets which kernels can be built for, and the
+ * compiler intrinsics for them.
+ *
+ * As this pulls in the intrinsic headers of the compiler, it may only be
+ * included by files defining FORBIDDEN_SYMBOL_ALLOW_ALL. It defines:
+ *
+ * - SIMD_SSE2, SIMD_AVX2 and SIMD_NEON for each instruction set kernels
+ *   can be built for
+ * - SIMD_TARGET(x) to put in front of a function using instruction set x
+ * - SIMD_CPU_SUPPORTS(x) to check whether the CPU running the code
+ *   supports instruction set x, before calling such a function
+ *
+ * With GCC and clang on x86, the kernels are built with per function
+ * target attributes and picked at runtime, so they work whatever the
+ * global compiler flags are. Other compilers only get SSE2 kernels, and
+ * only if they generate SSE2 code anyway. NEON is used if the compiler
+ * targets it.
+ */
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__)) && \
+	(defined(__clang__) || __GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#include <immintrin.h>
+#define SIMD_SSE2
+#define SIMD_AVX2
+#define SIMD_TARGET(x) __attribute__((target(x)))
+#define SIMD_CPU_SUPPORTS(x) __builtin_cpu_supports(x)
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_SSE2
+#define SIMD_TARGET(x)
+#define SIMD_CPU_SUPPORTS(x) true
+#endif
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define SIMD_NEON
+#endif
+
+#endif
@@ -70,6 +70,9 @@ static String errorToString(ErrorCode errorCode) {
 	case kUserCanceled:
 		return _s("User canceled");
 
+	case kUnsupportedFeature:
+		return _s("Feature not supported");
+
 	case kUnknownError:
 	default:
 		return _s("Unknown error");
@@ -64,6 +64,8 @@ enum ErrorCode {
 
 	kUserCanceled,			///< User has canceled the launching of the game
 
+	kUnsupportedFeature,		///< The engine does not implement the requested feature
+
 	kUnknownError				///< Catch-all error, used if no other error code matches
 };
 
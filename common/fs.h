@@ -213,6 +213,15 @@ public:
 	 */
 	bool isWritable() const;
 
+	/**
+	 * Returns the time of the last modification of the object, in seconds
+	 * since some unspecified epoch. This is only meant to detect changes to
+	 * a file; 0 means the time is not known.
+	 *
+	 * @return the modification time, or 0 if not available
+	 */
+	uint32 getModificationTime() const;
+
 	/**
 	 * Creates a SeekableReadStream instance corresponding to the file
 	 * referred by this node. This assumes that the node actually refers
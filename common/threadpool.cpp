@@ -0,0 +1,346 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#define FORBIDDEN_SYMBOL_EXCEPTION_time_h
+#define FORBIDDEN_SYMBOL_EXCEPTION_unistd_h
+
+#include "common/threadpool.h"
+#include "common/textconsole.h"
+#include "common/util.h"
+
+#ifdef HAVE_THREADS
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+namespace Common {
+DECLARE_SINGLETON(ThreadPool);
+
+enum {
+	/** Upper limit on the number of worker threads */
+	kMaxWorkers = 15
+};
+
+#pragma mark -
+
+#ifdef HAVE_THREADS
+
+NativeMutex::NativeMutex() {
+	pthread_mutex_t *mutex = new pthread_mutex_t;
+	if (pthread_mutex_init(mutex, 0) != 0)
+		error("NativeMutex: pthread_mutex_init() failed");
+	_mutex = mutex;
+}
+
+NativeMutex::~NativeMutex() {
+	pthread_mutex_destroy((pthread_mutex_t *)_mutex);
+	delete (pthread_mutex_t *)_mutex;
+}
+
+void NativeMutex::lock() {
+	pthread_mutex_lock((pthread_mutex_t *)_mutex);
+}
+
+void NativeMutex::unlock() {
+	pthread_mutex_unlock((pthread_mutex_t *)_mutex);
+}
+
+NativeCondition::NativeCondition() {
+	pthread_cond_t *cond = new pthread_cond_t;
+	if (pthread_cond_init(cond, 0) != 0)
+		error("NativeCondition: pthread_cond_init() failed");
+	_cond = cond;
+}
+
+NativeCondition::~NativeCondition() {
+	pthread_cond_destroy((pthread_cond_t *)_cond);
+	delete (pthread_cond_t *)_cond;
+}
+
+void NativeCondition::wait(NativeMutex &mutex) {
+	pthread_cond_wait((pthread_cond_t *)_cond, (pthread_mutex_t *)mutex._mutex);
+}
+
+bool NativeCondition::wait(NativeMutex &mutex, uint32 timeout) {
+	struct timespec until;
+	clock_gettime(CLOCK_REALTIME, &until);
+	until.tv_sec += timeout / 1000;
+	until.tv_nsec += (timeout % 1000) * 1000000;
+	if (until.tv_nsec >= 1000000000) {
+		until.tv_sec++;
+		until.tv_nsec -= 1000000000;
+	}
+
+	return pthread_cond_timedwait((pthread_cond_t *)_cond, (pthread_mutex_t *)mutex._mutex, &until) != ETIMEDOUT;
+}
+
+void NativeCondition::signal() {
+	pthread_cond_signal((pthread_cond_t *)_cond);
+}
+
+void NativeCondition::broadcast() {
+	pthread_cond_broadcast((pthread_cond_t *)_cond);
+}
+
+struct NativeThreadStart {
+	NativeThread::ThreadFunc func;
+	void *data;
+
+	static void *threadMain(void *arg) {
+		NativeThreadStart start = *(NativeThreadStart *)arg;
+		delete (NativeThreadStart *)arg;
+		start.func(start.data);
+		return 0;
+	}
+};
+
+NativeThread::NativeThread() : _thread(0) {}
+
+NativeThread::~NativeThread() {
+	assert(!_thread);
+}
+
+bool NativeThread::start(ThreadFunc func, void *data) {
+	assert(!_thread);
+
+	NativeThreadStart *start = new NativeThreadStart();
+	start->func = func;
+	start->data = data;
+
+	pthread_t *thread = new pthread_t;
+	if (pthread_create(thread, 0, NativeThreadStart::threadMain, start) != 0) {
+		delete start;
+		delete thread;
+		return false;
+	}
+
+	_thread = thread;
+	return true;
+}
+
+void NativeThread::join() {
+	if (!_thread)
+		return;
+
+	pthread_join(*(pthread_t *)_thread, 0);
+	delete (pthread_t *)_thread;
+	_thread = 0;
+}
+
+#else
+
+NativeMutex::NativeMutex() : _mutex(0) {}
+NativeMutex::~NativeMutex() {}
+void NativeMutex::lock() {}
+void NativeMutex::unlock() {}
+
+NativeCondition::NativeCondition() : _cond(0) {}
+NativeCondition::~NativeCondition() {}
+void NativeCondition::wait(NativeMutex &mutex) {}
+bool NativeCondition::wait(NativeMutex &mutex, uint32 timeout) { return true; }
+void NativeCondition::signal() {}
+void NativeCondition::broadcast() {}
+
+NativeThread::NativeThread() : _thread(0) {}
+NativeThread::~NativeThread() {}
+bool NativeThread::start(ThreadFunc func, void *data) { return false; }
+void NativeThread::join() {}
+
+#endif
+
+#pragma mark -
+
+#ifdef HAVE_THREADS
+
+struct ThreadPoolState {
+	pthread_t workers[kMaxWorkers];
+	uint workerCount;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t workCond;
+	pthread_cond_t doneCond;
+
+	ThreadPool::TaskFunc func;
+	void *data;
+	uint next;
+	uint count;
+	uint pending;
+	bool busy;
+	bool quit;
+
+	/** Run tasks of the current loop until none are left. Called locked. */
+	void runTasks() {
+		while (next < count) {
+			const uint index = next++;
+			pthread_mutex_unlock(&mutex);
+			func(data, index);
+			pthread_mutex_lock(&mutex);
+
+			if (--pending == 0)
+				pthread_cond_signal(&doneCond);
+		}
+	}
+
+	static void *workerMain(void *arg) {
+		ThreadPoolState *state = (ThreadPoolState *)arg;
+
+		pthread_mutex_lock(&state->mutex);
+		while (!state->quit) {
+			state->runTasks();
+			if (!state->quit)
+				pthread_cond_wait(&state->workCond, &state->mutex);
+		}
+		pthread_mutex_unlock(&state->mutex);
+		return 0;
+	}
+};
+
+/**
+ * Guards starting the workers, as parallelFor() may be called from several
+ * threads at once
+ */
+static pthread_mutex_t s_startMutex = PTHREAD_MUTEX_INITIALIZER;
+
+ThreadPool::ThreadPool() : _state(0) {
+}
+
+ThreadPool::~ThreadPool() {
+	if (!_state)
+		return;
+
+	pthread_mutex_lock(&_state->mutex);
+	_state->quit = true;
+	pthread_cond_broadcast(&_state->workCond);
+	pthread_mutex_unlock(&_state->mutex);
+
+	for (uint i = 0; i < _state->workerCount; i++)
+		pthread_join(_state->workers[i], 0);
+
+	pthread_cond_destroy(&_state->doneCond);
+	pthread_cond_destroy(&_state->workCond);
+	pthread_mutex_destroy(&_state->mutex);
+	delete _state;
+}
+
+void ThreadPool::start() {
+	pthread_mutex_lock(&s_startMutex);
+	if (_state) {
+		pthread_mutex_unlock(&s_startMutex);
+		return;
+	}
+
+	ThreadPoolState *state = new ThreadPoolState();
+	pthread_mutex_init(&state->mutex, 0);
+	pthread_cond_init(&state->workCond, 0);
+	pthread_cond_init(&state->doneCond, 0);
+
+	const uint wanted = MIN<uint>(getCPUCount() - 1, kMaxWorkers);
+	for (uint i = 0; i < wanted; i++) {
+		if (pthread_create(&state->workers[state->workerCount], 0, ThreadPoolState::workerMain, state) != 0) {
+			warning("ThreadPool: Could only start %u of %u worker threads", i, wanted);
+			break;
+		}
+		state->workerCount++;
+	}
+
+	_state = state;
+	pthread_mutex_unlock(&s_startMutex);
+}
+
+void ThreadPool::parallelFor(TaskFunc func, void *data, uint count) {
+	if (count > 1)
+		start();
+
+	if (count > 1 && _state->workerCount) {
+		pthread_mutex_lock(&_state->mutex);
+		if (!_state->busy) {
+			_state->busy = true;
+			_state->func = func;
+			_state->data = data;
+			_state->next = 0;
+			_state->count = count;
+			_state->pending = count;
+			pthread_cond_broadcast(&_state->workCond);
+
+			_state->runTasks();
+			while (_state->pending)
+				pthread_cond_wait(&_state->doneCond, &_state->mutex);
+
+			_state->busy = false;
+			pthread_mutex_unlock(&_state->mutex);
+			return;
+		}
+		pthread_mutex_unlock(&_state->mutex);
+	}
+
+	for (uint i = 0; i < count; i++)
+		func(data, i);
+}
+
+uint ThreadPool::getThreadCount() const {
+	pthread_mutex_lock(&s_startMutex);
+	const uint count = _state ? _state->workerCount + 1 : MIN<uint>(getCPUCount(), kMaxWorkers + 1);
+	pthread_mutex_unlock(&s_startMutex);
+	return count;
+}
+
+uint ThreadPool::getCPUCount() {
+#ifdef _SC_NPROCESSORS_ONLN
+	const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	if (cpus > 1)
+		return (uint)cpus;
+#endif
+	return 1;
+}
+
+#else
+
+struct ThreadPoolState {
+};
+
+ThreadPool::ThreadPool() : _state(0) {
+}
+
+ThreadPool::~ThreadPool() {
+}
+
+void ThreadPool::start() {
+}
+
+void ThreadPool::parallelFor(TaskFunc func, void *data, uint count) {
+	for (uint i = 0; i < count; i++)
+		func(data, i);
+}
+
+uint ThreadPool::getThreadCount() const {
+	return 1;
+}
+
+uint ThreadPool::getCPUCount() {
+	return 1;
+}
+
+#endif
+
+} // End of namespace Common
@@ -0,0 +1,162 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef COMMON_THREADPOOL_H
+#define COMMON_THREADPOOL_H
+
+#include "common/scummsys.h"
+#include "common/noncopyable.h"
+#include "common/singleton.h"
+
+namespace Common {
+
+/**
+ * A mutex that works across the threads of the ThreadPool.
+ *
+ * Unlike Common::Mutex this does not depend on the backend, whose mutexes
+ * may be no-ops when it never runs code on more than one thread. Without
+ * HAVE_THREADS, locking does nothing.
+ */
+class NativeMutex : NonCopyable {
+	friend class NativeCondition;
+
+	void *_mutex;
+
+public:
+	NativeMutex();
+	~NativeMutex();
+
+	void lock();
+	void unlock();
+};
+
+/**
+ * Auxillary class to (un)lock a NativeMutex on the stack.
+ */
+class NativeStackLock : NonCopyable {
+	NativeMutex &_mutex;
+
+public:
+	explicit NativeStackLock(NativeMutex &mutex) : _mutex(mutex) { _mutex.lock(); }
+	~NativeStackLock() { _mutex.unlock(); }
+};
+
+/**
+ * A condition variable to be used together with a NativeMutex. Without
+ * HAVE_THREADS, waiting returns immediately.
+ */
+class NativeCondition : NonCopyable {
+	void *_cond;
+
+public:
+	NativeCondition();
+	~NativeCondition();
+
+	/** Atomically unlock the mutex and wait to be woken, then relock it. */
+	void wait(NativeMutex &mutex);
+
+	/**
+	 * Like wait(), but give up after timeout milliseconds.
+	 * @return false if the time ran out before the condition was signalled
+	 */
+	bool wait(NativeMutex &mutex, uint32 timeout);
+
+	/** Wake one waiting thread. */
+	void signal();
+
+	/** Wake all waiting threads. */
+	void broadcast();
+};
+
+/**
+ * A single dedicated thread, for long running work like rendering ahead
+ * of a consumer. For splitting up loops, use the ThreadPool instead.
+ */
+class NativeThread : NonCopyable {
+public:
+	typedef void (*ThreadFunc)(void *data);
+
+	NativeThread();
+	~NativeThread();
+
+	/**
+	 * Start running func(data) on a new thread.
+	 *
+	 * @return false if no thread could be started, including when built
+	 *         without HAVE_THREADS. The caller has to do the work itself then.
+	 */
+	bool start(ThreadFunc func, void *data);
+
+	/** Wait for the thread function to return. Does nothing if not running. */
+	void join();
+
+	bool isRunning() const { return _thread != 0; }
+
+private:
+	void *_thread;
+};
+
+struct ThreadPoolState;
+
+/**
+ * A pool of worker threads for splitting CPU or I/O bound loops.
+ *
+ * The workers are started on first use, one less than the number of CPUs, as
+ * the calling thread takes part in the work too. Without HAVE_THREADS, or
+ * when called while the pool is already busy (for instance from one of its
+ * own tasks), all work simply runs on the calling thread.
+ */
+class ThreadPool : public Singleton<ThreadPool> {
+public:
+	typedef void (*TaskFunc)(void *data, uint index);
+
+	ThreadPool();
+	~ThreadPool();
+
+	/**
+	 * Call func(data, i) for each i in [0, count) and wait until all calls
+	 * have returned. The calls may run in any order and concurrently, so
+	 * each should only write to its own part of the output.
+	 */
+	void parallelFor(TaskFunc func, void *data, uint count);
+
+	/**
+	 * Returns the number of threads parallelFor() spreads its work over,
+	 * including the caller.
+	 */
+	uint getThreadCount() const;
+
+	/** Returns the number of online CPUs, or 1 if it cannot be determined. */
+	static uint getCPUCount();
+
+private:
+	ThreadPoolState *_state;
+
+	void start();
+};
+
+} // End of namespace Common
+
+/** Shortcut for accessing the thread pool. */
+#define ThreadPoolMan Common::ThreadPool::instance()
+
+#endif
@@ -106,6 +106,9 @@ typedef struct {
 #include "common/fs.h"
 #include "common/unzip.h"
 #include "common/memstream.h"
+#include "common/ptr.h"
+#include "common/substream.h"
+#include "common/textconsole.h"
 
 #include "common/hashmap.h"
 #include "common/hash-str.h"
@@ -382,6 +385,7 @@ typedef Common::HashMap<Common::String, cached_file_in_zip, Common::IgnoreCase_H
 */
 typedef struct {
 	Common::SeekableReadStream *_stream;				/* io structore of the zipfile */
+	Common::SharedPtr<Common::SeekableReadStream> _streamOwner;	/* shared with open members */
 	unz_global_info gi;				/* public global information */
 	uLong byte_before_the_zipfile;	/* byte before the zipfile, (>0 for sfx)*/
 	uLong num_file;					/* number of the current file in the zipfile*/
@@ -544,6 +548,7 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 	int err=UNZ_OK;
 
 	us->_stream = stream;
+	us->_streamOwner = Common::SharedPtr<Common::SeekableReadStream>(stream);
 
 	central_pos = unzlocal_SearchCentralDir(*us->_stream);
 	if (central_pos==0)
@@ -595,7 +600,6 @@ unzFile unzOpen(Common::SeekableReadStream *stream) {
 		err=UNZ_BADZIPFILE;
 
 	if (err != UNZ_OK) {
-		delete us->_stream;
 		delete us;
 		return NULL;
 	}
@@ -644,7 +648,7 @@ int unzClose(unzFile file) {
 	if (s->pfile_in_zip_read != NULL)
 		unzCloseCurrentFile(file);
 
-	delete s->_stream;
+	// The stream is deleted once no member streams use it any more
 	delete s;
 	return UNZ_OK;
 }
@@ -1485,36 +1489,174 @@ const ArchiveMemberPtr ZipArchive::getMember(const String &name) const {
 	return ArchiveMemberPtr(new GenericArchiveMember(name, this));
 }
 
+/**
+ * A window into the archive for stored members. Member streams share
+ * ownership of the archive stream, so they stay usable after the archive
+ * itself has been deleted.
+ */
+class ZipStoredReadStream : public SafeSeekableSubReadStream {
+private:
+	SharedPtr<SeekableReadStream> _archive;
+
+public:
+	ZipStoredReadStream(const SharedPtr<SeekableReadStream> &archive, uint32 begin, uint32 end)
+		: SafeSeekableSubReadStream(archive.get(), begin, end), _archive(archive) {
+	}
+};
+
+#ifdef USE_ZLIB
+
+/**
+ * Inflates a deflated archive member on demand. Each stream has its own
+ * inflate state and reads the archive through a SafeSeekableSubReadStream,
+ * so any number of members can be open and used at the same time. Like
+ * ZipStoredReadStream, it shares ownership of the archive stream.
+ */
+class ZipInflateReadStream : public SeekableReadStream {
+private:
+	enum {
+		BUFSIZE = UNZ_BUFSIZE
+	};
+
+	byte _buf[BUFSIZE];
+
+	SharedPtr<SeekableReadStream> _archive;
+	SafeSeekableSubReadStream _compressed;
+	z_stream _stream;
+	int _zlibErr;
+	uint32 _pos;
+	uint32 _size;
+	uLong _crc;
+	uLong _expectedCrc;
+	bool _eos;
+
+public:
+	ZipInflateReadStream(const SharedPtr<SeekableReadStream> &archive, uint32 begin, uint32 compressedSize, uint32 size, uLong crc)
+		: _archive(archive), _compressed(archive.get(), begin, begin + compressedSize), _stream(), _pos(0), _size(size),
+		  _crc(0), _expectedCrc(crc), _eos(false) {
+		// Zip members have no zlib header. Like in unzReadCurrentFile,
+		// the known sizes make waiting for Z_STREAM_END unnecessary.
+		_zlibErr = inflateInit2(&_stream, -MAX_WBITS);
+		_stream.next_in = _buf;
+		_stream.avail_in = 0;
+	}
+
+	~ZipInflateReadStream() {
+		inflateEnd(&_stream);
+	}
+
+	bool err() const { return (_zlibErr != Z_OK) && (_zlibErr != Z_STREAM_END); }
+	void clearErr() { _eos = false; }
+	bool eos() const { return _eos; }
+	int32 pos() const { return _pos; }
+	int32 size() const { return _size; }
+
+	uint32 read(void *dataPtr, uint32 dataSize) {
+		if (dataSize > _size - _pos) {
+			dataSize = _size - _pos;
+			_eos = true;
+		}
+
+		_stream.next_out = (Bytef *)dataPtr;
+		_stream.avail_out = dataSize;
+
+		while (_zlibErr == Z_OK && _stream.avail_out) {
+			if (_stream.avail_in == 0) {
+				_stream.next_in = _buf;
+				_stream.avail_in = _compressed.read(_buf, BUFSIZE);
+				if (_stream.avail_in == 0)
+					break;
+			}
+			_zlibErr = inflate(&_stream, Z_SYNC_FLUSH);
+		}
+
+		const uint32 done = dataSize - _stream.avail_out;
+		_crc = crc32(_crc, (const Bytef *)dataPtr, done);
+		_pos += done;
+
+		if (done < dataSize)
+			_eos = true;
+
+		if (_pos == _size && _crc != _expectedCrc) {
+			warning("ZipInflateReadStream: CRC mismatch");
+			_zlibErr = Z_DATA_ERROR;
+		}
+
+		return done;
+	}
+
+	bool seek(int32 offset, int whence = SEEK_SET) {
+		int32 newPos = 0;
+		switch (whence) {
+		case SEEK_SET:
+			newPos = offset;
+			break;
+		case SEEK_CUR:
+			newPos = _pos + offset;
+			break;
+		case SEEK_END:
+			newPos = _size + offset;
+			break;
+		}
+
+		if (newPos < 0 || (uint32)newPos > _size)
+			return false;
+
+		if ((uint32)newPos < _pos) {
+			// Deflate data can only be decoded from the start
+			_zlibErr = inflateReset(&_stream);
+			if (_zlibErr != Z_OK)
+				return false;
+			_compressed.seek(0);
+			_stream.next_in = _buf;
+			_stream.avail_in = 0;
+			_pos = 0;
+			_crc = 0;
+		}
+
+		// Decode up to the new position in chunks
+		byte tmp[1024];
+		while (_pos < (uint32)newPos && !err()) {
+			const uint32 skip = MIN<uint32>(sizeof(tmp), newPos - _pos);
+			if (read(tmp, skip) != skip)
+				return false;
+		}
+
+		_eos = false;
+		return !err();
+	}
+};
+
+#endif // USE_ZLIB
+
 SeekableReadStream *ZipArchive::createReadStreamForMember(const String &name) const {
 	if (unzLocateFile(_zipFile, name.c_str(), 2) != UNZ_OK)
 		return 0;
 
-	unz_file_info fileInfo;
 	if (unzOpenCurrentFile(_zipFile) != UNZ_OK)
 		return 0;
 
-	if (unzGetCurrentFileInfo(_zipFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) != UNZ_OK)
-		return 0;
-
-	byte *buffer = (byte *)malloc(fileInfo.uncompressed_size);
-	assert(buffer);
+	// Only take the location of the data, the member is read through its
+	// own stream instead of the archive's single current file.
+	const unz_s *const archive = (const unz_s *)_zipFile;
+	const file_in_zip_read_info_s *info = archive->pfile_in_zip_read;
+	const unz_file_info &fileInfo = archive->cur_file_info;
 
-	if (unzReadCurrentFile(_zipFile, buffer, fileInfo.uncompressed_size) != (int)fileInfo.uncompressed_size) {
-		free(buffer);
-		return 0;
-	}
+	const uint32 begin = info->pos_in_zipfile + info->byte_before_the_zipfile;
+	const uLong method = info->compression_method;
 
-	if (unzCloseCurrentFile(_zipFile) != UNZ_OK) {
-		free(buffer);
-		return 0;
-	}
+	unzCloseCurrentFile(_zipFile);
 
-	return new MemoryReadStream(buffer, fileInfo.uncompressed_size, DisposeAfterUse::YES);
+	// Stored members are returned as a window into the archive
+	if (method == 0)
+		return new ZipStoredReadStream(archive->_streamOwner, begin, begin + fileInfo.uncompressed_size);
 
-	// FIXME: instead of reading all into a memory stream, we could
-	// instead create a new ZipStream class. But then we have to be
-	// careful to handle the case where the client code opens multiple
-	// files in the archive and tries to use them independently.
+#ifdef USE_ZLIB
+	return new ZipInflateReadStream(archive->_streamOwner, begin, fileInfo.compressed_size,
+	                                fileInfo.uncompressed_size, fileInfo.crc);
+#else
+	return 0;
+#endif
 }
 
 Archive *makeZipArchive(const String &name) {
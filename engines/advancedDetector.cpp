@@ -28,9 +28,11 @@
 #include "common/config-manager.h"
 #include "common/system.h"
 #include "common/textconsole.h"
+#include "common/threadpool.h"
 #include "common/translation.h"
 #include "gui/EventRecorder.h"
 #include "engines/advancedDetector.h"
+#include "engines/detectioncache.h"
 #include "engines/obsolete.h"
 
 static GameDescriptor toGameDescriptor(const ADGameDescription &g, const PlainGameDescriptor *sg) {
@@ -265,6 +267,7 @@ Common::Error AdvancedMetaEngine::createInstance(OSystem *syst, Engine **engine)
 
 	// Run the detector on this
 	ADGameDescList matches = detectGame(files.begin()->getParent(), allFiles, language, platform, extra);
+	DetectionCacheMan.flush();
 
 	if (cleanupPirated(matches))
 		return Common::kNoGameDataFoundError;
@@ -385,34 +388,85 @@ void AdvancedMetaEngine::composeFileHashMap(FileMap &allFiles, const Common::FSL
 	}
 }
 
-bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const FileMap &allFiles, const ADGameDescription &game, const Common::String fname, ADFileProperties &fileProps) const {
-	// FIXME/TODO: We don't handle the case that a file is listed as a regular
-	// file and as one with resource fork.
-
-	if (game.flags & ADGF_MACRESFORK) {
+/**
+ * Compute the size and MD5 of a file, or of the resource fork of a Mac file
+ * in the parent directory node. This only uses the data passed in, so it can
+ * run on the threads of the ThreadPool.
+ *
+ * @param cache	the detection cache, prepared on the main thread, or 0
+ */
+static bool computeFileProperties(const Common::FSNode &node, bool resFork, const Common::String &fname, uint md5Bytes, DetectionCache *cache, ADFileProperties &fileProps) {
+	if (resFork) {
 		Common::MacResManager macResMan;
 
-		if (!macResMan.open(parent, fname))
+		if (!macResMan.open(node, fname))
 			return false;
 
-		fileProps.md5 = macResMan.computeResForkMD5AsString(_md5Bytes);
+		fileProps.md5 = macResMan.computeResForkMD5AsString(md5Bytes);
 		fileProps.size = macResMan.getResForkDataSize();
 		return true;
 	}
 
-	if (!allFiles.contains(fname))
-		return false;
-
 	Common::File testFile;
 
-	if (!testFile.open(allFiles[fname]))
+	if (!testFile.open(node))
 		return false;
 
 	fileProps.size = (int32)testFile.size();
-	fileProps.md5 = Common::computeStreamMD5AsString(testFile, _md5Bytes);
+
+	// Only the size is needed to check a cached MD5, which saves reading
+	// the file when the same folders are scanned again.
+	if (cache && cache->lookup(node, fileProps.size, md5Bytes, fileProps.md5))
+		return true;
+
+	fileProps.md5 = Common::computeStreamMD5AsString(testFile, md5Bytes);
+	if (cache)
+		cache->store(node, fileProps.size, md5Bytes, fileProps.md5);
 	return true;
 }
 
+bool AdvancedMetaEngine::getFileProperties(const Common::FSNode &parent, const FileMap &allFiles, const ADGameDescription &game, const Common::String fname, ADFileProperties &fileProps) const {
+	// FIXME/TODO: We don't handle the case that a file is listed as a regular
+	// file and as one with resource fork.
+
+	DetectionCache *cache = DetectionCacheMan.prepare() ? &DetectionCacheMan : 0;
+
+	if (game.flags & ADGF_MACRESFORK)
+		return computeFileProperties(parent, true, fname, _md5Bytes, cache, fileProps);
+
+	if (!allFiles.contains(fname))
+		return false;
+
+	return computeFileProperties(allFiles[fname], false, fname, _md5Bytes, cache, fileProps);
+}
+
+/**
+ * The files to hash in one detection pass, for ThreadPool::parallelFor().
+ *
+ * Each file gets its own copies of the node and name to work with, made on
+ * the main thread. Copies of nodes and strings otherwise share data, whose
+ * reference counts are not thread safe.
+ */
+struct FilePropertiesTask {
+	struct File {
+		Common::FSNode node;	///< the file, or its directory for resource forks
+		bool resFork;
+		Common::String name;
+		ADFileProperties props;
+		bool found;
+	};
+
+	uint md5Bytes;
+	DetectionCache *cache;
+	Common::Array<File> files;
+
+	static void run(void *data, uint index) {
+		FilePropertiesTask *task = (FilePropertiesTask *)data;
+		File &file = task->files[index];
+		file.found = computeFileProperties(file.node, file.resFork, file.name, task->md5Bytes, task->cache, file.props);
+	}
+};
+
 ADGameDescList AdvancedMetaEngine::detectGame(const Common::FSNode &parent, const FileMap &allFiles, Common::Language language, Common::Platform platform, const Common::String &extra) const {
 	ADFilePropertiesMap filesProps;
 
@@ -423,21 +477,44 @@ ADGameDescList AdvancedMetaEngine::detectGame(const Common::FSNode &parent, cons
 	debug(3, "Starting detection in dir '%s'", parent.getPath().c_str());
 
 	// Check which files are included in some ADGameDescription *and* are present.
-	// Compute MD5s and file sizes for these files.
+	// Compute MD5s and file sizes for these files. The first game listing
+	// a file decides how it is hashed.
+	Common::HashMap<Common::String, bool, Common::IgnoreCase_Hash, Common::IgnoreCase_EqualTo> seen;
+	FilePropertiesTask task;
+	task.md5Bytes = _md5Bytes;
+	task.cache = DetectionCacheMan.prepare() ? &DetectionCacheMan : 0;
+
 	for (descPtr = _gameDescriptors; ((const ADGameDescription *)descPtr)->gameId != 0; descPtr += _descItemSize) {
 		g = (const ADGameDescription *)descPtr;
 
 		for (fileDesc = g->filesDescriptions; fileDesc->fileName; fileDesc++) {
 			Common::String fname = fileDesc->fileName;
-			ADFileProperties tmp;
 
-			if (filesProps.contains(fname))
+			if (seen.contains(fname))
 				continue;
+			seen[fname] = true;
 
-			if (getFileProperties(parent, allFiles, *g, fname, tmp)) {
-				debug(3, "> '%s': '%s'", fname.c_str(), tmp.md5.c_str());
-				filesProps[fname] = tmp;
-			}
+			// Files that are not there would only fail to open
+			if (!(g->flags & ADGF_MACRESFORK) && !allFiles.contains(fname))
+				continue;
+
+			FilePropertiesTask::File file;
+			file.resFork = (g->flags & ADGF_MACRESFORK) != 0;
+			file.node = Common::FSNode(Common::String(file.resFork ? parent.getPath().c_str() : allFiles[fname].getPath().c_str()));
+			file.name = fname.c_str();
+			file.found = false;
+			task.files.push_back(file);
+		}
+	}
+
+	// Hashing dominates detection, spread it over all CPUs
+	ThreadPoolMan.parallelFor(FilePropertiesTask::run, &task, task.files.size());
+
+	for (uint f = 0; f < task.files.size(); f++) {
+		const FilePropertiesTask::File &file = task.files[f];
+		if (file.found) {
+			debug(3, "> '%s': '%s'", file.name.c_str(), file.props.md5.c_str());
+			filesProps[file.name] = file.props;
 		}
 	}
 
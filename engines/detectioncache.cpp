@@ -0,0 +1,204 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/detectioncache.h"
+
+#include "common/config-manager.h"
+#include "common/debug.h"
+#include "common/fs.h"
+#include "common/stream.h"
+#include "common/system.h"
+
+namespace Common {
+DECLARE_SINGLETON(DetectionCache);
+}
+
+#define DETECTION_CACHE_FILE "detection.cache"
+#define DETECTION_CACHE_HIDDEN_FILE ".scummvm-detection.cache"
+#define DETECTION_CACHE_MAGIC MKTAG('A','D','M','5')
+#define DETECTION_CACHE_VERSION 1
+
+enum {
+	/** Beyond this many entries, the ones unused in this session are dropped */
+	kMaxEntries = 32768
+};
+
+DetectionCache::DetectionCache() : _loaded(false), _dirty(false), _hits(0), _misses(0) {
+}
+
+Common::String DetectionCache::makeKey(const Common::String &path, uint md5Bytes) {
+	return Common::String::format("%u:", md5Bytes) + path;
+}
+
+Common::FSNode DetectionCache::getFile() {
+	// Next to the configuration file. A hidden configuration file, like
+	// ~/.scummvmrc, usually sits in the home directory, so hide the cache too.
+	const Common::String config = g_system->getDefaultConfigFileName();
+	const char *name = config.c_str();
+	for (const char *c = name; *c; c++) {
+		if (*c == '/' || *c == '\\')
+			name = c + 1;
+	}
+
+	const Common::String dir(config.c_str(), name);
+	return Common::FSNode(dir + (*name == '.' ? DETECTION_CACHE_HIDDEN_FILE : DETECTION_CACHE_FILE));
+}
+
+bool DetectionCache::prepare() {
+	if (ConfMan.hasKey("detection_cache") && !ConfMan.getBool("detection_cache"))
+		return false;
+
+	if (!g_system)
+		return false;
+
+	Common::NativeStackLock lock(_mutex);
+	load();
+	return true;
+}
+
+bool DetectionCache::lookup(const Common::FSNode &node, int32 size, uint md5Bytes, Common::String &md5) {
+	return lookup(node.getPath(), node.getModificationTime(), size, md5Bytes, md5);
+}
+
+bool DetectionCache::lookup(const Common::String &path, uint32 mtime, int32 size, uint md5Bytes, Common::String &md5) {
+	Common::NativeStackLock lock(_mutex);
+
+	EntryMap::iterator i = _entries.find(makeKey(path, md5Bytes));
+	if (mtime == 0 || i == _entries.end() || i->_value.size != size || i->_value.mtime != mtime) {
+		_misses++;
+		return false;
+	}
+
+	// Copied rather than shared, as updating the reference count of a
+	// string is not thread safe
+	i->_value.used = true;
+	md5 = i->_value.md5.c_str();
+	_hits++;
+	return true;
+}
+
+void DetectionCache::store(const Common::FSNode &node, int32 size, uint md5Bytes, const Common::String &md5) {
+	store(node.getPath(), node.getModificationTime(), size, md5Bytes, md5);
+}
+
+void DetectionCache::store(const Common::String &path, uint32 mtime, int32 size, uint md5Bytes, const Common::String &md5) {
+	// Without a modification time there is no way to tell if the file changed
+	if (mtime == 0 || md5.size() != 32)
+		return;
+
+	Common::NativeStackLock lock(_mutex);
+
+	Entry &entry = _entries[makeKey(path, md5Bytes)];
+	entry.size = size;
+	entry.mtime = mtime;
+	entry.md5 = md5.c_str();
+	entry.used = true;
+	_dirty = true;
+}
+
+void DetectionCache::flush() {
+	Common::NativeStackLock lock(_mutex);
+
+	if (_hits || _misses)
+		debug(1, "Detection cache: %u hits, %u misses", _hits, _misses);
+	_hits = _misses = 0;
+
+	if (_dirty) {
+		save();
+		_dirty = false;
+	}
+}
+
+void DetectionCache::load() {
+	if (_loaded)
+		return;
+	_loaded = true;
+
+	Common::FSNode file = getFile();
+	if (!file.exists())
+		return;
+
+	Common::SeekableReadStream *in = file.createReadStream();
+	if (!in)
+		return;
+
+	loadFrom(*in);
+	delete in;
+}
+
+void DetectionCache::loadFrom(Common::SeekableReadStream &in) {
+	if (in.readUint32BE() != DETECTION_CACHE_MAGIC || in.readUint32LE() != DETECTION_CACHE_VERSION)
+		return;
+
+	const uint32 count = in.readUint32LE();
+	for (uint32 i = 0; i < count && !in.eos() && !in.err(); i++) {
+		const uint16 keyLength = in.readUint16LE();
+		Common::String key;
+		for (uint16 j = 0; j < keyLength; j++)
+			key += (char)in.readByte();
+
+		Entry entry;
+		entry.size = in.readSint32LE();
+		entry.mtime = in.readUint32LE();
+		char md5[33];
+		in.read(md5, 32);
+		md5[32] = 0;
+		entry.md5 = md5;
+		entry.used = false;
+
+		if (in.eos() || in.err())
+			break;
+		_entries[key] = entry;
+	}
+}
+
+void DetectionCache::save() {
+	// Entries of files that were not seen for a while are the first to go
+	if (_entries.size() > kMaxEntries) {
+		for (EntryMap::iterator i = _entries.begin(); i != _entries.end(); ++i) {
+			if (!i->_value.used)
+				_entries.erase(i);
+		}
+	}
+
+	Common::WriteStream *out = getFile().createWriteStream();
+	if (!out || !saveTo(*out))
+		warning("Could not write the detection cache");
+	delete out;
+}
+
+bool DetectionCache::saveTo(Common::WriteStream &out) {
+	out.writeUint32BE(DETECTION_CACHE_MAGIC);
+	out.writeUint32LE(DETECTION_CACHE_VERSION);
+	out.writeUint32LE(_entries.size());
+
+	for (EntryMap::const_iterator i = _entries.begin(); i != _entries.end(); ++i) {
+		out.writeUint16LE(i->_key.size());
+		out.writeString(i->_key);
+		out.writeSint32LE(i->_value.size);
+		out.writeUint32LE(i->_value.mtime);
+		out.write(i->_value.md5.c_str(), 32);
+	}
+
+	out.finalize();
+	return !out.err();
+}
@@ -0,0 +1,123 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef ENGINES_DETECTIONCACHE_H
+#define ENGINES_DETECTIONCACHE_H
+
+#include "common/hashmap.h"
+#include "common/singleton.h"
+#include "common/str.h"
+#include "common/hash-str.h"
+#include "common/threadpool.h"
+
+namespace Common {
+class FSNode;
+class SeekableReadStream;
+class WriteStream;
+}
+
+/**
+ * Persistent cache of the MD5 sums computed by the advanced detector.
+ *
+ * Entries are keyed by the full path of a file and the number of bytes that
+ * were hashed. An entry is only used while the size and modification time of
+ * the file are unchanged, so files without a known modification time are
+ * never cached. Only the POSIX and Windows file system nodes report one.
+ *
+ * The cache is stored next to the configuration file rather than as a save
+ * file, as the save path may point to a game specific directory while an
+ * engine is created. It is written back by flush().
+ *
+ * prepare() has to be called on the main thread first. After that, lookup()
+ * and store() may be called from the threads of the ThreadPool.
+ */
+class DetectionCache : public Common::Singleton<DetectionCache> {
+public:
+	DetectionCache();
+
+	/**
+	 * Load the cache for a detection pass. This reads the configuration and
+	 * the cache file, so it has to be called on the main thread.
+	 *
+	 * @return false if the cache is disabled and should not be used
+	 */
+	bool prepare();
+
+	/**
+	 * Look up the MD5 of the first md5Bytes bytes of a file.
+	 *
+	 * @return true and set md5 if a valid entry was found
+	 */
+	bool lookup(const Common::FSNode &node, int32 size, uint md5Bytes, Common::String &md5);
+	bool lookup(const Common::String &path, uint32 mtime, int32 size, uint md5Bytes, Common::String &md5);
+
+	/** Record the MD5 of the first md5Bytes bytes of a file. */
+	void store(const Common::FSNode &node, int32 size, uint md5Bytes, const Common::String &md5);
+	void store(const Common::String &path, uint32 mtime, int32 size, uint md5Bytes, const Common::String &md5);
+
+	/**
+	 * Write the cache back if anything changed, and print the hit and miss
+	 * counts since the previous flush at debug level 1.
+	 */
+	void flush();
+
+	/** Add the entries of a stream written by saveTo(). */
+	void loadFrom(Common::SeekableReadStream &in);
+
+	/**
+	 * Write all entries to a stream.
+	 *
+	 * @return false if writing failed
+	 */
+	bool saveTo(Common::WriteStream &out);
+
+	uint getHits() const { return _hits; }
+	uint getMisses() const { return _misses; }
+
+private:
+	struct Entry {
+		int32 size;
+		uint32 mtime;
+		Common::String md5;
+		/** Whether the entry was looked up or stored since it was loaded */
+		bool used;
+	};
+
+	typedef Common::HashMap<Common::String, Entry> EntryMap;
+
+	static Common::String makeKey(const Common::String &path, uint md5Bytes);
+	static Common::FSNode getFile();
+	void load();
+	void save();
+
+	Common::NativeMutex _mutex;
+	EntryMap _entries;
+	bool _loaded;
+	bool _dirty;
+	uint _hits;
+	uint _misses;
+};
+
+/** Shortcut for accessing the detection cache. */
+#define DetectionCacheMan DetectionCache::instance()
+
+#endif
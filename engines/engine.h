@@ -41,6 +41,8 @@ class EventManager;
 class SaveFileManager;
 class TimerManager;
 class FSNode;
+class SeekableReadStream;
+class WriteStream;
 }
 namespace GUI {
 class Debugger;
@@ -131,7 +133,14 @@ public:
 		 * If this feature is supported, then the corresponding MetaEngine *must*
 		 * support the kSupportsListSaves feature.
 		 */
-		kSupportsSavingDuringRuntime
+		kSupportsSavingDuringRuntime,
+
+		/**
+		 * Saving and loading the game state through streams is supported,
+		 * that is, this engine implements saveGameStream() and
+		 * loadGameStream(). Backends use this to keep states in memory.
+		 */
+		kSupportsSavingToStream
 	};
 
 
@@ -245,6 +254,26 @@ public:
 	 */
 	virtual bool canSaveGameStateCurrently();
 
+	/**
+	 * Save the game state into a stream. Unlike saveGameState(), which
+	 * engines may carry out later from their main loop, the state has been
+	 * written completely when this returns.
+	 * @param stream	the stream to write the state to
+	 * @return returns kNoError on success, kUnsupportedFeature if the engine
+	 *         does not support kSupportsSavingToStream, else an error code.
+	 */
+	virtual Common::Error saveGameStream(Common::WriteStream *stream);
+
+	/**
+	 * Load a game state written by saveGameStream(). Like loadGameState(),
+	 * the engine may load the state later from its main loop, so the stream
+	 * has to stay valid until then. It is not deleted by the engine.
+	 * @param stream	the stream to read the state from
+	 * @return returns kNoError on success, kUnsupportedFeature if the engine
+	 *         does not support kSupportsSavingToStream, else an error code.
+	 */
+	virtual Common::Error loadGameStream(Common::SeekableReadStream *stream);
+
 protected:
 
 	/**
@@ -71,7 +71,8 @@ bool g_debug_track_mouse_clicks = false;
 static int parse_reg_t(EngineState *s, const char *str, reg_t *dest, bool mayBeValue);
 
 Console::Console(SciEngine *engine) : GUI::Debugger(),
-	_engine(engine), _debugState(engine->_debugState) {
+	_engine(engine), _debugState(engine->_debugState),
+	_scriptSteps(0), _scriptStepsPlayTime(0) {
 
 	assert(_engine);
 	assert(_engine->_gamestate);
@@ -110,6 +111,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("resource_id",		WRAP_METHOD(Console, cmdResourceId));
 	registerCmd("resource_info",		WRAP_METHOD(Console, cmdResourceInfo));
 	registerCmd("resource_types",		WRAP_METHOD(Console, cmdResourceTypes));
+	registerCmd("resource_cache",		WRAP_METHOD(Console, cmdResourceCache));
 	registerCmd("list",				WRAP_METHOD(Console, cmdList));
 	registerCmd("hexgrep",			WRAP_METHOD(Console, cmdHexgrep));
 	registerCmd("verify_scripts",		WRAP_METHOD(Console, cmdVerifyScripts));
@@ -212,6 +214,7 @@ Console::Console(SciEngine *engine) : GUI::Debugger(),
 	registerCmd("bpe",				WRAP_METHOD(Console, cmdBreakpointFunction));		// alias
 	// VM
 	registerCmd("script_steps",		WRAP_METHOD(Console, cmdScriptSteps));
+	registerCmd("selector_cache",		WRAP_METHOD(Console, cmdSelectorCache));
 	registerCmd("script_objects",   WRAP_METHOD(Console, cmdScriptObjects));
 	registerCmd("scro",             WRAP_METHOD(Console, cmdScriptObjects));
 	registerCmd("script_strings",   WRAP_METHOD(Console, cmdScriptStrings));
@@ -358,6 +361,7 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf(" resource_id - Identifies a resource number by splitting it up in resource type and resource number\n");
 	debugPrintf(" resource_info - Shows info about a resource\n");
 	debugPrintf(" resource_types - Shows the valid resource types\n");
+	debugPrintf(" resource_cache - Shows statistics of the resource cache, or changes its size\n");
 	debugPrintf(" list - Lists all the resources of a given type\n");
 	debugPrintf(" hexgrep - Searches some resources for a particular sequence of bytes, represented as hexadecimal numbers\n");
 	debugPrintf(" verify_scripts - Performs sanity checks on SCI1.1-SCI2.1 game scripts (e.g. if they're up to 64KB in total)\n");
@@ -439,7 +443,8 @@ bool Console::cmdHelp(int argc, const char **argv) {
 	debugPrintf(" bp_function / bpe - Sets a breakpoint on the execution of the specified exported function\n");
 	debugPrintf("\n");
 	debugPrintf("VM:\n");
-	debugPrintf(" script_steps - Shows the number of executed SCI operations\n");
+	debugPrintf(" script_steps - Shows the number of executed SCI operations, and their rate since the last call\n");
+	debugPrintf(" selector_cache - Shows how many selector lookups were cached\n");
 	debugPrintf(" vm_varlist / vmvarlist / vl - Shows the addresses of variables in the VM\n");
 	debugPrintf(" vm_vars / vmvars / vv - Displays or changes variables in the VM\n");
 	debugPrintf(" stack - Lists the specified number of stack elements\n");
@@ -967,6 +972,50 @@ bool Console::cmdResourceTypes(int argc, const char **argv) {
 	return true;
 }
 
+bool Console::cmdResourceCache(int argc, const char **argv) {
+	ResourceManager *resMan = _engine->getResMan();
+	ResourceCacheStats &stats = resMan->getCacheStats();
+
+	if (argc > 2) {
+		debugPrintf("Shows statistics of the resource cache, or changes its size.\n");
+		debugPrintf("Usage: %s [<size in KiB> | reset]\n", argv[0]);
+		debugPrintf("Specify 'reset' to start counting anew\n");
+		return true;
+	}
+
+	if (argc == 2) {
+		if (!strcmp(argv[1], "reset")) {
+			stats.reset();
+		} else {
+			int size;
+			if (!parseInteger(argv[1], size) || size < 0) {
+				debugPrintf("Invalid size %s\n", argv[1]);
+				return true;
+			}
+			resMan->setMaxMemoryLRU(size * 1024);
+		}
+	}
+
+	debugPrintf("Cache size: %d KiB, used: %d KiB, locked resources: %d KiB\n",
+		resMan->getMaxMemoryLRU() / 1024, resMan->getMemoryLRU() / 1024, resMan->getMemoryLocked() / 1024);
+
+	const uint32 requests = stats.hits + stats.misses;
+	debugPrintf("Requests: %u, hits: %u, misses: %u", requests, stats.hits, stats.misses);
+	if (requests)
+		debugPrintf(", hit rate: %u%%", (uint32)((uint64)stats.hits * 100 / requests));
+	debugPrintf("\n");
+
+	debugPrintf("Time spent loading: %u ms", stats.loadTime);
+	if (stats.misses)
+		debugPrintf(", %u ms per miss", stats.loadTime / stats.misses);
+	debugPrintf("\n");
+
+	debugPrintf("Loaded in the background: %u, waited for: %u, freed: %u\n",
+		stats.prefetched, stats.waits, stats.evictions);
+
+	return true;
+}
+
 bool Console::cmdHexgrep(int argc, const char **argv) {
 	if (argc < 4) {
 		debugPrintf("Searches some resources for a particular sequence of bytes, represented as decimal or hexadecimal numbers.\n");
@@ -2905,7 +2954,58 @@ bool Console::cmdViewAccumulatorObject(int argc, const char **argv) {
 }
 
 bool Console::cmdScriptSteps(int argc, const char **argv) {
+	const uint32 steps = _engine->_gamestate->scriptStepCounter;
+	const uint32 playTime = _engine->getTotalPlayTime();
+
 	debugPrintf("Number of executed SCI operations: %d\n", _engine->_gamestate->scriptStepCounter);
+
+	// Play time doesn't include the time spent in the debugger, and goes back
+	// when restoring
+	if (playTime > _scriptStepsPlayTime) {
+		const uint32 elapsed = playTime - _scriptStepsPlayTime;
+		debugPrintf("%u operations in the last %u ms of play time, %u per second\n",
+			steps - _scriptSteps, elapsed, (uint32)((uint64)(steps - _scriptSteps) * 1000 / elapsed));
+	}
+	_scriptSteps = steps;
+	_scriptStepsPlayTime = playTime;
+
+	uint decodedScripts = 0, decodedInstructions = 0;
+	SegManager *segMan = _engine->_gamestate->_segMan;
+	for (uint i = 0; i < segMan->_heap.size(); i++) {
+		if (segMan->_heap[i] && segMan->_heap[i]->getType() == SEG_TYPE_SCRIPT) {
+			const Script *scr = (const Script *)segMan->_heap[i];
+			if (scr->getDecodedInstructionCount()) {
+				decodedScripts++;
+				decodedInstructions += scr->getDecodedInstructionCount();
+			}
+		}
+	}
+	debugPrintf("Decoded instructions: %u in %u scripts\n", decodedInstructions, decodedScripts);
+
+	return true;
+}
+
+bool Console::cmdSelectorCache(int argc, const char **argv) {
+	if (argc > 2 || (argc == 2 && strcmp(argv[1], "reset"))) {
+		debugPrintf("Shows how many selector lookups were answered by the cache.\n");
+		debugPrintf("Usage: %s [reset]\n", argv[0]);
+		debugPrintf("Specify 'reset' to start counting anew\n");
+		return true;
+	}
+
+	SegManager *segMan = _engine->_gamestate->_segMan;
+	const uint32 lookups = segMan->_selectorCacheHits + segMan->_selectorCacheMisses;
+
+	debugPrintf("Selector lookups: %u, cache hits: %u, misses: %u\n", lookups,
+		segMan->_selectorCacheHits, segMan->_selectorCacheMisses);
+	if (lookups)
+		debugPrintf("Hit rate: %u%%\n", (uint32)((uint64)segMan->_selectorCacheHits * 100 / lookups));
+
+	if (argc == 2) {
+		segMan->_selectorCacheHits = 0;
+		segMan->_selectorCacheMisses = 0;
+	}
+
 	return true;
 }
 
@@ -88,6 +88,24 @@ const Object *Object::getClass(SegManager *segMan) const {
 	return isClass() ? this : segMan->getObject(getSuperClassSelector());
 }
 
+const SelectorCacheEntry *Object::getCachedSelector(Selector selector, uint32 generation) const {
+	if (_selectorCacheGeneration != generation)
+		return NULL;
+
+	const SelectorCacheEntry &entry = _selectorCache[selector & (kSelectorCacheSize - 1)];
+	return entry.selector == selector ? &entry : NULL;
+}
+
+void Object::cacheSelector(const SelectorCacheEntry &entry, uint32 generation) {
+	if (_selectorCacheGeneration != generation) {
+		for (uint i = 0; i < kSelectorCacheSize; i++)
+			_selectorCache[i].selector = 0xFFFF;
+		_selectorCacheGeneration = generation;
+	}
+
+	_selectorCache[entry.selector & (kSelectorCacheSize - 1)] = entry;
+}
+
 int Object::locateVarSelector(SegManager *segMan, Selector slc) const {
 	const byte *buf = 0;
 	uint varnum = 0;
@@ -69,6 +69,16 @@ enum ObjectOffsets {
 	kOffsetNamePointerSci11 = 16
 };
 
+/**
+ * A result of lookupSelector(), cached by the object it was looked up on.
+ */
+struct SelectorCacheEntry {
+	uint16 selector;
+	byte type;        // SelectorType of the selector
+	uint16 varIndex;  // for variable selectors
+	reg_t func;       // for method selectors
+};
+
 class Object {
 public:
 	Object() {
@@ -78,6 +88,7 @@ public:
 		_baseVars = 0;
 		_methodCount = 0;
 		_propertyOffsetsSci3 = 0;
+		_selectorCacheGeneration = 0;
 	}
 
 	~Object() {
@@ -228,6 +239,22 @@ public:
 	 */
 	int locateVarSelector(SegManager *segMan, Selector slc) const;
 
+	/**
+	 * Returns the cached result of looking up a selector on this object.
+	 * Cached results are only valid while the selector cache generation of
+	 * the segment manager doesn't change.
+	 * @param selector		the selector to look up
+	 * @param generation	the current selector cache generation
+	 * @return the cached result, or NULL if there is none
+	 */
+	const SelectorCacheEntry *getCachedSelector(Selector selector, uint32 generation) const;
+
+	/**
+	 * Caches the result of looking up a selector on this object, replacing
+	 * a result cached for another selector if necessary.
+	 */
+	void cacheSelector(const SelectorCacheEntry &entry, uint32 generation);
+
 	bool isClass() const { return (getInfoSelector().getOffset() & kInfoFlagClass); }
 	const Object *getClass(SegManager *segMan) const;
 
@@ -281,6 +308,12 @@ private:
 	reg_t _speciesSelectorSci3;	/**< reg_t containing species "selector" for SCI3 */
 	reg_t _infoSelectorSci3; /**< reg_t containing info "selector" for SCI3 */
 	Common::Array<bool> _mustSetViewVisible; /** cached bit of info to make lookup fast, SCI3 only */
+
+	enum {
+		kSelectorCacheSize = 8 /**< Number of selectors cached, must be a power of two */
+	};
+	SelectorCacheEntry _selectorCache[kSelectorCacheSize]; /**< Recent lookups, indexed by selector */
+	uint32 _selectorCacheGeneration; /**< Generation the cache is valid for, 0 if it's empty */
 };
 
 
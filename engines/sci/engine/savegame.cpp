@@ -448,6 +448,9 @@ void Object::saveLoadWithSerializer(Common::Serializer &s) {
 	s.syncAsSint32LE(_methodCount);		// that's actually a uint16
 
 	syncArray<reg_t>(s, _variables);
+
+	if (s.isLoading())
+		_selectorCacheGeneration = 0;
 }
 
 
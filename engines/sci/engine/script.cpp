@@ -28,6 +28,7 @@
 #include "sci/engine/state.h"
 #include "sci/engine/kernel.h"
 #include "sci/engine/script.h"
+#include "sci/engine/vm.h"
 
 #include "common/util.h"
 
@@ -70,6 +71,9 @@ void Script::freeScript() {
 	_offsetLookupObjectCount = 0;
 	_offsetLookupStringCount = 0;
 	_offsetLookupSaidCount = 0;
+
+	_decodedIndex.clear();
+	_decodedInstructions.clear();
 }
 
 void Script::load(int script_nr, ResourceManager *resMan, ScriptPatcher *scriptPatcher) {
@@ -1173,4 +1177,28 @@ bool Script::offsetIsObject(uint16 offset) const {
 	return (READ_SCI11ENDIAN_UINT16((const byte *)_buf + offset + SCRIPT_OBJECT_MAGIC_OFFSET) == SCRIPT_OBJECT_MAGIC_NUMBER);
 }
 
+const DecodedInstruction &Script::getDecodedInstruction(uint32 offset) {
+	assert(offset < _bufSize);
+
+	if (_decodedIndex.empty())
+		_decodedIndex.resize(_bufSize);
+
+	const uint16 index = _decodedIndex[offset];
+	if (index)
+		return _decodedInstructions[index - 1];
+
+	DecodedInstruction instruction;
+	instruction.size = readPMachineInstruction(_buf + offset, instruction.extOpcode, instruction.opparams);
+
+	// Scripts are far smaller than this, but don't rely on it
+	if (_decodedInstructions.size() >= 0xFFFF) {
+		_undecodedInstruction = instruction;
+		return _undecodedInstruction;
+	}
+
+	_decodedInstructions.push_back(instruction);
+	_decodedIndex[offset] = _decodedInstructions.size();
+	return _decodedInstructions.back();
+}
+
 } // End of namespace Sci
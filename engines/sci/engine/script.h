@@ -64,6 +64,15 @@ struct offsetLookupArrayEntry {
 
 typedef Common::Array<offsetLookupArrayEntry> offsetLookupArrayType;
 
+/**
+ * A bytecode instruction, as decoded by readPMachineInstruction().
+ */
+struct DecodedInstruction {
+	byte extOpcode;     // opcode, the lower bit selects byte sized operands
+	uint16 size;        // size of the instruction in bytes
+	int16 opparams[4];  // operands, sign or zero extended
+};
+
 class Script : public SegmentObj {
 private:
 	int _nr; /**< Script number */
@@ -98,6 +107,15 @@ private:
 	uint16 _offsetLookupStringCount;
 	uint16 _offsetLookupSaidCount;
 
+	/**
+	 * For every offset of the buffer, the index + 1 of the instruction
+	 * starting there in _decodedInstructions, or 0 if it wasn't decoded yet.
+	 * Allocated when the first instruction gets decoded.
+	 */
+	Common::Array<uint16> _decodedIndex;
+	Common::Array<DecodedInstruction> _decodedInstructions;
+	DecodedInstruction _undecodedInstruction; /**< Used once the index is full */
+
 public:
 	int getLocalsOffset() const { return _localsOffset; }
 	uint16 getLocalsCount() const { return _localsCount; }
@@ -115,6 +133,20 @@ public:
 	const ObjMap &getObjectMap() const { return _objects; }
 	bool offsetIsObject(uint16 offset) const;
 
+	/**
+	 * Returns the instruction at the specified offset. Instructions are
+	 * decoded on their first use only, so that the VM doesn't have to decode
+	 * the operands again every time it executes them.
+	 * The returned reference is only valid until the next call.
+	 * @param offset	offset of the instruction within the buffer
+	 */
+	const DecodedInstruction &getDecodedInstruction(uint32 offset);
+
+	/**
+	 * Returns the number of instructions decoded so far.
+	 */
+	uint getDecodedInstructionCount() const { return _decodedInstructions.size(); }
+
 public:
 	Script();
 	~Script();
@@ -46,6 +46,11 @@ SegManager::SegManager(ResourceManager *resMan, ScriptPatcher *scriptPatcher)
 	_bitmapSegId = 0;
 #endif
 
+	// Objects start out with an empty cache of generation 0
+	_selectorCacheGeneration = 1;
+	_selectorCacheHits = 0;
+	_selectorCacheMisses = 0;
+
 	createClassTable();
 }
 
@@ -178,6 +183,8 @@ void SegManager::deallocate(SegmentId seg) {
 			if (_heap[scr->getLocalsSegment()])
 				deallocate(scr->getLocalsSegment());
 		}
+
+		invalidateSelectorCache();
 	}
 
 	delete mobj;
@@ -1056,6 +1063,8 @@ int SegManager::instantiateScript(int scriptNum) {
 	scr->initializeClasses(this);
 	scr->initializeObjects(this, segmentId);
 
+	invalidateSelectorCache();
+
 	return segmentId;
 }
 
@@ -1079,6 +1088,8 @@ void SegManager::uninstantiateScript(int script_nr) {
 		if (getClass(i).reg.getSegment() == segmentId)
 			setClassOffset(i, NULL_REG);
 
+	invalidateSelectorCache();
+
 	if (getSciVersion() < SCI_VERSION_1_1)
 		uninstantiateScriptSci0(script_nr);
 	// FIXME: Add proper script uninstantiation for SCI 1.1
@@ -449,6 +449,18 @@ public:
 
 	const Common::Array<SegmentObj *> &getSegments() const { return _heap; }
 
+	/**
+	 * Drops the selector lookups cached by all objects. Needed whenever
+	 * scripts are loaded or unloaded, as that changes the objects and the
+	 * class hierarchy that lookups depend on.
+	 */
+	void invalidateSelectorCache() { _selectorCacheGeneration++; }
+	uint32 getSelectorCacheGeneration() const { return _selectorCacheGeneration; }
+
+	// Statistics of lookupSelector(), shown by the debugger
+	uint32 _selectorCacheHits;
+	uint32 _selectorCacheMisses;
+
 private:
 	Common::Array<SegmentObj *> _heap;
 	Common::Array<Class> _classTable; /**< Table of all classes */
@@ -463,6 +475,8 @@ private:
 	SegmentId _nodesSegId; ///< ID of the (a) node segment
 	SegmentId _hunksSegId; ///< ID of the (a) hunk segment
 
+	uint32 _selectorCacheGeneration; ///< Changes whenever cached selector lookups become invalid
+
 	// Statically allocated memory for system strings
 	reg_t _saveDirPtr;
 	reg_t _parserPtr;
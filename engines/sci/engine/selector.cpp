@@ -278,7 +278,7 @@ void invokeSelector(EngineState *s, reg_t object, int selectorId,
 }
 
 SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector selectorId, ObjVarRef *varp, reg_t *fptr) {
-	const Object *obj = segMan->getObject(obj_location);
+	Object *obj = segMan->getObject(obj_location);
 	int index;
 	bool oldScriptHeader = (getSciVersion() == SCI_VERSION_0_EARLY);
 
@@ -292,34 +292,57 @@ SelectorType lookupSelector(SegManager *segMan, reg_t obj_location, Selector sel
 				PRINT_REG(obj_location));
 	}
 
-	index = obj->locateVarSelector(segMan, selectorId);
+	// Objects remember their recent lookups, as searching the selector
+	// tables up the class hierarchy is slow
+	const uint32 generation = segMan->getSelectorCacheGeneration();
+	const SelectorCacheEntry *cached = obj->getCachedSelector(selectorId, generation);
+	SelectorCacheEntry entry;
 
-	if (index >= 0) {
-		// Found it as a variable
-		if (varp) {
-			varp->obj = obj_location;
-			varp->varindex = index;
-		}
-		return kSelectorVariable;
+	if (cached) {
+		segMan->_selectorCacheHits++;
+		entry = *cached;
 	} else {
-		// Check if it's a method, with recursive lookup in superclasses
-		while (obj) {
-			index = obj->funcSelectorPosition(selectorId);
-			if (index >= 0) {
-				if (fptr)
-					*fptr = obj->getFunction(index);
-
-				return kSelectorMethod;
-			} else {
-				obj = segMan->getObject(obj->getSuperClassSelector());
+		segMan->_selectorCacheMisses++;
+		entry.selector = selectorId;
+		entry.type = kSelectorNone;
+		entry.varIndex = 0;
+		entry.func = NULL_REG;
+
+		index = obj->locateVarSelector(segMan, selectorId);
+
+		if (index >= 0) {
+			// Found it as a variable
+			entry.type = kSelectorVariable;
+			entry.varIndex = index;
+		} else {
+			// Check if it's a method, with recursive lookup in superclasses
+			const Object *cls = obj;
+			while (cls) {
+				index = cls->funcSelectorPosition(selectorId);
+				if (index >= 0) {
+					entry.type = kSelectorMethod;
+					entry.func = cls->getFunction(index);
+					break;
+				} else {
+					cls = segMan->getObject(cls->getSuperClassSelector());
+				}
 			}
 		}
 
-		return kSelectorNone;
+		obj->cacheSelector(entry, generation);
 	}
 
+	if (entry.type == kSelectorVariable) {
+		if (varp) {
+			varp->obj = obj_location;
+			varp->varindex = entry.varIndex;
+		}
+	} else if (entry.type == kSelectorMethod) {
+		if (fptr)
+			*fptr = entry.func;
+	}
 
-//	return _lookupSelector_function(segMan, obj, selectorId, fptr);
+	return (SelectorType)entry.type;
 }
 
 } // End of namespace Sci
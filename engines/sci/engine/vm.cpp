@@ -564,6 +564,17 @@ int readPMachineInstruction(const byte *src, byte &extOpcode, int16 opparams[4])
 	return offset;
 }
 
+// With GCC and compatible compilers, run_vm() jumps to the code of an opcode
+// through a table of label addresses, rather than through the switch and its
+// range check. Every case label doubles as such a label, so that both ways
+// share the code of the opcodes. Other compilers just use the switch.
+#if defined(__GNUC__)
+#define SCI_VM_COMPUTED_GOTO
+#define OPCODE(op) case op: label_##op
+#else
+#define OPCODE(op) case op
+#endif
+
 void run_vm(EngineState *s) {
 	assert(s);
 
@@ -592,6 +603,44 @@ void run_vm(EngineState *s) {
 
 	s->_executionStackPosChanged = true; // Force initialization
 
+#ifdef SCI_VM_COMPUTED_GOTO
+	// Indexed by opcode
+	__extension__ static const void *const dispatchTable[128] = {
+		&&label_op_bnot, &&label_op_add, &&label_op_sub, &&label_op_mul,
+		&&label_op_div, &&label_op_mod, &&label_op_shr, &&label_op_shl,
+		&&label_op_xor, &&label_op_and, &&label_op_or, &&label_op_neg,
+		&&label_op_not, &&label_op_eq_, &&label_op_ne_, &&label_op_gt_,
+		&&label_op_ge_, &&label_op_lt_, &&label_op_le_, &&label_op_ugt_,
+		&&label_op_uge_, &&label_op_ult_, &&label_op_ule_, &&label_op_bt,
+		&&label_op_bnt, &&label_op_jmp, &&label_op_ldi, &&label_op_push,
+		&&label_op_pushi, &&label_op_toss, &&label_op_dup, &&label_op_link,
+		&&label_op_call, &&label_op_callk, &&label_op_callb, &&label_op_calle,
+		&&label_op_ret, &&label_op_send, &&label_op_infoToa, &&label_op_superToa,
+		&&label_op_class, &&label_0x29, &&label_op_self, &&label_op_super,
+		&&label_op_rest, &&label_op_lea, &&label_op_selfID, &&label_0x2f,
+		&&label_op_pprev, &&label_op_pToa, &&label_op_aTop, &&label_op_pTos,
+		&&label_op_sTop, &&label_op_ipToa, &&label_op_dpToa, &&label_op_ipTos,
+		&&label_op_dpTos, &&label_op_lofsa, &&label_op_lofss, &&label_op_push0,
+		&&label_op_push1, &&label_op_push2, &&label_op_pushSelf, &&label_op_line,
+		&&label_op_lag, &&label_op_lal, &&label_op_lat, &&label_op_lap,
+		&&label_op_lsg, &&label_op_lsl, &&label_op_lst, &&label_op_lsp,
+		&&label_op_lagi, &&label_op_lali, &&label_op_lati, &&label_op_lapi,
+		&&label_op_lsgi, &&label_op_lsli, &&label_op_lsti, &&label_op_lspi,
+		&&label_op_sag, &&label_op_sal, &&label_op_sat, &&label_op_sap,
+		&&label_op_ssg, &&label_op_ssl, &&label_op_sst, &&label_op_ssp,
+		&&label_op_sagi, &&label_op_sali, &&label_op_sati, &&label_op_sapi,
+		&&label_op_ssgi, &&label_op_ssli, &&label_op_ssti, &&label_op_sspi,
+		&&label_op_plusag, &&label_op_plusal, &&label_op_plusat, &&label_op_plusap,
+		&&label_op_plussg, &&label_op_plussl, &&label_op_plusst, &&label_op_plussp,
+		&&label_op_plusagi, &&label_op_plusali, &&label_op_plusati, &&label_op_plusapi,
+		&&label_op_plussgi, &&label_op_plussli, &&label_op_plussti, &&label_op_plusspi,
+		&&label_op_minusag, &&label_op_minusal, &&label_op_minusat, &&label_op_minusap,
+		&&label_op_minussg, &&label_op_minussl, &&label_op_minusst, &&label_op_minussp,
+		&&label_op_minusagi, &&label_op_minusali, &&label_op_minusati, &&label_op_minusapi,
+		&&label_op_minussgi, &&label_op_minussli, &&label_op_minussti, &&label_op_minusspi
+	};
+#endif
+
 #ifdef ABORT_ON_INFINITE_LOOP
 	byte prevOpcode = 0xFF;
 #endif
@@ -650,9 +699,12 @@ void run_vm(EngineState *s) {
 			error("run_vm(): program counter gone astray, addr: %d, code buffer size: %d",
 			s->xs->addr.pc.getOffset(), scr->getBufSize());
 
-		// Get opcode
-		byte extOpcode;
-		s->xs->addr.pc.incOffset(readPMachineInstruction(scr->getBuf(s->xs->addr.pc.getOffset()), extOpcode, opparams));
+		// Get opcode. The script decodes each instruction only once. Copy the
+		// operands, as kernel calls may run the VM recursively, decoding more.
+		const DecodedInstruction &instruction = scr->getDecodedInstruction(s->xs->addr.pc.getOffset());
+		const byte extOpcode = instruction.extOpcode;
+		memcpy(opparams, instruction.opparams, sizeof(opparams));
+		s->xs->addr.pc.incOffset(instruction.size);
 		const byte opcode = extOpcode >> 1;
 		//debug("%s: %d, %d, %d, %d, acc = %04x:%04x, script %d, local script %d", opcodeNames[opcode], opparams[0], opparams[1], opparams[2], opparams[3], PRINT_REG(s->r_acc), scr->getScriptNumber(), local_script->getScriptNumber());
 
@@ -671,121 +723,124 @@ void run_vm(EngineState *s) {
 		prevOpcode = opcode;
 #endif
 
+#ifdef SCI_VM_COMPUTED_GOTO
+		__extension__ ({ goto *dispatchTable[opcode]; });
+#endif
 		switch (opcode) {
 
-		case op_bnot: // 0x00 (00)
+		OPCODE(op_bnot): // 0x00 (00)
 			// Binary not
 			s->r_acc = make_reg(0, 0xffff ^ s->r_acc.requireUint16());
 			break;
 
-		case op_add: // 0x01 (01)
+		OPCODE(op_add): // 0x01 (01)
 			s->r_acc = POP32() + s->r_acc;
 			break;
 
-		case op_sub: // 0x02 (02)
+		OPCODE(op_sub): // 0x02 (02)
 			s->r_acc = POP32() - s->r_acc;
 			break;
 
-		case op_mul: // 0x03 (03)
+		OPCODE(op_mul): // 0x03 (03)
 			s->r_acc = POP32() * s->r_acc;
 			break;
 
-		case op_div: // 0x04 (04)
+		OPCODE(op_div): // 0x04 (04)
 			// we check for division by 0 inside the custom reg_t division operator
 			s->r_acc = POP32() / s->r_acc;
 			break;
 
-		case op_mod: // 0x05 (05)
+		OPCODE(op_mod): // 0x05 (05)
 			// we check for division by 0 inside the custom reg_t modulo operator
 			s->r_acc = POP32() % s->r_acc;
 			break;
 
-		case op_shr: // 0x06 (06)
+		OPCODE(op_shr): // 0x06 (06)
 			// Shift right logical
 			s->r_acc = POP32() >> s->r_acc;
 			break;
 
-		case op_shl: // 0x07 (07)
+		OPCODE(op_shl): // 0x07 (07)
 			// Shift left logical
 			s->r_acc = POP32() << s->r_acc;
 			break;
 
-		case op_xor: // 0x08 (08)
+		OPCODE(op_xor): // 0x08 (08)
 			s->r_acc = POP32() ^ s->r_acc;
 			break;
 
-		case op_and: // 0x09 (09)
+		OPCODE(op_and): // 0x09 (09)
 			s->r_acc = POP32() & s->r_acc;
 			break;
 
-		case op_or: // 0x0a (10)
+		OPCODE(op_or): // 0x0a (10)
 			s->r_acc = POP32() | s->r_acc;
 			break;
 
-		case op_neg:	// 0x0b (11)
+		OPCODE(op_neg):	// 0x0b (11)
 			s->r_acc = make_reg(0, -s->r_acc.requireSint16());
 			break;
 
-		case op_not: // 0x0c (12)
+		OPCODE(op_not): // 0x0c (12)
 			s->r_acc = make_reg(0, !(s->r_acc.getOffset() || s->r_acc.getSegment()));
 			// Must allow pointers to be negated, as this is used for checking whether objects exist
 			break;
 
-		case op_eq_: // 0x0d (13)
+		OPCODE(op_eq_): // 0x0d (13)
 			s->r_prev = s->r_acc;
 			s->r_acc  = make_reg(0, POP32() == s->r_acc);
 			break;
 
-		case op_ne_: // 0x0e (14)
+		OPCODE(op_ne_): // 0x0e (14)
 			s->r_prev = s->r_acc;
 			s->r_acc  = make_reg(0, POP32() != s->r_acc);
 			break;
 
-		case op_gt_: // 0x0f (15)
+		OPCODE(op_gt_): // 0x0f (15)
 			s->r_prev = s->r_acc;
 			s->r_acc  = make_reg(0, POP32() > s->r_acc);
 			break;
 
-		case op_ge_: // 0x10 (16)
+		OPCODE(op_ge_): // 0x10 (16)
 			s->r_prev = s->r_acc;
 			s->r_acc  = make_reg(0, POP32() >= s->r_acc);
 			break;
 
-		case op_lt_: // 0x11 (17)
+		OPCODE(op_lt_): // 0x11 (17)
 			s->r_prev = s->r_acc;
 			s->r_acc  = make_reg(0, POP32() < s->r_acc);
 			break;
 
-		case op_le_: // 0x12 (18)
+		OPCODE(op_le_): // 0x12 (18)
 			s->r_prev = s->r_acc;
 			s->r_acc  = make_reg(0, POP32() <= s->r_acc);
 			break;
 
-		case op_ugt_: // 0x13 (19)
+		OPCODE(op_ugt_): // 0x13 (19)
 			// > (unsigned)
 			s->r_prev = s->r_acc;
 			s->r_acc  = make_reg(0, POP32().gtU(s->r_acc));
 			break;
 
-		case op_uge_: // 0x14 (20)
+		OPCODE(op_uge_): // 0x14 (20)
 			// >= (unsigned)
 			s->r_prev = s->r_acc;
 			s->r_acc  = make_reg(0, POP32().geU(s->r_acc));
 			break;
 
-		case op_ult_: // 0x15 (21)
+		OPCODE(op_ult_): // 0x15 (21)
 			// < (unsigned)
 			s->r_prev = s->r_acc;
 			s->r_acc  = make_reg(0, POP32().ltU(s->r_acc));
 			break;
 
-		case op_ule_: // 0x16 (22)
+		OPCODE(op_ule_): // 0x16 (22)
 			// <= (unsigned)
 			s->r_prev = s->r_acc;
 			s->r_acc  = make_reg(0, POP32().leU(s->r_acc));
 			break;
 
-		case op_bt: // 0x17 (23)
+		OPCODE(op_bt): // 0x17 (23)
 			// Branch relative if true
 			if (s->r_acc.getOffset() || s->r_acc.getSegment())
 				s->xs->addr.pc.incOffset(opparams[0]);
@@ -795,7 +850,7 @@ void run_vm(EngineState *s) {
 					local_script->getScriptNumber(), s->xs->addr.pc.getOffset(), local_script->getScriptSize());
 			break;
 
-		case op_bnt: // 0x18 (24)
+		OPCODE(op_bnt): // 0x18 (24)
 			// Branch relative if not true
 			if (!(s->r_acc.getOffset() || s->r_acc.getSegment()))
 				s->xs->addr.pc.incOffset(opparams[0]);
@@ -805,7 +860,7 @@ void run_vm(EngineState *s) {
 					local_script->getScriptNumber(), s->xs->addr.pc.getOffset(), local_script->getScriptSize());
 			break;
 
-		case op_jmp: // 0x19 (25)
+		OPCODE(op_jmp): // 0x19 (25)
 			s->xs->addr.pc.incOffset(opparams[0]);
 
 			if (s->xs->addr.pc.getOffset() >= local_script->getScriptSize())
@@ -813,33 +868,33 @@ void run_vm(EngineState *s) {
 					local_script->getScriptNumber(), s->xs->addr.pc.getOffset(), local_script->getScriptSize());
 			break;
 
-		case op_ldi: // 0x1a (26)
+		OPCODE(op_ldi): // 0x1a (26)
 			// Load data immediate
 			s->r_acc = make_reg(0, opparams[0]);
 			break;
 
-		case op_push: // 0x1b (27)
+		OPCODE(op_push): // 0x1b (27)
 			// Push to stack
 			PUSH32(s->r_acc);
 			break;
 
-		case op_pushi: // 0x1c (28)
+		OPCODE(op_pushi): // 0x1c (28)
 			// Push immediate
 			PUSH(opparams[0]);
 			break;
 
-		case op_toss: // 0x1d (29)
+		OPCODE(op_toss): // 0x1d (29)
 			// TOS (Top Of Stack) subtract
 			s->xs->sp--;
 			break;
 
-		case op_dup: // 0x1e (30)
+		OPCODE(op_dup): // 0x1e (30)
 			// Duplicate TOD (Top Of Stack) element
 			r_temp = s->xs->sp[-1];
 			PUSH32(r_temp);
 			break;
 
-		case op_link: // 0x1f (31)
+		OPCODE(op_link): // 0x1f (31)
 			// We shouldn't initialize temp variables at all
 			//  We put special segment 0xFFFF in there, so that uninitialized reads can get detected
 			for (int i = 0; i < opparams[0]; i++)
@@ -848,7 +903,7 @@ void run_vm(EngineState *s) {
 			s->xs->sp += opparams[0];
 			break;
 
-		case op_call: { // 0x20 (32)
+		OPCODE(op_call): { // 0x20 (32)
 			// Call a script subroutine
 			int argc = (opparams[1] >> 1) // Given as offset, but we need count
 			           + 1 + s->r_rest;
@@ -874,7 +929,7 @@ void run_vm(EngineState *s) {
 			break;
 		}
 
-		case op_callk: { // 0x21 (33)
+		OPCODE(op_callk): { // 0x21 (33)
 			// Run the garbage collector, if needed
 			if (s->gcCountDown-- <= 0) {
 				s->gcCountDown = s->scriptGCInterval;
@@ -911,7 +966,7 @@ void run_vm(EngineState *s) {
 			break;
 		}
 
-		case op_callb: // 0x22 (34)
+		OPCODE(op_callb): // 0x22 (34)
 			// Call base script
 			temp = ((opparams[1] >> 1) + s->r_rest + 1);
 			s_temp = s->xs->sp;
@@ -925,7 +980,7 @@ void run_vm(EngineState *s) {
 				s->_executionStackPosChanged = true;
 			break;
 
-		case op_calle: // 0x23 (35)
+		OPCODE(op_calle): // 0x23 (35)
 			// Call external script
 			temp = ((opparams[2] >> 1) + s->r_rest + 1);
 			s_temp = s->xs->sp;
@@ -939,7 +994,7 @@ void run_vm(EngineState *s) {
 				s->_executionStackPosChanged = true;
 			break;
 
-		case op_ret: // 0x24 (36)
+		OPCODE(op_ret): // 0x24 (36)
 			// Return from an execution loop started by call, calle, callb, send, self or super
 			do {
 				StackPtr old_sp2 = s->xs->sp;
@@ -982,7 +1037,7 @@ void run_vm(EngineState *s) {
 
 			break;
 
-		case op_send: // 0x25 (37)
+		OPCODE(op_send): // 0x25 (37)
 			// Send for one or more selectors
 			s_temp = s->xs->sp;
 			s->xs->sp -= ((opparams[0] >> 1) + s->r_rest); // Adjust stack
@@ -998,7 +1053,7 @@ void run_vm(EngineState *s) {
 
 			break;
 
-		case op_infoToa: // (38)
+		OPCODE(op_infoToa): // (38)
 			if (getSciVersion() < SCI_VERSION_3)
 				error("Dummy opcode 0x%x called", opcode);	// should never happen
 
@@ -1008,7 +1063,7 @@ void run_vm(EngineState *s) {
 				PUSH32(obj->getInfoSelector());
 			break;
 
-		case op_superToa: // (39)
+		OPCODE(op_superToa): // (39)
 			if (getSciVersion() < SCI_VERSION_3)
 				error("Dummy opcode 0x%x called", opcode);	// should never happen
 
@@ -1018,17 +1073,17 @@ void run_vm(EngineState *s) {
 				PUSH32(obj->getSuperClassSelector());
 			break;
 
-		case op_class: // 0x28 (40)
+		OPCODE(op_class): // 0x28 (40)
 			// Get class address
 			s->r_acc = s->_segMan->getClassAddress((unsigned)opparams[0], SCRIPT_GET_LOCK,
 											s->xs->addr.pc.getSegment());
 			break;
 
-		case 0x29: // (41)
+		OPCODE(0x29): // (41)
 			error("Dummy opcode 0x%x called", opcode);	// should never happen
 			break;
 
-		case op_self: // 0x2a (42)
+		OPCODE(op_self): // 0x2a (42)
 			// Send to self
 			s_temp = s->xs->sp;
 			s->xs->sp -= ((opparams[0] >> 1) + s->r_rest); // Adjust stack
@@ -1044,7 +1099,7 @@ void run_vm(EngineState *s) {
 			s->r_rest = 0;
 			break;
 
-		case op_super: // 0x2b (43)
+		OPCODE(op_super): // 0x2b (43)
 			// Send to any class
 			r_temp = s->_segMan->getClassAddress(opparams[0], SCRIPT_GET_LOAD, s->xs->addr.pc.getSegment());
 
@@ -1067,7 +1122,7 @@ void run_vm(EngineState *s) {
 
 			break;
 
-		case op_rest: // 0x2c (44)
+		OPCODE(op_rest): // 0x2c (44)
 			// Pushes all or part of the parameter variable list on the stack
 			temp = (uint16) opparams[0]; // First argument
 			s->r_rest = MAX<int16>(s->xs->argc - temp + 1, 0); // +1 because temp counts the paramcount while argc doesn't
@@ -1077,7 +1132,7 @@ void run_vm(EngineState *s) {
 
 			break;
 
-		case op_lea: // 0x2d (45)
+		OPCODE(op_lea): // 0x2d (45)
 			// Load Effective Address
 			temp = (uint16) opparams[0] >> 1;
 			var_number = temp & 0x03; // Get variable type
@@ -1096,27 +1151,27 @@ void run_vm(EngineState *s) {
 			break;
 
 
-		case op_selfID: // 0x2e (46)
+		OPCODE(op_selfID): // 0x2e (46)
 			// Get 'self' identity
 			s->r_acc = s->xs->objp;
 			break;
 
-		case 0x2f: // (47)
+		OPCODE(0x2f): // (47)
 			error("Dummy opcode 0x%x called", opcode);	// should never happen
 			break;
 
-		case op_pprev: // 0x30 (48)
+		OPCODE(op_pprev): // 0x30 (48)
 			// Pushes the value of the prev register, set by the last comparison
 			// bytecode (eq?, lt?, etc.), on the stack
 			PUSH32(s->r_prev);
 			break;
 
-		case op_pToa: // 0x31 (49)
+		OPCODE(op_pToa): // 0x31 (49)
 			// Property To Accumulator
 			s->r_acc = validate_property(s, obj, opparams[0]);
 			break;
 
-		case op_aTop: // 0x32 (50)
+		OPCODE(op_aTop): // 0x32 (50)
 			// Accumulator To Property
 			validate_property(s, obj, opparams[0]) = s->r_acc;
 #ifdef ENABLE_SCI32
@@ -1124,12 +1179,12 @@ void run_vm(EngineState *s) {
 #endif
 			break;
 
-		case op_pTos: // 0x33 (51)
+		OPCODE(op_pTos): // 0x33 (51)
 			// Property To Stack
 			PUSH32(validate_property(s, obj, opparams[0]));
 			break;
 
-		case op_sTop: // 0x34 (52)
+		OPCODE(op_sTop): // 0x34 (52)
 			// Stack To Property
 			validate_property(s, obj, opparams[0]) = POP32();
 #ifdef ENABLE_SCI32
@@ -1137,10 +1192,10 @@ void run_vm(EngineState *s) {
 #endif
 			break;
 
-		case op_ipToa: // 0x35 (53)
-		case op_dpToa: // 0x36 (54)
-		case op_ipTos: // 0x37 (55)
-		case op_dpTos: // 0x38 (56)
+		OPCODE(op_ipToa): // 0x35 (53)
+		OPCODE(op_dpToa): // 0x36 (54)
+		OPCODE(op_ipTos): // 0x37 (55)
+		OPCODE(op_dpTos): // 0x38 (56)
 			{
 			// Increment/decrement a property and copy to accumulator,
 			// or push to stack
@@ -1159,8 +1214,8 @@ void run_vm(EngineState *s) {
 			break;
 		}
 
-		case op_lofsa: // 0x39 (57)
-		case op_lofss: // 0x3a (58)
+		OPCODE(op_lofsa): // 0x39 (57)
+		OPCODE(op_lofss): // 0x3a (58)
 			// Load offset to accumulator or push to stack
 			r_temp.setSegment(s->xs->addr.pc.getSegment());
 
@@ -1193,19 +1248,19 @@ void run_vm(EngineState *s) {
 				PUSH32(r_temp);
 			break;
 
-		case op_push0: // 0x3b (59)
+		OPCODE(op_push0): // 0x3b (59)
 			PUSH(0);
 			break;
 
-		case op_push1: // 0x3c (60)
+		OPCODE(op_push1): // 0x3c (60)
 			PUSH(1);
 			break;
 
-		case op_push2: // 0x3d (61)
+		OPCODE(op_push2): // 0x3d (61)
 			PUSH(2);
 			break;
 
-		case op_pushSelf: // 0x3e (62)
+		OPCODE(op_pushSelf): // 0x3e (62)
 			// Compensate for a bug in non-Sierra compilers, which seem to generate
 			// pushSelf instructions with the low bit set. This makes the following
 			// heuristic fail and leads to endless loops and crashes. Our
@@ -1219,20 +1274,20 @@ void run_vm(EngineState *s) {
 			}
 			break;
 
-		case op_line: // 0x3f (63)
+		OPCODE(op_line): // 0x3f (63)
 			// Debug opcode (line number)
 			//debug("Script %d, line %d", scr->getScriptNumber(), opparams[0]);
 			break;
 
-		case op_lag: // 0x40 (64)
-		case op_lal: // 0x41 (65)
-		case op_lat: // 0x42 (66)
-		case op_lap: // 0x43 (67)
+		OPCODE(op_lag): // 0x40 (64)
+		OPCODE(op_lal): // 0x41 (65)
+		OPCODE(op_lat): // 0x42 (66)
+		OPCODE(op_lap): // 0x43 (67)
 			// Load global, local, temp or param variable into the accumulator
-		case op_lagi: // 0x48 (72)
-		case op_lali: // 0x49 (73)
-		case op_lati: // 0x4a (74)
-		case op_lapi: // 0x4b (75)
+		OPCODE(op_lagi): // 0x48 (72)
+		OPCODE(op_lali): // 0x49 (73)
+		OPCODE(op_lati): // 0x4a (74)
+		OPCODE(op_lapi): // 0x4b (75)
 			// Same as the 4 ones above, except that the accumulator is used as
 			// an additional index
 			var_type = opcode & 0x3; // Gets the variable type: g, l, t or p
@@ -1240,15 +1295,15 @@ void run_vm(EngineState *s) {
 			s->r_acc = read_var(s, var_type, var_number);
 			break;
 
-		case op_lsg: // 0x44 (68)
-		case op_lsl: // 0x45 (69)
-		case op_lst: // 0x46 (70)
-		case op_lsp: // 0x47 (71)
+		OPCODE(op_lsg): // 0x44 (68)
+		OPCODE(op_lsl): // 0x45 (69)
+		OPCODE(op_lst): // 0x46 (70)
+		OPCODE(op_lsp): // 0x47 (71)
 			// Load global, local, temp or param variable into the stack
-		case op_lsgi: // 0x4c (76)
-		case op_lsli: // 0x4d (77)
-		case op_lsti: // 0x4e (78)
-		case op_lspi: // 0x4f (79)
+		OPCODE(op_lsgi): // 0x4c (76)
+		OPCODE(op_lsli): // 0x4d (77)
+		OPCODE(op_lsti): // 0x4e (78)
+		OPCODE(op_lspi): // 0x4f (79)
 			// Same as the 4 ones above, except that the accumulator is used as
 			// an additional index
 			var_type = opcode & 0x3; // Gets the variable type: g, l, t or p
@@ -1256,15 +1311,15 @@ void run_vm(EngineState *s) {
 			PUSH32(read_var(s, var_type, var_number));
 			break;
 
-		case op_sag: // 0x50 (80)
-		case op_sal: // 0x51 (81)
-		case op_sat: // 0x52 (82)
-		case op_sap: // 0x53 (83)
+		OPCODE(op_sag): // 0x50 (80)
+		OPCODE(op_sal): // 0x51 (81)
+		OPCODE(op_sat): // 0x52 (82)
+		OPCODE(op_sap): // 0x53 (83)
 			// Save the accumulator into the global, local, temp or param variable
-		case op_sagi: // 0x58 (88)
-		case op_sali: // 0x59 (89)
-		case op_sati: // 0x5a (90)
-		case op_sapi: // 0x5b (91)
+		OPCODE(op_sagi): // 0x58 (88)
+		OPCODE(op_sali): // 0x59 (89)
+		OPCODE(op_sati): // 0x5a (90)
+		OPCODE(op_sapi): // 0x5b (91)
 			// Save the accumulator into the global, local, temp or param variable,
 			// using the accumulator as an additional index
 			var_type = opcode & 0x3; // Gets the variable type: g, l, t or p
@@ -1274,15 +1329,15 @@ void run_vm(EngineState *s) {
 			write_var(s, var_type, var_number, s->r_acc);
 			break;
 
-		case op_ssg: // 0x54 (84)
-		case op_ssl: // 0x55 (85)
-		case op_sst: // 0x56 (86)
-		case op_ssp: // 0x57 (87)
+		OPCODE(op_ssg): // 0x54 (84)
+		OPCODE(op_ssl): // 0x55 (85)
+		OPCODE(op_sst): // 0x56 (86)
+		OPCODE(op_ssp): // 0x57 (87)
 			// Save the stack into the global, local, temp or param variable
-		case op_ssgi: // 0x5c (92)
-		case op_ssli: // 0x5d (93)
-		case op_ssti: // 0x5e (94)
-		case op_sspi: // 0x5f (95)
+		OPCODE(op_ssgi): // 0x5c (92)
+		OPCODE(op_ssli): // 0x5d (93)
+		OPCODE(op_ssti): // 0x5e (94)
+		OPCODE(op_sspi): // 0x5f (95)
 			// Same as the 4 ones above, except that the accumulator is used as
 			// an additional index
 			var_type = opcode & 0x3; // Gets the variable type: g, l, t or p
@@ -1290,16 +1345,16 @@ void run_vm(EngineState *s) {
 			write_var(s, var_type, var_number, POP32());
 			break;
 
-		case op_plusag: // 0x60 (96)
-		case op_plusal: // 0x61 (97)
-		case op_plusat: // 0x62 (98)
-		case op_plusap: // 0x63 (99)
+		OPCODE(op_plusag): // 0x60 (96)
+		OPCODE(op_plusal): // 0x61 (97)
+		OPCODE(op_plusat): // 0x62 (98)
+		OPCODE(op_plusap): // 0x63 (99)
 			// Increment the global, local, temp or param variable and save it
 			// to the accumulator
-		case op_plusagi: // 0x68 (104)
-		case op_plusali: // 0x69 (105)
-		case op_plusati: // 0x6a (106)
-		case op_plusapi: // 0x6b (107)
+		OPCODE(op_plusagi): // 0x68 (104)
+		OPCODE(op_plusali): // 0x69 (105)
+		OPCODE(op_plusati): // 0x6a (106)
+		OPCODE(op_plusapi): // 0x6b (107)
 			// Same as the 4 ones above, except that the accumulator is used as
 			// an additional index
 			var_type = opcode & 0x3; // Gets the variable type: g, l, t or p
@@ -1308,16 +1363,16 @@ void run_vm(EngineState *s) {
 			write_var(s, var_type, var_number, s->r_acc);
 			break;
 
-		case op_plussg: // 0x64 (100)
-		case op_plussl: // 0x65 (101)
-		case op_plusst: // 0x66 (102)
-		case op_plussp: // 0x67 (103)
+		OPCODE(op_plussg): // 0x64 (100)
+		OPCODE(op_plussl): // 0x65 (101)
+		OPCODE(op_plusst): // 0x66 (102)
+		OPCODE(op_plussp): // 0x67 (103)
 			// Increment the global, local, temp or param variable and save it
 			// to the stack
-		case op_plussgi: // 0x6c (108)
-		case op_plussli: // 0x6d (109)
-		case op_plussti: // 0x6e (110)
-		case op_plusspi: // 0x6f (111)
+		OPCODE(op_plussgi): // 0x6c (108)
+		OPCODE(op_plussli): // 0x6d (109)
+		OPCODE(op_plussti): // 0x6e (110)
+		OPCODE(op_plusspi): // 0x6f (111)
 			// Same as the 4 ones above, except that the accumulator is used as
 			// an additional index
 			var_type = opcode & 0x3; // Gets the variable type: g, l, t or p
@@ -1327,16 +1382,16 @@ void run_vm(EngineState *s) {
 			write_var(s, var_type, var_number, r_temp);
 			break;
 
-		case op_minusag: // 0x70 (112)
-		case op_minusal: // 0x71 (113)
-		case op_minusat: // 0x72 (114)
-		case op_minusap: // 0x73 (115)
+		OPCODE(op_minusag): // 0x70 (112)
+		OPCODE(op_minusal): // 0x71 (113)
+		OPCODE(op_minusat): // 0x72 (114)
+		OPCODE(op_minusap): // 0x73 (115)
 			// Decrement the global, local, temp or param variable and save it
 			// to the accumulator
-		case op_minusagi: // 0x78 (120)
-		case op_minusali: // 0x79 (121)
-		case op_minusati: // 0x7a (122)
-		case op_minusapi: // 0x7b (123)
+		OPCODE(op_minusagi): // 0x78 (120)
+		OPCODE(op_minusali): // 0x79 (121)
+		OPCODE(op_minusati): // 0x7a (122)
+		OPCODE(op_minusapi): // 0x7b (123)
 			// Same as the 4 ones above, except that the accumulator is used as
 			// an additional index
 			var_type = opcode & 0x3; // Gets the variable type: g, l, t or p
@@ -1345,16 +1400,16 @@ void run_vm(EngineState *s) {
 			write_var(s, var_type, var_number, s->r_acc);
 			break;
 
-		case op_minussg: // 0x74 (116)
-		case op_minussl: // 0x75 (117)
-		case op_minusst: // 0x76 (118)
-		case op_minussp: // 0x77 (119)
+		OPCODE(op_minussg): // 0x74 (116)
+		OPCODE(op_minussl): // 0x75 (117)
+		OPCODE(op_minusst): // 0x76 (118)
+		OPCODE(op_minussp): // 0x77 (119)
 			// Decrement the global, local, temp or param variable and save it
 			// to the stack
-		case op_minussgi: // 0x7c (124)
-		case op_minussli: // 0x7d (125)
-		case op_minussti: // 0x7e (126)
-		case op_minusspi: // 0x7f (127)
+		OPCODE(op_minussgi): // 0x7c (124)
+		OPCODE(op_minussli): // 0x7d (125)
+		OPCODE(op_minussti): // 0x7e (126)
+		OPCODE(op_minusspi): // 0x7f (127)
 			// Same as the 4 ones above, except that the accumulator is used as
 			// an additional index
 			var_type = opcode & 0x3; // Gets the variable type: g, l, t or p
@@ -1381,6 +1436,8 @@ void run_vm(EngineState *s) {
 	}
 }
 
+#undef OPCODE
+
 reg_t *ObjVarRef::getPointer(SegManager *segMan) const {
 	Object *o = segMan->getObject(obj);
 	return o ? &o->getVariableRef(varindex) : 0;
@@ -22,9 +22,11 @@
 
 // Resource library
 
+#include "common/config-manager.h"
 #include "common/file.h"
 #include "common/fs.h"
 #include "common/macresman.h"
+#include "common/system.h"
 #include "common/textconsole.h"
 #ifdef ENABLE_SCI32
 #include "common/memstream.h"
@@ -111,7 +113,8 @@ static const char *const s_errorDescriptions[] = {
 	"No resource files found",
 	"Unknown compression method",
 	"Decompression failed: Sanity check failed",
-	"Decompression failed: Resource too big"
+	"Decompression failed: Resource too big",
+	"Compression method not supported"
 };
 
 static const char *const s_resourceTypeNames[] = {
@@ -198,6 +201,8 @@ Resource::Resource(ResourceManager *resMan, ResourceId id) : _resMan(resMan), _i
 	_fileOffset = 0;
 	_status = kResStatusNoMalloc;
 	_lockers = 0;
+	_recentUses = 0;
+	_prefetched = false;
 	_source = NULL;
 	_header = NULL;
 	_headerSize = 0;
@@ -564,16 +569,19 @@ void ResourceSource::loadResource(ResourceManager *resMan, Resource *res) {
 		volVersion = kResVersionSci11;
 	fileStream->seek(res->_fileOffset, SEEK_SET);
 	
-	int error = res->decompress(volVersion, fileStream);
+	int errorNum = res->decompress(volVersion, fileStream);
 #else
 	fileStream->seek(res->_fileOffset, SEEK_SET);
 
-	int error = res->decompress(resMan->getVolVersion(), fileStream);
+	int errorNum = res->decompress(resMan->getVolVersion(), fileStream);
 #endif
-	if (error) {
+	if (errorNum == SCI_ERROR_UNSUPPORTED_COMPRESSION)
+		error("Resource %s: Compression method not supported", res->_id.toString().c_str());
+
+	if (errorNum) {
 		warning("Error %d occurred while reading %s from resource file %s: %s",
-				error, res->_id.toString().c_str(), res->getResourceLocation().c_str(),
-				s_errorDescriptions[error]);
+				errorNum, res->_id.toString().c_str(), res->getResourceLocation().c_str(),
+				s_errorDescriptions[errorNum]);
 		res->unalloc();
 	}
 
@@ -901,13 +909,14 @@ void ResourceManager::freeResourceSources() {
 	_sources.clear();
 }
 
-ResourceManager::ResourceManager() {
+ResourceManager::ResourceManager() : _prefetcher(NULL) {
 }
 
 void ResourceManager::init() {
 	_maxMemoryLRU = 256 * 1024; // 256KiB
 	_memoryLocked = 0;
 	_memoryLRU = 0;
+	_memoryPrefetched = 0;
 	_LRU.clear();
 	_resMap.clear();
 	_audioMapSCI1 = NULL;
@@ -969,6 +978,11 @@ void ResourceManager::init() {
 		_maxMemoryLRU = 2048 * 1024; // 2MiB
 	}
 
+	// Allow raising the budget for large games, or lowering it for devices
+	// with little memory
+	if (ConfMan.hasKey("sci_resource_cache_size"))
+		_maxMemoryLRU = MAX(ConfMan.getInt("sci_resource_cache_size"), 0) * 1024;
+
 	switch (_viewType) {
 	case kViewEga:
 		debugC(1, kDebugLevelResMan, "resMan: Detected EGA graphic resources");
@@ -995,6 +1009,9 @@ void ResourceManager::init() {
 }
 
 ResourceManager::~ResourceManager() {
+	// Stop the worker, before freeing what it uses
+	delete _prefetcher;
+
 	// freeing resources
 	ResourceMap::iterator itr = _resMap.begin();
 	while (itr != _resMap.end()) {
@@ -1056,8 +1073,35 @@ void ResourceManager::freeOldResources() {
 	while (_maxMemoryLRU < _memoryLRU) {
 		assert(!_LRU.empty());
 		Resource *goner = *_LRU.reverse_begin();
+
+		// Give resources which are requested over and over, like fonts and
+		// cursors, another round. This keeps them from being pushed out by
+		// the many resources used just once when changing rooms. Halving
+		// the count lets them age out eventually.
+		if (goner->_recentUses > 1) {
+			goner->_recentUses /= 2;
+			_LRU.pop_back();
+			_LRU.push_front(goner);
+			continue;
+		}
+
+		// Resources prefetched for the room being set up have not had their
+		// chance yet. They fit the budget, unless it was lowered since.
+		if (goner->_prefetched && _memoryPrefetched <= _maxMemoryLRU) {
+			_LRU.pop_back();
+			_LRU.push_front(goner);
+			continue;
+		}
+
+		if (goner->_prefetched) {
+			goner->_prefetched = false;
+			_memoryPrefetched -= goner->size;
+		}
+
 		removeFromLRU(goner);
 		goner->unalloc();
+		goner->_recentUses = 0;
+		_cacheStats.evictions++;
 #ifdef SCI_VERBOSE_RESMAN
 		debug("resMan-debug: LRU: Freeing %s (%d bytes)", goner->_id.toString().c_str(), goner->size);
 #endif
@@ -1083,9 +1127,36 @@ Resource *ResourceManager::findResource(ResourceId id, bool lock) {
 	if (!retval)
 		return NULL;
 
-	if (retval->_status == kResStatusNoMalloc)
-		loadResource(retval);
-	else if (retval->_status == kResStatusEnqueued)
+	if (_prefetcher)
+		addPrefetchedResources();
+
+	if (retval->_status == kResStatusNoMalloc) {
+		const uint32 startTime = g_system->getMillis();
+		_cacheStats.misses++;
+
+		if (_prefetcher && _prefetcher->wait(id)) {
+			// The worker was busy loading it
+			_cacheStats.waits++;
+			addPrefetchedResources();
+		}
+
+		if (retval->_status == kResStatusNoMalloc)
+			loadResource(retval);
+
+		_cacheStats.loadTime += g_system->getMillis() - startTime;
+	} else {
+		_cacheStats.hits++;
+	}
+
+	if (retval->_recentUses < 0xFFFF)
+		retval->_recentUses++;
+
+	if (retval->_prefetched) {
+		retval->_prefetched = false;
+		_memoryPrefetched -= retval->size;
+	}
+
+	if (retval->_status == kResStatusEnqueued)
 		// The resource is removed from its current position
 		// in the LRU list because it has been requested
 		// again. Below, it will either be locked, or it
@@ -1135,6 +1206,76 @@ void ResourceManager::unlockResource(Resource *res) {
 	freeOldResources();
 }
 
+void ResourceManager::prefetchResource(ResourceId id) {
+	Resource *res = testResource(id);
+	if (!res || res->_status != kResStatusNoMalloc || res->_source->getSourceType() != kSourceVolume)
+		return;
+
+	// Anything loaded now would only push out what was prefetched before
+	if (_memoryPrefetched >= _maxMemoryLRU)
+		return;
+
+	switch (id.getType()) {
+	case kResourceTypeView:
+	case kResourceTypePic:
+	case kResourceTypeSound:
+		break;
+	default:
+		return;
+	}
+
+	if (!_prefetcher) {
+		_prefetcher = new ResourcePrefetcher(this);
+		if (!_prefetcher->start())
+			debugC(1, kDebugLevelResMan, "resMan: Could not start the prefetch thread, loading resources when needed");
+	}
+
+	if (_prefetcher->isRunning())
+		_prefetcher->queue(res);
+}
+
+void ResourceManager::addPrefetchedResources() {
+	Common::Array<Resource *> loaded;
+	Common::Array<ResourcePrefetcher::Failure> failures;
+	_prefetcher->takeLoaded(loaded, failures);
+
+	// The resource is loaded again when it is requested, which reports the
+	// error for real
+	for (uint i = 0; i < failures.size(); i++)
+		debugC(1, kDebugLevelResMan, "resMan: Could not prefetch %s: %s",
+				failures[i].id.toString().c_str(), s_errorDescriptions[failures[i].error]);
+
+	if (loaded.empty())
+		return;
+
+	for (uint i = 0; i < loaded.size(); i++) {
+		Resource *res = testResource(loaded[i]->_id);
+
+		// It may have been loaded on this thread in the meantime. Once the
+		// batch exceeds the budget, the rest is loaded when requested.
+		if (res && res->_status == kResStatusNoMalloc && _memoryPrefetched + (int)loaded[i]->size <= _maxMemoryLRU) {
+			res->data = loaded[i]->data;
+			res->size = loaded[i]->size;
+			loaded[i]->data = NULL;
+
+			res->_status = kResStatusAllocated;
+			res->_prefetched = true;
+			_memoryPrefetched += res->size;
+			addToLRU(res);
+			_cacheStats.prefetched++;
+		}
+
+		delete loaded[i];
+	}
+
+	freeOldResources();
+}
+
+void ResourceManager::setMaxMemoryLRU(int bytes) {
+	_maxMemoryLRU = bytes;
+	freeOldResources();
+}
+
 const char *ResourceManager::versionDescription(ResVersion version) const {
 	switch (version) {
 	case kResVersionUnknown:
@@ -2090,8 +2231,8 @@ int Resource::decompress(ResVersion volVersion, Common::SeekableReadStream *file
 		break;
 #endif
 	default:
-		error("Resource %s: Compression method %d not supported", _id.toString().c_str(), compression);
-		return SCI_ERROR_UNKNOWN_COMPRESSION;
+		// Left to the caller to report, as this may run on the prefetch thread
+		return SCI_ERROR_UNSUPPORTED_COMPRESSION;
 	}
 
 	data = new byte[size];
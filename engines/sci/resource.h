@@ -64,7 +64,8 @@ enum ResourceErrorCodes {
 	SCI_ERROR_NO_RESOURCE_FILES_FOUND = 5,	/**< No resource at all was found */
 	SCI_ERROR_UNKNOWN_COMPRESSION = 6,
 	SCI_ERROR_DECOMPRESSION_ERROR = 7,	/**< sanity checks failed during decompression */
-	SCI_ERROR_RESOURCE_TOO_BIG = 8	/**< Resource size exceeds SCI_MAX_RESOURCE_SIZE */
+	SCI_ERROR_RESOURCE_TOO_BIG = 8,	/**< Resource size exceeds SCI_MAX_RESOURCE_SIZE */
+	SCI_ERROR_UNSUPPORTED_COMPRESSION = 9	/**< Known compression method that this build cannot unpack */
 };
 
 enum {
@@ -243,6 +244,7 @@ class Resource {
 #ifdef ENABLE_SCI32
 	friend class ChunkResourceSource;
 #endif
+	friend class ResourcePrefetcher;
 
 // NOTE : Currently most member variables lack the underscore prefix and have
 // public visibility to let the rest of the engine compile without changes.
@@ -282,6 +284,8 @@ protected:
 	int32 _fileOffset; /**< Offset in file */
 	ResourceStatus _status;
 	uint16 _lockers; /**< Number of places where this resource was locked */
+	uint16 _recentUses; /**< Number of requests, halved whenever it gets another round in the LRU queue */
+	bool _prefetched; /**< Loaded by the prefetcher and not requested since */
 	ResourceSource *_source;
 	ResourceManager *_resMan;
 
@@ -297,6 +301,23 @@ protected:
 typedef Common::HashMap<ResourceId, Resource *, ResourceIdHash> ResourceMap;
 
 class IntMapResourceSource;
+class ResourcePrefetcher;
+
+/** Statistics of the resource cache, shown by the debugger */
+struct ResourceCacheStats {
+	uint32 hits;       ///< Requests for resources which were in memory
+	uint32 misses;     ///< Requests which had to load the resource
+	uint32 loadTime;   ///< Milliseconds spent loading resources on misses
+	uint32 prefetched; ///< Resources loaded in the background
+	uint32 waits;      ///< Misses which waited for the resource to be prefetched
+	uint32 evictions;  ///< Resources freed to stay within the memory budget
+
+	ResourceCacheStats() { reset(); }
+	void reset() {
+		hits = misses = loadTime = prefetched = waits = evictions = 0;
+	}
+};
+
 class ResourceManager {
 	// FIXME: These 'friend' declarations are meant to be a temporary hack to
 	// ease transition to the ResourceSource class system.
@@ -352,6 +373,30 @@ public:
 	 */
 	void unlockResource(Resource *res);
 
+	/**
+	 * Starts loading a resource on a worker thread, as it is going to be
+	 * needed soon. findResource() picks the resource up when it is ready,
+	 * or waits for it while it is being loaded. Only views, pics and sounds
+	 * in resource volumes are loaded ahead, other requests are ignored, as
+	 * are all requests while the LRU budget is taken up by prefetched
+	 * resources.
+	 * @param id	The resource to load
+	 */
+	void prefetchResource(ResourceId id);
+
+	/**
+	 * Sets the memory budget for resources which are not locked. Resources
+	 * are freed when the budget is exceeded, starting with those requested
+	 * least recently and least often.
+	 * @param bytes	The budget in bytes
+	 */
+	void setMaxMemoryLRU(int bytes);
+	int getMaxMemoryLRU() const { return _maxMemoryLRU; }
+	int getMemoryLRU() const { return _memoryLRU; }
+	int getMemoryLocked() const { return _memoryLocked; }
+
+	ResourceCacheStats &getCacheStats() { return _cacheStats; }
+
 	/**
 	 * Tests whether a resource exists.
 	 *
@@ -463,7 +508,10 @@ protected:
 	Common::List<ResourceSource *> _sources;
 	int _memoryLocked;	///< Amount of resource bytes in locked memory
 	int _memoryLRU;		///< Amount of resource bytes under LRU control
+	int _memoryPrefetched; ///< Amount of resource bytes prefetched and not requested since
 	Common::List<Resource *> _LRU; ///< Last Resource Used list
+	ResourceCacheStats _cacheStats;
+	ResourcePrefetcher *_prefetcher; ///< Started on the first prefetch
 	ResourceMap _resMap;
 	Common::List<Common::File *> _volumeFiles; ///< list of opened volume files
 	ResourceSource *_audioMapSCI1; ///< Currently loaded audio map for SCI1
@@ -584,6 +632,14 @@ protected:
 	void addToLRU(Resource *res);
 	void removeFromLRU(Resource *res);
 
+	/**
+	 * Puts the resources loaded by the prefetcher in the meantime under LRU
+	 * control. Resources which would take the prefetched resources that are
+	 * still waiting to be requested over the LRU budget are thrown away, so
+	 * that a large batch does not push out its own first resources.
+	 */
+	void addPrefetchedResources();
+
 	ResourceCompression getViewCompression();
 	ViewType detectViewType();
 	bool hasSci0Voc999();
@@ -23,6 +23,8 @@
 #ifndef SCI_RESOURCE_INTERN_H
 #define SCI_RESOURCE_INTERN_H
 
+#include "common/threadpool.h"
+
 #include "sci/resource.h"
 
 namespace Common {
@@ -192,6 +194,93 @@ protected:
 	void decompressResource(Common::SeekableReadStream *stream, Resource *resource) const;
 };
 
+/**
+ * Loads resources from resource volumes on a worker thread.
+ *
+ * The worker only touches the requests, its own streams and the Resource
+ * objects it creates. Their data is handed over to the real resources by
+ * the resource manager, on the main thread. Everything shared with the
+ * worker is guarded by _mutex.
+ */
+class ResourcePrefetcher {
+public:
+	/** A resource the worker could not load */
+	struct Failure {
+		ResourceId id;
+		int error; ///< One of SCI_ERROR_*
+	};
+
+	ResourcePrefetcher(ResourceManager *resMan);
+	~ResourcePrefetcher();
+
+	/**
+	 * Starts the worker thread.
+	 * @return false if no thread could be started
+	 */
+	bool start();
+	bool isRunning() const { return _thread.isRunning(); }
+
+	/**
+	 * Queues a resource to be loaded, unless it is already queued.
+	 * @param res	A resource from a resource volume, which is not loaded
+	 */
+	void queue(const Resource *res);
+
+	/**
+	 * Makes sure that a resource is not queued or being loaded any more.
+	 * Waits for the worker if it is busy loading the resource.
+	 * @param id	The resource to wait for
+	 * @return true if the resource has been loaded by the worker
+	 */
+	bool wait(ResourceId id);
+
+	/**
+	 * Takes the resources the worker has loaded, and the errors it ran into.
+	 * Errors are not reported on the worker thread, as error() must not be
+	 * called there.
+	 * @param resources	Receives the loaded resources, which the caller
+	 *					takes ownership of
+	 * @param failures	Receives the resources which could not be loaded
+	 */
+	void takeLoaded(Common::Array<Resource *> &resources, Common::Array<Failure> &failures);
+
+private:
+	struct Request {
+		ResourceId id;
+		Common::SeekableReadStream *stream;
+		int32 offset;
+		ResVersion volVersion;
+	};
+
+	struct VolumeStream {
+		const ResourceSource *source;
+		Common::SeekableReadStream *stream;
+	};
+
+	ResourceManager *_resMan;
+
+	Common::NativeThread _thread;
+	Common::NativeMutex _mutex;
+	Common::NativeCondition _queueCond;  ///< Signaled when requests are queued
+	Common::NativeCondition _loadedCond; ///< Signaled when a resource has been loaded
+	Common::List<Request> _queue;
+	Common::Array<Resource *> _loaded;
+	Common::Array<Failure> _failures;
+	ResourceId _loading;  ///< The resource the worker is loading
+	bool _busy;           ///< Whether the worker is loading _loading
+	bool _stop;
+
+	/**
+	 * Streams of the volumes, separate from the resource manager's. Only
+	 * requests refer to them on the worker thread.
+	 */
+	Common::Array<VolumeStream> _streams;
+
+	Common::SeekableReadStream *getStream(const ResourceSource *source);
+	static void threadProc(void *data);
+	void run();
+};
+
 #ifdef ENABLE_SCI32
 
 /**
@@ -0,0 +1,185 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+// Resource prefetching
+
+#include "common/file.h"
+#include "common/fs.h"
+#include "common/textconsole.h"
+
+#include "sci/resource.h"
+#include "sci/resource_intern.h"
+
+namespace Sci {
+
+ResourcePrefetcher::ResourcePrefetcher(ResourceManager *resMan)
+	: _resMan(resMan), _busy(false), _stop(false) {
+}
+
+ResourcePrefetcher::~ResourcePrefetcher() {
+	if (_thread.isRunning()) {
+		_mutex.lock();
+		_stop = true;
+		_queueCond.signal();
+		_mutex.unlock();
+
+		_thread.join();
+	}
+
+	for (uint i = 0; i < _loaded.size(); i++)
+		delete _loaded[i];
+
+	for (uint i = 0; i < _streams.size(); i++)
+		delete _streams[i].stream;
+}
+
+bool ResourcePrefetcher::start() {
+	return _thread.start(threadProc, this);
+}
+
+Common::SeekableReadStream *ResourcePrefetcher::getStream(const ResourceSource *source) {
+	for (uint i = 0; i < _streams.size(); i++) {
+		if (_streams[i].source == source)
+			return _streams[i].stream;
+	}
+
+	// Files are opened here rather than on the worker, as looking them up
+	// isn't thread safe
+	VolumeStream volume;
+	volume.source = source;
+	if (source->_resourceFile) {
+		volume.stream = source->_resourceFile->createReadStream();
+	} else {
+		Common::File *file = new Common::File();
+		if (!file->open(source->getLocationName())) {
+			delete file;
+			file = NULL;
+		}
+		volume.stream = file;
+	}
+
+	// Remember failures too, so that they are not retried
+	_streams.push_back(volume);
+	return volume.stream;
+}
+
+void ResourcePrefetcher::queue(const Resource *res) {
+	Request request;
+	request.id = res->_id;
+	request.stream = getStream(res->_source);
+	request.offset = res->_fileOffset;
+	request.volVersion = _resMan->getVolVersion();
+
+	if (!request.stream)
+		return;
+
+	Common::NativeStackLock lock(_mutex);
+
+	if (_busy && _loading == request.id)
+		return;
+	for (Common::List<Request>::const_iterator it = _queue.begin(); it != _queue.end(); ++it) {
+		if (it->id == request.id)
+			return;
+	}
+	for (uint i = 0; i < _loaded.size(); i++) {
+		if (_loaded[i]->_id == request.id)
+			return;
+	}
+
+	_queue.push_back(request);
+	_queueCond.signal();
+}
+
+bool ResourcePrefetcher::wait(ResourceId id) {
+	Common::NativeStackLock lock(_mutex);
+
+	for (Common::List<Request>::iterator it = _queue.begin(); it != _queue.end(); ++it) {
+		if (it->id == id) {
+			// Not started yet, the caller is better off loading it itself
+			_queue.erase(it);
+			return false;
+		}
+	}
+
+	while (_busy && _loading == id)
+		_loadedCond.wait(_mutex);
+
+	for (uint i = 0; i < _loaded.size(); i++) {
+		if (_loaded[i]->_id == id)
+			return true;
+	}
+	return false;
+}
+
+void ResourcePrefetcher::takeLoaded(Common::Array<Resource *> &resources, Common::Array<Failure> &failures) {
+	Common::NativeStackLock lock(_mutex);
+	resources.push_back(_loaded);
+	_loaded.clear();
+	failures.push_back(_failures);
+	_failures.clear();
+}
+
+void ResourcePrefetcher::threadProc(void *data) {
+	((ResourcePrefetcher *)data)->run();
+}
+
+void ResourcePrefetcher::run() {
+	Common::NativeStackLock lock(_mutex);
+	while (!_stop) {
+		if (_queue.empty()) {
+			_queueCond.wait(_mutex);
+			continue;
+		}
+
+		const Request request = _queue.front();
+		_queue.pop_front();
+		_loading = request.id;
+		_busy = true;
+
+		// The stream is only used by requests, which are handled one at a
+		// time, so it can be read unlocked
+		_mutex.unlock();
+		Resource *res = new Resource(_resMan, request.id);
+		request.stream->seek(request.offset, SEEK_SET);
+		const int error = res->decompress(request.volVersion, request.stream);
+		if (error || res->_id != request.id) {
+			// Leave dealing with broken resources to loading them on the
+			// main thread
+			delete res;
+			res = NULL;
+		}
+		_mutex.lock();
+
+		if (res) {
+			_loaded.push_back(res);
+		} else if (error) {
+			Failure failure;
+			failure.id = request.id;
+			failure.error = error;
+			_failures.push_back(failure);
+		}
+		_busy = false;
+		_loadedCond.broadcast();
+	}
+}
+
+} // End of namespace Sci
@@ -983,6 +983,7 @@ bool ScummEngine::hasFeature(EngineFeature f) const {
 		(f == kSupportsRTL) ||
 		(f == kSupportsLoadingDuringRuntime) ||
 		(f == kSupportsSavingDuringRuntime) ||
+		(f == kSupportsSavingToStream) ||
 		(f == kSupportsSubtitleOptions);
 }
 
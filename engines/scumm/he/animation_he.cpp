@@ -41,9 +41,11 @@ namespace Scumm {
 
 MoviePlayer::MoviePlayer(ScummEngine_v90he *vm, Audio::Mixer *mixer) : _vm(vm) {
 #ifdef USE_BINK
-	if (_vm->_game.heversion >= 100 && (_vm->_game.features & GF_16BIT_COLOR))
-		_video = new Video::BinkDecoder();
-	else
+	if (_vm->_game.heversion >= 100 && (_vm->_game.features & GF_16BIT_COLOR)) {
+		Video::BinkDecoder *bink = new Video::BinkDecoder();
+		bink->setThreadedDecoding(Common::ThreadPool::getCPUCount() > 1);
+		_video = bink;
+	} else
 #endif
 		_video = new Video::SmackerDecoder();
 
@@ -23,6 +23,7 @@
 #include "common/config-manager.h"
 #include "common/memstream.h"
 #include "common/savefile.h"
+#include "common/substream.h"
 #include "common/system.h"
 #include "common/zlib.h"
 
@@ -137,8 +138,29 @@ bool ScummEngine::canSaveGameStateCurrently() {
 	return (VAR_MAINMENU_KEY == 0xFF || (VAR(VAR_MAINMENU_KEY) != 0 && _currentRoom != 0));
 }
 
+Common::Error ScummEngine::saveGameStream(Common::WriteStream *stream) {
+	// Backends may keep a state every frame, so leave out the header, the
+	// thumbnail and the infos of a savefile. Only the play time is kept.
+	// The engine state is serialized straight into the caller's stream.
+	stream->writeUint32BE(MKTAG('S','C','S','T'));
+	stream->writeUint32LE(getTotalPlayTime());
+
+	Serializer ser(0, stream, CURRENT_VER);
+	saveOrLoad(&ser);
+
+	if (stream->err())
+		return Common::kWritingFailed;
+	return Common::kNoError;
+}
+
+Common::Error ScummEngine::loadGameStream(Common::SeekableReadStream *stream) {
+	requestLoad(0);
+	_saveLoadStream = stream;
+	return Common::kNoError;
+}
 
 void ScummEngine::requestSave(int slot, const Common::String &name) {
+	_saveLoadStream = NULL;
 	_saveLoadSlot = slot;
 	_saveTemporaryState = false;
 	_saveLoadFlag = 1;		// 1 for save
@@ -146,6 +168,7 @@ void ScummEngine::requestSave(int slot, const Common::String &name) {
 }
 
 void ScummEngine::requestLoad(int slot) {
+	_saveLoadStream = NULL;
 	_saveLoadSlot = slot;
 	_saveTemporaryState = (slot == 100);
 	_saveLoadFlag = 2;		// 2 for load
@@ -317,17 +340,9 @@ bool ScummEngine::loadState(int slot, bool compat) {
 	return loadState(slot, compat, filename);
 }
 
-bool ScummEngine::loadState(int slot, bool compat, Common::String &filename) {
-	SaveGameHeader hdr;
-	int sb, sh;
-
-	Common::SeekableReadStream *in = openSaveFileForReading(slot, compat, filename);
-	if (!in)
-		return false;
-
+bool ScummEngine::loadStateHeader(Common::SeekableReadStream *in, SaveGameHeader &hdr, const Common::String &filename) {
 	if (!loadSaveGameHeader(in, hdr)) {
 		warning("Invalid savegame '%s'", filename.c_str());
-		delete in;
 		return false;
 	}
 
@@ -343,14 +358,12 @@ bool ScummEngine::loadState(int slot, bool compat, Common::String &filename) {
 	// information).
 	if (hdr.ver < VER(7) || hdr.ver > CURRENT_VER) {
 		warning("Invalid version of '%s'", filename.c_str());
-		delete in;
 		return false;
 	}
 
 	// We (deliberately) broke HE savegame compatibility at some point.
 	if (hdr.ver < VER(50) && _game.heversion >= 71) {
 		warning("Unsupported version of '%s'", filename.c_str());
-		delete in;
 		return false;
 	}
 
@@ -360,7 +373,6 @@ bool ScummEngine::loadState(int slot, bool compat, Common::String &filename) {
 		if (hdr.ver <= VER(74)) {
 			if (!Graphics::checkThumbnailHeader(*in)) {
 				warning("Can not load thumbnail");
-				delete in;
 				return false;
 			}
 		}
@@ -374,7 +386,6 @@ bool ScummEngine::loadState(int slot, bool compat, Common::String &filename) {
 		SaveStateMetaInfos infos;
 		if (!loadInfos(in, &infos)) {
 			warning("Info section could not be found");
-			delete in;
 			return false;
 		}
 
@@ -389,6 +400,41 @@ bool ScummEngine::loadState(int slot, bool compat, Common::String &filename) {
 	if (hdr.ver == VER(7))
 		hdr.ver = VER(8);
 
+	return true;
+}
+
+bool ScummEngine::loadState(int slot, bool compat, Common::String &filename) {
+	SaveGameHeader hdr;
+	int sb, sh;
+
+	Common::SeekableReadStream *in;
+	const bool fromStream = _saveLoadStream != NULL;
+	if (fromStream) {
+		// The stream passed to loadGameStream() stays owned by the caller
+		filename = makeSavegameName(slot, compat);
+		in = _saveLoadStream;
+		_saveLoadStream = NULL;
+
+		in->seek(0);
+		if (in->readUint32BE() != MKTAG('S','C','S','T')) {
+			warning("Invalid state stream");
+			return false;
+		}
+
+		hdr.ver = CURRENT_VER;
+		Common::strlcpy(hdr.name, _saveLoadDescription.c_str(), sizeof(hdr.name));
+		setTotalPlayTime(in->readUint32LE());
+	} else {
+		in = openSaveFileForReading(slot, compat, filename);
+		if (!in)
+			return false;
+
+		if (!loadStateHeader(in, hdr, filename)) {
+			delete in;
+			return false;
+		}
+	}
+
 	hdr.name[sizeof(hdr.name)-1] = 0;
 	_saveLoadDescription = hdr.name;
 
@@ -444,7 +490,8 @@ bool ScummEngine::loadState(int slot, bool compat, Common::String &filename) {
 	//
 	Serializer ser(in, 0, hdr.ver);
 	saveOrLoad(&ser);
-	delete in;
+	if (!fromStream)
+		delete in;
 
 	// Update volume settings
 	syncSoundSettings();
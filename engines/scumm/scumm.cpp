@@ -219,6 +219,7 @@ ScummEngine::ScummEngine(OSystem *syst, const DetectorResult &dr)
 	_resourceHeaderSize = 8;
 	_saveLoadFlag = 0;
 	_saveLoadSlot = 0;
+	_saveLoadStream = NULL;
 	_lastSaveTime = 0;
 	_saveTemporaryState = false;
 	memset(_localScriptOffsets, 0, sizeof(_localScriptOffsets));
@@ -94,6 +94,7 @@ class Sound;
 struct Box;
 struct BoxCoords;
 struct FindObjectInRoom;
+struct SaveGameHeader;
 
 // Use g_scumm from error() ONLY
 extern ScummEngine *g_scumm;
@@ -436,6 +437,8 @@ public:
 	virtual bool canLoadGameStateCurrently();
 	virtual Common::Error saveGameState(int slot, const Common::String &desc);
 	virtual bool canSaveGameStateCurrently();
+	virtual Common::Error saveGameStream(Common::WriteStream *stream);
+	virtual Common::Error loadGameStream(Common::SeekableReadStream *stream);
 
 	virtual void pauseEngineIntern(bool pause);
 
@@ -602,11 +605,13 @@ protected:
 	bool _saveTemporaryState;
 	Common::String _saveLoadFileName;
 	Common::String _saveLoadDescription;
+	Common::SeekableReadStream *_saveLoadStream;	// State to load instead of a savefile, see loadGameStream()
 
 	bool saveState(Common::WriteStream *out, bool writeHeader = true);
 	bool saveState(int slot, bool compat, Common::String &fileName);
 	bool loadState(int slot, bool compat);
 	bool loadState(int slot, bool compat, Common::String &fileName);
+	bool loadStateHeader(Common::SeekableReadStream *in, SaveGameHeader &hdr, const Common::String &fileName);
 	virtual void saveOrLoad(Serializer *s);
 	void saveResource(Serializer *ser, ResType type, ResId idx);
 	void loadResource(Serializer *ser, ResType type, ResId idx);
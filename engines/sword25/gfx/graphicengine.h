@@ -46,6 +46,7 @@
 #include "common/ptr.h"
 #include "common/str.h"
 #include "graphics/surface.h"
+#include "graphics/transformed_surface_cache.h"
 #include "sword25/kernel/common.h"
 #include "sword25/kernel/resservice.h"
 #include "sword25/kernel/persistable.h"
@@ -232,6 +233,9 @@ public:
 	Graphics::Surface _backSurface;
 	Graphics::Surface *getSurface() { return &_backSurface; }
 
+	/** Scaled copies of the images drawn, see RenderedImage::blit() */
+	Graphics::TransformedSurfaceCache *getTransformCache() { return &_transformCache; }
+
 	Common::SeekableReadStream *_thumbnail;
 	Common::SeekableReadStream *getThumbnail() { return _thumbnail; }
 
@@ -310,6 +314,10 @@ private:
 	uint _frameTimeSampleSlot;
 
 private:
+	// Declared before the render objects, so that it outlives the images
+	// they own
+	Graphics::TransformedSurfaceCache _transformCache;
+
 	RenderObjectPtr<Panel> _mainPanelPtr;
 
 	Common::ScopedPtr<RenderObjectManager> _renderObjectManagerPtr;
@@ -178,6 +178,8 @@ RenderedImage::RenderedImage() : _isTransparent(true) {
 // -----------------------------------------------------------------------------
 
 RenderedImage::~RenderedImage() {
+	invalidateTransformCache();
+
 	if (_doCleanup) {
 		_surface.free();
 	}
@@ -199,6 +201,8 @@ bool RenderedImage::setContent(const byte *pixeldata, uint size, uint offset, ui
 		return false;
 	}
 
+	invalidateTransformCache();
+
 	const byte *in = &pixeldata[offset];
 	byte *out = (byte *)_surface.getPixels();
 
@@ -212,6 +216,7 @@ bool RenderedImage::setContent(const byte *pixeldata, uint size, uint offset, ui
 }
 
 void RenderedImage::replaceContent(byte *pixeldata, int width, int height) {
+	invalidateTransformCache();
 	_surface.w = width;
 	_surface.h = height;
 	_surface.pitch = width * 4;
@@ -227,7 +232,9 @@ uint RenderedImage::getPixel(int x, int y) {
 // -----------------------------------------------------------------------------
 
 bool RenderedImage::blit(int posX, int posY, int flipping, Common::Rect *pPartRect, uint color, int width, int height, RectangleList *updateRects) {
-	_surface.blit(*_backSurface, posX, posY, (((flipping & 1) ? Graphics::FLIP_V : 0) | ((flipping & 2) ? Graphics::FLIP_H : 0)), pPartRect, color, width, height);
+	// Scaled images are usually drawn at the same size for many frames
+	_surface.blit(*_backSurface, posX, posY, (((flipping & 1) ? Graphics::FLIP_V : 0) | ((flipping & 2) ? Graphics::FLIP_H : 0)), pPartRect, color, width, height,
+	              Graphics::BLEND_NORMAL, Kernel::getInstance()->getGfx()->getTransformCache());
 
 	return true;
 }
@@ -256,6 +263,18 @@ void RenderedImage::copyDirectly(int posX, int posY) {
 	g_system->copyRectToScreen(data, _backSurface->pitch, posX, posY, w, h);
 }
 
+// -----------------------------------------------------------------------------
+
+void RenderedImage::invalidateTransformCache() {
+	// The graphics engine is gone when the remaining resources are freed
+	// on shutdown
+	GraphicEngine *gfx = Kernel::getInstance()->getGfx();
+	if (gfx)
+		gfx->getTransformCache()->invalidate(_surface);
+}
+
+// -----------------------------------------------------------------------------
+
 void RenderedImage::checkForTransparency() {
 	// Check if the source bitmap has any transparent pixels at all
 	_isTransparent = false;
@@ -119,6 +119,8 @@ private:
 	Graphics::Surface *_backSurface;
 
 	void checkForTransparency();
+	/** Drop the scaled copies of the image, before its pixels change */
+	void invalidateTransformCache();
 };
 
 } // End of namespace Sword25
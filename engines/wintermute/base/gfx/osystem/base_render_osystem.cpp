@@ -57,7 +57,6 @@ BaseRenderOSystem::BaseRenderOSystem(BaseGame *inGame) : BaseRenderer(inGame) {
 
 	_borderLeft = _borderRight = _borderTop = _borderBottom = 0;
 	_ratioX = _ratioY = 1.0f;
-	_dirtyRect = nullptr;
 	_disableDirtyRects = false;
 	if (ConfMan.hasKey("dirty_rects")) {
 		_disableDirtyRects = !ConfMan.getBool("dirty_rects");
@@ -70,13 +69,9 @@ BaseRenderOSystem::BaseRenderOSystem(BaseGame *inGame) : BaseRenderer(inGame) {
 BaseRenderOSystem::~BaseRenderOSystem() {
 	RenderQueueIterator it = _renderQueue.begin();
 	while (it != _renderQueue.end()) {
-		RenderTicket *ticket = *it;
-		it = _renderQueue.erase(it);
-		delete ticket;
+		it = deleteTicket(it);
 	}
 
-	delete _dirtyRect;
-
 	_renderSurface->free();
 	delete _renderSurface;
 	_blankSurface->free();
@@ -154,8 +149,7 @@ bool BaseRenderOSystem::indicatorFlip() {
 bool BaseRenderOSystem::flip() {
 	if (_skipThisFrame) {
 		_skipThisFrame = false;
-		delete _dirtyRect;
-		_dirtyRect = nullptr;
+		_dirtyRects.reset();
 		g_system->updateScreen();
 		_needsFlip = false;
 
@@ -176,9 +170,7 @@ bool BaseRenderOSystem::flip() {
 		RenderQueueIterator it = _renderQueue.begin();
 		while (it != _renderQueue.end()) {
 			if ((*it)->_wantsDraw == false) {
-				RenderTicket *ticket = *it;
-				it = _renderQueue.erase(it);
-				delete ticket;
+				it = deleteTicket(it);
 			} else {
 				(*it)->_wantsDraw = false;
 				++it;
@@ -194,9 +186,7 @@ bool BaseRenderOSystem::flip() {
 		if (_disableDirtyRects || screenChanged) {
 			g_system->copyRectToScreen((byte *)_renderSurface->getPixels(), _renderSurface->pitch, 0, 0, _renderSurface->w, _renderSurface->h);
 		}
-		//  g_system->copyRectToScreen((byte *)_renderSurface->getPixels(), _renderSurface->pitch, _dirtyRect->left, _dirtyRect->top, _dirtyRect->width(), _dirtyRect->height());
-		delete _dirtyRect;
-		_dirtyRect = nullptr;
+		_dirtyRects.reset();
 		_needsFlip = false;
 	}
 	_lastFrameIter = _renderQueue.end();
@@ -271,9 +261,9 @@ Graphics::PixelFormat BaseRenderOSystem::getPixelFormat() const {
 void BaseRenderOSystem::drawSurface(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, Graphics::TransformStruct &transform) {
 
 	if (_disableDirtyRects) {
-		RenderTicket *ticket = new RenderTicket(owner, surf, srcRect, dstRect, transform);
+		RenderTicket *ticket = createTicket(owner, surf, srcRect, dstRect, transform);
 		ticket->_wantsDraw = true;
-		_renderQueue.push_back(ticket);
+		queueTicket(_renderQueue.end(), ticket);
 		drawFromSurface(ticket);
 		return;
 	}
@@ -284,33 +274,80 @@ void BaseRenderOSystem::drawSurface(BaseSurfaceOSystem *owner, const Graphics::S
 	}
 
 	if (owner) { // Fade-tickets are owner-less
-		RenderTicket compare(owner, nullptr, srcRect, dstRect, transform);
-		RenderQueueIterator it = _lastFrameIter;
-		++it;
-		// Avoid calling end() and operator* every time, when potentially going through
-		// LOTS of tickets.
-		RenderQueueIterator endIterator = _renderQueue.end();
-		RenderTicket *compareTicket = nullptr;
-		for (; it != endIterator; ++it) {
-			compareTicket = *it;
-			if (*(compareTicket) == compare && compareTicket->_isValid) {
-				if (_disableDirtyRects) {
-					drawFromSurface(compareTicket);
-				} else {
-					drawFromQueuedTicket(it);
-				}
-				return;
-			}
+		RenderTicket *compareTicket = findReusableTicket(owner, *srcRect, *dstRect, transform);
+		if (compareTicket) {
+			RenderQueueIterator it = compareTicket->_queuePosition;
+			drawFromQueuedTicket(it);
+			return;
 		}
 	}
-	RenderTicket *ticket = new RenderTicket(owner, surf, srcRect, dstRect, transform);
-	if (!_disableDirtyRects) {
-		drawFromTicket(ticket);
-	} else {
-		ticket->_wantsDraw = true;
-		_renderQueue.push_back(ticket);
-		drawFromSurface(ticket);
+	RenderTicket *ticket = createTicket(owner, surf, srcRect, dstRect, transform);
+	drawFromTicket(ticket);
+}
+
+RenderTicket *BaseRenderOSystem::createTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, Graphics::TransformStruct &transform) {
+	// Fade-tickets are drawn from temporary surfaces
+	RenderTicket *ticket = new (_ticketPool) RenderTicket(owner, surf, srcRect, dstRect, transform, owner ? &_transformCache : nullptr);
+
+	RenderTicket *&first = _ticketsByKey[ticket->getKey()];
+	ticket->_nextWithKey = first;
+	first = ticket;
+
+	return ticket;
+}
+
+void BaseRenderOSystem::queueTicket(const RenderQueueIterator &pos, RenderTicket *renderTicket) {
+	_renderQueue.insert(pos, renderTicket);
+	renderTicket->_queuePosition = pos;
+	--renderTicket->_queuePosition;
+}
+
+BaseRenderOSystem::RenderQueueIterator BaseRenderOSystem::deleteTicket(const RenderQueueIterator &ticket) {
+	RenderTicket *renderTicket = *ticket;
+
+	TicketMap::iterator i = _ticketsByKey.find(renderTicket->getKey());
+	assert(i != _ticketsByKey.end());
+	RenderTicket **link = &i->_value;
+	while (*link != renderTicket) {
+		link = &(*link)->_nextWithKey;
+	}
+	*link = renderTicket->_nextWithKey;
+	if (!i->_value) {
+		_ticketsByKey.erase(i);
+	}
+
+	RenderQueueIterator next = _renderQueue.erase(ticket);
+	_ticketPool.deleteChunk(renderTicket);
+	return next;
+}
+
+RenderTicket *BaseRenderOSystem::findReusableTicket(BaseSurfaceOSystem *owner, const Common::Rect &srcRect, const Common::Rect &dstRect, const Graphics::TransformStruct &transform) {
+	RenderTicketKey key(owner, srcRect, dstRect);
+
+	// Usually things are drawn in the same order as in the last frame, so the
+	// next ticket is the one.
+	RenderQueueIterator next = _lastFrameIter;
+	++next;
+	if (next != _renderQueue.end()) {
+		RenderTicket *ticket = *next;
+		if (ticket->_isValid && !ticket->_wantsDraw && ticket->_transform == transform && ticket->getKey() == key) {
+			return ticket;
+		}
+	}
+
+	// Tickets already drawn in this frame come before _lastFrameIter, the
+	// others after it, so !_wantsDraw finds the same tickets as searching
+	// the queue from there would.
+	TicketMap::const_iterator i = _ticketsByKey.find(key);
+	if (i == _ticketsByKey.end()) {
+		return nullptr;
 	}
+	for (RenderTicket *ticket = i->_value; ticket; ticket = ticket->_nextWithKey) {
+		if (ticket->_isValid && !ticket->_wantsDraw && ticket->_transform == transform) {
+			return ticket;
+		}
+	}
+	return nullptr;
 }
 
 void BaseRenderOSystem::invalidateTicket(RenderTicket *renderTicket) {
@@ -328,6 +365,10 @@ void BaseRenderOSystem::invalidateTicketsFromSurface(BaseSurfaceOSystem *surf) {
 	}
 }
 
+void BaseRenderOSystem::invalidateTransformedSurfaces(const Graphics::Surface &surface) {
+	_transformCache.invalidate(surface);
+}
+
 void BaseRenderOSystem::drawFromTicket(RenderTicket *renderTicket) {
 	renderTicket->_wantsDraw = true;
 
@@ -335,13 +376,13 @@ void BaseRenderOSystem::drawFromTicket(RenderTicket *renderTicket) {
 	// In-order
 	if (_renderQueue.empty() || _lastFrameIter == _renderQueue.end()) {
 		_lastFrameIter--;
-		_renderQueue.push_back(renderTicket);
+		queueTicket(_renderQueue.end(), renderTicket);
 		++_lastFrameIter;
 		addDirtyRect(renderTicket->_dstRect);
 	} else {
 		// Before something
 		RenderQueueIterator pos = _lastFrameIter;
-		_renderQueue.insert(pos, renderTicket);
+		queueTicket(pos, renderTicket);
 		--_lastFrameIter;
 		addDirtyRect(renderTicket->_dstRect);
 	}
@@ -355,22 +396,30 @@ void BaseRenderOSystem::drawFromQueuedTicket(const RenderQueueIterator &ticket)
 	++_lastFrameIter;
 	// Not in the same order?
 	if (*_lastFrameIter != renderTicket) {
+		RenderQueueIterator pos = _lastFrameIter;
 		--_lastFrameIter;
+		// Moving the ticket in front of the ones queued before it only
+		// changes the picture where it overlaps them. Typically they are
+		// the tickets of things that moved or went away.
+		bool overlaps = false;
+		for (RenderQueueIterator it = pos; it != ticket && !overlaps; ++it) {
+			overlaps = (*it)->_dstRect.intersects(renderTicket->_dstRect);
+		}
 		// Remove the ticket from the list
 		assert(*_lastFrameIter != renderTicket);
 		_renderQueue.erase(ticket);
-		// Is not in order, so readd it as if it was a new ticket
-		drawFromTicket(renderTicket);
+		if (overlaps) {
+			// Is not in order, so readd it as if it was a new ticket
+			drawFromTicket(renderTicket);
+		} else {
+			queueTicket(pos, renderTicket);
+			_lastFrameIter = renderTicket->_queuePosition;
+		}
 	}
 }
 
 void BaseRenderOSystem::addDirtyRect(const Common::Rect &rect) {
-	if (!_dirtyRect) {
-		_dirtyRect = new Common::Rect(rect);
-	} else {
-		_dirtyRect->extend(rect);
-	}
-	_dirtyRect->clip(_renderRect);
+	_dirtyRects.addDirtyRect(rect, _renderRect);
 }
 
 void BaseRenderOSystem::drawTickets() {
@@ -381,15 +430,13 @@ void BaseRenderOSystem::drawTickets() {
 	// we have a copy of their data, so their invalidness won't affect us.
 	while (it != _renderQueue.end()) {
 		if ((*it)->_wantsDraw == false) {
-			RenderTicket *ticket = *it;
 			addDirtyRect((*it)->_dstRect);
-			it = _renderQueue.erase(it);
-			delete ticket;
+			it = deleteTicket(it);
 		} else {
 			++it;
 		}
 	}
-	if (!_dirtyRect || _dirtyRect->width() == 0 || _dirtyRect->height() == 0) {
+	if (_dirtyRects.isEmpty()) {
 		it = _renderQueue.begin();
 		while (it != _renderQueue.end()) {
 			RenderTicket *ticket = *it;
@@ -399,52 +446,61 @@ void BaseRenderOSystem::drawTickets() {
 		return;
 	}
 
-	it = _renderQueue.begin();
 	_lastFrameIter = _renderQueue.end();
-	// A special case: If the screen has one giant OPAQUE rect to be drawn, then we skip filling
-	// the background color. Typical use-case: Fullscreen FMVs.
-	// Caveat: The FPS-counter will invalidate this.
-	if (it != _lastFrameIter && _renderQueue.front() == _renderQueue.back() && (*it)->_transform._alphaDisable == true) {
-		// If our single opaque rect fills the dirty rect, we can skip filling.
-		if (*_dirtyRect != (*it)->_dstRect) {
+
+	// Redraw and copy each dirty rect on its own, so that changes in distant
+	// parts of the screen don't redraw everything between them.
+	const Common::Array<Common::Rect> &dirtyRects = _dirtyRects.getOptimized();
+	for (uint i = 0; i < dirtyRects.size(); i++) {
+		const Common::Rect &dirtyRect = dirtyRects[i];
+
+		it = _renderQueue.begin();
+		// A special case: If the screen has one giant OPAQUE rect to be drawn, then we skip filling
+		// the background color. Typical use-case: Fullscreen FMVs.
+		// Caveat: The FPS-counter will invalidate this.
+		if (it != _lastFrameIter && _renderQueue.front() == _renderQueue.back() && (*it)->_transform._alphaDisable == true) {
+			// If our single opaque rect covers the dirty rect, we can skip filling.
+			if (!(*it)->_dstRect.contains(dirtyRect)) {
+				// Apply the clear-color to the dirty rect.
+				_renderSurface->fillRect(dirtyRect, _clearColor);
+			}
+			// Otherwise Do NOT fill.
+		} else {
 			// Apply the clear-color to the dirty rect.
-			_renderSurface->fillRect(*_dirtyRect, _clearColor);
+			_renderSurface->fillRect(dirtyRect, _clearColor);
 		}
-		// Otherwise Do NOT fill.
-	} else {
-		// Apply the clear-color to the dirty rect.
-		_renderSurface->fillRect(*_dirtyRect, _clearColor);
-	}
-	for (; it != _renderQueue.end(); ++it) {
-		RenderTicket *ticket = *it;
-		if (ticket->_dstRect.intersects(*_dirtyRect)) {
-			// dstClip is the area we want redrawn.
-			Common::Rect dstClip(ticket->_dstRect);
-			// reduce it to the dirty rect
-			dstClip.clip(*_dirtyRect);
-			// we need to keep track of the position to redraw the dirty rect
-			Common::Rect pos(dstClip);
-			int16 offsetX = ticket->_dstRect.left;
-			int16 offsetY = ticket->_dstRect.top;
-			// convert from screen-coords to surface-coords.
-			dstClip.translate(-offsetX, -offsetY);
-
-			drawFromSurface(ticket, &pos, &dstClip);
-			_needsFlip = true;
+		for (; it != _renderQueue.end(); ++it) {
+			RenderTicket *ticket = *it;
+			if (ticket->_dstRect.intersects(dirtyRect)) {
+				// dstClip is the area we want redrawn.
+				Common::Rect dstClip(ticket->_dstRect);
+				// reduce it to the dirty rect
+				dstClip.clip(dirtyRect);
+				// we need to keep track of the position to redraw the dirty rect
+				Common::Rect pos(dstClip);
+				int16 offsetX = ticket->_dstRect.left;
+				int16 offsetY = ticket->_dstRect.top;
+				// convert from screen-coords to surface-coords.
+				dstClip.translate(-offsetX, -offsetY);
+
+				drawFromSurface(ticket, &pos, &dstClip);
+				_needsFlip = true;
+			}
 		}
-		// Some tickets want redraw but don't actually clip the dirty area (typically the ones that shouldnt become clear-color)
-		ticket->_wantsDraw = false;
+		g_system->copyRectToScreen((byte *)_renderSurface->getBasePtr(dirtyRect.left, dirtyRect.top), _renderSurface->pitch, dirtyRect.left, dirtyRect.top, dirtyRect.width(), dirtyRect.height());
+	}
+
+	// Some tickets want redraw but don't actually clip the dirty area (typically the ones that shouldnt become clear-color)
+	for (it = _renderQueue.begin(); it != _renderQueue.end(); ++it) {
+		(*it)->_wantsDraw = false;
 	}
-	g_system->copyRectToScreen((byte *)_renderSurface->getBasePtr(_dirtyRect->left, _dirtyRect->top), _renderSurface->pitch, _dirtyRect->left, _dirtyRect->top, _dirtyRect->width(), _dirtyRect->height());
 
 	it = _renderQueue.begin();
 	// Clean out the old tickets
 	while (it != _renderQueue.end()) {
 		if ((*it)->_isValid == false) {
-			RenderTicket *ticket = *it;
 			addDirtyRect((*it)->_dstRect);
-			it = _renderQueue.erase(it);
-			delete ticket;
+			it = deleteTicket(it);
 		} else {
 			++it;
 		}
@@ -567,9 +623,7 @@ void BaseRenderOSystem::endSaveLoad() {
 	// Clear the scale-buffered tickets as we just loaded.
 	RenderQueueIterator it = _renderQueue.begin();
 	while (it != _renderQueue.end()) {
-		RenderTicket *ticket = *it;
-		it = _renderQueue.erase(it);
-		delete ticket;
+		it = deleteTicket(it);
 	}
 	// HACK: After a save the buffer will be drawn before the scripts get to update it,
 	// so just skip this single frame.
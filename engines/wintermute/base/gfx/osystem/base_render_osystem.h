@@ -30,9 +30,13 @@
 #define WINTERMUTE_BASE_RENDERER_SDL_H
 
 #include "engines/wintermute/base/gfx/base_renderer.h"
+#include "engines/wintermute/base/gfx/osystem/dirty_rect_container.h"
+#include "engines/wintermute/base/gfx/osystem/render_ticket.h"
 #include "common/rect.h"
 #include "graphics/surface.h"
+#include "common/hashmap.h"
 #include "common/list.h"
+#include "common/memorypool.h"
 #include "graphics/transform_struct.h"
 
 namespace Wintermute {
@@ -80,6 +84,11 @@ public:
 
 	void invalidateTicket(RenderTicket *renderTicket);
 	void invalidateTicketsFromSurface(BaseSurfaceOSystem *surf);
+	/**
+	 * Forget the scaled and rotated copies made of the pixels of a surface,
+	 * before the pixels change or are freed.
+	 */
+	void invalidateTransformedSurfaces(const Graphics::Surface &surface);
 	/**
 	 * Insert a new ticket into the queue, adding a dirty rect
 	 * @param renderTicket the ticket to be added.
@@ -87,7 +96,7 @@ public:
 	void drawFromTicket(RenderTicket *renderTicket);
 	/**
 	 * Re-insert an existing ticket into the queue, adding a dirty rect
-	 * out-of-order from last draw from the ticket.
+	 * if it is drawn out-of-order over tickets it overlaps.
 	 * @param ticket iterator pointing to the ticket to be added.
 	 */
 	void drawFromQueuedTicket(const RenderQueueIterator &ticket);
@@ -122,12 +131,42 @@ private:
 	 * Traverse the tickets that are dirty, and draw them
 	 */
 	void drawTickets();
+	/**
+	 * Create a ticket in the ticket pool. It still has to be added to the
+	 * queue.
+	 */
+	RenderTicket *createTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, Graphics::TransformStruct &transform);
+	/**
+	 * Add a ticket to the queue.
+	 * @param pos the ticket to insert the new one before
+	 * @param renderTicket the ticket to be added.
+	 */
+	void queueTicket(const RenderQueueIterator &pos, RenderTicket *renderTicket);
+	/**
+	 * Remove a ticket from the queue and return it to the ticket pool.
+	 * @return the position of the next ticket in the queue
+	 */
+	RenderQueueIterator deleteTicket(const RenderQueueIterator &ticket);
+	/**
+	 * Find a ticket of the previous frame which draws the same, and hasn't
+	 * been drawn again in this frame yet.
+	 */
+	RenderTicket *findReusableTicket(BaseSurfaceOSystem *owner, const Common::Rect &srcRect, const Common::Rect &dstRect, const Graphics::TransformStruct &transform);
 	// Non-dirty-rects:
 	void drawFromSurface(RenderTicket *ticket);
 	// Dirty-rects:
 	void drawFromSurface(RenderTicket *ticket, Common::Rect *dstRect, Common::Rect *clipRect);
-	Common::Rect *_dirtyRect;
+	DirtyRectContainer _dirtyRects;
 	Common::List<RenderTicket *> _renderQueue;
+	Common::ObjectPool<RenderTicket> _ticketPool;
+	typedef Common::HashMap<RenderTicketKey, RenderTicket *, RenderTicketKey_Hash> TicketMap;
+	/**
+	 * The most recently created queued ticket for each key, the others are
+	 * chained through RenderTicket::_nextWithKey.
+	 */
+	TicketMap _ticketsByKey;
+	/** Scaled and rotated copies of the parts of surfaces drawn */
+	Graphics::TransformedSurfaceCache _transformCache;
 
 	bool _needsFlip;
 	RenderQueueIterator _lastFrameIter;
@@ -0,0 +1,110 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "engines/wintermute/base/gfx/osystem/dirty_rect_container.h"
+
+namespace Wintermute {
+
+static uint64 area(const Common::Rect &rect) {
+	return (uint64)rect.width() * rect.height();
+}
+
+DirtyRectContainer::DirtyRectContainer() : _optimized(true) {
+}
+
+void DirtyRectContainer::addDirtyRect(const Common::Rect &rect, const Common::Rect &clipRect) {
+	Common::Rect clipped(rect);
+	clipped.clip(clipRect);
+
+	if (clipped.isEmpty()) {
+		return;
+	}
+
+	for (uint i = 0; i < _rects.size(); i++) {
+		if (_rects[i].contains(clipped)) {
+			return;
+		}
+	}
+
+	_rects.push_back(clipped);
+	_optimized = false;
+
+	if (_rects.size() > kMaxRects) {
+		getOptimized();
+
+		// Still too many separate changes, give up on keeping them apart
+		if (_rects.size() > kMaxRects) {
+			for (uint i = 1; i < _rects.size(); i++) {
+				_rects[0].extend(_rects[i]);
+			}
+			_rects.resize(1);
+		}
+	}
+}
+
+void DirtyRectContainer::reset() {
+	_rects.clear();
+	_optimized = true;
+}
+
+const Common::Array<Common::Rect> &DirtyRectContainer::getOptimized() {
+	if (_optimized) {
+		return _rects;
+	}
+
+	// Merging two rects may make the result worth merging with another one,
+	// so keep going until nothing changes.
+	bool merged = true;
+	while (merged) {
+		merged = false;
+		for (uint i = 0; i < _rects.size(); i++) {
+			for (uint j = i + 1; j < _rects.size();) {
+				if (shouldMerge(_rects[i], _rects[j])) {
+					_rects[i].extend(_rects[j]);
+					_rects.remove_at(j);
+					merged = true;
+				} else {
+					j++;
+				}
+			}
+		}
+	}
+
+	_optimized = true;
+	return _rects;
+}
+
+bool DirtyRectContainer::shouldMerge(const Common::Rect &a, const Common::Rect &b) {
+	Common::Rect bounds(a);
+	bounds.extend(b);
+
+	uint64 covered = area(a) + area(b);
+	if (a.intersects(b)) {
+		Common::Rect intersection(a);
+		intersection.clip(b);
+		covered -= area(intersection);
+	}
+
+	return area(bounds) * 100 <= covered * (100 + kMaxOverdraw);
+}
+
+} // End of namespace Wintermute
@@ -0,0 +1,79 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef WINTERMUTE_DIRTY_RECT_CONTAINER_H
+#define WINTERMUTE_DIRTY_RECT_CONTAINER_H
+
+#include "common/array.h"
+#include "common/rect.h"
+
+namespace Wintermute {
+
+/**
+ * The regions of the screen that need to be redrawn in a frame.
+ *
+ * Rects that overlap or lie close to each other are merged, as long as the
+ * merged rect doesn't cover much more than the rects themselves, so that
+ * changes in distant parts of the screen are redrawn separately instead of
+ * redrawing everything between them.
+ */
+class DirtyRectContainer {
+public:
+	DirtyRectContainer();
+
+	/**
+	 * Add a rect to the region.
+	 * @param rect the rect to add
+	 * @param clipRect the area of the screen the rect is clipped to
+	 */
+	void addDirtyRect(const Common::Rect &rect, const Common::Rect &clipRect);
+
+	/** Empty the region */
+	void reset();
+
+	bool isEmpty() const { return _rects.empty(); }
+
+	/**
+	 * Return the rects making up the region, merged where redrawing the
+	 * merged rect is cheaper than redrawing the rects separately.
+	 */
+	const Common::Array<Common::Rect> &getOptimized();
+
+private:
+	/**
+	 * How many more pixels than the merged rects cover a merged rect may
+	 * contain, as a percentage.
+	 */
+	static const int kMaxOverdraw = 25;
+	/** Any more rects are merged into their bounding rect */
+	static const uint kMaxRects = 32;
+
+	/** Whether redrawing the bounding rect of a and b is worth it */
+	static bool shouldMerge(const Common::Rect &a, const Common::Rect &b);
+
+	Common::Array<Common::Rect> _rects;
+	bool _optimized;
+};
+
+} // End of namespace Wintermute
+
+#endif
@@ -34,14 +34,37 @@
 
 namespace Wintermute {
 
-RenderTicket::RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, Graphics::TransformStruct transform) :
+RenderTicket::RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRect, Graphics::TransformStruct transform, Graphics::TransformedSurfaceCache *cache) :
 	_owner(owner),
 	_srcRect(*srcRect),
 	_dstRect(*dstRect),
 	_isValid(true),
 	_wantsDraw(true),
-	_transform(transform) {
+	_transform(transform),
+	_nextWithKey(nullptr) {
 	if (surf) {
+		// NB: The numTimesX/numTimesY properties don't yet mix well with
+		// scaling and rotation, but there is no need for that functionality at
+		// the moment.
+		// NB: Mirroring and rotation are probably done in the wrong order.
+		// (Mirroring should most likely be done before rotation. See also
+		// TransformTools.)
+		const bool rotate = _transform._angle != Graphics::kDefaultAngle;
+		const bool scale = !rotate &&
+		                   (dstRect->width() != srcRect->width() || dstRect->height() != srcRect->height()) &&
+		                   _transform._numTimesX * _transform._numTimesY == 1;
+
+		if (cache && (rotate || scale)) {
+			// Sprites are often drawn with the same zoom and rotation for
+			// many frames, while they move around or their tickets are
+			// replaced, so the transformed pixels are kept in the cache.
+			const Graphics::TransparentSurface src(surf->getSubArea(*srcRect));
+			const Graphics::TransparentSurface *temp = rotate ? cache->rotoscale(src, transform) : cache->scale(src, dstRect->width(), dstRect->height());
+			_surface = new Graphics::Surface();
+			_surface->copyFrom(*temp);
+			return;
+		}
+
 		_surface = new Graphics::Surface();
 		_surface->create((uint16)srcRect->width(), (uint16)srcRect->height(), surf->format);
 		assert(_surface->format.bytesPerPixel == 4);
@@ -50,22 +73,13 @@ RenderTicket::RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *s
 			memcpy(_surface->getBasePtr(0, i), surf->getBasePtr(srcRect->left, srcRect->top + i), srcRect->width() * _surface->format.bytesPerPixel);
 		}
 		// Then scale it if necessary
-		//
-		// NB: The numTimesX/numTimesY properties don't yet mix well with
-		// scaling and rotation, but there is no need for that functionality at
-		// the moment.
-		// NB: Mirroring and rotation are probably done in the wrong order.
-		// (Mirroring should most likely be done before rotation. See also
-		// TransformTools.)
-		if (_transform._angle != Graphics::kDefaultAngle) {
+		if (rotate) {
 			Graphics::TransparentSurface src(*_surface, false);
 			Graphics::Surface *temp = src.rotoscale(transform);
 			_surface->free();
 			delete _surface;
 			_surface = temp;
-		} else if ((dstRect->width() != srcRect->width() ||
-					dstRect->height() != srcRect->height()) &&
-					_transform._numTimesX * _transform._numTimesY == 1) {
+		} else if (scale) {
 			Graphics::TransparentSurface src(*_surface, false);
 			Graphics::Surface *temp = src.scale(dstRect->width(), dstRect->height());
 			_surface->free();
@@ -84,6 +98,18 @@ RenderTicket::~RenderTicket() {
 	}
 }
 
+uint RenderTicketKey_Hash::operator()(const RenderTicketKey &key) const {
+	uint hash = (uint)(size_t)key._owner;
+	const Common::Rect *rects[] = { &key._srcRect, &key._dstRect };
+	for (int i = 0; i < ARRAYSIZE(rects); i++) {
+		hash = hash * 31 + (uint)rects[i]->left;
+		hash = hash * 31 + (uint)rects[i]->top;
+		hash = hash * 31 + (uint)rects[i]->right;
+		hash = hash * 31 + (uint)rects[i]->bottom;
+	}
+	return hash;
+}
+
 bool RenderTicket::operator==(const RenderTicket &t) const {
 	if ((t._owner != _owner) ||
 		(t._transform != _transform)  ||
@@ -30,12 +30,36 @@
 #define WINTERMUTE_RENDER_TICKET_H
 
 #include "graphics/transparent_surface.h"
+#include "graphics/transformed_surface_cache.h"
 #include "graphics/surface.h"
+#include "common/list.h"
 #include "common/rect.h"
 
 namespace Wintermute {
 
 class BaseSurfaceOSystem;
+
+/**
+ * What a ticket draws where, besides its transform. Tickets of consecutive
+ * frames with the same key and transform draw the same pixels.
+ */
+struct RenderTicketKey {
+	RenderTicketKey(BaseSurfaceOSystem *owner, const Common::Rect &srcRect, const Common::Rect &dstRect) :
+		_owner(owner), _srcRect(srcRect), _dstRect(dstRect) {}
+
+	BaseSurfaceOSystem *_owner;
+	Common::Rect _srcRect;
+	Common::Rect _dstRect;
+
+	bool operator==(const RenderTicketKey &key) const {
+		return _owner == key._owner && _srcRect == key._srcRect && _dstRect == key._dstRect;
+	}
+};
+
+struct RenderTicketKey_Hash {
+	uint operator()(const RenderTicketKey &key) const;
+};
+
 /**
  * A single RenderTicket.
  * A render ticket is a collection of the data and draw specifications made
@@ -51,8 +75,12 @@ class BaseSurfaceOSystem;
  */
 class RenderTicket {
 public:
-	RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRest, Graphics::TransformStruct transform);
-	RenderTicket() : _isValid(true), _wantsDraw(false), _transform(Graphics::TransformStruct()) {}
+	/**
+	 * @param cache where to take scaled and rotated copies of the surface
+	 *              from, or 0 to always scale and rotate
+	 */
+	RenderTicket(BaseSurfaceOSystem *owner, const Graphics::Surface *surf, Common::Rect *srcRect, Common::Rect *dstRest, Graphics::TransformStruct transform, Graphics::TransformedSurfaceCache *cache = nullptr);
+	RenderTicket() : _isValid(true), _wantsDraw(false), _transform(Graphics::TransformStruct()), _nextWithKey(nullptr) {}
 	~RenderTicket();
 	const Graphics::Surface *getSurface() const { return _surface; }
 	// Non-dirty-rects:
@@ -70,6 +98,12 @@ public:
 	BaseSurfaceOSystem *_owner;
 	bool operator==(const RenderTicket &a) const;
 	const Common::Rect *getSrcRect() const { return &_srcRect; }
+	RenderTicketKey getKey() const { return RenderTicketKey(_owner, _srcRect, _dstRect); }
+
+	/** The position of the ticket in the render queue */
+	Common::List<RenderTicket *>::iterator _queuePosition;
+	/** The next queued ticket with the same key */
+	RenderTicket *_nextWithKey;
 private:
 	Graphics::Surface *_surface;
 	Common::Rect _srcRect;
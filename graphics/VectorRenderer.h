@@ -279,6 +279,13 @@ public:
 	 */
 	virtual void setGradientColors(uint8 r1, uint8 g1, uint8 b1, uint8 r2, uint8 g2, uint8 b2) = 0;
 
+	/**
+	 * Gets the colors set with the functions above, in the format of the
+	 * surface. Drawing steps which do not set all their colors draw with
+	 * these.
+	 */
+	virtual void getColors(uint32 &fg, uint32 &bg, uint32 &bevel, uint32 &gradientStart, uint32 &gradientEnd) const = 0;
+
 	/**
 	 * Sets the active drawing surface. All drawing from this
 	 * point on will be done on that surface.
@@ -289,6 +296,11 @@ public:
 		_activeSurface = surface;
 	}
 
+	/**
+	 * Gets the active drawing surface.
+	 */
+	TransparentSurface *getActiveSurface() const { return _activeSurface; }
+
 	/**
 	 * Fills the active surface with the specified fg/bg color or the active gradient.
 	 * Defaults to using the active Foreground color for filling.
@@ -515,6 +527,7 @@ public:
 	 */
 	virtual void disableShadows() { _disableShadows = true; }
 	virtual void enableShadows() { _disableShadows = false; }
+	bool areShadowsDisabled() const { return _disableShadows; }
 
 	/**
 	 * Applies a whole-screen shading effect, used before opening a new dialog.
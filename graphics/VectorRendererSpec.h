@@ -85,6 +85,14 @@ public:
 	void setBevelColor(uint8 r, uint8 g, uint8 b) { _bevelColor = _format.RGBToColor(r, g, b); }
 	void setGradientColors(uint8 r1, uint8 g1, uint8 b1, uint8 r2, uint8 g2, uint8 b2);
 
+	void getColors(uint32 &fg, uint32 &bg, uint32 &bevel, uint32 &gradientStart, uint32 &gradientEnd) const {
+		fg = _fgColor;
+		bg = _bgColor;
+		bevel = _bevelColor;
+		gradientStart = _gradientStart;
+		gradientEnd = _gradientEnd;
+	}
+
 	void copyFrame(OSystem *sys, const Common::Rect &r);
 	void copyWholeFrame(OSystem *sys) { copyFrame(sys, Common::Rect(0, 0, _activeSurface->w, _activeSurface->h)); }
 
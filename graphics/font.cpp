@@ -36,6 +36,14 @@ Common::Rect Font::getBoundingBox(uint32 chr) const {
 	return Common::Rect(getCharWidth(chr), getFontHeight());
 }
 
+bool Font::drawRun(Surface *dst, const Common::String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const {
+	return false;
+}
+
+bool Font::drawRun(Surface *dst, const Common::U32String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const {
+	return false;
+}
+
 namespace {
 
 template<class StringType>
@@ -121,6 +129,9 @@ void drawStringImpl(const Font &font, Surface *dst, const StringType &str, int x
 	// ever change something here we will need to change it there too.
 	assert(dst != 0);
 
+	if (font.drawRun(dst, str, x, y, w, color, align, deltax))
+		return;
+
 	const int leftX = x, rightX = x + w;
 	int width = font.getStringWidth(str);
 
@@ -148,6 +148,17 @@ public:
 	virtual void drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const = 0;
 	void drawChar(ManagedSurface *dst, uint32 chr, int x, int y, uint32 color) const;
 
+	/**
+	 * Draw a whole line of text in one go, exactly like drawString would. This
+	 * is a hook for fonts which can do that faster than character by
+	 * character, the default implementation does nothing.
+	 *
+	 * @return true if the string has been drawn, false to have drawString
+	 *         draw the characters one by one.
+	 */
+	virtual bool drawRun(Surface *dst, const Common::String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const;
+	virtual bool drawRun(Surface *dst, const Common::U32String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const;
+
 	// TODO: Add doxygen comments to this
 	void drawString(Surface *dst, const Common::String &str, int x, int y, int w, uint32 color, TextAlign align = kTextAlignLeft, int deltax = 0, bool useEllipsis = true) const;
 	void drawString(Surface *dst, const Common::U32String &str, int x, int y, int w, uint32 color, TextAlign align = kTextAlignLeft) const;
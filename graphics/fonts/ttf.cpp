@@ -35,6 +35,7 @@
 #include "common/stream.h"
 #include "common/memstream.h"
 #include "common/hashmap.h"
+#include "common/list.h"
 #include "common/ptr.h"
 
 #include <ft2build.h>
@@ -55,6 +56,16 @@ inline int divRoundToNearest(int dividend, int divisor) {
 	return (dividend + (divisor / 2)) / divisor;
 }
 
+/** Hash a string of code points, like Common::hashit does for C strings. */
+struct U32StringHash {
+	uint operator()(const Common::U32String &str) const {
+		uint hash = str.empty() ? 0 : str[0] << 7;
+		for (uint i = 0; i < str.size(); ++i)
+			hash = (1000003 * hash) ^ str[i];
+		return hash ^ str.size();
+	}
+};
+
 } // End of anonymous namespace
 
 class TTFLibrary : public Common::Singleton<TTFLibrary> {
@@ -122,6 +133,9 @@ public:
 	virtual Common::Rect getBoundingBox(uint32 chr) const;
 
 	virtual void drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const;
+
+	virtual bool drawRun(Surface *dst, const Common::String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const;
+	virtual bool drawRun(Surface *dst, const Common::U32String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const;
 private:
 	bool _initialized;
 	FT_Face _face;
@@ -133,7 +147,7 @@ private:
 	int _ascent, _descent;
 
 	struct Glyph {
-		Surface image;
+		Surface image; ///< Sub-area of an atlas page
 		int xOffset, yOffset;
 		int advance;
 		FT_UInt slot;
@@ -145,6 +159,46 @@ private:
 	bool _allowLateCaching;
 	void assureCached(uint32 chr) const;
 
+	/**
+	 * The glyph images are packed into a few large pages, row by row, instead
+	 * of each being allocated on its own. Glyphs larger than a page get a
+	 * page of their own.
+	 */
+	enum { kAtlasPageSize = 256 };
+	mutable Common::Array<Surface *> _atlasPages;
+	mutable int _shelfPage;
+	mutable int _shelfX, _shelfY, _shelfHeight;
+	Surface allocateGlyphImage(int w, int h) const;
+
+	/**
+	 * A string rendered into a single coverage mask. Drawing it again is one
+	 * blending pass, without looking up and clipping every glyph.
+	 */
+	struct Run {
+		Common::U32String key;
+		Surface mask;
+		/** Position of the mask relative to where the string is drawn */
+		int xOffset, yOffset;
+		/** The range of the right edges of the characters, which drawString clips against */
+		int minRight, maxRight;
+		/** The width of the string, like getStringWidth returns */
+		int width;
+		Common::List<Run *>::iterator lruPosition;
+	};
+
+	enum { kRunCacheSize = 256 * 1024 };
+	typedef Common::HashMap<Common::U32String, Run *, U32StringHash> RunCache;
+	mutable RunCache _runs;
+	/** The runs from the most to the least recently drawn */
+	mutable Common::List<Run *> _runLRU;
+	mutable uint32 _runCacheSize;
+
+	template<class StringType>
+	bool drawRunImpl(Surface *dst, const StringType &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const;
+	template<class StringType>
+	Run *buildRun(const StringType &str) const;
+	static uint32 getRunSize(const Run *run);
+
 	Common::SeekableReadStream *readTTFTable(FT_ULong tag) const;
 
 	int computePointSize(int size, TTFSizeMode sizeMode) const;
@@ -158,8 +212,9 @@ private:
 
 TTFFont::TTFFont()
     : _initialized(false), _face(), _ttfFile(0), _size(0), _width(0), _height(0), _ascent(0),
-      _descent(0), _glyphs(), _loadFlags(FT_LOAD_TARGET_NORMAL), _renderMode(FT_RENDER_MODE_NORMAL),
-      _hasKerning(false), _allowLateCaching(false) {
+      _descent(0), _glyphs(), _allowLateCaching(false), _shelfPage(-1), _shelfX(0), _shelfY(0),
+      _shelfHeight(0), _runCacheSize(0), _loadFlags(FT_LOAD_TARGET_NORMAL), _renderMode(FT_RENDER_MODE_NORMAL),
+      _hasKerning(false) {
 }
 
 TTFFont::~TTFFont() {
@@ -169,11 +224,18 @@ TTFFont::~TTFFont() {
 		delete[] _ttfFile;
 		_ttfFile = 0;
 
-		for (GlyphCache::iterator i = _glyphs.begin(), end = _glyphs.end(); i != end; ++i)
-			i->_value.image.free();
-
 		_initialized = false;
 	}
+
+	for (Common::List<Run *>::iterator i = _runLRU.begin(); i != _runLRU.end(); ++i) {
+		(*i)->mask.free();
+		delete *i;
+	}
+
+	for (uint i = 0; i < _atlasPages.size(); ++i) {
+		_atlasPages[i]->free();
+		delete _atlasPages[i];
+	}
 }
 
 bool TTFFont::load(Common::SeekableReadStream &stream, int size, TTFSizeMode sizeMode, uint dpi, TTFRenderMode renderMode, const uint32 *mapping) {
@@ -494,28 +556,59 @@ void renderGlyph(uint8 *dstPos, const int dstPitch, const uint8 *srcPos, const i
 	}
 }
 
-} // End of anonymous namespace
+/**
+ * renderGlyph for 4 bytes per pixel with 8 bits per color component. This
+ * blends two components at once, with the same results.
+ */
+void renderGlyph8888(uint8 *dstPos, const int dstPitch, const uint8 *srcPos, const int srcPitch, const int w, const int h, uint32 color, const PixelFormat &dstFormat) {
+	const uint32 colorMask = (0xFF << dstFormat.rShift) | (0xFF << dstFormat.gShift) | (0xFF << dstFormat.bShift);
+	const uint32 alpha = (0xFF >> dstFormat.aLoss) << dstFormat.aShift;
+	const uint32 sRB = color & 0x00FF00FF;
+	const uint32 sGA = (color >> 8) & 0x00FF00FF;
 
-void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const {
-	assureCached(chr);
-	GlyphCache::const_iterator glyphEntry = _glyphs.find(chr);
-	if (glyphEntry == _glyphs.end())
-		return;
+	for (int y = 0; y < h; ++y) {
+		uint32 *rDst = (uint32 *)dstPos;
+		const uint8 *src = srcPos;
 
-	const Glyph &glyph = glyphEntry->_value;
+		for (int x = 0; x < w; ++x) {
+			if (*src == 255) {
+				*rDst = color;
+			} else if (*src) {
+				const uint32 a = *src;
+
+				uint32 rb = (*rDst & 0x00FF00FF) * (255 - a) + sRB * a;
+				uint32 ga = ((*rDst >> 8) & 0x00FF00FF) * (255 - a) + sGA * a;
+
+				// Divide both components by 255: (v + 1 + (v >> 8)) >> 8 is
+				// exact for the possible values
+				rb = ((rb + 0x00010001 + ((rb >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
+				ga = ((ga + 0x00010001 + ((ga >> 8) & 0x00FF00FF)) >> 8) & 0x00FF00FF;
 
-	x += glyph.xOffset;
-	y += glyph.yOffset;
+				*rDst = ((rb | (ga << 8)) & colorMask) | alpha;
+			}
 
+			++rDst;
+			++src;
+		}
+
+		dstPos += dstPitch;
+		srcPos += srcPitch;
+	}
+}
+
+/**
+ * Blend a color into a surface, with the given alpha values (coverage).
+ */
+void drawCoverage(Surface *dst, const Surface &coverage, int x, int y, uint32 color) {
 	if (x > dst->w)
 		return;
 	if (y > dst->h)
 		return;
 
-	int w = glyph.image.w;
-	int h = glyph.image.h;
+	int w = coverage.w;
+	int h = coverage.h;
 
-	const uint8 *srcPos = (const uint8 *)glyph.image.getPixels();
+	const uint8 *srcPos = (const uint8 *)coverage.getPixels();
 
 	// Make sure we are not drawing outside the screen bounds
 	if (x < 0) {
@@ -531,7 +624,7 @@ void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) con
 		return;
 
 	if (y < 0) {
-		srcPos -= y * glyph.image.pitch;
+		srcPos -= y * coverage.pitch;
 		h += y;
 		y = 0;
 	}
@@ -560,13 +653,203 @@ void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) con
 			}
 
 			dstPos += dst->pitch;
-			srcPos += glyph.image.pitch;
+			srcPos += coverage.pitch;
 		}
 	} else if (dst->format.bytesPerPixel == 2) {
-		renderGlyph<uint16>(dstPos, dst->pitch, srcPos, glyph.image.pitch, w, h, color, dst->format);
+		renderGlyph<uint16>(dstPos, dst->pitch, srcPos, coverage.pitch, w, h, color, dst->format);
 	} else if (dst->format.bytesPerPixel == 4) {
-		renderGlyph<uint32>(dstPos, dst->pitch, srcPos, glyph.image.pitch, w, h, color, dst->format);
+		const PixelFormat &format = dst->format;
+		if (format.rLoss == 0 && format.gLoss == 0 && format.bLoss == 0 &&
+		    (format.rShift % 8) == 0 && (format.gShift % 8) == 0 && (format.bShift % 8) == 0)
+			renderGlyph8888(dstPos, dst->pitch, srcPos, coverage.pitch, w, h, color, format);
+		else
+			renderGlyph<uint32>(dstPos, dst->pitch, srcPos, coverage.pitch, w, h, color, format);
+	}
+}
+
+} // End of anonymous namespace
+
+void TTFFont::drawChar(Surface *dst, uint32 chr, int x, int y, uint32 color) const {
+	assureCached(chr);
+	GlyphCache::const_iterator glyphEntry = _glyphs.find(chr);
+	if (glyphEntry == _glyphs.end())
+		return;
+
+	const Glyph &glyph = glyphEntry->_value;
+	drawCoverage(dst, glyph.image, x + glyph.xOffset, y + glyph.yOffset, color);
+}
+
+bool TTFFont::drawRun(Surface *dst, const Common::String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const {
+	return drawRunImpl(dst, str, x, y, w, color, align, deltax);
+}
+
+bool TTFFont::drawRun(Surface *dst, const Common::U32String &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const {
+	return drawRunImpl(dst, str, x, y, w, color, align, deltax);
+}
+
+template<class StringType>
+bool TTFFont::drawRunImpl(Surface *dst, const StringType &str, int x, int y, int w, uint32 color, TextAlign align, int deltax) const {
+	if (str.empty())
+		return false;
+
+	// Strings and U32Strings with the same code units are laid out the same
+	Common::U32String key;
+	for (typename StringType::const_iterator i = str.begin(), end = str.end(); i != end; ++i)
+		key += (typename StringType::unsigned_type)*i;
+
+	Run *run;
+	RunCache::iterator runEntry = _runs.find(key);
+	if (runEntry != _runs.end()) {
+		run = runEntry->_value;
+		_runLRU.erase(run->lruPosition);
+	} else {
+		run = buildRun(str);
+		run->key = key;
+
+		// Make room for the new run
+		_runCacheSize += getRunSize(run);
+		while (_runCacheSize > kRunCacheSize && !_runLRU.empty()) {
+			Run *oldest = _runLRU.back();
+			_runLRU.pop_back();
+			_runs.erase(oldest->key);
+			_runCacheSize -= getRunSize(oldest);
+			oldest->mask.free();
+			delete oldest;
+		}
+
+		_runs[key] = run;
 	}
+
+	_runLRU.push_front(run);
+	run->lruPosition = _runLRU.begin();
+
+	const int leftX = x, rightX = x + w;
+
+	if (align == kTextAlignCenter)
+		x = x + (w - run->width)/2;
+	else if (align == kTextAlignRight)
+		x = x + w - run->width;
+	x += deltax;
+
+	// The mask holds all characters, let drawString clip them one by one
+	if (x + run->minRight < leftX || x + run->maxRight > rightX)
+		return false;
+
+	drawCoverage(dst, run->mask, x + run->xOffset, y + run->yOffset, color);
+	return true;
+}
+
+template<class StringType>
+TTFFont::Run *TTFFont::buildRun(const StringType &str) const {
+	// We follow the logic of drawStringImpl in graphics/font.cpp here, to
+	// place every character where drawChar would draw it.
+	Common::Array<uint32> chars;
+	Common::Array<int> positions;
+	Run *run = new Run();
+	run->minRight = 0x7FFFFFFF;
+	run->maxRight = -0x7FFFFFFF;
+
+	int x = 0;
+	typename StringType::unsigned_type last = 0;
+	for (typename StringType::const_iterator i = str.begin(), end = str.end(); i != end; ++i) {
+#ifdef SCUMMVMKOR
+		bool isKorean = 1;
+		typename StringType::unsigned_type c;
+		c = *i;
+		if (c >= 0x80 && isKorean && i+1 < end) {
+			if (checkKorCode(c, *(i+1))) {
+				c += *(i+1) * 256;	//LE
+				i++;
+			} else {
+				isKorean = 0;
+			}
+		}
+#else
+		const typename StringType::unsigned_type c = *i;
+#endif
+		const typename StringType::unsigned_type cur = *i;
+		x += getKerningOffset(last, cur);
+		last = cur;
+		const int w = getCharWidth(c);
+		run->minRight = MIN(run->minRight, x + w);
+		run->maxRight = MAX(run->maxRight, x + w);
+		chars.push_back(c);
+		positions.push_back(x);
+		x += w;
+	}
+	run->width = x;
+
+	Common::Rect bbox;
+	for (uint i = 0; i < chars.size(); ++i) {
+		Common::Rect charBox = getBoundingBox(chars[i]);
+		if (charBox.isEmpty())
+			continue;
+
+		charBox.translate(positions[i], 0);
+		if (bbox.isEmpty())
+			bbox = charBox;
+		else
+			bbox.extend(charBox);
+	}
+
+	run->xOffset = bbox.left;
+	run->yOffset = bbox.top;
+	if (bbox.isEmpty())
+		return run;
+
+	run->mask.create(bbox.width(), bbox.height(), PixelFormat::createFormatCLUT8());
+
+	// Overlapping glyphs are combined like drawing one over the other does
+	for (uint i = 0; i < chars.size(); ++i) {
+		GlyphCache::const_iterator glyphEntry = _glyphs.find(chars[i]);
+		if (glyphEntry == _glyphs.end())
+			continue;
+
+		const Glyph &glyph = glyphEntry->_value;
+		for (int y = 0; y < glyph.image.h; ++y) {
+			const uint8 *src = (const uint8 *)glyph.image.getBasePtr(0, y);
+			uint8 *dst = (uint8 *)run->mask.getBasePtr(positions[i] + glyph.xOffset - bbox.left, glyph.yOffset + y - bbox.top);
+
+			for (int cx = 0; cx < glyph.image.w; ++cx, ++src, ++dst)
+				*dst = *dst + *src - (*dst * *src + 127) / 255;
+		}
+	}
+
+	return run;
+}
+
+uint32 TTFFont::getRunSize(const Run *run) {
+	return sizeof(Run) + run->key.size() * sizeof(uint32) + run->mask.w * run->mask.h;
+}
+
+Surface TTFFont::allocateGlyphImage(int w, int h) const {
+	if (w > kAtlasPageSize || h > kAtlasPageSize) {
+		Surface *page = new Surface();
+		page->create(w, h, PixelFormat::createFormatCLUT8());
+		_atlasPages.push_back(page);
+		return *page;
+	}
+
+	// Start a new row when the glyph does not fit next to the previous one,
+	// and a new page when the row does not fit below the previous one
+	if (_shelfX + w > kAtlasPageSize) {
+		_shelfX = 0;
+		_shelfY += _shelfHeight;
+		_shelfHeight = 0;
+	}
+
+	if (_shelfPage < 0 || _shelfY + h > kAtlasPageSize) {
+		Surface *page = new Surface();
+		page->create(kAtlasPageSize, kAtlasPageSize, PixelFormat::createFormatCLUT8());
+		_atlasPages.push_back(page);
+		_shelfPage = _atlasPages.size() - 1;
+		_shelfX = _shelfY = _shelfHeight = 0;
+	}
+
+	Surface image = _atlasPages[_shelfPage]->getSubArea(Common::Rect(_shelfX, _shelfY, _shelfX + w, _shelfY + h));
+	_shelfX += w;
+	_shelfHeight = MAX(_shelfHeight, h);
+	return image;
 }
 
 bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
@@ -594,7 +877,12 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 	glyph.advance = ftCeil26_6(_face->glyph->advance.x);
 
 	const FT_Bitmap &bitmap = _face->glyph->bitmap;
-	glyph.image.create(bitmap.width, bitmap.rows, PixelFormat::createFormatCLUT8());
+	if (bitmap.pixel_mode != FT_PIXEL_MODE_MONO && bitmap.pixel_mode != FT_PIXEL_MODE_GRAY) {
+		warning("TTFFont::cacheGlyph: Unsupported pixel mode %d", bitmap.pixel_mode);
+		return false;
+	}
+
+	glyph.image = allocateGlyphImage(bitmap.width, bitmap.rows);
 
 	const uint8 *src = bitmap.buffer;
 	int srcPitch = bitmap.pitch;
@@ -604,12 +892,12 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 	}
 
 	uint8 *dst = (uint8 *)glyph.image.getPixels();
-	memset(dst, 0, glyph.image.h * glyph.image.pitch);
 
 	switch (bitmap.pixel_mode) {
 	case FT_PIXEL_MODE_MONO:
 		for (int y = 0; y < (int)bitmap.rows; ++y) {
 			const uint8 *curSrc = src;
+			uint8 *curDst = dst;
 			uint8 mask = 0;
 
 			for (int x = 0; x < (int)bitmap.width; ++x) {
@@ -617,12 +905,13 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 					mask = *curSrc++;
 
 				if (mask & 0x80)
-					*dst = 255;
+					*curDst = 255;
 
 				mask <<= 1;
-				++dst;
+				++curDst;
 			}
 
+			dst += glyph.image.pitch;
 			src += srcPitch;
 		}
 		break;
@@ -634,11 +923,6 @@ bool TTFFont::cacheGlyph(Glyph &glyph, uint32 chr) const {
 			src += srcPitch;
 		}
 		break;
-
-	default:
-		warning("TTFFont::cacheGlyph: Unsupported pixel mode %d", bitmap.pixel_mode);
-		glyph.image.free();
-		return false;
 	}
 
 	return true;
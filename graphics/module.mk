@@ -28,12 +28,15 @@ MODULE_OBJS := \
 	surface.o \
 	transform_struct.o \
 	transform_tools.o \
+	transformed_surface_cache.o \
 	transparent_surface.o \
+	transparent_surface_simd.o \
 	thumbnail.o \
 	VectorRenderer.o \
 	VectorRendererSpec.o \
 	wincursor.o \
-	yuv_to_rgb.o
+	yuv_to_rgb.o \
+	yuv_to_rgb_simd.o
 
 ifdef USE_SCALERS
 MODULE_OBJS += \
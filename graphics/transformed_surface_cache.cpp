@@ -0,0 +1,133 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "graphics/transformed_surface_cache.h"
+#include "graphics/transparent_surface.h"
+
+namespace Graphics {
+
+TransformedSurfaceCache::TransformedSurfaceCache(uint32 maxSize) : _size(0), _maxSize(maxSize) {
+}
+
+TransformedSurfaceCache::~TransformedSurfaceCache() {
+	clear();
+}
+
+const TransparentSurface *TransformedSurfaceCache::scale(const TransparentSurface &src, uint16 newWidth, uint16 newHeight) {
+	Key key = makeKey(src);
+	key.newWidth = newWidth;
+	key.newHeight = newHeight;
+
+	const TransparentSurface *result = find(key);
+	if (result)
+		return result;
+
+	return add(key, src.scale(newWidth, newHeight));
+}
+
+const TransparentSurface *TransformedSurfaceCache::rotoscale(const TransparentSurface &src, const TransformStruct &transform) {
+	Key key = makeKey(src);
+	key.angle = transform._angle;
+	key.zoom = transform._zoom;
+	key.hotspot = transform._hotspot;
+
+	const TransparentSurface *result = find(key);
+	if (result)
+		return result;
+
+	return add(key, src.rotoscale(transform));
+}
+
+void TransformedSurfaceCache::invalidate(const Surface &surface) {
+	const byte *begin = (const byte *)surface.getPixels();
+	if (!begin)
+		return;
+
+	const byte *end = begin + surface.h * surface.pitch;
+
+	Common::List<Entry *>::iterator i = _lru.begin();
+	while (i != _lru.end()) {
+		Entry *entry = *i;
+		++i;
+
+		const byte *pixels = (const byte *)entry->key.pixels;
+		if (pixels >= begin && pixels < end)
+			remove(entry);
+	}
+}
+
+void TransformedSurfaceCache::clear() {
+	while (!_lru.empty())
+		remove(_lru.back());
+}
+
+TransformedSurfaceCache::Key TransformedSurfaceCache::makeKey(const TransparentSurface &src) {
+	Key key;
+	key.pixels = src.getPixels();
+	key.width = src.w;
+	key.height = src.h;
+	key.pitch = src.pitch;
+	key.newWidth = 0;
+	key.newHeight = 0;
+	key.angle = 0;
+	return key;
+}
+
+const TransparentSurface *TransformedSurfaceCache::find(const Key &key) {
+	EntryMap::iterator i = _entries.find(key);
+	if (i == _entries.end())
+		return nullptr;
+
+	Entry *entry = i->_value;
+	_lru.erase(entry->lruPosition);
+	_lru.push_front(entry);
+	entry->lruPosition = _lru.begin();
+	return entry->surface;
+}
+
+const TransparentSurface *TransformedSurfaceCache::add(const Key &key, TransparentSurface *surface) {
+	Entry *entry = new Entry();
+	entry->key = key;
+	entry->surface = surface;
+	_size += surface->h * surface->pitch;
+
+	// The new copy is kept even if it doesn't fit on its own, as the
+	// caller is about to use it
+	while (_size > _maxSize && !_lru.empty())
+		remove(_lru.back());
+
+	_lru.push_front(entry);
+	entry->lruPosition = _lru.begin();
+	_entries[key] = entry;
+	return surface;
+}
+
+void TransformedSurfaceCache::remove(Entry *entry) {
+	_entries.erase(entry->key);
+	_lru.erase(entry->lruPosition);
+	_size -= entry->surface->h * entry->surface->pitch;
+	entry->surface->free();
+	delete entry->surface;
+	delete entry;
+}
+
+} // End of namespace Graphics
@@ -0,0 +1,127 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_TRANSFORMED_SURFACE_CACHE_H
+#define GRAPHICS_TRANSFORMED_SURFACE_CACHE_H
+
+#include "common/hashmap.h"
+#include "common/list.h"
+#include "common/rect.h"
+#include "graphics/transform_struct.h"
+
+namespace Graphics {
+
+struct Surface;
+struct TransparentSurface;
+
+/**
+ * A cache of scaled and rotated copies of surfaces, for sprites which are
+ * drawn with the same transformation frame after frame.
+ *
+ * The copies are identified by the address of the pixels they were made
+ * from, so whoever owns those pixels has to invalidate the cache before
+ * changing or freeing them. When the copies take more memory than allowed,
+ * the least recently used ones are dropped.
+ */
+class TransformedSurfaceCache {
+public:
+	/** Memory used for the pixels of the copies at most, by default */
+	static const uint32 kDefaultMaxSize = 8 * 1024 * 1024;
+
+	explicit TransformedSurfaceCache(uint32 maxSize = kDefaultMaxSize);
+	~TransformedSurfaceCache();
+
+	/**
+	 * Return the surface scaled like TransparentSurface::scale() does.
+	 * The copy belongs to the cache and stays valid until the cache is
+	 * used again.
+	 */
+	const TransparentSurface *scale(const TransparentSurface &src, uint16 newWidth, uint16 newHeight);
+
+	/**
+	 * Return the surface rotated and scaled like
+	 * TransparentSurface::rotoscale() does. The copy belongs to the cache
+	 * and stays valid until the cache is used again.
+	 */
+	const TransparentSurface *rotoscale(const TransparentSurface &src, const TransformStruct &transform);
+
+	/** Drop the copies made from any part of the pixels of a surface. */
+	void invalidate(const Surface &surface);
+
+	/** Drop all copies. */
+	void clear();
+
+	/** Return the memory used for the pixels of the copies. */
+	uint32 getSize() const { return _size; }
+
+private:
+	/** Everything the copy depends on besides the values of the pixels */
+	struct Key {
+		const void *pixels;
+		uint16 width, height, pitch;
+		uint16 newWidth, newHeight; ///< 0 for rotated copies
+		int32 angle;
+		Common::Point zoom;
+		Common::Point hotspot;
+
+		bool operator==(const Key &other) const {
+			return pixels == other.pixels && width == other.width && height == other.height &&
+			       pitch == other.pitch && newWidth == other.newWidth && newHeight == other.newHeight &&
+			       angle == other.angle && zoom == other.zoom && hotspot == other.hotspot;
+		}
+	};
+
+	struct KeyHash {
+		uint operator()(const Key &key) const {
+			uint hash = (uint)(size_t)key.pixels;
+			hash = hash * 31 + key.width + (key.height << 16);
+			hash = hash * 31 + key.newWidth + (key.newHeight << 16);
+			hash = hash * 31 + (uint)key.angle;
+			hash = hash * 31 + (uint16)key.zoom.x + ((uint16)key.zoom.y << 16);
+			hash = hash * 31 + (uint16)key.hotspot.x + ((uint16)key.hotspot.y << 16);
+			return hash;
+		}
+	};
+
+	struct Entry {
+		Key key;
+		TransparentSurface *surface;
+		Common::List<Entry *>::iterator lruPosition;
+	};
+
+	static Key makeKey(const TransparentSurface &src);
+	const TransparentSurface *find(const Key &key);
+	/** Add a copy, the cache takes ownership of the surface */
+	const TransparentSurface *add(const Key &key, TransparentSurface *surface);
+	void remove(Entry *entry);
+
+	typedef Common::HashMap<Key, Entry *, KeyHash> EntryMap;
+	EntryMap _entries;
+	/** The entries from the most to the least recently used */
+	Common::List<Entry *> _lru;
+	uint32 _size;
+	uint32 _maxSize;
+};
+
+} // End of namespace Graphics
+
+#endif
@@ -45,6 +45,8 @@
 
 namespace Graphics {
 
+class TransformedSurfaceCache;
+
 // Enums
 /**
  @brief The possible flipping parameters for the blit method.
@@ -115,6 +117,9 @@ struct TransparentSurface : public Graphics::Surface {
 	 The images will be scaled if the output width of the screen section differs from the image section.<br>
 	 The value -1 determines that the image should not be scaled.<br>
 	 The default value is -1.
+	 @param cache a cache to take the scaled image from, instead of scaling it on every call.<br>
+	 The owner of the surface has to invalidate the cache whenever the pixels of the surface change.<br>
+	 The default value is NULL.
 	 @return returns false if the rendering failed.
 	 */
 	Common::Rect blit(Graphics::Surface &target, int posX = 0, int posY = 0,
@@ -122,14 +127,16 @@ struct TransparentSurface : public Graphics::Surface {
 	                  Common::Rect *pPartRect = nullptr,
 	                  uint color = TS_ARGB(255, 255, 255, 255),
 	                  int width = -1, int height = -1,
-	                  TSpriteBlendMode blend = BLEND_NORMAL);
+	                  TSpriteBlendMode blend = BLEND_NORMAL,
+	                  TransformedSurfaceCache *cache = nullptr);
 	Common::Rect blitClip(Graphics::Surface &target, Common::Rect clippingArea,
 						int posX = 0, int posY = 0,
 						int flipping = FLIP_NONE,
 						Common::Rect *pPartRect = nullptr,
 						uint color = TS_ARGB(255, 255, 255, 255),
 						int width = -1, int height = -1,
-						TSpriteBlendMode blend = BLEND_NORMAL);
+						TSpriteBlendMode blend = BLEND_NORMAL,
+						TransformedSurfaceCache *cache = nullptr);
 
 	void applyColorKey(uint8 r, uint8 g, uint8 b, bool overwriteAlpha = false);
 
@@ -163,6 +170,37 @@ struct TransparentSurface : public Graphics::Surface {
 
 	AlphaType getAlphaMode() const;
 	void setAlphaMode(AlphaType);
+
+	/**
+	 * Implementations of the alpha, additive and subtractive blending. The
+	 * vector kernels give exactly the same results as the scalar one.
+	 */
+	enum BlendKernel {
+		kBlendKernelScalar, /** The reference */
+		kBlendKernelSSE2,
+		kBlendKernelNEON,
+
+		kBlendKernelCount
+	};
+
+	/**
+	 * Return the fastest kernel which is compiled in and supported by the
+	 * CPU.
+	 */
+	static BlendKernel getBestBlendKernel();
+
+	/** Return whether the kernel is compiled in and supported by the CPU. */
+	static bool isBlendKernelSupported(BlendKernel kernel);
+
+	/** Return a human readable name of the specified kernel. */
+	static const char *getBlendKernelName(BlendKernel kernel);
+
+	/**
+	 * Use the specified kernel for all blits instead of the best available
+	 * one. Meant for tests and benchmarks.
+	 */
+	static void setBlendKernel(BlendKernel kernel);
+	static BlendKernel getBlendKernel();
 private:
 	AlphaType _alphaMode;
 
@@ -0,0 +1,79 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_TRANSPARENTSURFACE_INTERN_H
+#define GRAPHICS_TRANSPARENTSURFACE_INTERN_H
+
+#include "graphics/transparent_surface.h"
+
+namespace Graphics {
+
+// The shifts of the components of a color modulation in 0xAARRGGBB format
+static const int kBModShift = 0;
+static const int kGModShift = 8;
+static const int kRModShift = 16;
+static const int kAModShift = 24;
+
+// The bytes of the components in a pixel of the supported pixel format
+#ifdef SCUMM_LITTLE_ENDIAN
+static const int kAIndex = 0;
+static const int kBIndex = 1;
+static const int kGIndex = 2;
+static const int kRIndex = 3;
+#else
+static const int kAIndex = 3;
+static const int kBIndex = 2;
+static const int kGIndex = 1;
+static const int kRIndex = 0;
+#endif
+
+/**
+ * Blend a block of pixels onto a surface.
+ *
+ * @param ino    the first input pixel
+ * @param outo   the first output pixel
+ * @param width  the number of pixels per row
+ * @param height the number of rows
+ * @param pitch  the pitch of the output
+ * @param inStep the distance in bytes between two input pixels of a row,
+ *               negative for horizontally flipped input
+ * @param inoStep the distance in bytes between two input rows, negative for
+ *               vertically flipped input
+ * @param color  the color modulation in 0xAARRGGBB format, 0xFFFFFFFF for
+ *               none
+ */
+typedef void (*BlendProc)(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color);
+
+// The scalar reference kernels
+void doBlitAlphaBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color);
+void doBlitAdditiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color);
+void doBlitSubtractiveBlend(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color);
+
+/**
+ * Return the procedure blending with the specified mode using a kernel.
+ * Returns 0 for kernels not available on this CPU.
+ */
+BlendProc getBlendProc(TransparentSurface::BlendKernel kernel, TSpriteBlendMode blendMode);
+
+} // End of namespace Graphics
+
+#endif
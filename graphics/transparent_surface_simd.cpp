@@ -0,0 +1,426 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Vector kernels for the alpha, additive and subtractive blending of
+ * TransparentSurface.
+ *
+ * Every vector kernel reproduces the scalar one in transparent_surface.cpp
+ * bit for bit. The products of up to four 8 bit values the scalar kernels
+ * shift right by 16 or 24 bits are split into two products of at most 16
+ * bits each, and the upper half of multiplying those is the same as the
+ * shifted product. Where the scalar kernels treat a color modulation of 255
+ * as no modulation, the vector kernels multiply by 256 instead.
+ *
+ * The pixels left over at the end of a row are blended by the scalar
+ * kernels.
+ */
+
+// Allow use of the compiler intrinsic headers
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "graphics/transparent_surface_intern.h"
+
+#include "common/cpu-features.h"
+
+namespace Graphics {
+
+enum BlendOp {
+	kOpAlpha,
+	kOpAlphaMod,
+	kOpAdditive,
+	kOpAdditiveMod,
+	kOpSubtractive,
+	kOpSubtractiveMod
+};
+
+/**
+ * Return a component of a color modulation as a factor to multiply with
+ * and then divide by 256. The scalar additive and subtractive kernels
+ * don't modulate a component of 255 at all, which is the same as
+ * multiplying it by 256.
+ */
+static inline uint16 modFactor(uint32 color, int shift, BlendOp op) {
+	const uint16 mod = (color >> shift) & 0xFF;
+	return (mod == 255 && op != kOpAlphaMod) ? 256 : mod;
+}
+
+#pragma mark -
+
+#ifdef SIMD_SSE2
+
+// The SSE2 kernels rely on the little endian byte order of x86, with the
+// alpha in the lowest byte of every pixel.
+
+/** Load four pixels, in reverse order if the input is flipped. */
+SIMD_TARGET("sse2") static inline __m128i loadPixelsSSE2(const byte *in, bool reverse) {
+	if (!reverse)
+		return _mm_loadu_si128((const __m128i *)in);
+
+	return _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(in - 12)), _MM_SHUFFLE(0, 1, 2, 3));
+}
+
+/** Copy the alpha of two pixels in 16 bit lanes to all lanes of the pixels. */
+SIMD_TARGET("sse2") static inline __m128i alphaSSE2(__m128i pixels) {
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(0, 0, 0, 0));
+}
+
+/**
+ * Blend four pixels with the operation of one of the scalar kernels.
+ *
+ * @param alphaMod the alpha modulation in all 16 bit lanes
+ * @param colorMod the color modulation factors of two pixels in 16 bit
+ *                 lanes, 0 for alpha
+ */
+template<BlendOp op>
+SIMD_TARGET("sse2") static inline __m128i blendPixelsSSE2(__m128i src, __m128i dst, __m128i alphaMod, __m128i colorMod) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i full = _mm_set1_epi16(255);
+	const __m128i alphaMask = _mm_set1_epi32(0xFF);
+
+	const __m128i srcLo = _mm_unpacklo_epi8(src, zero);
+	const __m128i srcHi = _mm_unpackhi_epi8(src, zero);
+	const __m128i dstLo = _mm_unpacklo_epi8(dst, zero);
+	const __m128i dstHi = _mm_unpackhi_epi8(dst, zero);
+	__m128i alphaLo = alphaSSE2(srcLo);
+	__m128i alphaHi = alphaSSE2(srcHi);
+
+	if (op == kOpAlphaMod || op == kOpAdditiveMod) {
+		alphaLo = _mm_srli_epi16(_mm_mullo_epi16(alphaLo, alphaMod), 8);
+		alphaHi = _mm_srli_epi16(_mm_mullo_epi16(alphaHi, alphaMod), 8);
+	}
+
+	__m128i lo, hi;
+	switch (op) {
+	case kOpAlpha: {
+		// Pixels without any alpha leave the output untouched
+		const __m128i transparent = _mm_cmpeq_epi32(_mm_and_si128(src, alphaMask), zero);
+		if (_mm_movemask_epi8(transparent) == 0xFFFF)
+			return dst;
+
+		lo = _mm_add_epi16(_mm_mullo_epi16(srcLo, alphaLo), _mm_mullo_epi16(dstLo, _mm_sub_epi16(full, alphaLo)));
+		hi = _mm_add_epi16(_mm_mullo_epi16(srcHi, alphaHi), _mm_mullo_epi16(dstHi, _mm_sub_epi16(full, alphaHi)));
+		const __m128i blended = _mm_or_si128(_mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)), alphaMask);
+		return _mm_or_si128(_mm_and_si128(transparent, dst), _mm_andnot_si128(transparent, blended));
+	}
+
+	case kOpAlphaMod:
+		lo = _mm_srli_epi16(_mm_mullo_epi16(dstLo, _mm_sub_epi16(full, alphaLo)), 8);
+		hi = _mm_srli_epi16(_mm_mullo_epi16(dstHi, _mm_sub_epi16(full, alphaHi)), 8);
+		lo = _mm_add_epi16(lo, _mm_mulhi_epu16(_mm_mullo_epi16(srcLo, alphaLo), colorMod));
+		hi = _mm_add_epi16(hi, _mm_mulhi_epu16(_mm_mullo_epi16(srcHi, alphaHi), colorMod));
+		return _mm_or_si128(_mm_packus_epi16(lo, hi), alphaMask);
+
+	case kOpAdditive:
+		lo = _mm_srli_epi16(_mm_mullo_epi16(srcLo, alphaLo), 8);
+		hi = _mm_srli_epi16(_mm_mullo_epi16(srcHi, alphaHi), 8);
+		return _mm_adds_epu8(dst, _mm_andnot_si128(alphaMask, _mm_packus_epi16(lo, hi)));
+
+	case kOpAdditiveMod:
+		lo = _mm_mulhi_epu16(_mm_mullo_epi16(srcLo, alphaLo), colorMod);
+		hi = _mm_mulhi_epu16(_mm_mullo_epi16(srcHi, alphaHi), colorMod);
+		return _mm_adds_epu8(dst, _mm_packus_epi16(lo, hi));
+
+	case kOpSubtractive:
+		lo = _mm_mulhi_epu16(_mm_mullo_epi16(srcLo, dstLo), alphaLo);
+		hi = _mm_mulhi_epu16(_mm_mullo_epi16(srcHi, dstHi), alphaHi);
+		return _mm_sub_epi8(dst, _mm_andnot_si128(alphaMask, _mm_packus_epi16(lo, hi)));
+
+	case kOpSubtractiveMod:
+	default:
+		lo = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(srcLo, colorMod), _mm_mullo_epi16(dstLo, alphaLo)), 8);
+		hi = _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(srcHi, colorMod), _mm_mullo_epi16(dstHi, alphaHi)), 8);
+		return _mm_or_si128(_mm_sub_epi8(dst, _mm_packus_epi16(lo, hi)), alphaMask);
+	}
+}
+
+template<BlendOp op>
+SIMD_TARGET("sse2") static void blendRowsSSE2(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color, BlendProc reference) {
+	if (inStep != 4 && inStep != -4) {
+		reference(ino, outo, width, height, pitch, inStep, inoStep, color);
+		return;
+	}
+
+	const __m128i alphaMod = _mm_set1_epi16((color >> kAModShift) & 0xFF);
+	const int16 r = modFactor(color, kRModShift, op);
+	const int16 g = modFactor(color, kGModShift, op);
+	const int16 b = modFactor(color, kBModShift, op);
+	const __m128i colorMod = _mm_set_epi16(r, g, b, 0, r, g, b, 0);
+	const uint32 vectorWidth = width & ~3;
+
+	for (uint32 i = 0; i < height; i++) {
+		byte *in = ino;
+		byte *out = outo;
+		for (uint32 j = 0; j < vectorWidth; j += 4) {
+			const __m128i src = loadPixelsSSE2(in, inStep < 0);
+			const __m128i dst = _mm_loadu_si128((const __m128i *)out);
+			_mm_storeu_si128((__m128i *)out, blendPixelsSSE2<op>(src, dst, alphaMod, colorMod));
+			in += inStep * 4;
+			out += 16;
+		}
+
+		if (vectorWidth < width)
+			reference(in, out, width - vectorWidth, 1, pitch, inStep, inoStep, color);
+
+		outo += pitch;
+		ino += inoStep;
+	}
+}
+
+SIMD_TARGET("sse2") static void alphaBlendSSE2(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color) {
+	if (color == 0xffffffff)
+		blendRowsSSE2<kOpAlpha>(ino, outo, width, height, pitch, inStep, inoStep, color, &doBlitAlphaBlend);
+	else
+		blendRowsSSE2<kOpAlphaMod>(ino, outo, width, height, pitch, inStep, inoStep, color, &doBlitAlphaBlend);
+}
+
+SIMD_TARGET("sse2") static void additiveBlendSSE2(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color) {
+	if (color == 0xffffffff)
+		blendRowsSSE2<kOpAdditive>(ino, outo, width, height, pitch, inStep, inoStep, color, &doBlitAdditiveBlend);
+	else
+		blendRowsSSE2<kOpAdditiveMod>(ino, outo, width, height, pitch, inStep, inoStep, color, &doBlitAdditiveBlend);
+}
+
+SIMD_TARGET("sse2") static void subtractiveBlendSSE2(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color) {
+	if (color == 0xffffffff)
+		blendRowsSSE2<kOpSubtractive>(ino, outo, width, height, pitch, inStep, inoStep, color, &doBlitSubtractiveBlend);
+	else
+		blendRowsSSE2<kOpSubtractiveMod>(ino, outo, width, height, pitch, inStep, inoStep, color, &doBlitSubtractiveBlend);
+}
+
+#endif // SIMD_SSE2
+
+#ifdef SIMD_NEON
+
+// The NEON kernels split eight pixels into planes of their components, so
+// they work with either byte order.
+
+/** Return the upper 16 bits of multiplying 16 bit lanes. */
+static inline uint16x8_t mulHighNEON(uint16x8_t a, uint16x8_t b) {
+	const uint32x4_t lo = vmull_u16(vget_low_u16(a), vget_low_u16(b));
+	const uint32x4_t hi = vmull_u16(vget_high_u16(a), vget_high_u16(b));
+	return vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16));
+}
+
+/** Load eight pixels as planes, in reverse order if the input is flipped. */
+static inline uint8x8x4_t loadPixelsNEON(const byte *in, bool reverse) {
+	if (!reverse)
+		return vld4_u8(in);
+
+	uint8x8x4_t pixels = vld4_u8(in - 28);
+	for (int i = 0; i < 4; i++)
+		pixels.val[i] = vrev64_u8(pixels.val[i]);
+	return pixels;
+}
+
+/**
+ * Blend eight pixels with the operation of one of the scalar kernels.
+ *
+ * @param alphaMod the alpha modulation
+ * @param colorMod the color modulation factors, indexed by the byte of the
+ *                 component in a pixel
+ */
+template<BlendOp op>
+static inline uint8x8x4_t blendPixelsNEON(const uint8x8x4_t &src, const uint8x8x4_t &dst, uint8 alphaMod, const uint16 *colorMod) {
+	static const int kColors[3] = { kRIndex, kGIndex, kBIndex };
+
+	uint8x8_t alpha = src.val[kAIndex];
+	if (op == kOpAlphaMod || op == kOpAdditiveMod)
+		alpha = vshrn_n_u16(vmull_u8(alpha, vdup_n_u8(alphaMod)), 8);
+
+	uint8x8x4_t result = dst;
+	if (op == kOpAlpha || op == kOpAlphaMod || op == kOpSubtractiveMod)
+		result.val[kAIndex] = vdup_n_u8(255);
+
+	for (int i = 0; i < 3; i++) {
+		const int c = kColors[i];
+		const uint16x8_t mod = vdupq_n_u16(colorMod[c]);
+
+		switch (op) {
+		case kOpAlpha:
+			result.val[c] = vshrn_n_u16(vmlal_u8(vmull_u8(src.val[c], alpha), dst.val[c], vmvn_u8(alpha)), 8);
+			break;
+
+		case kOpAlphaMod:
+			result.val[c] = vadd_u8(vshrn_n_u16(vmull_u8(dst.val[c], vmvn_u8(alpha)), 8),
+			                        vmovn_u16(mulHighNEON(vmull_u8(src.val[c], alpha), mod)));
+			break;
+
+		case kOpAdditive:
+			result.val[c] = vqadd_u8(dst.val[c], vshrn_n_u16(vmull_u8(src.val[c], alpha), 8));
+			break;
+
+		case kOpAdditiveMod:
+			result.val[c] = vqadd_u8(dst.val[c], vmovn_u16(mulHighNEON(vmull_u8(src.val[c], alpha), mod)));
+			break;
+
+		case kOpSubtractive:
+			result.val[c] = vsub_u8(dst.val[c], vmovn_u16(mulHighNEON(vmull_u8(src.val[c], dst.val[c]), vmovl_u8(alpha))));
+			break;
+
+		case kOpSubtractiveMod:
+		default:
+			result.val[c] = vsub_u8(dst.val[c], vshrn_n_u16(mulHighNEON(vmulq_u16(vmovl_u8(src.val[c]), mod), vmull_u8(dst.val[c], alpha)), 8));
+			break;
+		}
+	}
+
+	if (op == kOpAlpha) {
+		// Pixels without any alpha leave the output untouched
+		const uint8x8_t transparent = vceq_u8(src.val[kAIndex], vdup_n_u8(0));
+		for (int i = 0; i < 4; i++)
+			result.val[i] = vbsl_u8(transparent, dst.val[i], result.val[i]);
+	}
+
+	return result;
+}
+
+template<BlendOp op>
+static void blendRowsNEON(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color, BlendProc reference) {
+	if (inStep != 4 && inStep != -4) {
+		reference(ino, outo, width, height, pitch, inStep, inoStep, color);
+		return;
+	}
+
+	const uint8 alphaMod = (color >> kAModShift) & 0xFF;
+	uint16 colorMod[4];
+	colorMod[kAIndex] = 0;
+	colorMod[kRIndex] = modFactor(color, kRModShift, op);
+	colorMod[kGIndex] = modFactor(color, kGModShift, op);
+	colorMod[kBIndex] = modFactor(color, kBModShift, op);
+	const uint32 vectorWidth = width & ~7;
+
+	for (uint32 i = 0; i < height; i++) {
+		byte *in = ino;
+		byte *out = outo;
+		for (uint32 j = 0; j < vectorWidth; j += 8) {
+			const uint8x8x4_t src = loadPixelsNEON(in, inStep < 0);
+			const uint8x8x4_t dst = vld4_u8(out);
+			vst4_u8(out, blendPixelsNEON<op>(src, dst, alphaMod, colorMod));
+			in += inStep * 8;
+			out += 32;
+		}
+
+		if (vectorWidth < width)
+			reference(in, out, width - vectorWidth, 1, pitch, inStep, inoStep, color);
+
+		outo += pitch;
+		ino += inoStep;
+	}
+}
+
+static void alphaBlendNEON(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color) {
+	if (color == 0xffffffff)
+		blendRowsNEON<kOpAlpha>(ino, outo, width, height, pitch, inStep, inoStep, color, &doBlitAlphaBlend);
+	else
+		blendRowsNEON<kOpAlphaMod>(ino, outo, width, height, pitch, inStep, inoStep, color, &doBlitAlphaBlend);
+}
+
+static void additiveBlendNEON(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color) {
+	if (color == 0xffffffff)
+		blendRowsNEON<kOpAdditive>(ino, outo, width, height, pitch, inStep, inoStep, color, &doBlitAdditiveBlend);
+	else
+		blendRowsNEON<kOpAdditiveMod>(ino, outo, width, height, pitch, inStep, inoStep, color, &doBlitAdditiveBlend);
+}
+
+static void subtractiveBlendNEON(byte *ino, byte *outo, uint32 width, uint32 height, uint32 pitch, int32 inStep, int32 inoStep, uint32 color) {
+	if (color == 0xffffffff)
+		blendRowsNEON<kOpSubtractive>(ino, outo, width, height, pitch, inStep, inoStep, color, &doBlitSubtractiveBlend);
+	else
+		blendRowsNEON<kOpSubtractiveMod>(ino, outo, width, height, pitch, inStep, inoStep, color, &doBlitSubtractiveBlend);
+}
+
+#endif // SIMD_NEON
+
+#pragma mark -
+
+bool TransparentSurface::isBlendKernelSupported(BlendKernel kernel) {
+	switch (kernel) {
+	case kBlendKernelScalar:
+		return true;
+#ifdef SIMD_SSE2
+	case kBlendKernelSSE2:
+		return SIMD_CPU_SUPPORTS("sse2");
+#endif
+#ifdef SIMD_NEON
+	case kBlendKernelNEON:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+TransparentSurface::BlendKernel TransparentSurface::getBestBlendKernel() {
+	static int best = -1;
+
+	if (best < 0) {
+		int kernel = kBlendKernelCount - 1;
+		while (!isBlendKernelSupported((BlendKernel)kernel))
+			--kernel;
+		best = kernel;
+	}
+
+	return (BlendKernel)best;
+}
+
+const char *TransparentSurface::getBlendKernelName(BlendKernel kernel) {
+	switch (kernel) {
+	case kBlendKernelScalar:
+		return "scalar";
+	case kBlendKernelSSE2:
+		return "SSE2";
+	case kBlendKernelNEON:
+		return "NEON";
+	default:
+		return "unknown";
+	}
+}
+
+#define BLEND_PROC(suffix) \
+	(blendMode == BLEND_ADDITIVE ? &additiveBlend##suffix : \
+	 blendMode == BLEND_SUBTRACTIVE ? &subtractiveBlend##suffix : &alphaBlend##suffix)
+
+BlendProc getBlendProc(TransparentSurface::BlendKernel kernel, TSpriteBlendMode blendMode) {
+	assert(blendMode == BLEND_NORMAL || blendMode == BLEND_ADDITIVE || blendMode == BLEND_SUBTRACTIVE);
+
+	if (!TransparentSurface::isBlendKernelSupported(kernel))
+		return 0;
+
+	switch (kernel) {
+#ifdef SIMD_SSE2
+	case TransparentSurface::kBlendKernelSSE2:
+		return BLEND_PROC(SSE2);
+#endif
+#ifdef SIMD_NEON
+	case TransparentSurface::kBlendKernelNEON:
+		return BLEND_PROC(NEON);
+#endif
+	default:
+		return blendMode == BLEND_ADDITIVE ? &doBlitAdditiveBlend :
+		       blendMode == BLEND_SUBTRACTIVE ? &doBlitSubtractiveBlend : &doBlitAlphaBlend;
+	}
+}
+
+#undef BLEND_PROC
+
+} // End of namespace Graphics
@@ -83,8 +83,11 @@
 // BASIS, AND BROWN UNIVERSITY HAS NO OBLIGATION TO PROVIDE MAINTENANCE,
 // SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
 
+#include "common/util.h"
+
 #include "graphics/surface.h"
 #include "graphics/yuv_to_rgb.h"
+#include "graphics/yuv_to_rgb_intern.h"
 
 namespace Common {
 DECLARE_SINGLETON(Graphics::YUVToRGBManager);
@@ -159,6 +162,7 @@ YUVToRGBLookup::YUVToRGBLookup(Graphics::PixelFormat format, YUVToRGBManager::Lu
 
 YUVToRGBManager::YUVToRGBManager() {
 	_lookup = 0;
+	_kernel = getBestKernel();
 
 	int16 *Cr_r_tab = &_colorTab[0 * 256];
 	int16 *Cr_g_tab = &_colorTab[1 * 256];
@@ -192,6 +196,11 @@ const YUVToRGBLookup *YUVToRGBManager::getLookup(Graphics::PixelFormat format, Y
 	return _lookup;
 }
 
+void YUVToRGBManager::setKernel(Kernel kernel) {
+	assert(isKernelSupported(kernel));
+	_kernel = kernel;
+}
+
 #define PUT_PIXEL(s, d) \
 	L = &rgbToPix[(s)]; \
 	*((PixelInt *)(d)) = (L[cr_r] | L[crb_g] | L[cb_b])
@@ -233,6 +242,21 @@ void YUVToRGBManager::convert444(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert(dst->format.bytesPerPixel == 2 || dst->format.bytesPerPixel == 4);
 	assert(ySrc && uSrc && vSrc);
 
+	YUVToRGBRowProc rowProc = getYUVToRGBRowProc(_kernel, dst->format.bytesPerPixel, false);
+	if (rowProc) {
+		const YUVToRGBParams params(dst->format, scale);
+		byte *dstPtr = (byte *)dst->getPixels();
+
+		for (int h = 0; h < yHeight; h++) {
+			rowProc(dstPtr, dst->pitch, ySrc, yPitch, uSrc, vSrc, yWidth, 1, params);
+			dstPtr += dst->pitch;
+			ySrc += yPitch;
+			uSrc += uvPitch;
+			vSrc += uvPitch;
+		}
+		return;
+	}
+
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
 
 	// Use a templated function to avoid an if check on every pixel
@@ -289,6 +313,21 @@ void YUVToRGBManager::convert420(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert((yWidth & 1) == 0);
 	assert((yHeight & 1) == 0);
 
+	YUVToRGBRowProc rowProc = getYUVToRGBRowProc(_kernel, dst->format.bytesPerPixel, true);
+	if (rowProc) {
+		const YUVToRGBParams params(dst->format, scale);
+		byte *dstPtr = (byte *)dst->getPixels();
+
+		for (int h = 0; h < yHeight; h += 2) {
+			rowProc(dstPtr, dst->pitch, ySrc, yPitch, uSrc, vSrc, yWidth, 2, params);
+			dstPtr += dst->pitch * 2;
+			ySrc += yPitch * 2;
+			uSrc += uvPitch;
+			vSrc += uvPitch;
+		}
+		return;
+	}
+
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
 
 	// Use a templated function to avoid an if check on every pixel
@@ -366,6 +405,22 @@ void convertYUV410ToRGB(byte *dstPtr, int dstPitch, const YUVToRGBLookup *lookup
 #undef DO_INTERPOLATION
 #undef DO_YUV410_PIXEL
 
+/**
+ * Interpolate the chroma values of one row of a YUV410 image, just like
+ * convertYUV410ToRGB() does it.
+ */
+static void interpolateYUV410Row(byte *dst, const byte *src, int quarterWidth, int yDiff, int uvPitch) {
+	for (int x = 0; x < quarterWidth; x++) {
+		const int a = src[x];
+		const int b = src[x + 1];
+		const int c = src[x + uvPitch];
+		const int d = src[x + uvPitch + 1];
+
+		for (int xDiff = 0; xDiff < 4; xDiff++)
+			*dst++ = (a * (4 - xDiff) * (4 - yDiff) + b * xDiff * (4 - yDiff) + c * yDiff * (4 - xDiff) + d * xDiff * yDiff) >> 4;
+	}
+}
+
 void YUVToRGBManager::convert410(Graphics::Surface *dst, YUVToRGBManager::LuminanceScale scale, const byte *ySrc, const byte *uSrc, const byte *vSrc, int yWidth, int yHeight, int yPitch, int uvPitch) {
 	// Sanity checks
 	assert(dst && dst->getPixels());
@@ -374,6 +429,34 @@ void YUVToRGBManager::convert410(Graphics::Surface *dst, YUVToRGBManager::Lumina
 	assert((yWidth & 3) == 0);
 	assert((yHeight & 3) == 0);
 
+	YUVToRGBRowProc rowProc = getYUVToRGBRowProc(_kernel, dst->format.bytesPerPixel, false);
+	if (rowProc) {
+		// Upscale the chroma of each row first, then convert it as YUV444.
+		// The chroma goes to the stack, a piece of the row at a time, as
+		// several threads may convert frames at once.
+		enum { kChunkWidth = 512 };
+		byte uRow[kChunkWidth], vRow[kChunkWidth];
+
+		const YUVToRGBParams params(dst->format, scale);
+		byte *dstPtr = (byte *)dst->getPixels();
+		const int bytesPerPixel = dst->format.bytesPerPixel;
+
+		for (int h = 0; h < yHeight; h++) {
+			const int offset = (h >> 2) * uvPitch;
+
+			for (int x = 0; x < yWidth; x += kChunkWidth) {
+				const int width = MIN<int>(kChunkWidth, yWidth - x);
+				interpolateYUV410Row(uRow, uSrc + offset + (x >> 2), width >> 2, h & 3, uvPitch);
+				interpolateYUV410Row(vRow, vSrc + offset + (x >> 2), width >> 2, h & 3, uvPitch);
+				rowProc(dstPtr + x * bytesPerPixel, dst->pitch, ySrc + x, yPitch, uRow, vRow, width, 1, params);
+			}
+
+			dstPtr += dst->pitch;
+			ySrc += yPitch;
+		}
+		return;
+	}
+
 	const YUVToRGBLookup *lookup = getLookup(dst->format, scale);
 
 	// Use a templated function to avoid an if check on every pixel
@@ -54,6 +54,39 @@ public:
 		kScaleITU   /** Luminance values range from [16, 235], the range from ITU-R BT.601 */
 	};
 
+	/**
+	 * Implementations of the conversion. The vector kernels compute the
+	 * colors arithmetically and may differ from the lookup tables by a
+	 * few steps per component.
+	 */
+	enum Kernel {
+		kKernelLookup, /** Per pixel table lookups, the reference */
+		kKernelSSE2,
+		kKernelAVX2,
+		kKernelNEON,
+
+		kKernelCount
+	};
+
+	/**
+	 * Return the fastest kernel which is compiled in and supported by the
+	 * CPU we are running on.
+	 */
+	static Kernel getBestKernel();
+
+	/** Return whether the kernel is compiled in and supported by the CPU. */
+	static bool isKernelSupported(Kernel kernel);
+
+	/** Return a human readable name of the specified kernel. */
+	static const char *getKernelName(Kernel kernel);
+
+	/**
+	 * Use the specified kernel instead of the best available one. Meant
+	 * for tests and benchmarks.
+	 */
+	void setKernel(Kernel kernel);
+	Kernel getKernel() const { return _kernel; }
+
 	/**
 	 * Convert a YUV444 image to an RGB surface
 	 *
@@ -114,6 +147,7 @@ private:
 
 	YUVToRGBLookup *_lookup;
 	int16 _colorTab[4 * 256]; // 2048 bytes
+	Kernel _kernel;
 };
 
 } // End of namespace Graphics
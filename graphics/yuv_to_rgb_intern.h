@@ -0,0 +1,77 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef GRAPHICS_YUV_TO_RGB_INTERN_H
+#define GRAPHICS_YUV_TO_RGB_INTERN_H
+
+#include "graphics/yuv_to_rgb.h"
+
+namespace Graphics {
+
+/**
+ * What the vector kernels need to know about the destination of a
+ * conversion.
+ */
+struct YUVToRGBParams {
+	YUVToRGBParams(const PixelFormat &format, YUVToRGBManager::LuminanceScale scale);
+
+	bool fullScale;
+	int rLoss, gLoss, bLoss;
+	int rShift, gShift, bShift;
+	/** The bits to set for an opaque alpha channel */
+	uint32 alpha;
+
+	/**
+	 * For 4 bytes per pixel with 8 bits per component at byte boundaries:
+	 * which component goes into each byte of a pixel, from the lowest to the
+	 * highest, 0-2 for red, green and blue, 3 for the opaque alpha and 4 for
+	 * unused bytes. bytes[0] is -1 for any other format.
+	 */
+	int bytes[4];
+};
+
+/**
+ * Convert one or more rows of pixels sharing the same chroma values.
+ *
+ * @param dst      the first destination row
+ * @param dstPitch the pitch of the destination
+ * @param ySrc     the y component of the first row
+ * @param yPitch   the pitch of the y component
+ * @param uSrc     the u component of the rows, one value per pixel or per
+ *                 two pixels, depending on the procedure
+ * @param vSrc     the v component of the rows, laid out like uSrc
+ * @param width    the number of pixels per row
+ * @param rows     the number of rows
+ * @param params   the destination format
+ */
+typedef void (*YUVToRGBRowProc)(byte *dst, int dstPitch, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int width, int rows, const YUVToRGBParams &params);
+
+/**
+ * Return the row conversion of a vector kernel for 2 or 4 bytes per pixel,
+ * with full or horizontally halved chroma resolution. Returns 0 for the
+ * lookup kernel and for kernels not available on this CPU.
+ */
+YUVToRGBRowProc getYUVToRGBRowProc(YUVToRGBManager::Kernel kernel, int bytesPerPixel, bool halfChroma);
+
+} // End of namespace Graphics
+
+#endif
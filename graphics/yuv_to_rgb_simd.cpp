@@ -0,0 +1,522 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Vector kernels for the YUV to RGB conversion.
+ *
+ * Instead of looking up every pixel in tables, the kernels compute the
+ * colors with 16 bit fixed point arithmetic, using the coefficients the
+ * tables of YUVToRGBManager are built from. Each chroma term is a high
+ * multiplication of the chroma value times 4 by the coefficient times 2^14,
+ * which rounds down where the tables truncate, so the results may differ
+ * from those of the lookup kernel by a few steps. All vector kernels and
+ * the scalar code handling the pixels left over at the end of a row give
+ * the same results though.
+ *
+ * Rows sharing their chroma values, like the two rows of YUV420, are
+ * converted together, so the chroma terms are only computed once. For the
+ * ITU range, luminance and chroma terms are stretched separately, which
+ * saves stretching each component of each pixel.
+ */
+
+// Allow use of the compiler intrinsic headers
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "common/cpu-features.h"
+#include "common/endian.h"
+#include "common/util.h"
+
+#include "graphics/yuv_to_rgb_intern.h"
+
+namespace Graphics {
+
+// The coefficients of YUVToRGBManager times 2^14
+enum {
+	kCrR = 22960,   //  0.419 / 0.299
+	kCrG = -11692,  // -0.299 / 0.419
+	kCbG = -5643,   // -0.114 / 0.331
+	kCbB = 29056,   //  0.587 / 0.331
+	kScale = 19077  //  255 / 219, stretching the ITU range
+};
+
+YUVToRGBParams::YUVToRGBParams(const PixelFormat &format, YUVToRGBManager::LuminanceScale scale) {
+	fullScale = (scale == YUVToRGBManager::kScaleFull);
+	rLoss = format.rLoss;
+	gLoss = format.gLoss;
+	bLoss = format.bLoss;
+	rShift = format.rShift;
+	gShift = format.gShift;
+	bShift = format.bShift;
+	alpha = format.aLoss < 8 ? (0xFF >> format.aLoss) << format.aShift : 0;
+
+	for (int i = 0; i < 4; i++)
+		bytes[i] = 4;
+
+	const int shifts[4] = { rShift, gShift, bShift, format.aShift };
+	const int losses[4] = { rLoss, gLoss, bLoss, format.aLoss };
+	for (int i = 0; i < 4; i++) {
+		if (i == 3 && losses[i] == 8)
+			continue;
+
+		if (format.bytesPerPixel != 4 || losses[i] != 0 || (shifts[i] & 7) || bytes[shifts[i] >> 3] != 4) {
+			bytes[0] = -1;
+			break;
+		}
+		bytes[shifts[i] >> 3] = i;
+	}
+}
+
+static inline int mulHigh(int a, int b) {
+	return (a * b) >> 16;
+}
+
+/** Convert one pixel exactly like the vector kernels do. */
+template<typename PixelInt>
+static inline PixelInt convertPixel(int y, int u, int v, const YUVToRGBParams &params) {
+	const int cr = (v - 128) * 4;
+	const int cb = (u - 128) * 4;
+
+	int rAdd = mulHigh(cr, kCrR);
+	int gAdd = mulHigh(cr, kCrG) + mulHigh(cb, kCbG);
+	int bAdd = mulHigh(cb, kCbB);
+
+	if (!params.fullScale) {
+		y = mulHigh((y - 16) * 4, kScale);
+		rAdd = mulHigh(rAdd * 4, kScale);
+		gAdd = mulHigh(gAdd * 4, kScale);
+		bAdd = mulHigh(bAdd * 4, kScale);
+	}
+
+	const int r = CLIP(y + rAdd, 0, 255);
+	const int g = CLIP(y + gAdd, 0, 255);
+	const int b = CLIP(y + bAdd, 0, 255);
+
+	return params.alpha | (r >> params.rLoss) << params.rShift | (g >> params.gLoss) << params.gShift | (b >> params.bLoss) << params.bShift;
+}
+
+template<typename PixelInt, bool halfChroma>
+static void convertRowsScalar(byte *dst, int dstPitch, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int x, int width, int rows, const YUVToRGBParams &params) {
+	for (int row = 0; row < rows; row++) {
+		PixelInt *out = (PixelInt *)(dst + row * dstPitch);
+		const byte *yRow = ySrc + row * yPitch;
+
+		for (int i = x; i < width; i++) {
+			const int c = halfChroma ? i >> 1 : i;
+			out[i] = convertPixel<PixelInt>(yRow[i], uSrc[c], vSrc[c], params);
+		}
+	}
+}
+
+#pragma mark -
+
+#ifdef SIMD_SSE2
+
+/**
+ * Compute the chroma terms of the red, green and blue values of eight
+ * pixels, already stretched for the ITU range.
+ */
+SIMD_TARGET("sse2") static inline void chromaSSE2(__m128i u, __m128i v, bool fullScale, __m128i &rAdd, __m128i &gAdd, __m128i &bAdd) {
+	const __m128i bias = _mm_set1_epi16(128);
+	const __m128i cr = _mm_slli_epi16(_mm_sub_epi16(v, bias), 2);
+	const __m128i cb = _mm_slli_epi16(_mm_sub_epi16(u, bias), 2);
+
+	rAdd = _mm_mulhi_epi16(cr, _mm_set1_epi16(kCrR));
+	gAdd = _mm_add_epi16(_mm_mulhi_epi16(cr, _mm_set1_epi16(kCrG)), _mm_mulhi_epi16(cb, _mm_set1_epi16(kCbG)));
+	bAdd = _mm_mulhi_epi16(cb, _mm_set1_epi16(kCbB));
+
+	if (!fullScale) {
+		const __m128i scale = _mm_set1_epi16(kScale);
+		rAdd = _mm_mulhi_epi16(_mm_slli_epi16(rAdd, 2), scale);
+		gAdd = _mm_mulhi_epi16(_mm_slli_epi16(gAdd, 2), scale);
+		bAdd = _mm_mulhi_epi16(_mm_slli_epi16(bAdd, 2), scale);
+	}
+}
+
+/** Compute the red, green and blue values of eight pixels, in 16 bit lanes. */
+SIMD_TARGET("sse2") static inline void pixelsSSE2(__m128i y, __m128i rAdd, __m128i gAdd, __m128i bAdd, bool fullScale, __m128i &r, __m128i &g, __m128i &b) {
+	if (!fullScale)
+		y = _mm_mulhi_epi16(_mm_slli_epi16(_mm_sub_epi16(y, _mm_set1_epi16(16)), 2), _mm_set1_epi16(kScale));
+
+	r = _mm_add_epi16(y, rAdd);
+	g = _mm_add_epi16(y, gAdd);
+	b = _mm_add_epi16(y, bAdd);
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i white = _mm_set1_epi16(255);
+	r = _mm_min_epi16(_mm_max_epi16(r, zero), white);
+	g = _mm_min_epi16(_mm_max_epi16(g, zero), white);
+	b = _mm_min_epi16(_mm_max_epi16(b, zero), white);
+}
+
+template<typename PixelInt, bool halfChroma>
+SIMD_TARGET("sse2") static void convertRowsSSE2(byte *dst, int dstPitch, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int width, int rows, const YUVToRGBParams &params) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rLoss = _mm_cvtsi32_si128(params.rLoss), rShift = _mm_cvtsi32_si128(params.rShift);
+	const __m128i gLoss = _mm_cvtsi32_si128(params.gLoss), gShift = _mm_cvtsi32_si128(params.gShift);
+	const __m128i bLoss = _mm_cvtsi32_si128(params.bLoss), bShift = _mm_cvtsi32_si128(params.bShift);
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		__m128i u, v;
+		if (halfChroma) {
+			u = _mm_cvtsi32_si128(READ_UINT32(uSrc + x / 2));
+			v = _mm_cvtsi32_si128(READ_UINT32(vSrc + x / 2));
+			u = _mm_unpacklo_epi8(u, u);
+			v = _mm_unpacklo_epi8(v, v);
+		} else {
+			u = _mm_loadl_epi64((const __m128i *)(uSrc + x));
+			v = _mm_loadl_epi64((const __m128i *)(vSrc + x));
+		}
+
+		__m128i rAdd, gAdd, bAdd;
+		chromaSSE2(_mm_unpacklo_epi8(u, zero), _mm_unpacklo_epi8(v, zero), params.fullScale, rAdd, gAdd, bAdd);
+
+		for (int row = 0; row < rows; row++) {
+			PixelInt *out = (PixelInt *)(dst + row * dstPitch) + x;
+			const __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(ySrc + row * yPitch + x)), zero);
+
+			__m128i r, g, b;
+			pixelsSSE2(y, rAdd, gAdd, bAdd, params.fullScale, r, g, b);
+
+			if (sizeof(PixelInt) == 2) {
+				__m128i pixels = _mm_set1_epi16((int16)params.alpha);
+				pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(r, rLoss), rShift));
+				pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(g, gLoss), gShift));
+				pixels = _mm_or_si128(pixels, _mm_sll_epi16(_mm_srl_epi16(b, bLoss), bShift));
+				_mm_storeu_si128((__m128i *)out, pixels);
+			} else if (params.bytes[0] >= 0) {
+				// Put the components into the low and high halves of the pixels
+				const __m128i components[5] = { r, g, b, _mm_set1_epi16(0xFF), zero };
+				const __m128i low = _mm_or_si128(components[params.bytes[0]], _mm_slli_epi16(components[params.bytes[1]], 8));
+				const __m128i high = _mm_or_si128(components[params.bytes[2]], _mm_slli_epi16(components[params.bytes[3]], 8));
+				_mm_storeu_si128((__m128i *)out, _mm_unpacklo_epi16(low, high));
+				_mm_storeu_si128((__m128i *)(out + 4), _mm_unpackhi_epi16(low, high));
+			} else {
+				for (int half = 0; half < 2; half++) {
+					const __m128i r32 = half ? _mm_unpackhi_epi16(r, zero) : _mm_unpacklo_epi16(r, zero);
+					const __m128i g32 = half ? _mm_unpackhi_epi16(g, zero) : _mm_unpacklo_epi16(g, zero);
+					const __m128i b32 = half ? _mm_unpackhi_epi16(b, zero) : _mm_unpacklo_epi16(b, zero);
+					__m128i pixels = _mm_set1_epi32((int)params.alpha);
+					pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_srl_epi32(r32, rLoss), rShift));
+					pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_srl_epi32(g32, gLoss), gShift));
+					pixels = _mm_or_si128(pixels, _mm_sll_epi32(_mm_srl_epi32(b32, bLoss), bShift));
+					_mm_storeu_si128((__m128i *)(out + half * 4), pixels);
+				}
+			}
+		}
+	}
+
+	convertRowsScalar<PixelInt, halfChroma>(dst, dstPitch, ySrc, yPitch, uSrc, vSrc, x, width, rows, params);
+}
+
+#endif // SIMD_SSE2
+
+#ifdef SIMD_AVX2
+
+/** The AVX2 counterpart of chromaSSE2(), for sixteen pixels. */
+SIMD_TARGET("avx2") static inline void chromaAVX2(__m256i u, __m256i v, bool fullScale, __m256i &rAdd, __m256i &gAdd, __m256i &bAdd) {
+	const __m256i bias = _mm256_set1_epi16(128);
+	const __m256i cr = _mm256_slli_epi16(_mm256_sub_epi16(v, bias), 2);
+	const __m256i cb = _mm256_slli_epi16(_mm256_sub_epi16(u, bias), 2);
+
+	rAdd = _mm256_mulhi_epi16(cr, _mm256_set1_epi16(kCrR));
+	gAdd = _mm256_add_epi16(_mm256_mulhi_epi16(cr, _mm256_set1_epi16(kCrG)), _mm256_mulhi_epi16(cb, _mm256_set1_epi16(kCbG)));
+	bAdd = _mm256_mulhi_epi16(cb, _mm256_set1_epi16(kCbB));
+
+	if (!fullScale) {
+		const __m256i scale = _mm256_set1_epi16(kScale);
+		rAdd = _mm256_mulhi_epi16(_mm256_slli_epi16(rAdd, 2), scale);
+		gAdd = _mm256_mulhi_epi16(_mm256_slli_epi16(gAdd, 2), scale);
+		bAdd = _mm256_mulhi_epi16(_mm256_slli_epi16(bAdd, 2), scale);
+	}
+}
+
+/** The AVX2 counterpart of pixelsSSE2(), for sixteen pixels. */
+SIMD_TARGET("avx2") static inline void pixelsAVX2(__m256i y, __m256i rAdd, __m256i gAdd, __m256i bAdd, bool fullScale, __m256i &r, __m256i &g, __m256i &b) {
+	if (!fullScale)
+		y = _mm256_mulhi_epi16(_mm256_slli_epi16(_mm256_sub_epi16(y, _mm256_set1_epi16(16)), 2), _mm256_set1_epi16(kScale));
+
+	r = _mm256_add_epi16(y, rAdd);
+	g = _mm256_add_epi16(y, gAdd);
+	b = _mm256_add_epi16(y, bAdd);
+
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i white = _mm256_set1_epi16(255);
+	r = _mm256_min_epi16(_mm256_max_epi16(r, zero), white);
+	g = _mm256_min_epi16(_mm256_max_epi16(g, zero), white);
+	b = _mm256_min_epi16(_mm256_max_epi16(b, zero), white);
+}
+
+template<typename PixelInt, bool halfChroma>
+SIMD_TARGET("avx2") static void convertRowsAVX2(byte *dst, int dstPitch, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int width, int rows, const YUVToRGBParams &params) {
+	const __m128i rLoss = _mm_cvtsi32_si128(params.rLoss), rShift = _mm_cvtsi32_si128(params.rShift);
+	const __m128i gLoss = _mm_cvtsi32_si128(params.gLoss), gShift = _mm_cvtsi32_si128(params.gShift);
+	const __m128i bLoss = _mm_cvtsi32_si128(params.bLoss), bShift = _mm_cvtsi32_si128(params.bShift);
+
+	int x = 0;
+	for (; x + 16 <= width; x += 16) {
+		__m128i u, v;
+		if (halfChroma) {
+			u = _mm_loadl_epi64((const __m128i *)(uSrc + x / 2));
+			v = _mm_loadl_epi64((const __m128i *)(vSrc + x / 2));
+			u = _mm_unpacklo_epi8(u, u);
+			v = _mm_unpacklo_epi8(v, v);
+		} else {
+			u = _mm_loadu_si128((const __m128i *)(uSrc + x));
+			v = _mm_loadu_si128((const __m128i *)(vSrc + x));
+		}
+
+		__m256i rAdd, gAdd, bAdd;
+		chromaAVX2(_mm256_cvtepu8_epi16(u), _mm256_cvtepu8_epi16(v), params.fullScale, rAdd, gAdd, bAdd);
+
+		for (int row = 0; row < rows; row++) {
+			PixelInt *out = (PixelInt *)(dst + row * dstPitch) + x;
+			const __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(ySrc + row * yPitch + x)));
+
+			__m256i r, g, b;
+			pixelsAVX2(y, rAdd, gAdd, bAdd, params.fullScale, r, g, b);
+
+			if (sizeof(PixelInt) == 2) {
+				__m256i pixels = _mm256_set1_epi16((int16)params.alpha);
+				pixels = _mm256_or_si256(pixels, _mm256_sll_epi16(_mm256_srl_epi16(r, rLoss), rShift));
+				pixels = _mm256_or_si256(pixels, _mm256_sll_epi16(_mm256_srl_epi16(g, gLoss), gShift));
+				pixels = _mm256_or_si256(pixels, _mm256_sll_epi16(_mm256_srl_epi16(b, bLoss), bShift));
+				_mm256_storeu_si256((__m256i *)out, pixels);
+			} else if (params.bytes[0] >= 0) {
+				const __m256i components[5] = { r, g, b, _mm256_set1_epi16(0xFF), _mm256_setzero_si256() };
+				const __m256i low = _mm256_or_si256(components[params.bytes[0]], _mm256_slli_epi16(components[params.bytes[1]], 8));
+				const __m256i high = _mm256_or_si256(components[params.bytes[2]], _mm256_slli_epi16(components[params.bytes[3]], 8));
+				// Unpacking works within 128 bit lanes, which gives pixels 0-3 and 8-11, resp. 4-7 and 12-15
+				const __m256i pixels0 = _mm256_unpacklo_epi16(low, high);
+				const __m256i pixels1 = _mm256_unpackhi_epi16(low, high);
+				_mm256_storeu_si256((__m256i *)out, _mm256_permute2x128_si256(pixels0, pixels1, 0x20));
+				_mm256_storeu_si256((__m256i *)(out + 8), _mm256_permute2x128_si256(pixels0, pixels1, 0x31));
+			} else {
+				for (int half = 0; half < 2; half++) {
+					const __m256i r32 = _mm256_cvtepu16_epi32(half ? _mm256_extracti128_si256(r, 1) : _mm256_castsi256_si128(r));
+					const __m256i g32 = _mm256_cvtepu16_epi32(half ? _mm256_extracti128_si256(g, 1) : _mm256_castsi256_si128(g));
+					const __m256i b32 = _mm256_cvtepu16_epi32(half ? _mm256_extracti128_si256(b, 1) : _mm256_castsi256_si128(b));
+					__m256i pixels = _mm256_set1_epi32((int)params.alpha);
+					pixels = _mm256_or_si256(pixels, _mm256_sll_epi32(_mm256_srl_epi32(r32, rLoss), rShift));
+					pixels = _mm256_or_si256(pixels, _mm256_sll_epi32(_mm256_srl_epi32(g32, gLoss), gShift));
+					pixels = _mm256_or_si256(pixels, _mm256_sll_epi32(_mm256_srl_epi32(b32, bLoss), bShift));
+					_mm256_storeu_si256((__m256i *)(out + half * 8), pixels);
+				}
+			}
+		}
+	}
+
+	convertRowsScalar<PixelInt, halfChroma>(dst, dstPitch, ySrc, yPitch, uSrc, vSrc, x, width, rows, params);
+}
+
+#endif // SIMD_AVX2
+
+#ifdef SIMD_NEON
+
+/**
+ * The NEON counterpart of chromaSSE2(). A doubling high multiplication of
+ * the chroma value times 2 gives the same result as the high multiplication
+ * of the chroma value times 4 there.
+ */
+static inline void chromaNEON(int16x8_t u, int16x8_t v, bool fullScale, int16x8_t &rAdd, int16x8_t &gAdd, int16x8_t &bAdd) {
+	const int16x8_t bias = vdupq_n_s16(128);
+	const int16x8_t cr = vshlq_n_s16(vsubq_s16(v, bias), 1);
+	const int16x8_t cb = vshlq_n_s16(vsubq_s16(u, bias), 1);
+
+	rAdd = vqdmulhq_s16(cr, vdupq_n_s16(kCrR));
+	gAdd = vaddq_s16(vqdmulhq_s16(cr, vdupq_n_s16(kCrG)), vqdmulhq_s16(cb, vdupq_n_s16(kCbG)));
+	bAdd = vqdmulhq_s16(cb, vdupq_n_s16(kCbB));
+
+	if (!fullScale) {
+		const int16x8_t scale = vdupq_n_s16(kScale);
+		rAdd = vqdmulhq_s16(vshlq_n_s16(rAdd, 1), scale);
+		gAdd = vqdmulhq_s16(vshlq_n_s16(gAdd, 1), scale);
+		bAdd = vqdmulhq_s16(vshlq_n_s16(bAdd, 1), scale);
+	}
+}
+
+/** The NEON counterpart of pixelsSSE2(). */
+static inline void pixelsNEON(int16x8_t y, int16x8_t rAdd, int16x8_t gAdd, int16x8_t bAdd, bool fullScale, int16x8_t &r, int16x8_t &g, int16x8_t &b) {
+	if (!fullScale)
+		y = vqdmulhq_s16(vshlq_n_s16(vsubq_s16(y, vdupq_n_s16(16)), 1), vdupq_n_s16(kScale));
+
+	r = vaddq_s16(y, rAdd);
+	g = vaddq_s16(y, gAdd);
+	b = vaddq_s16(y, bAdd);
+
+	const int16x8_t zero = vdupq_n_s16(0);
+	const int16x8_t white = vdupq_n_s16(255);
+	r = vminq_s16(vmaxq_s16(r, zero), white);
+	g = vminq_s16(vmaxq_s16(g, zero), white);
+	b = vminq_s16(vmaxq_s16(b, zero), white);
+}
+
+template<typename PixelInt, bool halfChroma>
+static void convertRowsNEON(byte *dst, int dstPitch, const byte *ySrc, int yPitch, const byte *uSrc, const byte *vSrc, int width, int rows, const YUVToRGBParams &params) {
+	// Shifting by a negative count shifts to the right
+	const int16x8_t rLoss16 = vdupq_n_s16(-params.rLoss), rShift16 = vdupq_n_s16(params.rShift);
+	const int16x8_t gLoss16 = vdupq_n_s16(-params.gLoss), gShift16 = vdupq_n_s16(params.gShift);
+	const int16x8_t bLoss16 = vdupq_n_s16(-params.bLoss), bShift16 = vdupq_n_s16(params.bShift);
+	const int32x4_t rLoss32 = vdupq_n_s32(-params.rLoss), rShift32 = vdupq_n_s32(params.rShift);
+	const int32x4_t gLoss32 = vdupq_n_s32(-params.gLoss), gShift32 = vdupq_n_s32(params.gShift);
+	const int32x4_t bLoss32 = vdupq_n_s32(-params.bLoss), bShift32 = vdupq_n_s32(params.bShift);
+
+	int x = 0;
+	for (; x + 8 <= width; x += 8) {
+		uint8x8_t u, v;
+		if (halfChroma) {
+			u = vreinterpret_u8_u32(vdup_n_u32(READ_UINT32(uSrc + x / 2)));
+			v = vreinterpret_u8_u32(vdup_n_u32(READ_UINT32(vSrc + x / 2)));
+			u = vzip_u8(u, u).val[0];
+			v = vzip_u8(v, v).val[0];
+		} else {
+			u = vld1_u8(uSrc + x);
+			v = vld1_u8(vSrc + x);
+		}
+
+		int16x8_t rAdd, gAdd, bAdd;
+		chromaNEON(vreinterpretq_s16_u16(vmovl_u8(u)), vreinterpretq_s16_u16(vmovl_u8(v)), params.fullScale, rAdd, gAdd, bAdd);
+
+		for (int row = 0; row < rows; row++) {
+			PixelInt *out = (PixelInt *)(dst + row * dstPitch) + x;
+			const int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(ySrc + row * yPitch + x)));
+
+			int16x8_t r, g, b;
+			pixelsNEON(y, rAdd, gAdd, bAdd, params.fullScale, r, g, b);
+
+			const uint16x8_t r16 = vreinterpretq_u16_s16(r);
+			const uint16x8_t g16 = vreinterpretq_u16_s16(g);
+			const uint16x8_t b16 = vreinterpretq_u16_s16(b);
+
+			if (sizeof(PixelInt) == 2) {
+				uint16x8_t pixels = vdupq_n_u16((uint16)params.alpha);
+				pixels = vorrq_u16(pixels, vshlq_u16(vshlq_u16(r16, rLoss16), rShift16));
+				pixels = vorrq_u16(pixels, vshlq_u16(vshlq_u16(g16, gLoss16), gShift16));
+				pixels = vorrq_u16(pixels, vshlq_u16(vshlq_u16(b16, bLoss16), bShift16));
+				vst1q_u16((uint16_t *)out, pixels);
+			} else if (params.bytes[0] >= 0) {
+				const uint16x8_t components[5] = { r16, g16, b16, vdupq_n_u16(0xFF), vdupq_n_u16(0) };
+				const uint16x8_t low = vorrq_u16(components[params.bytes[0]], vshlq_n_u16(components[params.bytes[1]], 8));
+				const uint16x8_t high = vorrq_u16(components[params.bytes[2]], vshlq_n_u16(components[params.bytes[3]], 8));
+				const uint16x8x2_t pixels = vzipq_u16(low, high);
+				vst1q_u16((uint16_t *)out, pixels.val[0]);
+				vst1q_u16((uint16_t *)(out + 4), pixels.val[1]);
+			} else {
+				for (int half = 0; half < 2; half++) {
+					const uint32x4_t r32 = vmovl_u16(half ? vget_high_u16(r16) : vget_low_u16(r16));
+					const uint32x4_t g32 = vmovl_u16(half ? vget_high_u16(g16) : vget_low_u16(g16));
+					const uint32x4_t b32 = vmovl_u16(half ? vget_high_u16(b16) : vget_low_u16(b16));
+					uint32x4_t pixels = vdupq_n_u32(params.alpha);
+					pixels = vorrq_u32(pixels, vshlq_u32(vshlq_u32(r32, rLoss32), rShift32));
+					pixels = vorrq_u32(pixels, vshlq_u32(vshlq_u32(g32, gLoss32), gShift32));
+					pixels = vorrq_u32(pixels, vshlq_u32(vshlq_u32(b32, bLoss32), bShift32));
+					vst1q_u32((uint32_t *)(out + half * 4), pixels);
+				}
+			}
+		}
+	}
+
+	convertRowsScalar<PixelInt, halfChroma>(dst, dstPitch, ySrc, yPitch, uSrc, vSrc, x, width, rows, params);
+}
+
+#endif // SIMD_NEON
+
+#pragma mark -
+
+bool YUVToRGBManager::isKernelSupported(Kernel kernel) {
+	switch (kernel) {
+	case kKernelLookup:
+		return true;
+#ifdef SIMD_SSE2
+	case kKernelSSE2:
+		return SIMD_CPU_SUPPORTS("sse2");
+#endif
+#ifdef SIMD_AVX2
+	case kKernelAVX2:
+		return SIMD_CPU_SUPPORTS("avx2");
+#endif
+#ifdef SIMD_NEON
+	case kKernelNEON:
+		return true;
+#endif
+	default:
+		return false;
+	}
+}
+
+YUVToRGBManager::Kernel YUVToRGBManager::getBestKernel() {
+	static int best = -1;
+
+	if (best < 0) {
+		int kernel = kKernelCount - 1;
+		while (!isKernelSupported((Kernel)kernel))
+			--kernel;
+		best = kernel;
+	}
+
+	return (Kernel)best;
+}
+
+const char *YUVToRGBManager::getKernelName(Kernel kernel) {
+	switch (kernel) {
+	case kKernelLookup:
+		return "lookup";
+	case kKernelSSE2:
+		return "SSE2";
+	case kKernelAVX2:
+		return "AVX2";
+	case kKernelNEON:
+		return "NEON";
+	default:
+		return "unknown";
+	}
+}
+
+#define ROW_PROC(name) \
+	(bytesPerPixel == 2 ? (halfChroma ? &name<uint16, true> : &name<uint16, false>) : \
+	                      (halfChroma ? &name<uint32, true> : &name<uint32, false>))
+
+YUVToRGBRowProc getYUVToRGBRowProc(YUVToRGBManager::Kernel kernel, int bytesPerPixel, bool halfChroma) {
+	if (!YUVToRGBManager::isKernelSupported(kernel))
+		return 0;
+
+	switch (kernel) {
+#ifdef SIMD_SSE2
+	case YUVToRGBManager::kKernelSSE2:
+		return ROW_PROC(convertRowsSSE2);
+#endif
+#ifdef SIMD_AVX2
+	case YUVToRGBManager::kKernelAVX2:
+		return ROW_PROC(convertRowsAVX2);
+#endif
+#ifdef SIMD_NEON
+	case YUVToRGBManager::kKernelNEON:
+		return ROW_PROC(convertRowsNEON);
+#endif
+	default:
+		return 0;
+	}
+}
+
+#undef ROW_PROC
+
+} // End of namespace Graphics
@@ -101,6 +101,121 @@ struct WidgetDrawData {
 	void calcBackgroundOffset();
 };
 
+/**
+ * Remembers the results of drawing DrawData items, so that drawing one again
+ * with the same size and state over the same background is a copy instead of
+ * running its drawing steps.
+ */
+class WidgetCache {
+public:
+	/** Everything besides the background that the drawing depends on */
+	struct Key {
+		const WidgetDrawData *data;
+		int16 width, height;
+		/** Gradients are dithered by the parity of the screen column */
+		bool oddLeft;
+		uint32 dynamic;
+		Common::Rect clip; ///< Relative to the widget, empty when not clipped
+		bool shadows;
+		uint32 colors[5];  ///< The renderer colors the steps start with
+
+		bool operator==(const Key &other) const {
+			return data == other.data && width == other.width && height == other.height &&
+			       oddLeft == other.oddLeft && dynamic == other.dynamic && clip == other.clip && shadows == other.shadows &&
+			       !memcmp(colors, other.colors, sizeof(colors));
+		}
+	};
+
+	struct Entry {
+		Key key;
+		Graphics::Surface background; ///< The pixels before drawing
+		Graphics::Surface result;     ///< The pixels after drawing
+		Common::List<Entry *>::iterator lruPosition;
+	};
+
+	/** Memory used for the surfaces of the entries at most */
+	static const uint32 kCacheSize = 2 * 1024 * 1024;
+
+	WidgetCache() : _size(0) {}
+	~WidgetCache() { clear(); }
+
+	Entry *find(const Key &key);
+
+	/** Add an entry, the cache takes ownership of the surfaces */
+	void add(const Key &key, Graphics::Surface &background, Graphics::Surface &result);
+
+	void clear();
+
+private:
+	struct KeyHash {
+		uint operator()(const Key &key) const {
+			uint hash = (uint)(size_t)key.data;
+			hash = hash * 31 + key.width;
+			hash = hash * 31 + key.height;
+			hash = hash * 31 + key.oddLeft;
+			hash = hash * 31 + key.dynamic;
+			hash = hash * 31 + key.clip.left + (key.clip.top << 16);
+			hash = hash * 31 + key.clip.right + (key.clip.bottom << 16);
+			for (int i = 0; i < ARRAYSIZE(key.colors); ++i)
+				hash = hash * 31 + key.colors[i];
+			return hash;
+		}
+	};
+
+	void remove(Entry *entry);
+
+	typedef Common::HashMap<Key, Entry *, KeyHash> EntryMap;
+	EntryMap _entries;
+	/** The entries from the most to the least recently used */
+	Common::List<Entry *> _lru;
+	uint32 _size;
+};
+
+WidgetCache::Entry *WidgetCache::find(const Key &key) {
+	EntryMap::iterator i = _entries.find(key);
+	if (i == _entries.end())
+		return 0;
+
+	Entry *entry = i->_value;
+	_lru.erase(entry->lruPosition);
+	_lru.push_front(entry);
+	entry->lruPosition = _lru.begin();
+	return entry;
+}
+
+void WidgetCache::add(const Key &key, Graphics::Surface &background, Graphics::Surface &result) {
+	EntryMap::iterator i = _entries.find(key);
+	if (i != _entries.end())
+		remove(i->_value);
+
+	Entry *entry = new Entry();
+	entry->key = key;
+	entry->background = background;
+	entry->result = result;
+	_size += background.h * background.pitch + result.h * result.pitch;
+
+	while (_size > kCacheSize && !_lru.empty())
+		remove(_lru.back());
+
+	_lru.push_front(entry);
+	entry->lruPosition = _lru.begin();
+	_entries[key] = entry;
+}
+
+void WidgetCache::remove(Entry *entry) {
+	_entries.erase(entry->key);
+	_lru.erase(entry->lruPosition);
+	_size -= entry->background.h * entry->background.pitch + entry->result.h * entry->result.pitch;
+	entry->background.free();
+	entry->result.free();
+	delete entry;
+}
+
+void WidgetCache::clear() {
+	while (!_lru.empty())
+		remove(_lru.back());
+}
+
 class ThemeItem {
 
 public:
@@ -275,11 +390,8 @@ void ThemeItemDrawData::drawSelf(bool draw, bool restore) {
 	if (restore)
 		_engine->restoreBackground(extendedRect);
 
-	if (draw) {
-		Common::List<Graphics::DrawStep>::const_iterator step;
-		for (step = _data->_steps.begin(); step != _data->_steps.end(); ++step)
-			_engine->renderer()->drawStep(_area, *step, _dynamicData);
-	}
+	if (draw)
+		_engine->drawWidget(_data, _area, Common::Rect(), _dynamicData);
 
 	_engine->addDirtyRect(extendedRect);
 }
@@ -292,12 +404,8 @@ void ThemeItemDrawDataClip::drawSelf(bool draw, bool restore) {
 	if (restore)
 		_engine->restoreBackground(extendedRect);
 
-	if (draw) {
-		Common::List<Graphics::DrawStep>::const_iterator step;
-		for (step = _data->_steps.begin(); step != _data->_steps.end(); ++step) {
-			_engine->renderer()->drawStepClip(_area, _clip, *step, _dynamicData);
-		}
-	}
+	if (draw)
+		_engine->drawWidget(_data, _area, _clip, _dynamicData);
 
 	extendedRect.clip(_clip);
 
@@ -366,12 +474,13 @@ void ThemeItemBitmapClip::drawSelf(bool draw, bool restore) {
 ThemeEngine::ThemeEngine(Common::String id, GraphicsMode mode) :
 	_system(0), _vectorRenderer(0),
 	_buffering(false), _bytesPerPixel(0),  _graphicsMode(kGfxDisabled),
-	_font(0), _initOk(false), _themeOk(false), _enabled(false), _themeFiles(),
-	_cursor(0) {
+	_font(0), _dirtyTilesPitch(0), _hasDirtyTiles(false), _initOk(false), _themeOk(false), _enabled(false),
+	_themeFiles(), _cursor(0) {
 
 	_system = g_system;
 	_parser = new ThemeParser(this);
 	_themeEval = new GUI::ThemeEval();
+	_widgetCache = new WidgetCache();
 
 	_useCursor = false;
 
@@ -440,6 +549,7 @@ ThemeEngine::~ThemeEngine() {
 
 	delete _parser;
 	delete _themeEval;
+	delete _widgetCache;
 	delete[] _cursor;
 }
 
@@ -642,7 +752,13 @@ void ThemeEngine::setGraphicsMode(GraphicsMode mode) {
 	// drawn so far. Sometimes we still end up with dirty screen bits in the
 	// list. Clearing it avoids invalid overlay writes when the backend
 	// resizes the overlay.
-	_dirtyScreen.clear();
+	_dirtyTilesPitch = (width + kDirtyTileSize - 1) / kDirtyTileSize;
+	_dirtyTiles.clear();
+	_dirtyTiles.resize(_dirtyTilesPitch * ((height + kDirtyTileSize - 1) / kDirtyTileSize));
+	_hasDirtyTiles = false;
+
+	// The cached widgets were drawn by the old renderer
+	_widgetCache->clear();
 }
 
 void WidgetDrawData::calcBackgroundOffset() {
@@ -664,6 +780,85 @@ void ThemeEngine::restoreBackground(Common::Rect r) {
 	_vectorRenderer->blitSurface(&_backBuffer, r);
 }
 
+void ThemeEngine::drawWidget(const WidgetDrawData *data, const Common::Rect &area, const Common::Rect &clip, uint32 dynamic) {
+	Graphics::TransparentSurface *surface = _vectorRenderer->getActiveSurface();
+
+	Common::Rect bounds = area;
+	bounds.grow(kDirtyRectangleThreshold + data->_backgroundOffset);
+
+	// Some shapes are drawn differently close to the edges of the surface,
+	// only widgets away from them look the same everywhere
+	bool cacheable = bounds.left > 0 && bounds.top > 0 && bounds.right < surface->w && bounds.bottom < surface->h;
+
+	if (!clip.isEmpty())
+		bounds.clip(clip);
+
+	if (bounds.isEmpty() || (uint32)(bounds.width() * bounds.height() * surface->format.bytesPerPixel) > WidgetCache::kCacheSize / 8)
+		cacheable = false;
+
+	WidgetCache::Key key;
+	Graphics::Surface background;
+
+	if (cacheable) {
+		key.data = data;
+		key.width = area.width();
+		key.height = area.height();
+		key.oddLeft = (area.left & 1) != 0;
+		key.dynamic = dynamic;
+		key.clip = clip;
+		if (!clip.isEmpty())
+			key.clip.translate(-area.left, -area.top);
+		key.shadows = !_vectorRenderer->areShadowsDisabled();
+		_vectorRenderer->getColors(key.colors[0], key.colors[1], key.colors[2], key.colors[3], key.colors[4]);
+
+		const Graphics::Surface current = surface->getSubArea(bounds);
+		const int rowSize = bounds.width() * surface->format.bytesPerPixel;
+
+		WidgetCache::Entry *entry = _widgetCache->find(key);
+		if (entry) {
+			bool sameBackground = true;
+			for (int y = 0; y < current.h && sameBackground; ++y)
+				sameBackground = !memcmp(current.getBasePtr(0, y), entry->background.getBasePtr(0, y), rowSize);
+
+			if (sameBackground) {
+				surface->copyRectToSurface(entry->result, bounds.left, bounds.top, Common::Rect(bounds.width(), bounds.height()));
+
+				// Leave the colors as drawing the steps would, later steps
+				// may draw with them
+				Common::List<Graphics::DrawStep>::const_iterator step;
+				for (step = data->_steps.begin(); step != data->_steps.end(); ++step) {
+					if (step->bgColor.set)
+						_vectorRenderer->setBgColor(step->bgColor.r, step->bgColor.g, step->bgColor.b);
+					if (step->fgColor.set)
+						_vectorRenderer->setFgColor(step->fgColor.r, step->fgColor.g, step->fgColor.b);
+					if (step->bevelColor.set)
+						_vectorRenderer->setBevelColor(step->bevelColor.r, step->bevelColor.g, step->bevelColor.b);
+					if (step->gradColor1.set && step->gradColor2.set)
+						_vectorRenderer->setGradientColors(step->gradColor1.r, step->gradColor1.g, step->gradColor1.b,
+						                                   step->gradColor2.r, step->gradColor2.g, step->gradColor2.b);
+				}
+				return;
+			}
+		}
+
+		background.copyFrom(current);
+	}
+
+	Common::List<Graphics::DrawStep>::const_iterator step;
+	for (step = data->_steps.begin(); step != data->_steps.end(); ++step) {
+		if (clip.isEmpty())
+			_vectorRenderer->drawStep(area, *step, dynamic);
+		else
+			_vectorRenderer->drawStepClip(area, clip, *step, dynamic);
+	}
+
+	if (cacheable) {
+		Graphics::Surface result;
+		result.copyFrom(surface->getSubArea(bounds));
+		_widgetCache->add(key, background, result);
+	}
+}
+
 
 
 /**********************************************************
@@ -912,6 +1107,7 @@ void ThemeEngine::unloadTheme() {
 	}
 
 	_themeEval->reset();
+	_widgetCache->clear();
 	_themeOk = false;
 }
 
@@ -1876,36 +2072,60 @@ void ThemeEngine::addDirtyRect(Common::Rect r) {
 	if (r.isEmpty())
 		return;
 
-	// Check if the new rectangle is contained within another in the list
-	Common::List<Common::Rect>::iterator it;
-	for (it = _dirtyScreen.begin(); it != _dirtyScreen.end();) {
-		// If we find a rectangle which fully contains the new one,
-		// we can abort the search.
-		if (it->contains(r))
-			return;
-
-		// Conversely, if we find rectangles which are contained in
-		// the new one, we can remove them
-		if (r.contains(*it))
-			it = _dirtyScreen.erase(it);
-		else
-			++it;
-	}
+	// Mark all tiles the rect touches
+	const int left = r.left / kDirtyTileSize, right = (r.right - 1) / kDirtyTileSize;
+	const int top = r.top / kDirtyTileSize, bottom = (r.bottom - 1) / kDirtyTileSize;
 
-	// If we got here, we can safely add r to the list of dirty rects.
-	_dirtyScreen.push_back(r);
+	for (int y = top; y <= bottom; ++y)
+		for (int x = left; x <= right; ++x)
+			_dirtyTiles[y * _dirtyTilesPitch + x] = true;
+
+	_hasDirtyTiles = true;
 }
 
 void ThemeEngine::renderDirtyScreen() {
-	if (_dirtyScreen.empty())
+	if (!_hasDirtyTiles)
 		return;
 
-	Common::List<Common::Rect>::iterator i;
-	for (i = _dirtyScreen.begin(); i != _dirtyScreen.end(); ++i) {
-		_vectorRenderer->copyFrame(_system, *i);
+	// Copy the dirty tiles in as few rects as possible: take each run of
+	// dirty tiles in a row, together with the same run in the rows below
+	const int rows = _dirtyTiles.size() / _dirtyTilesPitch;
+
+	for (int y = 0; y < rows; ++y) {
+		bool *row = &_dirtyTiles[y * _dirtyTilesPitch];
+
+		for (int x = 0; x < _dirtyTilesPitch; ++x) {
+			if (!row[x])
+				continue;
+
+			int right = x;
+			while (right < _dirtyTilesPitch && row[right])
+				++right;
+
+			int bottom = y + 1;
+			for (; bottom < rows; ++bottom) {
+				const bool *below = &_dirtyTiles[bottom * _dirtyTilesPitch];
+
+				int i = x;
+				while (i < right && below[i])
+					++i;
+
+				if (i < right)
+					break;
+			}
+
+			for (int i = y; i < bottom; ++i)
+				memset(&_dirtyTiles[i * _dirtyTilesPitch + x], 0, (right - x) * sizeof(bool));
+
+			Common::Rect r(x * kDirtyTileSize, y * kDirtyTileSize, right * kDirtyTileSize, bottom * kDirtyTileSize);
+			r.clip(_screen.w, _screen.h);
+			_vectorRenderer->copyFrame(_system, r);
+
+			x = right;
+		}
 	}
 
-	_dirtyScreen.clear();
+	_hasDirtyTiles = false;
 }
 
 void ThemeEngine::openDialog(bool doBuffer, ShadingStyle style) {
@@ -2220,12 +2440,8 @@ bool ThemeEngine::themeConfigUsable(const Common::FSNode &node, Common::String &
 			// Open THEMERC from the ZIP file.
 			stream.open("THEMERC", *zipArchive);
 		}
-		// Delete the ZIP archive again. Note: This only works because
-		// stream.open() only uses ZipArchive::createReadStreamForMember,
-		// and that in turn happens to read all the data for a given
-		// archive member into a memory block. So there will be no dangling
-		// reference to zipArchive anywhere. This could change if we
-		// ever modify ZipArchive::createReadStreamForMember.
+		// Delete the ZIP archive again. Member streams share ownership of
+		// the archive's file, so the stream stays usable without it.
 		delete zipArchive;
 	} else if (node.isDirectory()) {
 		Common::FSNode headerfile = node.getChild("THEMERC");
@@ -24,6 +24,7 @@
 #define GUI_THEME_ENGINE_H
 
 #include "common/scummsys.h"
+#include "common/array.h"
 #include "common/fs.h"
 #include "common/hash-str.h"
 #include "common/hashmap.h"
@@ -49,6 +50,7 @@ class VectorRenderer;
 namespace GUI {
 
 struct WidgetDrawData;
+class WidgetCache;
 struct TextDrawData;
 struct TextColorData;
 class Dialog;
@@ -581,6 +583,18 @@ public:
 	 */
 	void restoreBackground(Common::Rect r);
 
+	/**
+	 * Draws the steps of a DrawData item on the active surface of the
+	 * renderer. When the item was drawn with the same size and state over
+	 * the same background before, the result of that is copied instead.
+	 *
+	 * @param data DrawData item to draw.
+	 * @param area Area of the widget.
+	 * @param clip Area to clip the drawing to, or an empty rect to not clip.
+	 * @param dynamic Dynamic data for the drawing steps.
+	 */
+	void drawWidget(const WidgetDrawData *data, const Common::Rect &area, const Common::Rect &clip, uint32 dynamic);
+
 	const Common::String &getThemeName() const { return _themeName; }
 	const Common::String &getThemeId() const { return _themeId; }
 	int getGraphicsMode() const { return _graphicsMode; }
@@ -624,8 +638,8 @@ protected:
 
 	/**
 	 * Actual Dirty Screen handling function.
-	 * Handles all the dirty squares in the list, merges and optimizes
-	 * them when possible and draws them to the screen.
+	 * Merges the dirty tiles into as few rects as possible and draws them
+	 * to the screen.
 	 * Called from updateScreen()
 	 */
 	void renderDirtyScreen();
@@ -728,8 +742,16 @@ protected:
 	Graphics::PixelFormat _cursorFormat;
 #endif
 
-	/** List of all the dirty screens that must be blitted to the overlay. */
-	Common::List<Common::Rect> _dirtyScreen;
+	/** Size of the squares the screen is divided in for the dirty tracking */
+	static const int kDirtyTileSize = 16;
+
+	/** Whether each tile must be blitted to the overlay, row by row */
+	Common::Array<bool> _dirtyTiles;
+	int _dirtyTilesPitch;
+	bool _hasDirtyTiles;
+
+	/** Results of drawing DrawData items, @see drawWidget */
+	WidgetCache *_widgetCache;
 
 	/** Queue with all the drawing that must be done to the Back Buffer */
 	Common::List<ThemeItem *> _bufferQueue;
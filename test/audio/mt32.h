@@ -0,0 +1,115 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/scummsys.h"
+
+#ifdef USE_MT32EMU
+#include "audio/softsynth/mt32/mt32emu.h"
+#include "audio/softsynth/mt32/BReverbModel.h"
+#include "audio/softsynth/mt32/VectorOps.h"
+#endif
+
+class MT32TestSuite : public CxxTest::TestSuite
+{
+public:
+	void test_mixPannedMatchesScalar() {
+#if defined(USE_MT32EMU) && !MT32EMU_USE_FLOAT_SAMPLES
+		const int length = 67;
+		int16 input[length];
+		int16 left[length], right[length];
+		int16 expectedLeft[length], expectedRight[length];
+
+		uint32 seed = 1;
+		for (int i = 0; i < length; ++i) {
+			seed = seed * 1103515245 + 12345;
+			input[i] = (int16)(seed >> 16);
+		}
+		input[0] = -32768;
+		input[1] = 32767;
+
+		// The pan factors as set up by Partial, including the negated ones
+		static const int32 pans[] = { 0, 18, 128, 256, -18, -256 };
+
+		for (int l = 0; l < ARRAYSIZE(pans); ++l) {
+			for (int r = 0; r < ARRAYSIZE(pans); ++r) {
+				for (int i = 0; i < length; ++i) {
+					// Something already mixed into the buffer, loud enough to clip
+					left[i] = expectedLeft[i] = (i & 1) ? 24000 : -24000;
+					right[i] = expectedRight[i] = (i & 2) ? 24000 : -24000;
+
+					expectedLeft[i] = CLIP<int32>(expectedLeft[i] + (int16)((input[i] * pans[l]) >> 8), -32768, 32767);
+					expectedRight[i] = CLIP<int32>(expectedRight[i] + (int16)((input[i] * pans[r]) >> 8), -32768, 32767);
+				}
+
+				MT32Emu::VectorOps::mixPanned(left, right, input, length, pans[l], pans[r]);
+				TS_ASSERT_EQUALS(memcmp(left, expectedLeft, sizeof(left)), 0);
+				TS_ASSERT_EQUALS(memcmp(right, expectedRight, sizeof(right)), 0);
+			}
+		}
+#endif
+	}
+
+	void test_reverbMatchesReference() {
+#ifdef USE_MT32EMU
+		for (int model = 0; model < 2; ++model) {
+			for (int mode = MT32Emu::REVERB_MODE_ROOM; mode <= MT32Emu::REVERB_MODE_TAP_DELAY; ++mode) {
+				for (int time = 0; time < 8; ++time) {
+					testReverb((MT32Emu::ReverbMode)mode, model != 0, time, 0);
+					testReverb((MT32Emu::ReverbMode)mode, model != 0, time, 3);
+					testReverb((MT32Emu::ReverbMode)mode, model != 0, time, 7);
+				}
+			}
+		}
+#endif
+	}
+
+private:
+#ifdef USE_MT32EMU
+	void testReverb(const MT32Emu::ReverbMode mode, const bool mt32CompatibleModel, const int time, const int level) {
+		// Long enough for the signal to go round the longest comb a few times
+		const int length = 16000;
+
+		MT32Emu::Sample *inLeft = new MT32Emu::Sample[length];
+		MT32Emu::Sample *inRight = new MT32Emu::Sample[length];
+		MT32Emu::Sample *expectedLeft = new MT32Emu::Sample[length];
+		MT32Emu::Sample *expectedRight = new MT32Emu::Sample[length];
+		MT32Emu::Sample *outLeft = new MT32Emu::Sample[length];
+		MT32Emu::Sample *outRight = new MT32Emu::Sample[length];
+
+		// Loud noise bursts followed by silence, so the tails get through as well
+		uint32 seed = 1;
+		for (int i = 0; i < length; ++i) {
+			seed = seed * 1103515245 + 12345;
+			const bool burst = (i % 4000) < 1500;
+			inLeft[i] = burst ? (MT32Emu::Sample)(seed >> 16) : 0;
+			inRight[i] = burst ? (MT32Emu::Sample)(seed >> 8) : 0;
+		}
+
+		MT32Emu::BReverbModel reference(mode, mt32CompatibleModel);
+		MT32Emu::BReverbModel reverb(mode, mt32CompatibleModel);
+		reference.open();
+		reverb.open();
+		reference.setParameters(time, level);
+		reverb.setParameters(time, level);
+
+		reference.processReference(inLeft, inRight, expectedLeft, expectedRight, length);
+
+		// Odd run sizes, to cover partial blocks and the wraparound of the filter buffers at any point
+		int pos = 0;
+		for (int run = 1; pos < length; run = run * 7 % 601 + 1) {
+			const int count = MIN(run, length - pos);
+			reverb.process(inLeft + pos, inRight + pos, outLeft + pos, outRight + pos, count);
+			pos += count;
+		}
+
+		TS_ASSERT_EQUALS(memcmp(expectedLeft, outLeft, length * sizeof(MT32Emu::Sample)), 0);
+		TS_ASSERT_EQUALS(memcmp(expectedRight, outRight, length * sizeof(MT32Emu::Sample)), 0);
+
+		delete[] inLeft;
+		delete[] inRight;
+		delete[] expectedLeft;
+		delete[] expectedRight;
+		delete[] outLeft;
+		delete[] outRight;
+	}
+#endif
+};
@@ -0,0 +1,105 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/rate.h"
+#include "audio/mixer.h"
+
+#include "helper.h"
+
+class RateTestSuite : public CxxTest::TestSuite
+{
+public:
+	void test_mixKernelsMatchScalar() {
+		const int frames = 67;
+		int16 input[frames * 2];
+		int16 scalar[frames * 2];
+		int16 output[frames * 2];
+
+		// Full range samples, including the extremes, so that both the
+		// rounding of negative products and saturation get exercised
+		uint32 seed = 1;
+		for (int i = 0; i < frames * 2; ++i) {
+			seed = seed * 1103515245 + 12345;
+			input[i] = (int16)(seed >> 16);
+		}
+		input[0] = -32768;
+		input[1] = 32767;
+
+		static const Audio::st_volume_t volumes[] = { 0, 1, 127, 255, 256 };
+
+		for (int kernel = Audio::kMixKernelScalar + 1; kernel < Audio::kMixKernelCount; ++kernel) {
+			for (int layout = 0; layout < 3; ++layout) {
+				const bool stereo = layout != 0;
+				const bool reverseStereo = layout == 2;
+
+				Audio::MixProc proc = Audio::getMixProc((Audio::MixKernel)kernel, stereo, reverseStereo);
+				if (!proc)
+					continue;
+				Audio::MixProc reference = Audio::getMixProc(Audio::kMixKernelScalar, stereo, reverseStereo);
+
+				for (int l = 0; l < ARRAYSIZE(volumes); ++l) {
+					for (int r = 0; r < ARRAYSIZE(volumes); ++r) {
+						for (int i = 0; i < frames * 2; ++i)
+							scalar[i] = output[i] = input[frames * 2 - 1 - i];
+
+						reference(scalar, input, frames, volumes[l], volumes[r]);
+						proc(output, input, frames, volumes[l], volumes[r]);
+						TS_ASSERT_EQUALS(memcmp(scalar, output, sizeof(output)), 0);
+					}
+				}
+			}
+		}
+	}
+
+	void test_convertersMatchScalar() {
+		testConverter(11025, 44100, false, false);
+		testConverter(22050, 44100, true, false);
+		testConverter(44100, 44100, false, false);
+		testConverter(44100, 44100, true, true);
+		testConverter(44100, 22050, true, false);
+		testConverter(48000, 44100, true, true);
+	}
+
+private:
+	void testConverter(const int inRate, const int outRate, const bool stereo, const bool reverseStereo) {
+		const int frames = outRate / 4;
+
+		int16 *scalar = new int16[frames * 2];
+		int16 *output = new int16[frames * 2];
+
+		for (int kernel = Audio::kMixKernelScalar + 1; kernel < Audio::kMixKernelCount; ++kernel) {
+			if (!Audio::getMixProc((Audio::MixKernel)kernel, stereo, reverseStereo))
+				continue;
+
+			const int expected = mix(scalar, frames, inRate, outRate, stereo, reverseStereo, Audio::kMixKernelScalar);
+			const int count = mix(output, frames, inRate, outRate, stereo, reverseStereo, (Audio::MixKernel)kernel);
+			TS_ASSERT_EQUALS(count, expected);
+			TS_ASSERT_EQUALS(memcmp(scalar, output, frames * 2 * sizeof(int16)), 0);
+		}
+
+		delete[] scalar;
+		delete[] output;
+	}
+
+	int mix(int16 *buffer, const int frames, const int inRate, const int outRate, const bool stereo, const bool reverseStereo, Audio::MixKernel kernel) {
+		Audio::SeekableAudioStream *s = createSineStream<int16>(inRate, 1, 0, false, stereo);
+		Audio::RateConverter *converter = Audio::makeRateConverter(inRate, outRate, stereo, reverseStereo, kernel);
+
+		// Something already mixed into the buffer, loud enough to clip
+		for (int i = 0; i < frames * 2; ++i)
+			buffer[i] = (i & 1) ? 24000 : -24000;
+
+		// Odd chunk sizes, to cover the scalar tails of the vector kernels
+		int total = 0;
+		while (total < frames) {
+			const int chunk = MIN(frames - total, 733);
+			const int count = converter->flow(*s, buffer + total * 2, chunk, 200, 131);
+			total += count;
+			if (count < chunk)
+				break;
+		}
+
+		delete converter;
+		delete s;
+		return total;
+	}
+};
@@ -0,0 +1,259 @@
+#include <cxxtest/TestSuite.h>
+
+#include "audio/mpu401.h"
+#include "audio/trace.h"
+
+#include "common/memstream.h"
+
+/**
+ * An OPL remembering the register writes it got, ticking on request.
+ */
+class LoggingOPL : public OPL::OPL {
+public:
+	Common::Array<int> log;
+	int frequency;
+
+	LoggingOPL() : frequency(0) {}
+	~LoggingOPL() { stop(); }
+
+	void tick() {
+		log.push_back(-1);
+		if (_callback && _callback->isValid())
+			(*_callback)();
+	}
+
+	bool init() { log.push_back(-2); return true; }
+	void reset() {}
+	void write(int a, int v) { log.push_back(a << 8 | v); }
+	byte read(int a) { return 0; }
+	void writeReg(int r, int v) { log.push_back(0x10000 | r << 8 | v); }
+	void setCallbackFrequency(int timerFrequency) { frequency = timerFrequency; }
+
+protected:
+	void startCallbacks(int timerFrequency) { frequency = timerFrequency; }
+	void stopCallbacks() { frequency = 0; }
+};
+
+/**
+ * A MIDI driver remembering the messages it got, ticking on request.
+ */
+class LoggingMidiDriver : public MidiDriver {
+public:
+	Common::Array<uint32> log;
+	uint32 tempo;
+	bool opened;
+	void *timerParam;
+	Common::TimerManager::TimerProc timerProc;
+	MidiChannel_MPU401 channels[16];
+
+	explicit LoggingMidiDriver(uint32 baseTempo) : tempo(baseTempo), opened(false), timerParam(0), timerProc(0) {
+		for (int i = 0; i < 16; ++i)
+			channels[i].init(this, i);
+	}
+
+	void tick() {
+		log.push_back(0xFFFFFFFF);
+		if (timerProc)
+			timerProc(timerParam);
+	}
+
+	int open() { opened = true; return 0; }
+	bool isOpen() const { return opened; }
+	void close() { opened = false; }
+	void send(uint32 b) { log.push_back(b); }
+	void sysEx(const byte *msg, uint16 length) { log.push_back(0xF0000000 | length << 16 | msg[0] << 8 | msg[length - 1]); }
+	void setTimerCallback(void *timer_param, Common::TimerManager::TimerProc timer_proc) {
+		timerParam = timer_param;
+		timerProc = timer_proc;
+	}
+	uint32 getBaseTempo() { return tempo; }
+	MidiChannel *allocateChannel() { return &channels[2]; }
+	MidiChannel *getPercussionChannel() { return &channels[9]; }
+};
+
+class TraceTestSuite : public CxxTest::TestSuite
+{
+	Common::Array<byte> _trace;
+
+	static void engineTimer(void *refCon) {
+		static_cast<MidiDriver *>(refCon)->send(0x7F3C90);
+	}
+
+	void onOPLTimer() {
+		_opl->writeReg(0xB0, 0x31);
+	}
+
+	::OPL::OPL *_opl;
+
+	void finishTrace(Audio::TraceRecorder *recorder, Common::MemoryWriteStreamDynamic *stream) {
+		recorder->flush();
+		_trace = Common::Array<byte>(stream->getData(), stream->size());
+		delete recorder;
+	}
+
+public:
+	void test_oplRoundTrip() {
+		Common::MemoryWriteStreamDynamic *stream = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+		Audio::TraceRecorder *recorder = new Audio::TraceRecorder(stream);
+
+		// Record an engine writing a few registers, then one more per tick
+		LoggingOPL *chip = new LoggingOPL();
+		_opl = recorder->wrapOPL(chip, ::OPL::Config::kOpl3);
+		_opl->init();
+		_opl->writeReg(0x105, 1);
+		_opl->write(0x388, 0x20);
+		_opl->start(new Common::Functor0Mem<void, TraceTestSuite>(this, &TraceTestSuite::onOPLTimer), 72);
+		TS_ASSERT_EQUALS(chip->frequency, 72);
+		chip->tick();
+		chip->tick();
+		const Common::Array<int> recorded = chip->log;
+		_opl->stop();
+		delete _opl;
+		finishTrace(recorder, stream);
+
+		Common::MemoryReadStream trace(_trace.begin(), _trace.size());
+		Common::Array<Audio::TraceDevice> devices;
+		TS_ASSERT(Audio::loadTrace(trace, devices));
+		TS_ASSERT_EQUALS(devices.size(), 1u);
+		TS_ASSERT(devices[0].isOPL);
+		TS_ASSERT_EQUALS(devices[0].oplType, ::OPL::Config::kOpl3);
+
+		// The replay has to produce the very same sequence
+		LoggingOPL replay;
+		Audio::TracePlayer player(devices[0]);
+		player.start(&replay);
+		TS_ASSERT_EQUALS(replay.frequency, 72);
+		TS_ASSERT(!player.isFinished());
+		replay.tick();
+		replay.tick();
+		TS_ASSERT(player.isFinished());
+		TS_ASSERT_EQUALS(player.getTicks(), 2u);
+		TS_ASSERT(replay.log == recorded);
+		player.stop();
+	}
+
+	void test_midiRoundTrip() {
+		Common::MemoryWriteStreamDynamic *stream = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+		Audio::TraceRecorder *recorder = new Audio::TraceRecorder(stream);
+
+		LoggingMidiDriver *driver = new LoggingMidiDriver(4000);
+		MidiDriver *traced = recorder->wrapMidiDriver(driver);
+		TS_ASSERT_EQUALS(traced->open(), 0);
+		traced->setTimerCallback(traced, &TraceTestSuite::engineTimer);
+		static const byte reset[] = { 0x41, 0x10, 0x16, 0x12, 0x7F, 0x00, 0x00, 0x01, 0x00 };
+		traced->sysEx(reset, sizeof(reset));
+		for (int i = 0; i < 5; ++i)
+			driver->tick();
+		traced->close();
+		delete traced;
+		finishTrace(recorder, stream);
+
+		Common::MemoryReadStream trace(_trace.begin(), _trace.size());
+		Common::Array<Audio::TraceDevice> devices;
+		TS_ASSERT(Audio::loadTrace(trace, devices));
+		TS_ASSERT_EQUALS(devices.size(), 1u);
+		TS_ASSERT(!devices[0].isOPL);
+		TS_ASSERT_EQUALS(devices[0].tempo, 4000u);
+
+		// A driver ticking at 10ms has to play 2.5 recorded ticks each time
+		LoggingMidiDriver replay(10000);
+		replay.open();
+		Audio::TracePlayer player(devices[0]);
+		player.start(&replay);
+		TS_ASSERT_EQUALS(replay.log.size(), 1u);
+		TS_ASSERT_EQUALS(replay.log[0], 0xF0094100u);
+
+		replay.tick();
+		TS_ASSERT_EQUALS(player.getTicks(), 2u);
+		replay.tick();
+		TS_ASSERT_EQUALS(player.getTicks(), 5u);
+		TS_ASSERT(player.isFinished());
+
+		// The sysEx, then each tick with the note sent by the engine
+		TS_ASSERT_EQUALS(replay.log.size(), 1u + 2 + 5);
+		TS_ASSERT_EQUALS(replay.log[2], 0x7F3C90u);
+		TS_ASSERT_EQUALS(replay.log[3], 0x7F3C90u);
+		player.stop();
+	}
+
+	void test_midiChannels() {
+		Common::MemoryWriteStreamDynamic *stream = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+		Audio::TraceRecorder *recorder = new Audio::TraceRecorder(stream);
+
+		LoggingMidiDriver *driver = new LoggingMidiDriver(4000);
+		MidiDriver *traced = recorder->wrapMidiDriver(driver);
+		traced->open();
+
+		// Channels belong to the traced driver and are wrapped only once
+		MidiChannel *channel = traced->allocateChannel();
+		TS_ASSERT(channel);
+		TS_ASSERT_EQUALS(channel->device(), traced);
+		TS_ASSERT_EQUALS(channel->getNumber(), 2);
+		TS_ASSERT_EQUALS(traced->allocateChannel(), channel);
+
+		channel->noteOn(60, 100);
+		channel->pitchBend(-0x1000);
+		channel->pitchBendFactor(12);
+		channel->volume(90);
+		channel->noteOff(60);
+		traced->getPercussionChannel()->noteOn(36, 127);
+		const Common::Array<uint32> recorded = driver->log;
+		TS_ASSERT_EQUALS(recorded.size(), 11u);
+
+		traced->close();
+		delete traced;
+		finishTrace(recorder, stream);
+
+		Common::MemoryReadStream trace(_trace.begin(), _trace.size());
+		Common::Array<Audio::TraceDevice> devices;
+		TS_ASSERT(Audio::loadTrace(trace, devices));
+		TS_ASSERT_EQUALS(devices.size(), 1u);
+
+		// Replayed as messages to the driver, with the same effect
+		LoggingMidiDriver replay(4000);
+		replay.open();
+		Audio::TracePlayer player(devices[0]);
+		player.start(&replay);
+		TS_ASSERT(player.isFinished());
+		TS_ASSERT(replay.log == recorded);
+		player.stop();
+	}
+
+	void test_largeTrace() {
+		Common::MemoryWriteStreamDynamic *stream = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+		Audio::TraceRecorder *recorder = new Audio::TraceRecorder(stream);
+
+		// Enough records for the writer thread to write some while recording
+		LoggingOPL *chip = new LoggingOPL();
+		::OPL::OPL *opl = recorder->wrapOPL(chip, ::OPL::Config::kOpl2);
+		opl->init();
+		for (int i = 0; i < 100000; ++i)
+			opl->writeReg(i & 0xFF, (i >> 8) & 0xFF);
+		const Common::Array<int> recorded = chip->log;
+		delete opl;
+		finishTrace(recorder, stream);
+
+		Common::MemoryReadStream trace(_trace.begin(), _trace.size());
+		Common::Array<Audio::TraceDevice> devices;
+		TS_ASSERT(Audio::loadTrace(trace, devices));
+		TS_ASSERT_EQUALS(devices.size(), 1u);
+
+		LoggingOPL replay;
+		Audio::TracePlayer player(devices[0]);
+		player.start(&replay);
+		TS_ASSERT(player.isFinished());
+		TS_ASSERT(replay.log == recorded);
+		player.stop();
+	}
+
+	void test_rejectsGarbage() {
+		static const byte garbage[] = { 'S', 'V', 'A', 'T', 1, 0x42, 0 };
+		Common::Array<Audio::TraceDevice> devices;
+
+		Common::MemoryReadStream wrongType(garbage, sizeof(garbage));
+		TS_ASSERT(!Audio::loadTrace(wrongType, devices));
+
+		Common::MemoryReadStream wrongMagic(garbage + 1, sizeof(garbage) - 1);
+		TS_ASSERT(!Audio::loadTrace(wrongMagic, devices));
+	}
+};
@@ -0,0 +1,152 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Times TransparentSurface::blit() of a 256x256 sprite with varying alpha
+ * onto a 640x480 surface, for each blend mode with and without color
+ * modulation, with the scalar reference and every vector kernel the CPU
+ * supports. Also checks that the kernels give the same result as the
+ * reference, and times blitting the sprite scaled with and without a
+ * TransformedSurfaceCache.
+ *
+ * Usage: blend [blits per run]
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "common/util.h"
+#include "graphics/transparent_surface.h"
+#include "graphics/transformed_surface_cache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+static const int kWidth = 640;
+static const int kHeight = 480;
+static const int kSpriteSize = 256;
+
+typedef Graphics::TransparentSurface Sprite;
+
+static double now() {
+	struct timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * Blit the sprite over and over, moving it around the target.
+ *
+ * @return blits per second
+ */
+static double run(const Sprite &sprite, Graphics::Surface &target, uint32 color, Graphics::TSpriteBlendMode mode, int size, Graphics::TransformedSurfaceCache *cache, int blits) {
+	Sprite &src = const_cast<Sprite &>(sprite);
+
+	const double start = now();
+	for (int i = 0; i < blits; i++)
+		src.blit(target, (i * 7) % (kWidth - size), (i * 5) % (kHeight - size), Graphics::FLIP_NONE, nullptr, color, size, size, mode, cache);
+	return blits / (now() - start);
+}
+
+static bool equal(const Graphics::Surface &a, const Graphics::Surface &b) {
+	return !memcmp(a.getPixels(), b.getPixels(), a.h * a.pitch);
+}
+
+int main(int argc, char **argv) {
+	const int blits = argc > 1 ? atoi(argv[1]) : 2000;
+
+	static const char *const modeNames[] = { "alpha", "add", "sub" };
+	static const uint32 colors[] = { 0xFFFFFFFF, 0xC0FF8040 };
+	const Graphics::PixelFormat format = Sprite::getSupportedPixelFormat();
+
+	Sprite sprite;
+	sprite.create(kSpriteSize, kSpriteSize, format);
+	uint32 seed = 1;
+	for (int y = 0; y < kSpriteSize; y++) {
+		uint32 *pixels = (uint32 *)sprite.getBasePtr(0, y);
+		for (int x = 0; x < kSpriteSize; x++) {
+			seed = seed * 1103515245 + 12345;
+			// A transparent border around an opaque core, with noise in between
+			const int edge = MIN(MIN(x, y), MIN(kSpriteSize - 1 - x, kSpriteSize - 1 - y));
+			const uint8 alpha = edge < 32 ? 0 : edge < 64 ? (seed >> 24) : 255;
+			pixels[x] = ((seed >> 8) & 0xFFFFFF00) | alpha;
+		}
+	}
+
+	Graphics::Surface background, reference, result;
+	background.create(kWidth, kHeight, format);
+	for (int i = 0; i < kWidth * kHeight; i++) {
+		seed = seed * 1103515245 + 12345;
+		((uint32 *)background.getPixels())[i] = seed | 0xFF;
+	}
+	reference.create(kWidth, kHeight, format);
+	result.create(kWidth, kHeight, format);
+
+	printf("Blitting a %dx%d sprite %d times, best kernel: %s\n", kSpriteSize, kSpriteSize, blits,
+	       Sprite::getBlendKernelName(Sprite::getBestBlendKernel()));
+	printf("%-5s %-8s %-7s %9s %8s %5s\n", "mode", "color", "kernel", "blits/s", "speedup", "same");
+
+	for (int mode = Graphics::BLEND_NORMAL; mode <= Graphics::BLEND_SUBTRACTIVE; mode++) {
+		for (int c = 0; c < ARRAYSIZE(colors); c++) {
+			Sprite::setBlendKernel(Sprite::kBlendKernelScalar);
+			reference.copyFrom(background);
+			const double scalar = run(sprite, reference, colors[c], (Graphics::TSpriteBlendMode)mode, kSpriteSize, nullptr, blits);
+			printf("%-5s %08x %-7s %9.1f\n", modeNames[mode], colors[c], "scalar", scalar);
+
+			for (int kernel = Sprite::kBlendKernelScalar + 1; kernel < Sprite::kBlendKernelCount; kernel++) {
+				if (!Sprite::isBlendKernelSupported((Sprite::BlendKernel)kernel))
+					continue;
+
+				Sprite::setBlendKernel((Sprite::BlendKernel)kernel);
+				result.copyFrom(background);
+				const double speed = run(sprite, result, colors[c], (Graphics::TSpriteBlendMode)mode, kSpriteSize, nullptr, blits);
+				printf("%-5s %08x %-7s %9.1f %7.2fx %5s\n", modeNames[mode], colors[c],
+				       Sprite::getBlendKernelName((Sprite::BlendKernel)kernel), speed, speed / scalar,
+				       equal(reference, result) ? "yes" : "NO");
+			}
+		}
+	}
+
+	// Scaling is independent of the blend kernel
+	Sprite::setBlendKernel(Sprite::getBestBlendKernel());
+	Graphics::TransformedSurfaceCache cache;
+	const int scaledSize = kSpriteSize * 3 / 2;
+
+	printf("\nBlitting the sprite scaled to %dx%d\n", scaledSize, scaledSize);
+	printf("%-8s %9s %8s %5s\n", "cache", "blits/s", "speedup", "same");
+
+	reference.copyFrom(background);
+	const double uncached = run(sprite, reference, colors[0], Graphics::BLEND_NORMAL, scaledSize, nullptr, blits);
+	printf("%-8s %9.1f\n", "none", uncached);
+
+	result.copyFrom(background);
+	const double cached = run(sprite, result, colors[0], Graphics::BLEND_NORMAL, scaledSize, &cache, blits);
+	printf("%-8s %9.1f %7.2fx %5s\n", "LRU", cached, cached / uncached, equal(reference, result) ? "yes" : "NO");
+
+	sprite.free();
+	background.free();
+	reference.free();
+	result.free();
+
+	return 0;
+}
@@ -0,0 +1,152 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Times the file hashing done by the advanced detector over a synthetic
+ * directory tree, once on a single thread and once spread over the
+ * ThreadPool.
+ *
+ * Usage: detection [directories] [files per directory]
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "common/md5.h"
+#include "common/stream.h"
+#include "common/str.h"
+#include "common/array.h"
+#include "common/threadpool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/** The number of bytes AdvancedMetaEngine hashes by default */
+static const uint kMD5Bytes = 5000;
+
+class BenchFileStream : public Common::SeekableReadStream {
+	FILE *_file;
+
+public:
+	BenchFileStream(FILE *file) : _file(file) {}
+	~BenchFileStream() { fclose(_file); }
+
+	bool err() const { return ferror(_file) != 0; }
+	void clearErr() { clearerr(_file); }
+	bool eos() const { return feof(_file) != 0; }
+	uint32 read(void *dataPtr, uint32 dataSize) { return fread(dataPtr, 1, dataSize, _file); }
+	int32 pos() const { return ftell(_file); }
+	int32 size() const {
+		const long cur = ftell(_file);
+		fseek(_file, 0, SEEK_END);
+		const long end = ftell(_file);
+		fseek(_file, cur, SEEK_SET);
+		return end;
+	}
+	bool seek(int32 offset, int whence = SEEK_SET) { return fseek(_file, offset, whence) == 0; }
+};
+
+struct HashTask {
+	Common::Array<Common::String> paths;
+	Common::Array<Common::String> md5s;
+
+	static void run(void *data, uint index) {
+		HashTask *task = (HashTask *)data;
+		FILE *file = fopen(task->paths[index].c_str(), "rb");
+		if (!file)
+			return;
+
+		BenchFileStream stream(file);
+		task->md5s[index] = Common::computeStreamMD5AsString(stream, kMD5Bytes);
+	}
+};
+
+static double now() {
+	struct timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+int main(int argc, char **argv) {
+	const uint dirs = argc > 1 ? atoi(argv[1]) : 64;
+	const uint filesPerDir = argc > 2 ? atoi(argv[2]) : 32;
+
+	char root[] = "/tmp/scummvm-detection-XXXXXX";
+	if (!mkdtemp(root)) {
+		perror("mkdtemp");
+		return 1;
+	}
+
+	// Game-like files of varying size, with distinct contents
+	HashTask task;
+	byte buf[16384];
+	for (uint d = 0; d < dirs; d++) {
+		const Common::String dir = Common::String::format("%s/game%03u", root, d);
+		mkdir(dir.c_str(), 0755);
+
+		for (uint f = 0; f < filesPerDir; f++) {
+			const Common::String path = Common::String::format("%s/RESOURCE.%03u", dir.c_str(), f);
+			FILE *file = fopen(path.c_str(), "wb");
+			if (!file) {
+				perror(path.c_str());
+				return 1;
+			}
+
+			for (uint i = 0; i < sizeof(buf); i++)
+				buf[i] = (byte)(i * 31 + d * 7 + f);
+			const uint size = 4096 + ((d * filesPerDir + f) * 997) % sizeof(buf);
+			fwrite(buf, 1, size, file);
+			fclose(file);
+
+			task.paths.push_back(path);
+		}
+	}
+	task.md5s.resize(task.paths.size());
+
+	printf("Hashing %u files in %u directories\n", task.paths.size(), dirs);
+
+	double start = now();
+	for (uint i = 0; i < task.paths.size(); i++)
+		HashTask::run(&task, i);
+	const double serial = now() - start;
+	const Common::Array<Common::String> reference = task.md5s;
+
+	start = now();
+	ThreadPoolMan.parallelFor(HashTask::run, &task, task.paths.size());
+	const double parallel = now() - start;
+
+	const bool same = (task.md5s == reference);
+
+	printf("serial:   %8.2f ms\n", serial * 1000);
+	printf("parallel: %8.2f ms on %u threads (%.2fx)%s\n", parallel * 1000, ThreadPoolMan.getThreadCount(),
+	       serial / parallel, same ? "" : " MISMATCH");
+
+	for (uint i = 0; i < task.paths.size(); i++)
+		unlink(task.paths[i].c_str());
+	for (uint d = 0; d < dirs; d++)
+		rmdir(Common::String::format("%s/game%03u", root, d).c_str());
+	rmdir(root);
+
+	return same ? 0 : 1;
+}
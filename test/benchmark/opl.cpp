@@ -0,0 +1,237 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Times the DOSBox OPL emulator rendering a fixed, generated register write
+ * trace at 44.1kHz, as an OPL2, as the dual OPL2 it emulates for AdLib Gold
+ * style games, and as an OPL3 using 4 operator channels. The checksum of the
+ * output is printed too, so that changes to the emulation can be spotted.
+ *
+ * The MAME emulator is not included, since it needs a running OSystem for
+ * its noise generator.
+ *
+ * Usage: opl [seconds of output per run]
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "audio/softsynth/opl/dbopl.h"
+#include "common/array.h"
+#include "common/util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+#ifndef DISABLE_DOSBOX_OPL
+
+using namespace OPL::DOSBox;
+
+/** The output rate of a typical backend */
+static const int kOutputRate = 44100;
+
+/** The largest number of frames rendered at once, as in DOSBox::OPL */
+static const int kChunkFrames = 512;
+
+enum ChipMode {
+	kModeOpl2,
+	kModeDualOpl2,
+	kModeOpl3
+};
+
+struct RegWrite {
+	uint32 frame;
+	uint16 reg;
+	uint8 val;
+};
+
+/** Operator register offsets of the 9 channels of one register bank */
+static const uint8 kOperatorOffsets[9] = { 0, 1, 2, 8, 9, 10, 16, 17, 18 };
+
+class TraceBuilder {
+	Common::Array<RegWrite> &_trace;
+	const ChipMode _mode;
+	uint32 _seed;
+	uint32 _frame;
+
+public:
+	TraceBuilder(Common::Array<RegWrite> &trace, ChipMode mode) : _trace(trace), _mode(mode), _seed(1), _frame(0) {}
+
+	uint random(uint max) {
+		_seed = _seed * 1103515245 + 12345;
+		return (_seed >> 16) % max;
+	}
+
+	void write(uint16 reg, uint8 val) {
+		RegWrite w = { _frame, reg, val };
+		_trace.push_back(w);
+
+		// The dual OPL2 drives one chip per side, with the same writes
+		if (_mode == kModeDualOpl2 && reg < 0x100) {
+			if (reg >= 0xC0 && reg <= 0xC8)
+				_trace.back().val = (val & 0x0F) | 0x10;
+			RegWrite right = { _frame, (uint16)(reg | 0x100), (uint8)(reg >= 0xC0 && reg <= 0xC8 ? (val & 0x0F) | 0x20 : val) };
+			_trace.push_back(right);
+		}
+	}
+
+	void instrument(uint channel) {
+		const uint16 bank = channel >= 9 ? 0x100 : 0;
+		const uint8 slot = kOperatorOffsets[channel % 9];
+		const uint8 waveMask = _mode == kModeOpl3 ? 7 : 3;
+
+		for (int op = 0; op < 2; ++op) {
+			const uint16 base = bank + slot + op * 3;
+			write(0x20 + base, random(256));
+			// Keep the carriers loud, the modulators anywhere
+			write(0x40 + base, op ? random(4) << 6 | random(16) : random(256));
+			write(0x60 + base, random(256) | 0x80);
+			write(0x80 + base, random(256));
+			write(0xE0 + base, random(8) & waveMask);
+		}
+		write(0xC0 + bank + channel % 9, random(16) | (_mode == kModeOpl3 ? 0x30 : 0));
+	}
+
+	void note(uint channel, bool on) {
+		const uint16 reg = (channel >= 9 ? 0x100 : 0) + channel % 9;
+		const uint fnum = 0x100 + random(0x200);
+		write(0xA0 + reg, fnum & 0xFF);
+		write(0xB0 + reg, (on ? 0x20 : 0) | (1 + random(6)) << 2 | fnum >> 8);
+	}
+
+	void build(int frames) {
+		const uint channels = _mode == kModeOpl3 ? 18 : 9;
+
+		write(0x01, 0x20);
+		write(0x08, 0x00);
+		if (_mode == kModeOpl3) {
+			write(0x105, 0x01);
+			// 4 operator channels 0+3, 1+4 and 9+12
+			write(0x104, 0x0B);
+		}
+		// Deep tremolo and vibrato
+		write(0xBD, 0xC0);
+
+		for (uint channel = 0; channel < channels; ++channel)
+			instrument(channel);
+
+		// A note on some channel every 1/32 second, a new instrument now and then.
+		// In the second half, an OPL2 plays the rhythm section too.
+		for (_frame = 0; _frame < (uint32)frames; _frame += kOutputRate / 32) {
+			const uint channel = random(channels);
+			note(channel, false);
+			if (random(8) == 0)
+				instrument(channel);
+			note(channel, random(4) != 0);
+
+			if (_mode == kModeOpl2 && _frame > (uint32)frames / 2)
+				write(0xBD, 0xE0 | random(32));
+		}
+	}
+};
+
+static double now() {
+	struct timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * Render the whole trace.
+ *
+ * @return output frames per second
+ */
+static double run(ChipMode mode, const Common::Array<RegWrite> &trace, int32 *buffer, int frames) {
+	DBOPL::InitTables();
+	DBOPL::Chip *chip = new DBOPL::Chip();
+	chip->Setup(kOutputRate);
+	if (mode == kModeDualOpl2)
+		chip->WriteReg(0x105, 1);
+
+	const bool stereo = mode != kModeOpl2;
+	uint next = 0;
+
+	const double start = now();
+	for (int pos = 0; pos < frames;) {
+		while (next < trace.size() && trace[next].frame <= (uint32)pos) {
+			chip->WriteReg(trace[next].reg, trace[next].val);
+			++next;
+		}
+
+		int count = MIN(kChunkFrames, frames - pos);
+		if (next < trace.size())
+			count = MIN<int>(count, trace[next].frame - pos);
+
+		if (stereo)
+			chip->GenerateBlock3(count, buffer + pos * 2);
+		else
+			chip->GenerateBlock2(count, buffer + pos);
+		pos += count;
+	}
+	const double elapsed = now() - start;
+
+	delete chip;
+	return frames / elapsed;
+}
+
+static uint32 checksum(const int32 *buffer, int samples) {
+	// FNV-1a over the samples
+	uint32 hash = 2166136261u;
+	for (int i = 0; i < samples; ++i) {
+		hash = (hash ^ (uint32)buffer[i]) * 16777619u;
+	}
+	return hash;
+}
+
+int main(int argc, char **argv) {
+	const int seconds = argc > 1 ? atoi(argv[1]) : 60;
+	const int frames = seconds * kOutputRate;
+
+	static const char *const modes[] = { "opl2", "dualopl2", "opl3" };
+
+	int32 *buffer = new int32[frames * 2];
+
+	printf("Rendering %d seconds at %d Hz\n", seconds, kOutputRate);
+	printf("%-9s %10s %9s\n", "mode", "Mframes/s", "checksum");
+
+	for (int mode = 0; mode < ARRAYSIZE(modes); ++mode) {
+		Common::Array<RegWrite> trace;
+		TraceBuilder builder(trace, (ChipMode)mode);
+		builder.build(frames);
+
+		const double speed = run((ChipMode)mode, trace, buffer, frames);
+		printf("%-9s %10.2f  %08x\n", modes[mode], speed / 1000000,
+		       checksum(buffer, mode == kModeOpl2 ? frames : frames * 2));
+	}
+
+	delete[] buffer;
+	return 0;
+}
+
+#else
+
+int main(int argc, char **argv) {
+	printf("The DOSBox OPL emulator is disabled\n");
+	return 0;
+}
+
+#endif
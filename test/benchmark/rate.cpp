@@ -0,0 +1,140 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Times the rate converters mixing into a 44.1kHz output buffer, for each
+ * channel layout and a range of input rates, with the scalar reference and
+ * every mix kernel the CPU supports.
+ *
+ * Usage: rate [seconds of output per run]
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "audio/audiostream.h"
+#include "audio/rate.h"
+#include "common/util.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+/** The output rate of a typical backend */
+static const int kOutputRate = 44100;
+
+/** The number of frames requested per flow() call, as in a mixer callback */
+static const int kChunkFrames = 1024;
+
+/**
+ * An endless stream of noise, cheap enough not to dominate the timing.
+ */
+class NoiseStream : public Audio::AudioStream {
+	const int _rate;
+	const bool _stereo;
+	uint32 _seed;
+
+public:
+	NoiseStream(int rate, bool stereo) : _rate(rate), _stereo(stereo), _seed(1) {}
+
+	int readBuffer(int16 *buffer, const int numSamples) {
+		for (int i = 0; i < numSamples; i++) {
+			_seed = _seed * 1103515245 + 12345;
+			buffer[i] = (int16)(_seed >> 16);
+		}
+		return numSamples;
+	}
+
+	bool isStereo() const { return _stereo; }
+	int getRate() const { return _rate; }
+	bool endOfData() const { return false; }
+};
+
+static double now() {
+	struct timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * Run one converter for the given number of output frames.
+ *
+ * @return output frames per second
+ */
+static double run(int inRate, bool stereo, bool reverseStereo, Audio::MixKernel kernel, int16 *buffer, int frames) {
+	NoiseStream stream(inRate, stereo);
+	Audio::RateConverter *converter = Audio::makeRateConverter(inRate, kOutputRate, stereo, reverseStereo, kernel);
+
+	memset(buffer, 0, frames * 2 * sizeof(int16));
+
+	const double start = now();
+	for (int pos = 0; pos < frames; pos += kChunkFrames)
+		converter->flow(stream, buffer + pos * 2, MIN(kChunkFrames, frames - pos), 200, 131);
+	const double elapsed = now() - start;
+
+	delete converter;
+	return frames / elapsed;
+}
+
+int main(int argc, char **argv) {
+	const int seconds = argc > 1 ? atoi(argv[1]) : 60;
+	const int frames = seconds * kOutputRate;
+
+	static const int rates[] = { 11025, 22050, 44100, 48000, 88200 };
+	static const char *const layouts[] = { "mono", "stereo", "reverse" };
+
+	int16 *buffer = new int16[frames * 2];
+	int16 *reference = new int16[frames * 2];
+	bool same = true;
+
+	printf("Mixing %d seconds into %d Hz, best kernel: %s\n", seconds, kOutputRate,
+	       Audio::getMixKernelName(Audio::getBestMixKernel()));
+	printf("%-8s %6s %-7s %10s %8s\n", "layout", "rate", "kernel", "Mframes/s", "speedup");
+
+	for (int layout = 0; layout < ARRAYSIZE(layouts); layout++) {
+		const bool stereo = layout != 0;
+		const bool reverseStereo = layout == 2;
+
+		for (int r = 0; r < ARRAYSIZE(rates); r++) {
+			const double scalar = run(rates[r], stereo, reverseStereo, Audio::kMixKernelScalar, reference, frames);
+			printf("%-8s %6d %-7s %10.2f\n", layouts[layout], rates[r], "scalar", scalar / 1000000);
+
+			for (int kernel = Audio::kMixKernelScalar + 1; kernel < Audio::kMixKernelCount; kernel++) {
+				if (!Audio::getMixProc((Audio::MixKernel)kernel, stereo, reverseStereo))
+					continue;
+
+				const double speed = run(rates[r], stereo, reverseStereo, (Audio::MixKernel)kernel, buffer, frames);
+				const bool match = !memcmp(buffer, reference, frames * 2 * sizeof(int16));
+				same = same && match;
+
+				printf("%-8s %6d %-7s %10.2f %7.2fx%s\n", layouts[layout], rates[r],
+				       Audio::getMixKernelName((Audio::MixKernel)kernel), speed / 1000000, speed / scalar,
+				       match ? "" : " MISMATCH");
+			}
+		}
+	}
+
+	delete[] buffer;
+	delete[] reference;
+
+	return same ? 0 : 1;
+}
@@ -0,0 +1,155 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+/*
+ * Times the YUV to RGB conversion of a 640x480 frame of noise into 16 and
+ * 32 bit surfaces, for each chroma subsampling, with the lookup tables and
+ * every vector kernel the CPU supports. Also prints the largest difference
+ * of a color component from the lookup result.
+ *
+ * Usage: yuv [frames per run]
+ */
+
+#define FORBIDDEN_SYMBOL_ALLOW_ALL
+
+#include "common/util.h"
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/time.h>
+
+static const int kWidth = 640;
+static const int kHeight = 480;
+
+typedef Graphics::YUVToRGBManager Manager;
+
+static double now() {
+	struct timeval t;
+	gettimeofday(&t, 0);
+	return t.tv_sec + t.tv_usec / 1000000.0;
+}
+
+/**
+ * Convert the frame over and over.
+ *
+ * @return frames per second
+ */
+static double run(Manager::Kernel kernel, int subsampling, const byte *y, const byte *u, const byte *v, Graphics::Surface &dst, int frames) {
+	YUVToRGBMan.setKernel(kernel);
+
+	const double start = now();
+	for (int i = 0; i < frames; i++) {
+		switch (subsampling) {
+		case 0:
+			YUVToRGBMan.convert444(&dst, Manager::kScaleITU, y, u, v, kWidth, kHeight, kWidth, kWidth + 1);
+			break;
+		case 1:
+			YUVToRGBMan.convert420(&dst, Manager::kScaleITU, y, u, v, kWidth, kHeight, kWidth, kWidth + 1);
+			break;
+		default:
+			YUVToRGBMan.convert410(&dst, Manager::kScaleITU, y, u, v, kWidth, kHeight, kWidth, kWidth + 1);
+			break;
+		}
+	}
+	return frames / (now() - start);
+}
+
+static int maxDifference(const Graphics::Surface &a, const Graphics::Surface &b) {
+	int result = 0;
+
+	for (int y = 0; y < a.h; y++) {
+		for (int x = 0; x < a.w; x++) {
+			uint8 ra, ga, ba, rb, gb, bb;
+			if (a.format.bytesPerPixel == 2) {
+				a.format.colorToRGB(*(const uint16 *)a.getBasePtr(x, y), ra, ga, ba);
+				b.format.colorToRGB(*(const uint16 *)b.getBasePtr(x, y), rb, gb, bb);
+			} else {
+				a.format.colorToRGB(*(const uint32 *)a.getBasePtr(x, y), ra, ga, ba);
+				b.format.colorToRGB(*(const uint32 *)b.getBasePtr(x, y), rb, gb, bb);
+			}
+			result = MAX(result, MAX(ABS(ra - rb), MAX(ABS(ga - gb), ABS(ba - bb))));
+		}
+	}
+
+	return result;
+}
+
+int main(int argc, char **argv) {
+	const int frames = argc > 1 ? atoi(argv[1]) : 200;
+
+	static const char *const subsamplings[] = { "444", "420", "410" };
+	static const Graphics::PixelFormat formats[] = {
+		Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+		Graphics::PixelFormat(4, 8, 8, 8, 8, 24, 16, 8, 0)
+	};
+
+	// The chroma planes have the extra row and column convert410() needs
+	byte *y = new byte[kWidth * kHeight];
+	byte *u = new byte[(kWidth + 1) * (kHeight + 1)];
+	byte *v = new byte[(kWidth + 1) * (kHeight + 1)];
+	uint32 seed = 1;
+	for (int i = 0; i < kWidth * kHeight; i++) {
+		seed = seed * 1103515245 + 12345;
+		y[i] = seed >> 16;
+	}
+	for (int i = 0; i < (kWidth + 1) * (kHeight + 1); i++) {
+		seed = seed * 1103515245 + 12345;
+		u[i] = seed >> 16;
+		v[i] = seed >> 24;
+	}
+
+	printf("Converting %d frames of %dx%d, best kernel: %s\n", frames, kWidth, kHeight,
+	       Manager::getKernelName(Manager::getBestKernel()));
+	printf("%-4s %-4s %-7s %9s %8s %8s\n", "yuv", "bpp", "kernel", "frames/s", "speedup", "maxdiff");
+
+	for (int f = 0; f < ARRAYSIZE(formats); f++) {
+		Graphics::Surface reference, result;
+		reference.create(kWidth, kHeight, formats[f]);
+		result.create(kWidth, kHeight, formats[f]);
+
+		for (int s = 0; s < ARRAYSIZE(subsamplings); s++) {
+			const double lookup = run(Manager::kKernelLookup, s, y, u, v, reference, frames);
+			printf("%-4s %-4d %-7s %9.1f\n", subsamplings[s], formats[f].bytesPerPixel * 8, "lookup", lookup);
+
+			for (int kernel = Manager::kKernelLookup + 1; kernel < Manager::kKernelCount; kernel++) {
+				if (!Manager::isKernelSupported((Manager::Kernel)kernel))
+					continue;
+
+				const double speed = run((Manager::Kernel)kernel, s, y, u, v, result, frames);
+				printf("%-4s %-4d %-7s %9.1f %7.2fx %8d\n", subsamplings[s], formats[f].bytesPerPixel * 8,
+				       Manager::getKernelName((Manager::Kernel)kernel), speed, speed / lookup,
+				       maxDifference(reference, result));
+			}
+		}
+
+		reference.free();
+		result.free();
+	}
+
+	delete[] y;
+	delete[] u;
+	delete[] v;
+
+	return 0;
+}
@@ -0,0 +1,103 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/threadpool.h"
+
+struct ThreadPoolTestData {
+	uint visits[100];
+	uint nested;
+};
+
+static void threadPoolVisit(void *data, uint index) {
+	((ThreadPoolTestData *)data)->visits[index]++;
+}
+
+static void threadPoolNested(void *data, uint index) {
+	ThreadPoolTestData *test = (ThreadPoolTestData *)data;
+
+	// A task using the busy pool must not wait for itself
+	ThreadPoolTestData inner;
+	memset(&inner, 0, sizeof(inner));
+	ThreadPoolMan.parallelFor(threadPoolVisit, &inner, 10);
+
+	uint total = 0;
+	for (uint i = 0; i < 10; i++)
+		total += inner.visits[i];
+	test->visits[index] = total;
+}
+
+struct NativeThreadTestData {
+	Common::NativeMutex mutex;
+	Common::NativeCondition cond;
+	uint produced;
+	uint consumed;
+};
+
+static void nativeThreadProduce(void *data) {
+	NativeThreadTestData *test = (NativeThreadTestData *)data;
+
+	// Hand over values one at a time, waiting for each to be taken
+	Common::NativeStackLock lock(test->mutex);
+	for (uint i = 1; i <= 100; i++) {
+		while (test->consumed != test->produced)
+			test->cond.wait(test->mutex);
+		test->produced = i;
+		test->cond.broadcast();
+	}
+}
+
+class ThreadPoolTestSuite : public CxxTest::TestSuite {
+public:
+	void test_parallelFor() {
+		ThreadPoolTestData data;
+		memset(&data, 0, sizeof(data));
+
+		ThreadPoolMan.parallelFor(threadPoolVisit, &data, 100);
+		for (uint i = 0; i < 100; i++)
+			TS_ASSERT_EQUALS(data.visits[i], 1u);
+
+		// The pool is reusable
+		ThreadPoolMan.parallelFor(threadPoolVisit, &data, 50);
+		for (uint i = 0; i < 100; i++)
+			TS_ASSERT_EQUALS(data.visits[i], i < 50 ? 2u : 1u);
+	}
+
+	void test_nested() {
+		ThreadPoolTestData data;
+		memset(&data, 0, sizeof(data));
+
+		ThreadPoolMan.parallelFor(threadPoolNested, &data, 8);
+		for (uint i = 0; i < 8; i++)
+			TS_ASSERT_EQUALS(data.visits[i], 10u);
+	}
+
+	void test_nativeThread() {
+		NativeThreadTestData data;
+		data.produced = data.consumed = 0;
+
+		Common::NativeThread thread;
+		if (!thread.start(nativeThreadProduce, &data)) {
+			// Without threads there is nothing to hand over
+			TS_ASSERT(!thread.isRunning());
+			return;
+		}
+		TS_ASSERT(thread.isRunning());
+
+		data.mutex.lock();
+		while (data.consumed < 100) {
+			while (data.produced == data.consumed)
+				data.cond.wait(data.mutex);
+			TS_ASSERT_EQUALS(data.produced, data.consumed + 1);
+			data.consumed = data.produced;
+			data.cond.broadcast();
+		}
+		data.mutex.unlock();
+
+		thread.join();
+		TS_ASSERT(!thread.isRunning());
+	}
+
+	void test_threadCount() {
+		TS_ASSERT_LESS_THAN_EQUALS(1u, ThreadPoolMan.getThreadCount());
+		TS_ASSERT_LESS_THAN_EQUALS(1u, Common::ThreadPool::getCPUCount());
+	}
+};
@@ -0,0 +1,157 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/archive.h"
+#include "common/memstream.h"
+#include "common/unzip.h"
+#include "common/zlib.h"
+
+class UnzipTestSuite : public CxxTest::TestSuite {
+	// Records when the archive's stream is deleted
+	class TrackedStream : public Common::MemoryReadStream {
+		bool &_deleted;
+	public:
+		TrackedStream(const byte *data, uint32 size, bool &deleted)
+			: Common::MemoryReadStream(data, size, DisposeAfterUse::YES), _deleted(deleted) {
+			_deleted = false;
+		}
+		~TrackedStream() { _deleted = true; }
+	};
+
+	struct Member {
+		const char *name;
+		uint16 method;
+		const byte *data;
+		uint32 compressedSize;
+		uint32 size;
+		uint32 crc;
+		uint32 offset;
+	};
+
+	static uint32 crc32(const byte *data, uint32 size) {
+		uint32 crc = 0xFFFFFFFF;
+		for (uint32 i = 0; i < size; i++) {
+			crc ^= data[i];
+			for (int bit = 0; bit < 8; bit++)
+				crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+		}
+		return ~crc;
+	}
+
+	static void writeHeader(Common::WriteStream &out, const Member &member) {
+		out.writeUint16LE(20); // version needed
+		out.writeUint16LE(0);  // flags
+		out.writeUint16LE(member.method);
+		out.writeUint32LE(0);  // time and date
+		out.writeUint32LE(member.crc);
+		out.writeUint32LE(member.compressedSize);
+		out.writeUint32LE(member.size);
+		out.writeUint16LE(strlen(member.name));
+		out.writeUint16LE(0);  // extra field
+	}
+
+	static Common::SeekableReadStream *createZip(Member *members, int count, bool &deleted) {
+		Common::MemoryWriteStreamDynamic out(DisposeAfterUse::NO);
+
+		for (int i = 0; i < count; i++) {
+			members[i].offset = out.pos();
+			out.writeUint32LE(0x04034B50);
+			writeHeader(out, members[i]);
+			out.writeString(members[i].name);
+			out.write(members[i].data, members[i].compressedSize);
+		}
+
+		const uint32 centralDir = out.pos();
+		for (int i = 0; i < count; i++) {
+			out.writeUint32LE(0x02014B50);
+			out.writeUint16LE(20); // version made by
+			writeHeader(out, members[i]);
+			out.writeUint16LE(0);  // comment
+			out.writeUint16LE(0);  // disk
+			out.writeUint16LE(0);  // internal attributes
+			out.writeUint32LE(0);  // external attributes
+			out.writeUint32LE(members[i].offset);
+			out.writeString(members[i].name);
+		}
+
+		const uint32 centralDirSize = out.pos() - centralDir;
+		out.writeUint32LE(0x06054B50);
+		out.writeUint16LE(0);
+		out.writeUint16LE(0);
+		out.writeUint16LE(count);
+		out.writeUint16LE(count);
+		out.writeUint32LE(centralDirSize);
+		out.writeUint32LE(centralDir);
+		out.writeUint16LE(0);
+
+		return new TrackedStream(out.getData(), out.size(), deleted);
+	}
+
+	static bool readsBack(Common::SeekableReadStream *stream, const byte *data, uint32 size) {
+		byte buffer[256];
+		if (!stream || stream->size() != (int32)size || size > sizeof(buffer))
+			return false;
+		return stream->read(buffer, size) == size && !memcmp(buffer, data, size);
+	}
+
+public:
+	void test_membersOutliveArchive() {
+		byte data[200];
+		for (uint i = 0; i < sizeof(data); i++)
+			data[i] = i * 7;
+
+		Member members[2];
+		int count = 0;
+
+		members[count].name = "stored";
+		members[count].method = 0;
+		members[count].data = data;
+		members[count].compressedSize = members[count].size = sizeof(data);
+		members[count].crc = crc32(data, sizeof(data));
+		count++;
+
+#ifdef USE_ZLIB
+		// The gzip format wraps the deflate data in a 10 byte header
+		// and an 8 byte trailer
+		byte gzip[sizeof(data) * 2];
+		Common::MemoryWriteStream *gzipStream = new Common::MemoryWriteStream(gzip, sizeof(gzip));
+		Common::WriteStream *compressor = Common::wrapCompressedWriteStream(gzipStream);
+		compressor->write(data, sizeof(data));
+		compressor->finalize();
+		const uint32 gzipSize = gzipStream->pos();
+		delete compressor;
+
+		members[count].name = "deflated";
+		members[count].method = 8;
+		members[count].data = gzip + 10;
+		members[count].compressedSize = gzipSize - 10 - 8;
+		members[count].size = sizeof(data);
+		members[count].crc = members[0].crc;
+		count++;
+#endif
+
+		bool deleted;
+		Common::Archive *archive = Common::makeZipArchive(createZip(members, count, deleted));
+		TS_ASSERT(archive);
+		if (!archive)
+			return;
+
+		Common::SeekableReadStream *streams[2];
+		for (int i = 0; i < count; i++)
+			streams[i] = archive->createReadStreamForMember(members[i].name);
+
+		delete archive;
+		TS_ASSERT(!deleted);
+
+		for (int i = 0; i < count; i++) {
+			TS_ASSERT(readsBack(streams[i], data, sizeof(data)));
+
+			// Reading again after a backward seek
+			TS_ASSERT(streams[i]->seek(0));
+			TS_ASSERT(readsBack(streams[i], data, sizeof(data)));
+		}
+
+		for (int i = 0; i < count; i++)
+			delete streams[i];
+		TS_ASSERT(deleted);
+	}
+};
@@ -0,0 +1,75 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/memstream.h"
+#include "engines/detectioncache.h"
+
+class DetectionCacheTestSuite : public CxxTest::TestSuite {
+	static const char *md5() { return "0123456789abcdef0123456789abcdef"; }
+
+public:
+	void test_lookupStore() {
+		DetectionCache cache;
+		Common::String result;
+
+		TS_ASSERT(!cache.lookup("/games/a/resource.map", 1000, 4096, 5000, result));
+		cache.store("/games/a/resource.map", 1000, 4096, 5000, md5());
+
+		TS_ASSERT(cache.lookup("/games/a/resource.map", 1000, 4096, 5000, result));
+		TS_ASSERT_EQUALS(result, md5());
+
+		// Different path or number of hashed bytes
+		TS_ASSERT(!cache.lookup("/games/b/resource.map", 1000, 4096, 5000, result));
+		TS_ASSERT(!cache.lookup("/games/a/resource.map", 1000, 4096, 0, result));
+
+		TS_ASSERT_EQUALS(cache.getHits(), 1u);
+		TS_ASSERT_EQUALS(cache.getMisses(), 3u);
+	}
+
+	void test_invalidate() {
+		DetectionCache cache;
+		Common::String result;
+
+		cache.store("/games/a/resource.map", 1000, 4096, 5000, md5());
+
+		// The file was modified or changed its size
+		TS_ASSERT(!cache.lookup("/games/a/resource.map", 1001, 4096, 5000, result));
+		TS_ASSERT(!cache.lookup("/games/a/resource.map", 1000, 4097, 5000, result));
+
+		// An unknown modification time never matches
+		TS_ASSERT(!cache.lookup("/games/a/resource.map", 0, 4096, 5000, result));
+		cache.store("/games/b/resource.map", 0, 4096, 5000, md5());
+		TS_ASSERT(!cache.lookup("/games/b/resource.map", 0, 4096, 5000, result));
+
+		// Storing again replaces the entry
+		cache.store("/games/a/resource.map", 1001, 4096, 5000, md5());
+		TS_ASSERT(cache.lookup("/games/a/resource.map", 1001, 4096, 5000, result));
+		TS_ASSERT(!cache.lookup("/games/a/resource.map", 1000, 4096, 5000, result));
+	}
+
+	void test_saveLoad() {
+		DetectionCache cache;
+		cache.store("/games/a/resource.map", 1000, 4096, 5000, md5());
+		cache.store("/games/a/resource.000", 1002, 65536, 0, "fedcba9876543210fedcba9876543210");
+
+		Common::MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+		TS_ASSERT(cache.saveTo(out));
+
+		DetectionCache loaded;
+		Common::MemoryReadStream in(out.getData(), out.size());
+		loaded.loadFrom(in);
+
+		Common::String result;
+		TS_ASSERT(loaded.lookup("/games/a/resource.map", 1000, 4096, 5000, result));
+		TS_ASSERT_EQUALS(result, md5());
+		TS_ASSERT(loaded.lookup("/games/a/resource.000", 1002, 65536, 0, result));
+		TS_ASSERT_EQUALS(result, "fedcba9876543210fedcba9876543210");
+		TS_ASSERT(!loaded.lookup("/games/a/resource.000", 1003, 65536, 0, result));
+
+		// A truncated file keeps the complete entries only
+		DetectionCache truncated;
+		Common::MemoryReadStream part(out.getData(), out.size() - 1);
+		truncated.loadFrom(part);
+		TS_ASSERT_EQUALS(truncated.lookup("/games/a/resource.map", 1000, 4096, 5000, result) +
+		                 truncated.lookup("/games/a/resource.000", 1002, 65536, 0, result), 1);
+	}
+};
@@ -0,0 +1,125 @@
+#include <cxxtest/TestSuite.h>
+
+#include "graphics/transparent_surface.h"
+#include "graphics/transformed_surface_cache.h"
+
+class TransparentSurfaceTestSuite : public CxxTest::TestSuite
+{
+	// Not a multiple of the vector widths, leaving pixels at the end of rows
+	static const int kWidth = 37;
+	static const int kHeight = 6;
+
+	static void fillSurface(Graphics::Surface &surface, uint32 seed) {
+		for (int y = 0; y < surface.h; y++) {
+			uint32 *pixels = (uint32 *)surface.getBasePtr(0, y);
+			for (int x = 0; x < surface.w; x++) {
+				seed = seed * 1103515245 + 12345;
+				pixels[x] = (seed >> 16) | (seed << 16);
+			}
+		}
+		// Include fully transparent and fully opaque pixels, and the extremes
+		// of every component
+		*(uint32 *)surface.getBasePtr(0, 0) = 0;
+		*(uint32 *)surface.getBasePtr(1, 0) = 0xFFFFFFFF;
+		*(uint32 *)surface.getBasePtr(2, 0) = TS_ARGB(0, 255, 255, 255);
+		*(uint32 *)surface.getBasePtr(3, 0) = TS_ARGB(255, 0, 0, 0);
+	}
+
+	static bool equal(const Graphics::Surface &a, const Graphics::Surface &b) {
+		for (int y = 0; y < a.h; y++) {
+			if (memcmp(a.getBasePtr(0, y), b.getBasePtr(0, y), a.w * a.format.bytesPerPixel))
+				return false;
+		}
+		return true;
+	}
+
+public:
+	void test_kernelsMatchScalar() {
+		static const uint32 colors[] = {
+			0xFFFFFFFF,
+			0xFF80FF40,
+			0x80FFFFFF,
+			0xC0FF00FE,
+			0x01404040
+		};
+		static const Graphics::TSpriteBlendMode modes[] = {
+			Graphics::BLEND_NORMAL,
+			Graphics::BLEND_ADDITIVE,
+			Graphics::BLEND_SUBTRACTIVE
+		};
+		const Graphics::TransparentSurface::BlendKernel saved = Graphics::TransparentSurface::getBlendKernel();
+		const Graphics::PixelFormat format = Graphics::TransparentSurface::getSupportedPixelFormat();
+
+		Graphics::TransparentSurface src;
+		Graphics::Surface background, reference, result;
+		src.create(kWidth, kHeight, format);
+		background.create(kWidth + 3, kHeight, format);
+		reference.create(kWidth + 3, kHeight, format);
+		result.create(kWidth + 3, kHeight, format);
+		fillSurface(src, 42);
+		fillSurface(background, 4711);
+
+		for (int mode = 0; mode < ARRAYSIZE(modes); mode++) {
+			for (int color = 0; color < ARRAYSIZE(colors); color++) {
+				for (int flipping = Graphics::FLIP_NONE; flipping <= Graphics::FLIP_HV; flipping++) {
+					Graphics::TransparentSurface::setBlendKernel(Graphics::TransparentSurface::kBlendKernelScalar);
+					reference.copyFrom(background);
+					src.blit(reference, 1, 0, flipping, nullptr, colors[color], -1, -1, modes[mode]);
+
+					for (int kernel = Graphics::TransparentSurface::kBlendKernelScalar + 1; kernel < Graphics::TransparentSurface::kBlendKernelCount; kernel++) {
+						if (!Graphics::TransparentSurface::isBlendKernelSupported((Graphics::TransparentSurface::BlendKernel)kernel))
+							continue;
+
+						Graphics::TransparentSurface::setBlendKernel((Graphics::TransparentSurface::BlendKernel)kernel);
+						result.copyFrom(background);
+						src.blit(result, 1, 0, flipping, nullptr, colors[color], -1, -1, modes[mode]);
+						TS_ASSERT(equal(reference, result));
+					}
+				}
+			}
+		}
+
+		src.free();
+		background.free();
+		reference.free();
+		result.free();
+
+		Graphics::TransparentSurface::setBlendKernel(saved);
+	}
+
+	void test_cacheReusesCopies() {
+		const Graphics::PixelFormat format = Graphics::TransparentSurface::getSupportedPixelFormat();
+		Graphics::TransparentSurface src;
+		src.create(kWidth, kHeight, format);
+		fillSurface(src, 42);
+
+		// Room for two copies of the scaled surface
+		Graphics::TransformedSurfaceCache cache(2 * kWidth * 2 * kHeight * 2 * 4);
+
+		Graphics::TransparentSurface *expected = src.scale(kWidth * 2, kHeight * 2);
+		const Graphics::TransparentSurface *scaled = cache.scale(src, kWidth * 2, kHeight * 2);
+		TS_ASSERT(equal(*expected, *scaled));
+		TS_ASSERT_EQUALS(cache.scale(src, kWidth * 2, kHeight * 2), scaled);
+		TS_ASSERT_EQUALS(cache.getSize(), (uint32)(scaled->h * scaled->pitch));
+		expected->free();
+		delete expected;
+
+		// A different part of the surface is another copy
+		const Graphics::TransparentSurface part(src.getSubArea(Common::Rect(1, 1, kWidth, kHeight)));
+		const Graphics::TransparentSurface *scaledPart = cache.scale(part, kWidth * 2, kHeight * 2);
+		TS_ASSERT_DIFFERS(scaledPart, scaled);
+		TS_ASSERT_EQUALS(cache.getSize(), (uint32)(2 * scaled->h * scaled->pitch));
+
+		// Exceeding the size drops the least recently used copy
+		TS_ASSERT_EQUALS(cache.scale(src, kWidth * 2, kHeight * 2), scaled);
+		cache.scale(src, kHeight * 2, kWidth * 2);
+		TS_ASSERT_EQUALS(cache.getSize(), (uint32)(2 * scaled->h * scaled->pitch));
+		TS_ASSERT_EQUALS(cache.scale(src, kWidth * 2, kHeight * 2), scaled);
+
+		// Invalidating the surface drops the copies of all its parts
+		cache.invalidate(src);
+		TS_ASSERT_EQUALS(cache.getSize(), 0u);
+
+		src.free();
+	}
+};
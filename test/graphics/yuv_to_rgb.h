@@ -0,0 +1,137 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/util.h"
+
+#include "graphics/surface.h"
+#include "graphics/yuv_to_rgb.h"
+
+class YUVToRGBTestSuite : public CxxTest::TestSuite
+{
+	enum Subsampling {
+		k444,
+		k420,
+		k410
+	};
+
+	// Not a multiple of the vector widths, leaving pixels at the end of rows
+	static const int kWidth = 60;
+	static const int kHeight = 8;
+	static const int kPitch = 64;
+
+	byte _y[kPitch * kHeight];
+	byte _u[kPitch * (kHeight + 1)];
+	byte _v[kPitch * (kHeight + 1)];
+
+	void fillPlanes(uint32 seed) {
+		for (int i = 0; i < ARRAYSIZE(_y); i++) {
+			seed = seed * 1103515245 + 12345;
+			_y[i] = seed >> 16;
+		}
+		for (int i = 0; i < ARRAYSIZE(_u); i++) {
+			seed = seed * 1103515245 + 12345;
+			_u[i] = seed >> 16;
+			_v[i] = seed >> 24;
+		}
+		// Include the extremes of every component
+		_y[0] = _u[0] = _v[0] = 0;
+		_y[1] = _u[1] = _v[1] = 255;
+	}
+
+	void convert(Graphics::YUVToRGBManager::Kernel kernel, Subsampling subsampling, Graphics::YUVToRGBManager::LuminanceScale scale, Graphics::Surface &dst) {
+		YUVToRGBMan.setKernel(kernel);
+
+		switch (subsampling) {
+		case k444:
+			YUVToRGBMan.convert444(&dst, scale, _y, _u, _v, kWidth, kHeight, kPitch, kPitch);
+			break;
+		case k420:
+			YUVToRGBMan.convert420(&dst, scale, _y, _u, _v, kWidth, kHeight, kPitch, kPitch);
+			break;
+		case k410:
+			YUVToRGBMan.convert410(&dst, scale, _y, _u, _v, kWidth, kHeight, kPitch, kPitch);
+			break;
+		}
+	}
+
+	/** Return the largest difference of a color component, in steps of the format. */
+	static int maxDifference(const Graphics::Surface &a, const Graphics::Surface &b) {
+		const Graphics::PixelFormat &format = a.format;
+		int result = 0;
+
+		for (int y = 0; y < a.h; y++) {
+			for (int x = 0; x < a.w; x++) {
+				const uint32 pa = format.bytesPerPixel == 2 ? *(const uint16 *)a.getBasePtr(x, y) : *(const uint32 *)a.getBasePtr(x, y);
+				const uint32 pb = format.bytesPerPixel == 2 ? *(const uint16 *)b.getBasePtr(x, y) : *(const uint32 *)b.getBasePtr(x, y);
+				uint8 ra, ga, ba, rb, gb, bb;
+				format.colorToRGB(pa, ra, ga, ba);
+				format.colorToRGB(pb, rb, gb, bb);
+				result = MAX(result, ABS((ra >> format.rLoss) - (rb >> format.rLoss)));
+				result = MAX(result, ABS((ga >> format.gLoss) - (gb >> format.gLoss)));
+				result = MAX(result, ABS((ba >> format.bLoss) - (bb >> format.bLoss)));
+
+				// The alpha channel has to match exactly
+				if ((pa & ~format.RGBToColor(255, 255, 255)) != (pb & ~format.RGBToColor(255, 255, 255)))
+					return 1000;
+			}
+		}
+
+		return result;
+	}
+
+	static bool equal(const Graphics::Surface &a, const Graphics::Surface &b) {
+		for (int y = 0; y < a.h; y++) {
+			if (memcmp(a.getBasePtr(0, y), b.getBasePtr(0, y), a.w * a.format.bytesPerPixel))
+				return false;
+		}
+		return true;
+	}
+
+public:
+	void test_kernelsMatchLookup() {
+		static const Graphics::PixelFormat formats[] = {
+			Graphics::PixelFormat(2, 5, 6, 5, 0, 11, 5, 0, 0),
+			Graphics::PixelFormat(2, 4, 4, 4, 4, 8, 4, 0, 12),
+			Graphics::PixelFormat(4, 8, 8, 8, 0, 16, 8, 0, 0),
+			Graphics::PixelFormat(4, 8, 8, 8, 8, 0, 8, 16, 24)
+		};
+		const Graphics::YUVToRGBManager::Kernel saved = YUVToRGBMan.getKernel();
+
+		fillPlanes(42);
+
+		for (int f = 0; f < ARRAYSIZE(formats); f++) {
+			Graphics::Surface reference, result, first;
+			reference.create(kWidth, kHeight, formats[f]);
+			result.create(kWidth, kHeight, formats[f]);
+			first.create(kWidth, kHeight, formats[f]);
+
+			for (int sub = k444; sub <= k410; sub++) {
+				for (int scale = Graphics::YUVToRGBManager::kScaleFull; scale <= Graphics::YUVToRGBManager::kScaleITU; scale++) {
+					convert(Graphics::YUVToRGBManager::kKernelLookup, (Subsampling)sub, (Graphics::YUVToRGBManager::LuminanceScale)scale, reference);
+
+					bool haveFirst = false;
+					for (int kernel = Graphics::YUVToRGBManager::kKernelLookup + 1; kernel < Graphics::YUVToRGBManager::kKernelCount; kernel++) {
+						if (!Graphics::YUVToRGBManager::isKernelSupported((Graphics::YUVToRGBManager::Kernel)kernel))
+							continue;
+
+						convert((Graphics::YUVToRGBManager::Kernel)kernel, (Subsampling)sub, (Graphics::YUVToRGBManager::LuminanceScale)scale, result);
+						TS_ASSERT_LESS_THAN_EQUALS(maxDifference(reference, result), 4);
+
+						// All vector kernels compute exactly the same
+						if (haveFirst) {
+							TS_ASSERT(equal(first, result));
+						} else {
+							first.copyFrom(result);
+							haveFirst = true;
+						}
+					}
+				}
+			}
+
+			reference.free();
+			result.free();
+			first.free();
+		}
+
+		YUVToRGBMan.setKernel(saved);
+	}
+};
@@ -5,8 +5,12 @@
 #
 ######################################################################
 
-TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h
-TEST_LIBS    := audio/libaudio.a common/libcommon.a
+TESTS        := $(srcdir)/test/common/*.h $(srcdir)/test/audio/*.h $(srcdir)/test/graphics/*.h $(srcdir)/test/engines/*.h $(srcdir)/test/video/*.h
+TEST_LIBS    := engines/libengines.a video/libvideo.a image/libimage.a audio/libaudio.a graphics/libgraphics.a common/libcommon.a
+
+ifdef USE_MT32EMU
+TEST_LIBS    := audio/softsynth/mt32/libmt32.a $(TEST_LIBS)
+endif
 
 #
 TEST_FLAGS   := --runner=StdioPrinter --no-std --no-eh --include=$(srcdir)/test/cxxtest_mingw.h
@@ -35,8 +39,21 @@ test/runner.cpp: $(TESTS)
 	$(srcdir)/test/cxxtest/cxxtestgen.py $(TEST_FLAGS) -o $@ $+
 
 
+#
+# Benchmarks are standalone programs in test/benchmark, timing hot paths.
+# Use the 'benchmark' target to build and run them all.
+#
+BENCHMARKS   := $(patsubst $(srcdir)/%.cpp,%,$(wildcard $(srcdir)/test/benchmark/*.cpp))
+
+benchmark: $(BENCHMARKS)
+	@for bench in $(BENCHMARKS); do echo "== $$bench"; ./$$bench || exit 1; done
+test/benchmark/%: $(srcdir)/test/benchmark/%.cpp $(TEST_LIBS)
+	@mkdir -p test/benchmark
+	$(QUIET_LINK)$(CXX) $(TEST_CXXFLAGS) $(CPPFLAGS) -o $@ $+ $(TEST_LDFLAGS)
+
+
 clean: clean-test
 clean-test:
-	-$(RM) test/runner.cpp test/runner
+	-$(RM) test/runner.cpp test/runner $(BENCHMARKS)
 
-.PHONY: test clean-test
+.PHONY: test benchmark clean-test
@@ -0,0 +1,111 @@
+#include <cxxtest/TestSuite.h>
+
+#include "common/array.h"
+
+#include "graphics/surface.h"
+
+#include "video/avi_decoder.h"
+
+#include "helper.h"
+
+class DecodeAheadTestSuite : public CxxTest::TestSuite {
+	VideoTestSystem _system;
+	OSystem *_oldSystem;
+
+public:
+	void setUp() {
+		_oldSystem = g_system;
+		g_system = &_system;
+	}
+
+	void tearDown() {
+		g_system = _oldSystem;
+	}
+
+	void test_frameOrder() {
+		const VideoTestFile file = createVideoTestAVI(10, 1, true);
+
+		// Decoding ahead hands out the same frames as decoding synchronously
+		for (uint limit = 0; limit < 4; limit++) {
+			Video::AVIDecoder decoder;
+			TS_ASSERT(decoder.setDecodeAhead(limit));
+			TS_ASSERT(decoder.loadStream(openVideoTestFile(file)));
+
+			for (int i = 0; i < 10; i++) {
+				TS_ASSERT(!decoder.endOfVideo());
+
+				const Graphics::Surface *frame = decoder.decodeNextFrame();
+				TS_ASSERT(frame);
+				if (!frame)
+					break;
+
+				TS_ASSERT_EQUALS(*(const byte *)frame->getPixels(), i + 1);
+				TS_ASSERT_EQUALS(decoder.getCurFrame(), i);
+				TS_ASSERT_LESS_THAN_EQUALS(decoder.getDecodeAheadQueueDepth(), limit);
+			}
+
+			TS_ASSERT(decoder.endOfVideo());
+			TS_ASSERT_EQUALS(decoder.getDecodeAheadQueueDepth(), 0u);
+			decoder.close();
+		}
+	}
+
+	void test_seek() {
+		const VideoTestFile file = createVideoTestAVI(10, 1, true);
+		Video::AVIDecoder decoder;
+		TS_ASSERT(decoder.setDecodeAhead(3));
+		TS_ASSERT(decoder.loadStream(openVideoTestFile(file)));
+
+		const Graphics::Surface *frame = decoder.decodeNextFrame();
+		TS_ASSERT_EQUALS(*(const byte *)frame->getPixels(), 1);
+		TS_ASSERT(decoder.waitForDecodeAhead(3, 5000));
+
+		// The frames queued before seeking are thrown away
+		TS_ASSERT(decoder.seekToFrame(6));
+		TS_ASSERT_EQUALS(decoder.getDecodeAheadQueueDepth(), 0u);
+
+		for (int i = 6; i < 10; i++) {
+			frame = decoder.decodeNextFrame();
+			TS_ASSERT_EQUALS(*(const byte *)frame->getPixels(), i + 1);
+			TS_ASSERT_EQUALS(decoder.getCurFrame(), i);
+		}
+
+		TS_ASSERT(decoder.endOfVideo());
+
+		TS_ASSERT(decoder.rewind());
+		frame = decoder.decodeNextFrame();
+		TS_ASSERT_EQUALS(*(const byte *)frame->getPixels(), 1);
+		TS_ASSERT_EQUALS(decoder.getCurFrame(), 0);
+	}
+
+	void test_surfaceReuse() {
+		const uint limit = 2;
+		const VideoTestFile file = createVideoTestAVI(20, 1, true);
+		Video::AVIDecoder decoder;
+		TS_ASSERT(decoder.setDecodeAhead(limit));
+		TS_ASSERT(decoder.loadStream(openVideoTestFile(file)));
+
+		Common::Array<const void *> buffers;
+
+		for (int i = 0; i < 20; i++) {
+			const Graphics::Surface *frame = decoder.decodeNextFrame();
+			TS_ASSERT(frame);
+			if (!frame)
+				break;
+
+			// The frame shown is left alone while the worker fills the queue
+			TS_ASSERT(decoder.waitForDecodeAhead(limit, 5000));
+			TS_ASSERT_EQUALS(*(const byte *)frame->getPixels(), i + 1);
+
+			bool known = false;
+			for (uint j = 0; j < buffers.size(); j++)
+				known |= buffers[j] == frame->getPixels();
+			if (!known)
+				buffers.push_back(frame->getPixels());
+		}
+
+		// The queued frames and the one shown take turns with their buffers
+		TS_ASSERT_LESS_THAN_EQUALS(buffers.size(), limit + 1);
+		TS_ASSERT(decoder.endOfVideo());
+	}
+};
@@ -0,0 +1,204 @@
+#include <cxxtest/TestSuite.h>
+
+#include "video/avi_decoder.h"
+#include "video/frame_index_cache.h"
+#include "video/qt_decoder.h"
+#include "video/smk_decoder.h"
+
+#include "helper.h"
+
+class FrameIndexTestSuite : public CxxTest::TestSuite {
+	VideoTestSystem _system;
+	OSystem *_oldSystem;
+
+	static Common::String makeKey(const char *format, const VideoTestFile &file) {
+		Common::SeekableReadStream *stream = openVideoTestFile(file);
+		const Common::String key = FrameIndexMan.makeKey(format, Common::String(), *stream);
+		delete stream;
+		return key;
+	}
+
+	/** Whether an index is kept for a file, which stays kept */
+	static bool isCached(const Common::String &key) {
+		Video::FrameIndex *index = FrameIndexMan.take(key);
+		if (!index)
+			return false;
+
+		FrameIndexMan.store(key, index);
+		return true;
+	}
+
+	static int decodePixel(Video::VideoDecoder &decoder) {
+		const Graphics::Surface *frame = decoder.decodeNextFrame();
+		return frame ? *(const byte *)frame->getPixels() : -1;
+	}
+
+	static int seekAndDecode(Video::VideoDecoder &decoder, uint frame) {
+		return decoder.seekToFrame(frame) ? decodePixel(decoder) : -1;
+	}
+
+	/** The color of each frame of a Smacker video from createVideoTestSmacker() */
+	static void getSmackerColors(const byte *frames, uint frameCount, byte *colors) {
+		byte color = 0;
+		for (uint i = 0; i < frameCount; i++) {
+			if (frames[i] != kVideoTestSmackerSkip)
+				color = frames[i];
+			colors[i] = color;
+		}
+	}
+
+public:
+	void setUp() {
+		_oldSystem = g_system;
+		g_system = &_system;
+		FrameIndexMan.clear();
+	}
+
+	void tearDown() {
+		FrameIndexMan.clear();
+		g_system = _oldSystem;
+	}
+
+	void test_key() {
+		const VideoTestFile file = createVideoTestAVI(10, 1, true);
+		const Common::String key = makeKey("avi", file);
+		TS_ASSERT(!key.empty());
+
+		// Other formats, names and contents get other keys
+		TS_ASSERT_DIFFERS(key, makeKey("smk", file));
+		TS_ASSERT_DIFFERS(key, makeKey("avi", createVideoTestAVI(10, 2, true)));
+
+		Common::SeekableReadStream *stream = openVideoTestFile(file);
+		stream->seek(12);
+		TS_ASSERT_DIFFERS(key, FrameIndexMan.makeKey("avi", "intro.avi", *stream));
+		TS_ASSERT_EQUALS(FrameIndexMan.makeKey("avi", "intro.avi", *stream), FrameIndexMan.makeKey("avi", "INTRO.AVI", *stream));
+
+		// The position is kept
+		TS_ASSERT_EQUALS(stream->pos(), 12);
+		delete stream;
+	}
+
+	void test_aviRoundTrip() {
+		// Without an index, the movie list is scanned on the first seek
+		for (int withIndex = 0; withIndex < 2; withIndex++) {
+			const VideoTestFile file = createVideoTestAVI(10, 1, withIndex);
+			const Common::String key = makeKey("avi", file);
+			Video::AVIDecoder decoder;
+
+			TS_ASSERT(decoder.loadStream(openVideoTestFile(file)));
+			TS_ASSERT_EQUALS(seekAndDecode(decoder, 7), 8);
+			TS_ASSERT_EQUALS(decodePixel(decoder), 9);
+			decoder.close();
+			TS_ASSERT(isCached(key));
+
+			// Opening the file again takes the index out of the cache
+			TS_ASSERT(decoder.loadStream(openVideoTestFile(file)));
+			TS_ASSERT(!isCached(key));
+			TS_ASSERT_EQUALS(seekAndDecode(decoder, 3), 4);
+			TS_ASSERT_EQUALS(seekAndDecode(decoder, 9), 10);
+			TS_ASSERT_EQUALS(seekAndDecode(decoder, 0), 1);
+			decoder.close();
+			TS_ASSERT(isCached(key));
+		}
+	}
+
+	void test_quickTimeRoundTrip() {
+		// QuickTime videos keep their sample tables in the movie atom, so
+		// the sample index is built from those again when reopening
+		const VideoTestFile file = createVideoTestQuickTime(10, 1);
+		Video::QuickTimeDecoder decoder;
+
+		for (int pass = 0; pass < 2; pass++) {
+			TS_ASSERT(decoder.loadStream(openVideoTestFile(file)));
+			TS_ASSERT_EQUALS(decoder.getFrameCount(), 10u);
+
+			// Frames in the middle and at the end of chunks, after keyframes
+			// and samples of both sizes
+			static const uint frames[] = { 5, 2, 9, 7, 0, 4 };
+			for (uint i = 0; i < ARRAYSIZE(frames); i++) {
+				TS_ASSERT(decoder.seek(Audio::Timestamp(0, frames[i], 10)));
+				TS_ASSERT_EQUALS(decodePixel(decoder), (int)frames[i] + 1);
+			}
+
+			TS_ASSERT_EQUALS(decodePixel(decoder), 6);
+			decoder.close();
+		}
+	}
+
+	void test_smackerRoundTrip() {
+		static const byte frames[] = { 1, kVideoTestSmackerSkip, 2, kVideoTestSmackerSkip, kVideoTestSmackerSkip, 3, kVideoTestSmackerSkip, 1 };
+		const uint frameCount = ARRAYSIZE(frames);
+		byte colors[frameCount];
+		getSmackerColors(frames, frameCount, colors);
+
+		const VideoTestFile file = createVideoTestSmacker(frames, frameCount);
+		const Common::String key = makeKey("smk", file);
+		Video::SmackerDecoder decoder;
+
+		// Playing the video finds its keyframes
+		TS_ASSERT(decoder.loadStream(openVideoTestFile(file)));
+		for (uint i = 0; i < frameCount; i++)
+			TS_ASSERT_EQUALS(decodePixel(decoder), colors[i]);
+		decoder.close();
+		TS_ASSERT(isCached(key));
+
+		TS_ASSERT(decoder.loadStream(openVideoTestFile(file)));
+		TS_ASSERT(!isCached(key));
+
+		static const uint seeks[] = { 4, 1, 6, 7, 3, 0 };
+		for (uint i = 0; i < ARRAYSIZE(seeks); i++)
+			TS_ASSERT_EQUALS(seekAndDecode(decoder, seeks[i]), colors[seeks[i]]);
+
+		decoder.close();
+		TS_ASSERT(isCached(key));
+	}
+
+	void test_staleEntries() {
+		// A file changed in place has another key, so the index of the old
+		// file stays unused
+		const VideoTestFile oldFile = createVideoTestAVI(10, 1, false);
+		const VideoTestFile newFile = createVideoTestAVI(10, 21, false);
+		const Common::String oldKey = makeKey("avi", oldFile);
+		Video::AVIDecoder aviDecoder;
+
+		TS_ASSERT(aviDecoder.loadStream(openVideoTestFile(oldFile)));
+		TS_ASSERT_EQUALS(seekAndDecode(aviDecoder, 5), 6);
+		aviDecoder.close();
+
+		TS_ASSERT(aviDecoder.loadStream(openVideoTestFile(newFile)));
+		TS_ASSERT(isCached(oldKey));
+		TS_ASSERT_EQUALS(seekAndDecode(aviDecoder, 5), 26);
+		aviDecoder.close();
+
+		// An index which ended up with the key of a file it does not fit is
+		// thrown away by the decoder
+		const VideoTestFile longFile = createVideoTestAVI(14, 1, false);
+		const Common::String longKey = makeKey("avi", longFile);
+		FrameIndexMan.store(longKey, FrameIndexMan.take(oldKey));
+
+		TS_ASSERT(aviDecoder.loadStream(openVideoTestFile(longFile)));
+		TS_ASSERT_EQUALS(seekAndDecode(aviDecoder, 12), 13);
+		aviDecoder.close();
+
+		static const byte frames[] = { 1, kVideoTestSmackerSkip, 2, kVideoTestSmackerSkip };
+		static const byte longFrames[] = { 3, kVideoTestSmackerSkip, kVideoTestSmackerSkip, 1, kVideoTestSmackerSkip, 2 };
+		byte colors[ARRAYSIZE(longFrames)];
+		getSmackerColors(longFrames, ARRAYSIZE(longFrames), colors);
+
+		const VideoTestFile smkFile = createVideoTestSmacker(frames, ARRAYSIZE(frames));
+		const VideoTestFile longSmkFile = createVideoTestSmacker(longFrames, ARRAYSIZE(longFrames));
+		Video::SmackerDecoder smkDecoder;
+
+		TS_ASSERT(smkDecoder.loadStream(openVideoTestFile(smkFile)));
+		for (uint i = 0; i < ARRAYSIZE(frames); i++)
+			decodePixel(smkDecoder);
+		smkDecoder.close();
+
+		FrameIndexMan.store(makeKey("smk", longSmkFile), FrameIndexMan.take(makeKey("smk", smkFile)));
+
+		TS_ASSERT(smkDecoder.loadStream(openVideoTestFile(longSmkFile)));
+		for (uint i = ARRAYSIZE(longFrames); i-- > 0; )
+			TS_ASSERT_EQUALS(seekAndDecode(smkDecoder, i), colors[i]);
+		smkDecoder.close();
+	}
+};
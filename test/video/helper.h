@@ -0,0 +1,471 @@
+#ifndef TEST_VIDEO_HELPER_H
+#define TEST_VIDEO_HELPER_H
+
+#include "common/array.h"
+#include "common/endian.h"
+#include "common/list.h"
+#include "common/memstream.h"
+#include "common/system.h"
+#include "common/util.h"
+
+#include "graphics/pixelformat.h"
+
+/**
+ * Just enough of a backend for the video decoders, which ask for the
+ * screen format when they are created.
+ */
+class VideoTestSystem : public OSystem {
+public:
+	virtual const GraphicsMode *getSupportedGraphicsModes() const { return 0; }
+	virtual int getDefaultGraphicsMode() const { return 0; }
+	virtual bool setGraphicsMode(int mode) { return false; }
+	virtual int getGraphicsMode() const { return 0; }
+	virtual Graphics::PixelFormat getScreenFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	virtual Common::List<Graphics::PixelFormat> getSupportedFormats() const { return Common::List<Graphics::PixelFormat>(); }
+	virtual void initSize(uint width, uint height, const Graphics::PixelFormat *format = NULL) {}
+	virtual int16 getHeight() { return 0; }
+	virtual int16 getWidth() { return 0; }
+	virtual PaletteManager *getPaletteManager() { return 0; }
+	virtual void copyRectToScreen(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual Graphics::Surface *lockScreen() { return 0; }
+	virtual void unlockScreen() {}
+	virtual void fillScreen(uint32 col) {}
+	virtual void updateScreen() {}
+	virtual void setShakePos(int shakeOffset) {}
+	virtual void showOverlay() {}
+	virtual void hideOverlay() {}
+	virtual Graphics::PixelFormat getOverlayFormat() const { return Graphics::PixelFormat::createFormatCLUT8(); }
+	virtual void clearOverlay() {}
+	virtual void grabOverlay(void *buf, int pitch) {}
+	virtual void copyRectToOverlay(const void *buf, int pitch, int x, int y, int w, int h) {}
+	virtual int16 getOverlayHeight() { return 0; }
+	virtual int16 getOverlayWidth() { return 0; }
+	virtual bool showMouse(bool visible) { return false; }
+	virtual void warpMouse(int x, int y) {}
+	virtual void setMouseCursor(const void *buf, uint w, uint h, int hotspotX, int hotspotY, uint32 keycolor, bool dontScale = false, const Graphics::PixelFormat *format = NULL) {}
+	virtual uint32 getMillis(bool skipRecord = false) { return 0; }
+	virtual void delayMillis(uint msecs) {}
+	virtual void getTimeAndDate(TimeDate &t) const {}
+	virtual MutexRef createMutex() { return 0; }
+	virtual void lockMutex(MutexRef mutex) {}
+	virtual void unlockMutex(MutexRef mutex) {}
+	virtual void deleteMutex(MutexRef mutex) {}
+	virtual Audio::Mixer *getMixer() { return 0; }
+	virtual void quit() {}
+	virtual void displayMessageOnOSD(const char *msg) {}
+	virtual void displayActivityIconOnOSD(const Graphics::Surface *icon) {}
+	virtual void logMessage(LogMessageType::Type type, const char *message) {}
+};
+
+typedef Common::Array<byte> VideoTestFile;
+
+static Common::SeekableReadStream *openVideoTestFile(const VideoTestFile &file) {
+	byte *data = (byte *)malloc(file.size());
+	memcpy(data, file.begin(), file.size());
+	return new Common::MemoryReadStream(data, file.size(), DisposeAfterUse::YES);
+}
+
+/**
+ * Create an AVI video of 4x1 uncompressed 8 bit frames. All pixels of
+ * frame i are seed + i. With an index, every fourth frame is a keyframe.
+ */
+static VideoTestFile createVideoTestAVI(uint frameCount, byte seed, bool withIndex) {
+	Common::MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+	const uint32 indexSize = withIndex ? 8 + 16 * frameCount : 0;
+
+	out.writeUint32BE(MKTAG('R','I','F','F'));
+	out.writeUint32LE(4 + (8 + 196) + (8 + 4 + 12 * frameCount) + indexSize);
+	out.writeUint32BE(MKTAG('A','V','I',' '));
+
+	out.writeUint32BE(MKTAG('L','I','S','T'));
+	out.writeUint32LE(196);
+	out.writeUint32BE(MKTAG('h','d','r','l'));
+
+	out.writeUint32BE(MKTAG('a','v','i','h'));
+	out.writeUint32LE(56);
+	out.writeUint32LE(100000); // microseconds per frame
+	out.writeUint32LE(0);      // max bytes per second
+	out.writeUint32LE(0);      // padding
+	out.writeUint32LE(withIndex ? 0x10 : 0);
+	out.writeUint32LE(frameCount);
+	out.writeUint32LE(0);      // initial frames
+	out.writeUint32LE(1);      // streams
+	out.writeUint32LE(0);      // buffer size
+	out.writeUint32LE(4);      // width
+	out.writeUint32LE(1);      // height
+	for (int i = 0; i < 4; i++)
+		out.writeUint32LE(0);
+
+	out.writeUint32BE(MKTAG('L','I','S','T'));
+	out.writeUint32LE(120);
+	out.writeUint32BE(MKTAG('s','t','r','l'));
+
+	out.writeUint32BE(MKTAG('s','t','r','h'));
+	out.writeUint32LE(56);
+	out.writeUint32BE(MKTAG('v','i','d','s'));
+	out.writeUint32BE(0);      // handler
+	out.writeUint32LE(0);      // flags
+	out.writeUint16LE(0);      // priority
+	out.writeUint16LE(0);      // language
+	out.writeUint32LE(0);      // initial frames
+	out.writeUint32LE(1);      // scale
+	out.writeUint32LE(10);     // rate
+	out.writeUint32LE(0);      // start
+	out.writeUint32LE(frameCount);
+	out.writeUint32LE(0);      // buffer size
+	out.writeUint32LE(0);      // quality
+	out.writeUint32LE(0);      // sample size
+	out.writeUint32LE(0);      // frame rectangle
+	out.writeUint32LE(0);
+
+	out.writeUint32BE(MKTAG('s','t','r','f'));
+	out.writeUint32LE(44);
+	out.writeUint32LE(40);
+	out.writeUint32LE(4);      // width
+	out.writeUint32LE(1);      // height
+	out.writeUint16LE(1);      // planes
+	out.writeUint16LE(8);      // bits per pixel
+	out.writeUint32BE(0);      // uncompressed
+	out.writeUint32LE(4);      // image size
+	out.writeUint32LE(0);
+	out.writeUint32LE(0);
+	out.writeUint32LE(1);      // colors used
+	out.writeUint32LE(0);
+	out.writeUint32LE(0);      // the palette
+
+	out.writeUint32BE(MKTAG('L','I','S','T'));
+	out.writeUint32LE(4 + 12 * frameCount);
+	out.writeUint32BE(MKTAG('m','o','v','i'));
+	for (uint i = 0; i < frameCount; i++) {
+		out.writeUint32BE(MKTAG('0','0','d','b'));
+		out.writeUint32LE(4);
+		out.writeUint32BE((seed + i) * 0x01010101);
+	}
+
+	if (withIndex) {
+		out.writeUint32BE(MKTAG('i','d','x','1'));
+		out.writeUint32LE(16 * frameCount);
+		for (uint i = 0; i < frameCount; i++) {
+			out.writeUint32BE(MKTAG('0','0','d','b'));
+			out.writeUint32LE((i % 4) == 0 ? 0x10 : 0);
+			out.writeUint32LE(4 + 12 * i); // relative to the movie list
+			out.writeUint32LE(4);
+		}
+	}
+
+	return VideoTestFile(out.getData(), out.size());
+}
+
+static void writeVideoTestAtom(Common::WriteStream &out, uint32 type, Common::MemoryWriteStreamDynamic &payload) {
+	out.writeUint32BE(8 + payload.size());
+	out.writeUint32BE(type);
+	out.write(payload.getData(), payload.size());
+}
+
+/**
+ * Create a QuickTime video of 4x1 QuickTime RLE frames, three samples to a
+ * chunk. All pixels of frame i are seed + i. Frames 0, 3 and 7 are
+ * keyframes, and every second frame has an optional header so that the
+ * samples differ in size.
+ */
+static VideoTestFile createVideoTestQuickTime(uint frameCount, byte seed) {
+	const uint samplesPerChunk = 3;
+	const uint chunkCount = (frameCount + samplesPerChunk - 1) / samplesPerChunk;
+	const uint32 keyFrames[] = { 1, 4, 8 };
+
+	Common::MemoryWriteStreamDynamic samples(DisposeAfterUse::YES);
+	Common::Array<uint32> sampleSizes;
+	for (uint i = 0; i < frameCount; i++) {
+		const bool header = (i & 1) != 0;
+		const uint32 size = header ? 21 : 13;
+		sampleSizes.push_back(size);
+
+		samples.writeUint32BE(size);
+		samples.writeUint16BE(header ? 8 : 0);
+		if (header) {
+			samples.writeUint16BE(0); // start line
+			samples.writeUint16BE(0);
+			samples.writeUint16BE(1); // lines
+			samples.writeUint16BE(0);
+		}
+		samples.writeByte(1);         // skip
+		samples.writeByte(1);         // copy four pixels
+		samples.writeUint32BE((seed + i) * 0x01010101);
+		samples.writeByte(0xFF);      // end of line
+	}
+
+	// The chunk offsets depend on the size of the movie atom in front of
+	// the samples, which does not depend on the offsets
+	uint32 dataStart = 0;
+	Common::MemoryWriteStreamDynamic *moov = 0;
+
+	for (int pass = 0; pass < 2; pass++) {
+		Common::MemoryWriteStreamDynamic stsd(DisposeAfterUse::YES);
+		stsd.writeUint32BE(0);
+		stsd.writeUint32BE(1);
+		stsd.writeUint32BE(102);
+		stsd.writeUint32BE(MKTAG('r','l','e',' '));
+		stsd.writeUint32BE(0);
+		stsd.writeUint16BE(0);
+		stsd.writeUint16BE(1);        // data reference
+		stsd.writeUint16BE(0);        // version
+		stsd.writeUint16BE(0);        // revision
+		stsd.writeUint32BE(0);        // vendor
+		stsd.writeUint32BE(0);        // temporal quality
+		stsd.writeUint32BE(0);        // spatial quality
+		stsd.writeUint16BE(4);        // width
+		stsd.writeUint16BE(1);        // height
+		stsd.writeUint32BE(0x480000);
+		stsd.writeUint32BE(0x480000);
+		stsd.writeUint32BE(0);
+		stsd.writeUint16BE(1);        // frames per sample
+		for (int i = 0; i < 8; i++)
+			stsd.writeUint32BE(0);    // codec name
+		stsd.writeUint16BE(8);        // depth
+		stsd.writeUint16BE(0);        // color table in the file
+		stsd.writeUint32BE(0);        // first color
+		stsd.writeUint16BE(0);
+		stsd.writeUint16BE(0);        // last color
+		stsd.writeUint16BE(0);
+		stsd.writeUint16BE(0xFFFF);
+		stsd.writeUint16BE(0xFFFF);
+		stsd.writeUint16BE(0xFFFF);
+
+		Common::MemoryWriteStreamDynamic stts(DisposeAfterUse::YES);
+		stts.writeUint32BE(0);
+		stts.writeUint32BE(1);
+		stts.writeUint32BE(frameCount);
+		stts.writeUint32BE(1);
+
+		Common::MemoryWriteStreamDynamic stss(DisposeAfterUse::YES);
+		stss.writeUint32BE(0);
+		stss.writeUint32BE(ARRAYSIZE(keyFrames));
+		for (uint i = 0; i < ARRAYSIZE(keyFrames); i++)
+			stss.writeUint32BE(keyFrames[i]);
+
+		Common::MemoryWriteStreamDynamic stsc(DisposeAfterUse::YES);
+		stsc.writeUint32BE(0);
+		stsc.writeUint32BE(1);
+		stsc.writeUint32BE(1);        // first chunk
+		stsc.writeUint32BE(samplesPerChunk);
+		stsc.writeUint32BE(1);        // sample description
+
+		Common::MemoryWriteStreamDynamic stsz(DisposeAfterUse::YES);
+		stsz.writeUint32BE(0);
+		stsz.writeUint32BE(0);        // the sizes differ
+		stsz.writeUint32BE(frameCount);
+		for (uint i = 0; i < frameCount; i++)
+			stsz.writeUint32BE(sampleSizes[i]);
+
+		Common::MemoryWriteStreamDynamic stco(DisposeAfterUse::YES);
+		stco.writeUint32BE(0);
+		stco.writeUint32BE(chunkCount);
+		uint32 offset = dataStart;
+		for (uint i = 0; i < frameCount; i++) {
+			if ((i % samplesPerChunk) == 0)
+				stco.writeUint32BE(offset);
+			offset += sampleSizes[i];
+		}
+
+		Common::MemoryWriteStreamDynamic stbl(DisposeAfterUse::YES);
+		writeVideoTestAtom(stbl, MKTAG('s','t','s','d'), stsd);
+		writeVideoTestAtom(stbl, MKTAG('s','t','t','s'), stts);
+		writeVideoTestAtom(stbl, MKTAG('s','t','s','s'), stss);
+		writeVideoTestAtom(stbl, MKTAG('s','t','s','c'), stsc);
+		writeVideoTestAtom(stbl, MKTAG('s','t','s','z'), stsz);
+		writeVideoTestAtom(stbl, MKTAG('s','t','c','o'), stco);
+
+		Common::MemoryWriteStreamDynamic minf(DisposeAfterUse::YES);
+		writeVideoTestAtom(minf, MKTAG('s','t','b','l'), stbl);
+
+		Common::MemoryWriteStreamDynamic mdhd(DisposeAfterUse::YES);
+		mdhd.writeUint32BE(0);
+		mdhd.writeUint32BE(0);
+		mdhd.writeUint32BE(0);
+		mdhd.writeUint32BE(10);       // time scale
+		mdhd.writeUint32BE(frameCount);
+		mdhd.writeUint32BE(0);
+
+		Common::MemoryWriteStreamDynamic hdlr(DisposeAfterUse::YES);
+		hdlr.writeUint32BE(0);
+		hdlr.writeUint32BE(MKTAG('m','h','l','r'));
+		hdlr.writeUint32BE(MKTAG('v','i','d','e'));
+		hdlr.writeUint32BE(0);
+		hdlr.writeUint32BE(0);
+		hdlr.writeUint32BE(0);
+
+		Common::MemoryWriteStreamDynamic mdia(DisposeAfterUse::YES);
+		writeVideoTestAtom(mdia, MKTAG('m','d','h','d'), mdhd);
+		writeVideoTestAtom(mdia, MKTAG('h','d','l','r'), hdlr);
+		writeVideoTestAtom(mdia, MKTAG('m','i','n','f'), minf);
+
+		// The display matrix of the movie and the track
+		Common::MemoryWriteStreamDynamic matrix(DisposeAfterUse::YES);
+		for (int i = 0; i < 9; i++)
+			matrix.writeUint32BE((i == 0 || i == 4) ? 0x10000 : (i == 8 ? 0x40000000 : 0));
+
+		Common::MemoryWriteStreamDynamic tkhd(DisposeAfterUse::YES);
+		tkhd.writeUint32BE(0);
+		tkhd.writeUint32BE(0);
+		tkhd.writeUint32BE(0);
+		tkhd.writeUint32BE(1);        // track id
+		tkhd.writeUint32BE(0);
+		tkhd.writeUint32BE(frameCount);
+		tkhd.writeUint32BE(0);
+		tkhd.writeUint32BE(0);
+		tkhd.writeUint32BE(0);        // layer and alternate group
+		tkhd.writeUint32BE(0);        // volume
+		tkhd.write(matrix.getData(), matrix.size());
+		tkhd.writeUint32BE(4 << 16);
+		tkhd.writeUint32BE(1 << 16);
+
+		Common::MemoryWriteStreamDynamic trak(DisposeAfterUse::YES);
+		writeVideoTestAtom(trak, MKTAG('t','k','h','d'), tkhd);
+		writeVideoTestAtom(trak, MKTAG('m','d','i','a'), mdia);
+
+		Common::MemoryWriteStreamDynamic mvhd(DisposeAfterUse::YES);
+		mvhd.writeUint32BE(0);
+		mvhd.writeUint32BE(0);
+		mvhd.writeUint32BE(0);
+		mvhd.writeUint32BE(10);       // time scale
+		mvhd.writeUint32BE(frameCount);
+		mvhd.writeUint32BE(0x10000);  // preferred rate
+		mvhd.writeUint16BE(0x100);    // preferred volume
+		for (int i = 0; i < 10; i++)
+			mvhd.writeByte(0);
+		mvhd.write(matrix.getData(), matrix.size());
+		for (int i = 0; i < 7; i++)
+			mvhd.writeUint32BE(0);
+
+		delete moov;
+		moov = new Common::MemoryWriteStreamDynamic(DisposeAfterUse::YES);
+		writeVideoTestAtom(*moov, MKTAG('m','v','h','d'), mvhd);
+		writeVideoTestAtom(*moov, MKTAG('t','r','a','k'), trak);
+
+		dataStart = 8 + moov->size();
+	}
+
+	Common::MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+	writeVideoTestAtom(out, MKTAG('m','o','o','v'), *moov);
+	out.write(samples.getData(), samples.size());
+	delete moov;
+
+	return VideoTestFile(out.getData(), out.size());
+}
+
+/** Writes bits in the order Smacker reads them, starting at the LSB */
+class VideoTestBitWriter {
+public:
+	VideoTestBitWriter() : _bits(0) {}
+
+	void putBit(uint bit) {
+		if ((_bits % 8) == 0)
+			_data.push_back(0);
+		if (bit)
+			_data.back() |= 1 << (_bits % 8);
+		_bits++;
+	}
+
+	void putBits(uint32 value, uint count) {
+		for (uint i = 0; i < count; i++)
+			putBit((value >> i) & 1);
+	}
+
+	/** Write the code of a leaf of a complete Huffman tree */
+	void putCode(uint leaf, uint depth) {
+		while (depth--)
+			putBit((leaf >> depth) & 1);
+	}
+
+	const VideoTestFile &getData() const { return _data; }
+
+private:
+	VideoTestFile _data;
+	uint _bits;
+};
+
+enum {
+	/** A frame of createVideoTestSmacker() which leaves the picture alone */
+	kVideoTestSmackerSkip = 0
+};
+
+/**
+ * Create a Smacker video of 4x4 frames, which consist of a single block.
+ * Each frame either fills the block with a color from 1 to 3, which makes
+ * it a keyframe, or skips it.
+ */
+static VideoTestFile createVideoTestSmacker(const byte *frames, uint frameCount) {
+	// The block type tree has four leaves: fills with colors 1 to 3, and
+	// a skip. The low bytes are the block types with a run of one block,
+	// the high bytes the colors.
+	VideoTestBitWriter trees;
+	trees.putBit(0); // no mono block map tree
+	trees.putBit(0); // no mono block color tree
+	trees.putBit(0); // no full block tree
+
+	trees.putBit(1);
+	trees.putBit(1); // low bytes: fill, skip
+	trees.putBit(1);
+	trees.putBit(0);
+	trees.putBits(3, 8);
+	trees.putBit(0);
+	trees.putBits(2, 8);
+	trees.putBit(0);
+	trees.putBit(1); // high bytes: 0 to 3
+	trees.putBit(1);
+	trees.putBit(1);
+	for (uint i = 0; i < 4; i++) {
+		if (i == 2)
+			trees.putBit(1);
+		trees.putBit(0);
+		trees.putBits(i, 8);
+	}
+	trees.putBit(0);
+	for (uint i = 0; i < 3; i++)
+		trees.putBits(0xFFFF - i, 16); // markers, none of them used
+	trees.putBit(1);
+	trees.putBit(1);
+	for (uint i = 0; i < 4; i++) {
+		if (i == 2)
+			trees.putBit(1);
+		trees.putBit(0);
+		trees.putCode(i == 3 ? 1 : 0, 1);
+		trees.putCode(i == 3 ? 0 : i + 1, 2);
+	}
+	trees.putBit(0);
+
+	Common::MemoryWriteStreamDynamic out(DisposeAfterUse::YES);
+	out.writeUint32BE(MKTAG('S','M','K','2'));
+	out.writeUint32LE(4);          // width
+	out.writeUint32LE(4);          // height
+	out.writeUint32LE(frameCount);
+	out.writeUint32LE(100);        // milliseconds per frame
+	out.writeUint32LE(0);          // flags
+	for (int i = 0; i < 7; i++)
+		out.writeUint32LE(0);      // audio sizes
+	out.writeUint32LE(trees.getData().size());
+	out.writeUint32LE(4);          // mono block map tree
+	out.writeUint32LE(4);          // mono block color tree
+	out.writeUint32LE(4);          // full block tree
+	out.writeUint32LE(64);         // block type tree
+	for (int i = 0; i < 7; i++)
+		out.writeUint32LE(0);      // audio formats
+	out.writeUint32LE(0);
+	for (uint i = 0; i < frameCount; i++)
+		out.writeUint32LE(4);      // frame size
+	for (uint i = 0; i < frameCount; i++)
+		out.writeByte(0);          // frame type
+	out.write(trees.getData().begin(), trees.getData().size());
+
+	for (uint i = 0; i < frameCount; i++) {
+		VideoTestBitWriter frame;
+		frame.putCode(frames[i] == kVideoTestSmackerSkip ? 3 : frames[i] - 1, 2);
+		out.write(frame.getData().begin(), 1);
+		out.writeByte(0);
+		out.writeUint16LE(0);
+	}
+
+	return VideoTestFile(out.getData(), out.size());
+}
+
+#endif
@@ -102,13 +102,13 @@ void AVIDecoder::initCommon() {
 	_fileStream = 0;
 	_videoTrackCounter = _audioTrackCounter = 0;
 	_lastAddedTrack = nullptr;
+	_seekIndex = 0;
 	memset(&_header, 0, sizeof(_header));
 }
 
 bool AVIDecoder::isSeekable() const {
-	// Only videos with an index can seek
-	// Anyone else who wants to seek is crazy.
-	return isVideoLoaded() && !_indexEntries.empty();
+	// Videos without an index get their movie list scanned on the first seek
+	return isVideoLoaded();
 }
 
 bool AVIDecoder::parseNextChunk() {
@@ -342,6 +342,11 @@ bool AVIDecoder::loadStream(Common::SeekableReadStream *stream) {
 		return false;
 	}
 
+	// Take the index of the file, in case it was opened before
+	_seekIndexKey = FrameIndexMan.makeKey("avi", getLoadingFileName(), *stream);
+	if (!_seekIndexKey.empty())
+		_seekIndex = (SeekIndex *)FrameIndexMan.take(_seekIndexKey);
+
 	_fileStream = stream;
 
 	// Go through all chunks in the file
@@ -382,6 +387,18 @@ bool AVIDecoder::loadStream(Common::SeekableReadStream *stream) {
 	// Check if this is a special Duck Truemotion video
 	checkTruemotion1();
 
+	// Throw away an index taken from the cache which does not fit the file
+	// after all
+	if (_seekIndex && (_seekIndex->movieListStart != _movieListStart || _seekIndex->movieListEnd != _movieListEnd)) {
+		delete _seekIndex;
+		_seekIndex = 0;
+	}
+
+	// Look up the chunks of the streams for seeking. Without an index,
+	// the movie list is only scanned when seeking.
+	if (_seekIndex && _seekIndex->streams.empty())
+		buildStreamIndexes();
+
 	return true;
 }
 
@@ -395,7 +412,14 @@ void AVIDecoder::close() {
 	_movieListStart = 0;
 	_movieListEnd = 0;
 
-	_indexEntries.clear();
+	// Keep the index in case the file is opened again
+	if (_seekIndex && !_seekIndexKey.empty())
+		FrameIndexMan.store(_seekIndexKey, _seekIndex);
+	else
+		delete _seekIndex;
+
+	_seekIndex = 0;
+	_seekIndexKey.clear();
 	memset(&_header, 0, sizeof(_header));
 
 	_videoTracks.clear();
@@ -552,60 +576,56 @@ bool AVIDecoder::seekIntern(const Audio::Timestamp &time) {
 		return true;
 	}
 
-	// Get the frame we should be on at this time
-	uint frame = videoTrack->getFrameAtTime(time);
+	// Without an index, find the chunks in the movie list
+	if (!_seekIndex) {
+		scanMovieList();
+		buildStreamIndexes();
+	}
 
-	// Reset any palette, if necessary
-	videoTrack->useInitialPalette();
+	if (videoIndex >= _seekIndex->streams.size())
+		return false;
 
-	int lastKeyFrame = -1;
-	int frameIndex = -1;
-	uint curFrame = 0;
+	const Common::Array<OldIndex> &entries = _seekIndex->entries;
+	const StreamIndex &videoStream = _seekIndex->streams[videoIndex];
 
-	// Go through and figure out where we should be
-	// If there's a palette, we need to find the palette too
-	for (uint32 i = 0; i < _indexEntries.size(); i++) {
-		const OldIndex &index = _indexEntries[i];
+	// Get the frame we should be on at this time
+	uint frame = videoTrack->getFrameAtTime(time);
 
-		// We don't care about RECs
-		if (index.id == ID_REC)
-			continue;
+	if (frame >= videoStream.chunks.size()) // This shouldn't happen.
+		return false;
 
-		// We're only looking at entries for this track
-		if (getStreamIndex(index.id) != videoIndex)
-			continue;
+	// Reset any palette, if necessary
+	videoTrack->useInitialPalette();
 
-		uint16 streamType = getStreamType(index.id);
+	// We need to handle any palette change up to the frame since there's
+	// no flag to tell if this is a "key" palette.
+	for (uint32 i = 0; i < videoStream.paletteChanges.size() && videoStream.paletteChanges[i].frame <= frame; i++) {
+		const OldIndex &index = entries[videoStream.paletteChanges[i].entry];
 
-		if (streamType == kStreamTypePaletteChange) {
-			// We need to handle any palette change we see since there's no
-			// flag to tell if this is a "key" palette.
-			// Decode the palette
-			_fileStream->seek(_indexEntries[i].offset + 8);
-			Common::SeekableReadStream *chunk = 0;
+		// Decode the palette
+		_fileStream->seek(index.offset + 8);
+		Common::SeekableReadStream *chunk = 0;
 
-			if (_indexEntries[i].size != 0)
-				chunk = _fileStream->readStream(_indexEntries[i].size);
+		if (index.size != 0)
+			chunk = _fileStream->readStream(index.size);
 
-			videoTrack->loadPaletteFromChunk(chunk);
-		} else {
-			// Check to see if this is a keyframe
-			// The first frame has to be a keyframe
-			if ((_indexEntries[i].flags & AVIIF_INDEX) || curFrame == 0)
-				lastKeyFrame = i;
+		videoTrack->loadPaletteFromChunk(chunk);
+	}
 
-			// Did we find the target frame?
-			if (frame == curFrame) {
-				frameIndex = i;
-				break;
-			}
+	// Find the last keyframe up to the frame. The first frame is always a
+	// keyframe.
+	const Common::Array<uint32> &keyFrames = videoStream.keyFrames;
+	uint32 low = 0, high = keyFrames.size();
+	while (high - low > 1) {
+		uint32 mid = (low + high) / 2;
 
-			curFrame++;
-		}
+		if (keyFrames[mid] <= frame)
+			low = mid;
+		else
+			high = mid;
 	}
 
-	if (frameIndex < 0) // This shouldn't happen.
-		return false;
+	uint32 lastKeyFrame = keyFrames[low];
 
 	// Update all the audio tracks
 	for (uint32 i = 0; i < _audioTracks.size(); i++) {
@@ -617,25 +637,15 @@ bool AVIDecoder::seekIntern(const Audio::Timestamp &time) {
 		// Set the chunk index for the track
 		audioTrack->setCurChunk(frame);
 
-		uint32 chunksFound = 0;
-		for (uint32 j = 0; j < _indexEntries.size(); j++) {
-			const OldIndex &index = _indexEntries[j];
-
-			// Continue ignoring RECs
-			if (index.id == ID_REC)
-				continue;
-
-			if (getStreamIndex(index.id) == _audioTracks[i].index) {
-				if (chunksFound == frame) {
-					_fileStream->seek(index.offset + 8);
-					Common::SeekableReadStream *audioChunk = _fileStream->readStream(index.size);
-					audioTrack->queueSound(audioChunk);
-					_audioTracks[i].chunkSearchOffset = (j == _indexEntries.size() - 1) ? _movieListEnd : _indexEntries[j + 1].offset;
-					break;
-				}
+		uint32 audioIndex = _audioTracks[i].index;
+		if (audioIndex < _seekIndex->streams.size() && frame < _seekIndex->streams[audioIndex].chunks.size()) {
+			uint32 j = _seekIndex->streams[audioIndex].chunks[frame];
+			const OldIndex &index = entries[j];
 
-				chunksFound++;
-			}
+			_fileStream->seek(index.offset + 8);
+			Common::SeekableReadStream *audioChunk = _fileStream->readStream(index.size);
+			audioTrack->queueSound(audioChunk);
+			_audioTracks[i].chunkSearchOffset = (j == entries.size() - 1) ? _movieListEnd : entries[j + 1].offset;
 		}
 
 		// Skip any audio to bring us to the right time
@@ -643,25 +653,15 @@ bool AVIDecoder::seekIntern(const Audio::Timestamp &time) {
 	}
 
 	// Decode from keyFrame to curFrame - 1
-	for (int i = lastKeyFrame; i < frameIndex; i++) {
-		if (_indexEntries[i].id == ID_REC)
-			continue;
-
-		if (getStreamIndex(_indexEntries[i].id) != videoIndex)
-			continue;
-
-		uint16 streamType = getStreamType(_indexEntries[i].id);
-
-		// Ignore palettes, they were already handled
-		if (streamType == kStreamTypePaletteChange)
-			continue;
+	for (uint32 i = lastKeyFrame; i < frame; i++) {
+		const OldIndex &index = entries[videoStream.chunks[i]];
 
 		// Frame, hopefully
-		_fileStream->seek(_indexEntries[i].offset + 8);
+		_fileStream->seek(index.offset + 8);
 		Common::SeekableReadStream *chunk = 0;
 
-		if (_indexEntries[i].size != 0)
-			chunk = _fileStream->readStream(_indexEntries[i].size);
+		if (index.size != 0)
+			chunk = _fileStream->readStream(index.size);
 
 		videoTrack->decodeFrame(chunk);
 	}
@@ -670,7 +670,7 @@ bool AVIDecoder::seekIntern(const Audio::Timestamp &time) {
 	videoTrack->setCurFrame((int)frame - 1);
 
 	// Set the video track's search offset to the right spot
-	_videoTracks[0].chunkSearchOffset = _indexEntries[frameIndex].offset;
+	_videoTracks[0].chunkSearchOffset = entries[videoStream.chunks[frame]].offset;
 	return true;
 }
 
@@ -689,6 +689,21 @@ void AVIDecoder::readOldIndex(uint32 size) {
 	if (entryCount == 0)
 		return;
 
+	// Keep an index taken from the cache, unless it does not fit the file
+	// after all
+	if (_seekIndex) {
+		if (_seekIndex->movieListStart == _movieListStart && _seekIndex->movieListEnd == _movieListEnd) {
+			skipChunk(size);
+			return;
+		}
+
+		delete _seekIndex;
+	}
+
+	_seekIndex = new SeekIndex();
+	_seekIndex->movieListStart = _movieListStart;
+	_seekIndex->movieListEnd = _movieListEnd;
+
 	// Read the first index separately
 	OldIndex firstEntry;
 	firstEntry.id = _fileStream->readUint32BE();
@@ -706,7 +721,7 @@ void AVIDecoder::readOldIndex(uint32 size) {
 		firstEntry.offset += _movieListStart - 4;
 
 	debug(7, "Index 0: Tag '%s', Offset = %d, Size = %d (Flags = %d)", tag2str(firstEntry.id), firstEntry.offset, firstEntry.size, firstEntry.flags);
-	_indexEntries.push_back(firstEntry);
+	_seekIndex->entries.push_back(firstEntry);
 
 	for (uint32 i = 1; i < entryCount; i++) {
 		OldIndex indexEntry;
@@ -719,11 +734,74 @@ void AVIDecoder::readOldIndex(uint32 size) {
 		if (!isAbsolute)
 			indexEntry.offset += _movieListStart - 4;
 
-		_indexEntries.push_back(indexEntry);
+		_seekIndex->entries.push_back(indexEntry);
 		debug(7, "Index %d: Tag '%s', Offset = %d, Size = %d (Flags = %d)", i, tag2str(indexEntry.id), indexEntry.offset, indexEntry.size, indexEntry.flags);
 	}
 }
 
+void AVIDecoder::scanMovieList() {
+	_seekIndex = new SeekIndex();
+	_seekIndex->movieListStart = _movieListStart;
+	_seekIndex->movieListEnd = _movieListEnd;
+
+	// Go through the chunks like handleNextPacket() does
+	uint32 pos = _movieListStart;
+	while (pos + 8 < _movieListEnd) {
+		_fileStream->seek(pos);
+
+		OldIndex entry;
+		entry.id = _fileStream->readUint32BE();
+		entry.flags = 0;
+		entry.offset = pos;
+		entry.size = _fileStream->readUint32LE();
+
+		if (_fileStream->eos())
+			break;
+
+		if (entry.id == ID_LIST) {
+			// A list of audio/video chunks, skip just the list type
+			pos += 12;
+			continue;
+		}
+
+		pos += 8 + entry.size + (entry.size & 1);
+
+		if (entry.id != ID_JUNK && entry.id != ID_IDX1)
+			_seekIndex->entries.push_back(entry);
+	}
+
+	debug(6, "Scanned the movie list: %d entries", _seekIndex->entries.size());
+}
+
+void AVIDecoder::buildStreamIndexes() {
+	const Common::Array<OldIndex> &entries = _seekIndex->entries;
+
+	for (uint32 i = 0; i < entries.size(); i++) {
+		// We don't care about RECs
+		if (entries[i].id == ID_REC)
+			continue;
+
+		byte streamIndex = getStreamIndex(entries[i].id);
+		if (streamIndex >= _seekIndex->streams.size())
+			_seekIndex->streams.resize(streamIndex + 1);
+
+		StreamIndex &stream = _seekIndex->streams[streamIndex];
+
+		if (getStreamType(entries[i].id) == kStreamTypePaletteChange) {
+			PaletteChange change;
+			change.entry = i;
+			change.frame = stream.chunks.size();
+			stream.paletteChanges.push_back(change);
+		} else {
+			// The first frame has to be a keyframe
+			if ((entries[i].flags & AVIIF_INDEX) || stream.chunks.empty())
+				stream.keyFrames.push_back(stream.chunks.size());
+
+			stream.chunks.push_back(i);
+		}
+	}
+}
+
 void AVIDecoder::checkTruemotion1() {
 	// If we got here from loadStream(), we know the track is valid
 	assert(!_videoTracks.empty());
@@ -28,6 +28,7 @@
 #include "common/rect.h"
 #include "common/str.h"
 
+#include "video/frame_index_cache.h"
 #include "video/video_decoder.h"
 #include "audio/mixer.h"
 
@@ -274,8 +275,42 @@ protected:
 
 	AVIHeader _header;
 
+	struct PaletteChange {
+		uint32 entry; // The index entry of the palette change
+		uint32 frame; // The number of frames before it
+	};
+
+	struct StreamIndex {
+		/** The index entries of the frames or audio chunks */
+		Common::Array<uint32> chunks;
+
+		/** The frames which do not need any earlier frame to be decoded */
+		Common::Array<uint32> keyFrames;
+
+		/** The palette changes in a video stream */
+		Common::Array<PaletteChange> paletteChanges;
+	};
+
+	/**
+	 * The index of the movie list, with the chunks of each stream looked
+	 * up for seeking.
+	 */
+	struct SeekIndex : public FrameIndex {
+		/** Where the movie list was, to tell the file from others */
+		uint32 movieListStart, movieListEnd;
+
+		/** The index entries, from the file or found by scanning the movie list */
+		Common::Array<OldIndex> entries;
+
+		/** The streams, by their number in the chunk tags */
+		Common::Array<StreamIndex> streams;
+	};
+
 	void readOldIndex(uint32 size);
-	Common::Array<OldIndex> _indexEntries;
+	void scanMovieList();
+	void buildStreamIndexes();
+	SeekIndex *_seekIndex;
+	Common::String _seekIndexKey;
 
 	Common::SeekableReadStream *_fileStream;
 	bool _decodedHeader;
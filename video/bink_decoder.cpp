@@ -63,6 +63,7 @@ namespace Video {
 
 BinkDecoder::BinkDecoder() {
 	_bink = 0;
+	_threaded = false;
 }
 
 BinkDecoder::~BinkDecoder() {
@@ -104,6 +105,7 @@ bool BinkDecoder::loadStream(Common::SeekableReadStream *stream) {
 	// BIKh and BIKi swap the chroma planes
 	addTrack(new BinkVideoTrack(width, height, getDefaultHighColorFormat(), frameCount,
 			Common::Rational(frameRateNum, frameRateDen), (id == kBIKhID || id == kBIKiID), videoFlags & kVideoFlagAlpha, id));
+	((BinkVideoTrack *)getTrack(0))->setThreaded(_threaded);
 
 	uint32 audioTrackCount = _bink->readUint32LE();
 
@@ -212,6 +214,13 @@ void BinkDecoder::readNextPacket() {
 	frame.bits = 0;
 }
 
+void BinkDecoder::setThreadedDecoding(bool threaded) {
+	_threaded = threaded;
+
+	if (isVideoLoaded())
+		((BinkVideoTrack *)getTrack(0))->setThreaded(threaded);
+}
+
 VideoDecoder::AudioTrack *BinkDecoder::getAudioTrack(int index) {
 	// Bink audio track indexes are relative to the first audio track
 	Track *track = getTrack(index + 1);
@@ -243,7 +252,8 @@ BinkDecoder::AudioInfo::~AudioInfo() {
 }
 
 BinkDecoder::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, const Graphics::PixelFormat &format, uint32 frameCount, const Common::Rational &frameRate, bool swapPlanes, bool hasAlpha, uint32 id) :
-		_frameCount(frameCount), _frameRate(frameRate), _swapPlanes(swapPlanes), _hasAlpha(hasAlpha), _id(id) {
+		_frameCount(frameCount), _frameRate(frameRate), _swapPlanes(swapPlanes), _hasAlpha(hasAlpha), _id(id),
+		_threaded(false), _rowsDecoded(0), _rowsConverted(0), _stopConverting(false) {
 	_curFrame = -1;
 
 	for (int i = 0; i < 16; i++)
@@ -314,6 +324,8 @@ BinkDecoder::BinkVideoTrack::BinkVideoTrack(uint32 width, uint32 height, const G
 }
 
 BinkDecoder::BinkVideoTrack::~BinkVideoTrack() {
+	stopConvertThread();
+
 	for (int i = 0; i < 4; i++) {
 		delete[] _curPlanes[i]; _curPlanes[i] = 0;
 		delete[] _oldPlanes[i]; _oldPlanes[i] = 0;
@@ -342,10 +354,28 @@ void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
 	if (_id == kBIKiID)
 		frame.bits->skip(32);
 
+	// The planes follow each other in the bitstream without any offsets, so
+	// they have to be decoded in order. In threaded mode, the conversion runs
+	// alongside the last one instead.
+	if (_threaded && !_convertThread.isRunning()) {
+		_stopConverting = false;
+		if (!_convertThread.start(convertThreadProc, this)) {
+			warning("Could not start the Bink conversion thread, converting serially");
+			_threaded = false;
+		}
+	}
+
+	bool converting = false;
+
 	for (int i = 0; i < 3; i++) {
 		int planeIdx = ((i == 0) || !_swapPlanes) ? i : (i ^ 3);
 
-		decodePlane(frame, planeIdx, i != 0);
+		if (_threaded && i == 2) {
+			startConversion();
+			converting = true;
+		}
+
+		decodePlane(frame, planeIdx, i != 0, _threaded && i == 2);
 
 		if (frame.bits->pos() >= frame.bits->size())
 			break;
@@ -356,8 +386,13 @@ void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
 	// The width used here is the surface-width, and not the video-width
 	// to allow for odd-sized videos.
 	assert(_curPlanes[0] && _curPlanes[1] && _curPlanes[2]);
-	YUVToRGBMan.convert420(&_surface, Graphics::YUVToRGBManager::kScaleITU, _curPlanes[0], _curPlanes[1], _curPlanes[2],
-			_surfaceWidth, _surfaceHeight, _surfaceWidth, _surfaceWidth >> 1);
+	if (_threaded) {
+		// If decoding stopped before the last plane, nothing was converted yet
+		if (!converting)
+			startConversion();
+		finishConversion();
+	} else
+		convertBand(_curPlanes, 0, _surfaceHeight);
 
 	// And swap the planes with the reference planes
 	for (int i = 0; i < 4; i++)
@@ -366,7 +401,88 @@ void BinkDecoder::BinkVideoTrack::decodePacket(VideoFrame &frame) {
 	_curFrame++;
 }
 
-void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, bool isChroma) {
+void BinkDecoder::BinkVideoTrack::setThreaded(bool threaded) {
+	if (!threaded)
+		stopConvertThread();
+
+	_threaded = threaded;
+}
+
+void BinkDecoder::BinkVideoTrack::startConversion() {
+	Common::NativeStackLock lock(_convertMutex);
+
+	for (int i = 0; i < 3; i++)
+		_convertPlanes[i] = _curPlanes[i];
+
+	_rowsDecoded = 0;
+	_rowsConverted = 0;
+}
+
+void BinkDecoder::BinkVideoTrack::setRowsDecoded(uint32 rows) {
+	Common::NativeStackLock lock(_convertMutex);
+
+	if (rows > _rowsDecoded) {
+		_rowsDecoded = rows;
+		_decodedCond.signal();
+	}
+}
+
+void BinkDecoder::BinkVideoTrack::finishConversion() {
+	setRowsDecoded(_surfaceHeight);
+
+	Common::NativeStackLock lock(_convertMutex);
+	while (_rowsConverted < (uint32)_surfaceHeight)
+		_convertedCond.wait(_convertMutex);
+}
+
+void BinkDecoder::BinkVideoTrack::stopConvertThread() {
+	if (!_convertThread.isRunning())
+		return;
+
+	_convertMutex.lock();
+	_stopConverting = true;
+	_decodedCond.signal();
+	_convertMutex.unlock();
+
+	_convertThread.join();
+}
+
+void BinkDecoder::BinkVideoTrack::convertThreadProc(void *data) {
+	((BinkVideoTrack *)data)->convertRows();
+}
+
+void BinkDecoder::BinkVideoTrack::convertRows() {
+	Common::NativeStackLock lock(_convertMutex);
+	while (!_stopConverting) {
+		if (_rowsConverted >= _rowsDecoded) {
+			_decodedCond.wait(_convertMutex);
+			continue;
+		}
+
+		// The decoder does not touch the rows it reported as final anymore,
+		// so they can be converted unlocked
+		const uint32 start = _rowsConverted;
+		const uint32 end = _rowsDecoded;
+		_convertMutex.unlock();
+		convertBand(_convertPlanes, start, end);
+		_convertMutex.lock();
+
+		_rowsConverted = end;
+		_convertedCond.signal();
+	}
+}
+
+void BinkDecoder::BinkVideoTrack::convertBand(const byte * const *planes, uint32 start, uint32 end) {
+	Graphics::Surface band;
+	band.init(_surfaceWidth, end - start, _surface.pitch, _surface.getBasePtr(0, start), _surface.format);
+
+	const uint32 uvPitch = _surfaceWidth >> 1;
+	YUVToRGBMan.convert420(&band, Graphics::YUVToRGBManager::kScaleITU, planes[0] + start * _surfaceWidth,
+			planes[1] + (start >> 1) * uvPitch, planes[2] + (start >> 1) * uvPitch,
+			_surfaceWidth, end - start, _surfaceWidth, uvPitch);
+}
+
+void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, bool isChroma, bool reportRows) {
 	uint32 blockWidth  = isChroma ? ((_surface.w  + 15) >> 4) : ((_surface.w  + 7) >> 3);
 	uint32 blockHeight = isChroma ? ((_surface.h + 15) >> 4) : ((_surface.h + 7) >> 3);
 	uint32 width       = isChroma ?  (_surface.w        >> 1) :   _surface.w;
@@ -459,6 +575,12 @@ void BinkDecoder::BinkVideoTrack::decodePlane(VideoFrame &video, int planeIdx, b
 
 		}
 
+		if (reportRows) {
+			// A 16x16 block starting on an even row also covers the odd one
+			// below, so an even row is only final once the next one is done
+			const uint32 finalRows = (ctx.blockY & 1) ? ctx.blockY + 1 : ctx.blockY;
+			setRowsDecoded(MIN<uint32>(finalRows * (isChroma ? 16 : 8), _surfaceHeight));
+		}
 	}
 
 	if (video.bits->pos() & 0x1F) // next plane data starts at 32-bit boundary
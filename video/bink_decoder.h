@@ -33,6 +33,7 @@
 
 #include "common/array.h"
 #include "common/rational.h"
+#include "common/threadpool.h"
 
 #include "video/video_decoder.h"
 
@@ -72,6 +73,13 @@ public:
 	bool loadStream(Common::SeekableReadStream *stream);
 	void close();
 
+	/**
+	 * Convert the decoded frames to RGB on a worker thread, while the last
+	 * plane is still being decoded. Off by default; the output is the same
+	 * either way.
+	 */
+	void setThreadedDecoding(bool threaded);
+
 protected:
 	void readNextPacket();
 	bool supportsAudioTrackSwitching() const { return true; }
@@ -154,6 +162,9 @@ private:
 		/** Decode a video packet. */
 		void decodePacket(VideoFrame &frame);
 
+		/** Overlap the color conversion with the decoding of the last plane. */
+		void setThreaded(bool threaded);
+
 	protected:
 		Common::Rational getFrameRate() const { return _frameRate; }
 
@@ -257,6 +268,29 @@ private:
 		byte *_curPlanes[4]; ///< The 4 color planes, YUVA, current frame.
 		byte *_oldPlanes[4]; ///< The 4 color planes, YUVA, last frame.
 
+		// Threaded mode: a worker thread converts the rows of the current frame
+		// as soon as the decoding of the last plane is done with them. All but
+		// the pixels is guarded by _convertMutex.
+		bool _threaded;
+		Common::NativeThread _convertThread;
+		Common::NativeMutex _convertMutex;
+		Common::NativeCondition _decodedCond;   ///< Signalled when more rows are decoded
+		Common::NativeCondition _convertedCond; ///< Signalled when more rows are converted
+		const byte *_convertPlanes[3];
+		uint32 _rowsDecoded;   ///< Surface rows that are final in the planes
+		uint32 _rowsConverted; ///< Surface rows already converted
+		bool _stopConverting;
+
+		void startConversion();
+		void setRowsDecoded(uint32 rows);
+		void finishConversion();
+		void stopConvertThread();
+		static void convertThreadProc(void *data);
+		void convertRows();
+
+		/** Convert the given surface rows from the planes. */
+		void convertBand(const byte * const *planes, uint32 start, uint32 end);
+
 		/** Initialize the bundles. */
 		void initBundles();
 		/** Deinitialize the bundles. */
@@ -265,8 +299,12 @@ private:
 		/** Initialize the Huffman decoders. */
 		void initHuffman();
 
-		/** Decode a plane. */
-		void decodePlane(VideoFrame &video, int planeIdx, bool isChroma);
+		/**
+		 * Decode a plane.
+		 *
+		 * @param reportRows Tell the conversion thread about the rows done
+		 */
+		void decodePlane(VideoFrame &video, int planeIdx, bool isChroma, bool reportRows = false);
 
 		/** Read/Initialize a bundle for decoding a plane. */
 		void readBundle(VideoFrame &video, Source source);
@@ -349,6 +387,8 @@ private:
 
 	Common::SeekableReadStream *_bink;
 
+	bool _threaded;
+
 	Common::Array<AudioInfo> _audioTracks; ///< All audio tracks.
 	Common::Array<VideoFrame> _frames;      ///< All video frames.
 
@@ -570,6 +570,10 @@ public:
 
 	void setSurfaceMemory(void *mem, uint16 width, uint16 height, uint8 bpp);
 
+protected:
+	// The frames may be decoded straight into the surface memory
+	bool supportsDecodeAhead() const { return false; }
+
 private:
 	class VMDVideoTrack : public FixedRateVideoTrack {
 	public:
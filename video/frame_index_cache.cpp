@@ -0,0 +1,102 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#include "video/frame_index_cache.h"
+
+#include "common/md5.h"
+#include "common/stream.h"
+#include "common/util.h"
+
+namespace Common {
+DECLARE_SINGLETON(Video::FrameIndexCache);
+}
+
+namespace Video {
+
+FrameIndexCache::~FrameIndexCache() {
+	clear();
+}
+
+Common::String FrameIndexCache::makeKey(const char *format, const Common::String &fileName, Common::SeekableReadStream &stream) {
+	const int32 pos = stream.pos();
+	const int32 size = stream.size();
+	if (pos < 0 || size < 0)
+		return Common::String();
+
+	stream.seek(0);
+	const Common::String head = Common::computeStreamMD5AsString(stream, kFingerprintSize);
+
+	// The end of the file, unless the start already covered all of it
+	Common::String tail;
+	if ((uint32)size > kFingerprintSize) {
+		stream.seek(MAX<int32>(kFingerprintSize, size - kFingerprintSize));
+		tail = Common::computeStreamMD5AsString(stream, kFingerprintSize);
+	}
+
+	const bool failed = stream.err();
+	stream.seek(pos);
+	if (failed)
+		return Common::String();
+
+	// Engines do not always agree on the case of file names
+	Common::String name(fileName);
+	name.toLowercase();
+
+	return Common::String::format("%s:%d:%s:%s:%s", format, size, head.c_str(), tail.c_str(), name.c_str());
+}
+
+void FrameIndexCache::store(const Common::String &key, FrameIndex *index) {
+	assert(!key.empty() && index);
+
+	delete take(key);
+
+	Entry entry;
+	entry.key = key;
+	entry.index = index;
+	_entries.push_front(entry);
+
+	if (_entries.size() > kMaxEntries) {
+		delete _entries.back().index;
+		_entries.pop_back();
+	}
+}
+
+FrameIndex *FrameIndexCache::take(const Common::String &key) {
+	for (EntryList::iterator it = _entries.begin(); it != _entries.end(); it++) {
+		if (it->key == key) {
+			FrameIndex *index = it->index;
+			_entries.erase(it);
+			return index;
+		}
+	}
+
+	return 0;
+}
+
+void FrameIndexCache::clear() {
+	for (EntryList::iterator it = _entries.begin(); it != _entries.end(); it++)
+		delete it->index;
+
+	_entries.clear();
+}
+
+} // End of namespace Video
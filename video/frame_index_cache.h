@@ -0,0 +1,117 @@
+/* ScummVM - Graphic Adventure Engine
+ *
+ * ScummVM is the legal property of its developers, whose names
+ * are too numerous to list here. Please refer to the COPYRIGHT
+ * file distributed with this source distribution.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ */
+
+#ifndef VIDEO_FRAME_INDEX_CACHE_H
+#define VIDEO_FRAME_INDEX_CACHE_H
+
+#include "common/list.h"
+#include "common/singleton.h"
+#include "common/str.h"
+
+namespace Common {
+class SeekableReadStream;
+}
+
+namespace Video {
+
+/**
+ * What a decoder found out about the layout of a video file in order to
+ * seek in it, and which was expensive to find out.
+ */
+class FrameIndex {
+public:
+	virtual ~FrameIndex() {}
+};
+
+/**
+ * Keeps the frame indexes of recently closed videos, so that opening the
+ * same file again does not have to build its index again. The decoder owns
+ * the index while the video is open and stores it back when closing it.
+ * Only to be used from the main thread.
+ */
+class FrameIndexCache : public Common::Singleton<FrameIndexCache> {
+public:
+	~FrameIndexCache();
+
+	/**
+	 * Create the key of a file for store() and take().
+	 *
+	 * Besides the size, the key holds the MD5 sums of the start and the end
+	 * of the file, so that a file changed in place or another file with the
+	 * same name is not mistaken for the one indexed. Both are where video
+	 * formats keep their headers and indexes, and reading them is cheap
+	 * compared to hashing the whole file.
+	 *
+	 * @param format   the video format, as the same file may be read by
+	 *                 different decoders
+	 * @param fileName the name of the file, or empty if it is not known
+	 * @param stream   the file, whose position is kept
+	 * @return the key, or an empty string if the stream cannot be read
+	 */
+	static Common::String makeKey(const char *format, const Common::String &fileName, Common::SeekableReadStream &stream);
+
+	/**
+	 * Keep the index of a file. This replaces any index kept for the key,
+	 * and may throw away the indexes of the files used least recently.
+	 * @param key   the key of the file, from makeKey()
+	 * @param index the index, which the cache owns afterwards
+	 */
+	void store(const Common::String &key, FrameIndex *index);
+
+	/**
+	 * Take the index of a file out of the cache.
+	 * @param key the key of the file, from makeKey()
+	 * @return the index, which the caller owns afterwards, or 0 if none
+	 *         is kept for the file
+	 */
+	FrameIndex *take(const Common::String &key);
+
+	/** Throw away all indexes. */
+	void clear();
+
+private:
+	friend class Common::Singleton<SingletonBaseType>;
+	FrameIndexCache() {}
+
+	struct Entry {
+		Common::String key;
+		FrameIndex *index;
+	};
+
+	typedef Common::List<Entry> EntryList;
+
+	/** The indexes, most recently stored first */
+	EntryList _entries;
+
+	/** How many indexes are kept at most */
+	static const uint kMaxEntries = 32;
+
+	/** How many bytes at the start and the end of a file are hashed */
+	static const uint32 kFingerprintSize = 4096;
+};
+
+} // End of namespace Video
+
+/** Shortcut for accessing the frame index cache. */
+#define FrameIndexMan Video::FrameIndexCache::instance()
+
+#endif
@@ -5,6 +5,7 @@ MODULE_OBJS := \
 	coktel_decoder.o \
 	dxa_decoder.o \
 	flic_decoder.o \
+	frame_index_cache.o \
 	mpegps_decoder.o \
 	psx_decoder.o \
 	qt_decoder.o \
@@ -72,6 +72,10 @@ public:
 	Audio::Timestamp getDuration() const { return Audio::Timestamp(0, _duration, _timeScale); }
 
 protected:
+	// The tracks read their samples themselves, and the audio is buffered
+	// from the same stream in decodeNextFrame()
+	bool supportsDecodeAhead() const { return false; }
+
 	Common::QuickTimeParser::SampleDesc *readSampleDesc(Common::QuickTimeParser::Track *track, uint32 format, uint32 descSize);
 
 private:
@@ -164,6 +168,11 @@ private:
 		Graphics::Surface *_ditherFrame;
 		const Graphics::Surface *forceDither(const Graphics::Surface &frame);
 
+		// Where each sample is in the file, and its sample description
+		Common::Array<uint32> _sampleOffsets;
+		Common::Array<uint32> _sampleDescIds;
+		void buildSampleIndex();
+
 		Common::SeekableReadStream *getNextFramePacket(uint32 &descId);
 		uint32 getFrameDuration();
 		uint32 findKeyFrame(uint32 frame) const;
@@ -282,6 +282,7 @@ SmackerDecoder::SmackerDecoder(Audio::Mixer::SoundType soundType) : _soundType(s
 	_firstFrameStart = 0;
 	_frameTypes = 0;
 	_frameSizes = 0;
+	_seekIndex = 0;
 }
 
 SmackerDecoder::~SmackerDecoder() {
@@ -391,6 +392,27 @@ bool SmackerDecoder::loadStream(Common::SeekableReadStream *stream) {
 
 	_firstFrameStart = _fileStream->pos();
 
+	_frameOffsets.resize(frameCount + 1);
+	_frameOffsets[0] = _firstFrameStart;
+	for (i = 0; i < frameCount; ++i)
+		_frameOffsets[i + 1] = _frameOffsets[i] + (_frameSizes[i] & ~3);
+
+	// Take what is known about the file, in case it was opened before
+	_seekIndexKey = FrameIndexMan.makeKey("smk", getLoadingFileName(), *_fileStream);
+	if (!_seekIndexKey.empty())
+		_seekIndex = (SeekIndex *)FrameIndexMan.take(_seekIndexKey);
+
+	if (_seekIndex && (_seekIndex->frameCount != frameCount || _seekIndex->firstFrameStart != _firstFrameStart)) {
+		delete _seekIndex;
+		_seekIndex = 0;
+	}
+
+	if (!_seekIndex) {
+		_seekIndex = new SeekIndex();
+		_seekIndex->frameCount = frameCount;
+		_seekIndex->firstFrameStart = _firstFrameStart;
+	}
+
 	return true;
 }
 
@@ -405,6 +427,17 @@ void SmackerDecoder::close() {
 
 	delete[] _frameSizes;
 	_frameSizes = 0;
+
+	_frameOffsets.clear();
+
+	// Keep the keyframes found in case the file is opened again
+	if (_seekIndex && !_seekIndexKey.empty())
+		FrameIndexMan.store(_seekIndexKey, _seekIndex);
+	else
+		delete _seekIndex;
+
+	_seekIndex = 0;
+	_seekIndexKey.clear();
 }
 
 bool SmackerDecoder::rewind() {
@@ -417,6 +450,90 @@ bool SmackerDecoder::rewind() {
 	return true;
 }
 
+bool SmackerDecoder::seekIntern(const Audio::Timestamp &time) {
+	// Can't seek beyond the end
+	if (time > getDuration())
+		return false;
+
+	SmackerVideoTrack *videoTrack = (SmackerVideoTrack *)getTrack(0);
+	uint32 frameCount = videoTrack->getFrameCount();
+	uint32 frame = videoTrack->getFrameAtTime(time);
+
+	resetAudio();
+
+	// If we seek directly to the end, just mark the video as over
+	if (frame >= frameCount) {
+		videoTrack->setCurFrame(frameCount - 1);
+		_fileStream->seek(_frameOffsets[frameCount]);
+		return true;
+	}
+
+	// Decode from the last keyframe up to the frame, or go on from the
+	// current frame if that is closer
+	int curFrame = videoTrack->getCurFrame();
+	const SeekIndex::KeyFrame *keyFrame = findKeyFrame(frame);
+	uint32 startFrame;
+
+	if (curFrame >= 0 && (uint32)curFrame < frame && (!keyFrame || (uint32)curFrame >= keyFrame->frame)) {
+		startFrame = curFrame + 1;
+	} else if (keyFrame) {
+		startFrame = keyFrame->frame;
+		videoTrack->setPalette(_seekIndex->palettes[keyFrame->palette].colors);
+	} else {
+		startFrame = 0;
+		videoTrack->clearFrame();
+	}
+
+	// The audio of a frame may be played long after the frame itself, so
+	// find the first chunk of each track that is still to be heard
+	uint32 firstFrame = startFrame;
+	uint32 audioStart[7];
+
+	for (uint i = 0; i < 7; ++i) {
+		audioStart[i] = frame;
+
+		if (!_header.audioInfo[i].hasAudio)
+			continue;
+
+		if (_seekIndex->audioOffsets[i].empty())
+			buildAudioOffsets();
+
+		const Common::Array<uint32> &offsets = _seekIndex->audioOffsets[i];
+		SmackerAudioTrack *audioTrack = (SmackerAudioTrack *)getTrack(i + 1);
+		uint32 position = audioTrack->getBytesAtTime(time);
+
+		// Find the last frame up to the frame whose audio starts before the time
+		uint32 low = 0, high = frame + 1;
+		while (high - low > 1) {
+			uint32 mid = (low + high) / 2;
+
+			if (offsets[mid] <= position)
+				low = mid;
+			else
+				high = mid;
+		}
+
+		audioStart[i] = low;
+		audioTrack->skipBytes(position - offsets[low]);
+		firstFrame = MIN(firstFrame, low);
+	}
+
+	_fileStream->seek(_frameOffsets[firstFrame]);
+
+	for (uint32 i = firstFrame; i < frame; i++) {
+		byte audioTracks = 0;
+		for (uint j = 0; j < 7; ++j)
+			if (audioStart[j] <= i)
+				audioTracks |= 1 << j;
+
+		readFrame(i, i >= startFrame, audioTracks);
+	}
+
+	videoTrack->setCurFrame((int)frame - 1);
+	_fileStream->seek(_frameOffsets[frame]);
+	return true;
+}
+
 void SmackerDecoder::readNextPacket() {
 	SmackerVideoTrack *videoTrack = (SmackerVideoTrack *)getTrack(0);
 
@@ -424,6 +541,11 @@ void SmackerDecoder::readNextPacket() {
 		return;
 
 	videoTrack->increaseCurFrame();
+	readFrame(videoTrack->getCurFrame(), true, 0x7F);
+}
+
+void SmackerDecoder::readFrame(uint32 frame, bool decodeVideo, byte audioTracks) {
+	SmackerVideoTrack *videoTrack = (SmackerVideoTrack *)getTrack(0);
 
 	uint i;
 	uint32 chunkSize = 0;
@@ -431,15 +553,26 @@ void SmackerDecoder::readNextPacket() {
 
 	uint32 startPos = _fileStream->pos();
 
+	// Keep the palette the frame starts with, in case it turns out to be
+	// a keyframe
+	byte palette[3 * 256];
+	memcpy(palette, videoTrack->getCurPalette(), 3 * 256);
+
 	// Check if we got a frame with palette data, and
 	// call back the virtual setPalette function to set
 	// the current palette
-	if (_frameTypes[videoTrack->getCurFrame()] & 1)
-		videoTrack->unpackPalette(_fileStream);
+	if (_frameTypes[frame] & 1) {
+		if (decodeVideo) {
+			videoTrack->unpackPalette(_fileStream);
+		} else {
+			uint32 paletteStart = _fileStream->pos();
+			_fileStream->seek(paletteStart + 4 * _fileStream->readByte());
+		}
+	}
 
 	// Load audio tracks
 	for (i = 0; i < 7; ++i) {
-		if (!(_frameTypes[videoTrack->getCurFrame()] & (2 << i)))
+		if (!(_frameTypes[frame] & (2 << i)))
 			continue;
 
 		chunkSize = _fileStream->readUint32LE();
@@ -452,29 +585,139 @@ void SmackerDecoder::readNextPacket() {
 			chunkSize -= 4;    // subtract the next 4 bytes (unpacked data size)
 		}
 
-		handleAudioTrack(i, chunkSize, dataSizeUnpacked);
+		// When seeking, audio before the time seeked to is not needed
+		if (!_header.audioInfo[i].hasAudio || (audioTracks & (1 << i)))
+			handleAudioTrack(i, chunkSize, dataSizeUnpacked);
+		else
+			_fileStream->skip(chunkSize);
 	}
 
-	uint32 frameSize = _frameSizes[videoTrack->getCurFrame()] & ~3;
-//	uint32 remainder =  _frameSizes[videoTrack->getCurFrame()] & 3;
+	uint32 frameSize = _frameSizes[frame] & ~3;
+//	uint32 remainder =  _frameSizes[frame] & 3;
 
 	if (_fileStream->pos() - startPos > frameSize)
 		error("Smacker actual frame size exceeds recorded frame size");
 
-	uint32 frameDataSize = frameSize - (_fileStream->pos() - startPos);
+	if (decodeVideo) {
+		uint32 frameDataSize = frameSize - (_fileStream->pos() - startPos);
 
-	byte *frameData = (byte *)malloc(frameDataSize + 1);
-	// Padding to keep the BigHuffmanTrees from reading past the data end
-	frameData[frameDataSize] = 0x00;
+		byte *frameData = (byte *)malloc(frameDataSize + 1);
+		// Padding to keep the BigHuffmanTrees from reading past the data end
+		frameData[frameDataSize] = 0x00;
 
-	_fileStream->read(frameData, frameDataSize);
+		_fileStream->read(frameData, frameDataSize);
 
-	Common::BitStream8LSB bs(new Common::MemoryReadStream(frameData, frameDataSize + 1, DisposeAfterUse::YES), DisposeAfterUse::YES);
-	videoTrack->decodeFrame(bs);
+		Common::BitStream8LSB bs(new Common::MemoryReadStream(frameData, frameDataSize + 1, DisposeAfterUse::YES), DisposeAfterUse::YES);
+		if (videoTrack->decodeFrame(bs))
+			addKeyFrame(frame, palette);
+	}
 
 	_fileStream->seek(startPos + frameSize);
 }
 
+void SmackerDecoder::addKeyFrame(uint32 frame, const byte *palette) {
+	Common::Array<SeekIndex::KeyFrame> &keyFrames = _seekIndex->keyFrames;
+	Common::Array<SeekIndex::Palette> &palettes = _seekIndex->palettes;
+
+	// Find where the keyframe goes
+	uint32 low = 0, high = keyFrames.size();
+	while (low < high) {
+		uint32 mid = (low + high) / 2;
+
+		if (keyFrames[mid].frame < frame)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	if (low < keyFrames.size() && keyFrames[low].frame == frame)
+		return;
+
+	// The palette rarely changes, so share it with the keyframes around
+	SeekIndex::KeyFrame keyFrame;
+	keyFrame.frame = frame;
+
+	if (low > 0 && !memcmp(palettes[keyFrames[low - 1].palette].colors, palette, 3 * 256)) {
+		keyFrame.palette = keyFrames[low - 1].palette;
+	} else if (low < keyFrames.size() && !memcmp(palettes[keyFrames[low].palette].colors, palette, 3 * 256)) {
+		keyFrame.palette = keyFrames[low].palette;
+	} else {
+		keyFrame.palette = palettes.size();
+		palettes.push_back(SeekIndex::Palette());
+		memcpy(palettes.back().colors, palette, 3 * 256);
+	}
+
+	keyFrames.insert_at(low, keyFrame);
+}
+
+const SmackerDecoder::SeekIndex::KeyFrame *SmackerDecoder::findKeyFrame(uint32 frame) const {
+	const Common::Array<SeekIndex::KeyFrame> &keyFrames = _seekIndex->keyFrames;
+
+	// Find the last keyframe up to the frame
+	uint32 low = 0, high = keyFrames.size();
+	while (low < high) {
+		uint32 mid = (low + high) / 2;
+
+		if (keyFrames[mid].frame <= frame)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+
+	return (low > 0) ? &keyFrames[low - 1] : 0;
+}
+
+void SmackerDecoder::buildAudioOffsets() {
+	uint32 frameCount = ((SmackerVideoTrack *)getTrack(0))->getFrameCount();
+
+	for (uint i = 0; i < 7; ++i) {
+		_seekIndex->audioOffsets[i].resize(frameCount + 1);
+		_seekIndex->audioOffsets[i][0] = 0;
+	}
+
+	// Go through the audio chunks of all frames, without reading the audio
+	for (uint32 frame = 0; frame < frameCount; frame++) {
+		_fileStream->seek(_frameOffsets[frame]);
+
+		if (_frameTypes[frame] & 1) {
+			uint32 paletteStart = _fileStream->pos();
+			_fileStream->seek(paletteStart + 4 * _fileStream->readByte());
+		}
+
+		for (uint i = 0; i < 7; ++i) {
+			uint32 dataSizeUnpacked = 0;
+
+			if (_frameTypes[frame] & (2 << i)) {
+				uint32 chunkSize = _fileStream->readUint32LE() - 4;
+
+				if (_header.audioInfo[i].compression == kCompressionNone) {
+					dataSizeUnpacked = chunkSize;
+				} else {
+					dataSizeUnpacked = _fileStream->readUint32LE();
+					chunkSize -= 4;
+				}
+
+				// Count only what handleAudioTrack() queues
+				uint32 chunkStart = _fileStream->pos();
+				if (chunkSize == 0 || _header.audioInfo[i].compression == kCompressionRDFT || _header.audioInfo[i].compression == kCompressionDCT)
+					dataSizeUnpacked = 0;
+				else if (_header.audioInfo[i].compression == kCompressionDPCM && !(_fileStream->readByte() & 1))
+					dataSizeUnpacked = 0;
+
+				_fileStream->seek(chunkStart + chunkSize);
+			}
+
+			_seekIndex->audioOffsets[i][frame + 1] = _seekIndex->audioOffsets[i][frame] + dataSizeUnpacked;
+		}
+	}
+}
+
+void SmackerDecoder::resetAudio() {
+	for (TrackListIterator it = getTrackListBegin(); it != getTrackListEnd(); it++)
+		if ((*it)->getTrackType() == Track::kTrackTypeAudio)
+			((SmackerAudioTrack *)*it)->rewind();
+}
+
 void SmackerDecoder::handleAudioTrack(byte track, uint32 chunkSize, uint32 unpackedSize) {
 	if (chunkSize == 0)
 		return;
@@ -560,7 +803,7 @@ void SmackerDecoder::SmackerVideoTrack::readTrees(Common::BitStream &bs, uint32
 	_TypeTree = new BigHuffmanTree(bs, typeSize);
 }
 
-void SmackerDecoder::SmackerVideoTrack::decodeFrame(Common::BitStream &bs) {
+bool SmackerDecoder::SmackerVideoTrack::decodeFrame(Common::BitStream &bs) {
 	_MMapTree->reset();
 	_MClrTree->reset();
 	_FullTree->reset();
@@ -580,6 +823,9 @@ void SmackerDecoder::SmackerVideoTrack::decodeFrame(Common::BitStream &bs) {
 	byte hi, lo;
 	uint i;
 
+	// Whether all blocks are drawn anew
+	bool isKeyFrame = true;
+
 	while (block < blocks) {
 		type = _TypeTree->getCode(bs);
 		run = getBlockRun((type >> 2) & 0x3f);
@@ -621,6 +867,10 @@ void SmackerDecoder::SmackerVideoTrack::decodeFrame(Common::BitStream &bs) {
 				}
 			}
 
+			// Mode 1 only draws the first four lines of doubled blocks
+			if (mode == 1 && doubleY != 1)
+				isKeyFrame = false;
+
 			while (run-- && block < blocks) {
 				out = (byte *)_surface->getPixels() + (block / bw) * (stride * 4 * doubleY) + (block % bw) * 4;
 				switch (mode) {
@@ -683,6 +933,7 @@ void SmackerDecoder::SmackerVideoTrack::decodeFrame(Common::BitStream &bs) {
 		case SMK_BLOCK_SKIP:
 			while (run-- && block < blocks)
 				block++;
+			isKeyFrame = false;
 			break;
 		case SMK_BLOCK_FILL:
 			uint32 col;
@@ -699,6 +950,19 @@ void SmackerDecoder::SmackerVideoTrack::decodeFrame(Common::BitStream &bs) {
 			break;
 		}
 	}
+
+	return isKeyFrame;
+}
+
+void SmackerDecoder::SmackerVideoTrack::setPalette(const byte *palette) {
+	memcpy(_palette, palette, 3 * 256);
+	_dirtyPalette = true;
+}
+
+void SmackerDecoder::SmackerVideoTrack::clearFrame() {
+	memset(_surface->getPixels(), 0, _surface->pitch * _surface->h);
+	memset(_palette, 0, 3 * 256);
+	_dirtyPalette = true;
 }
 
 void SmackerDecoder::SmackerVideoTrack::unpackPalette(Common::SeekableReadStream *stream) {
@@ -754,7 +1018,7 @@ void SmackerDecoder::SmackerVideoTrack::unpackPalette(Common::SeekableReadStream
 }
 
 SmackerDecoder::SmackerAudioTrack::SmackerAudioTrack(const AudioInfo &audioInfo, Audio::Mixer::SoundType soundType) :
-		_audioInfo(audioInfo), _soundType(soundType) {
+		_audioInfo(audioInfo), _soundType(soundType), _skipBytes(0) {
 	_audioStream = Audio::makeQueuingAudioStream(_audioInfo.sampleRate, _audioInfo.isStereo);
 }
 
@@ -765,6 +1029,7 @@ SmackerDecoder::SmackerAudioTrack::~SmackerAudioTrack() {
 bool SmackerDecoder::SmackerAudioTrack::rewind() {
 	delete _audioStream;
 	_audioStream = Audio::makeQueuingAudioStream(_audioInfo.sampleRate, _audioInfo.isStereo);
+	_skipBytes = 0;
 	return true;
 }
 
@@ -855,6 +1120,20 @@ void SmackerDecoder::SmackerAudioTrack::queueCompressedBuffer(byte *buffer, uint
 }
 
 void SmackerDecoder::SmackerAudioTrack::queuePCM(byte *buffer, uint32 bufferSize) {
+	// Drop the audio before the time seeked to
+	if (_skipBytes != 0) {
+		uint32 skip = MIN(_skipBytes, bufferSize);
+		_skipBytes -= skip;
+
+		if (skip == bufferSize) {
+			free(buffer);
+			return;
+		}
+
+		bufferSize -= skip;
+		memmove(buffer, buffer + skip, bufferSize);
+	}
+
 	byte flags = 0;
 	if (_audioInfo.is16Bits)
 		flags |= Audio::FLAG_16BITS;
@@ -864,6 +1143,11 @@ void SmackerDecoder::SmackerAudioTrack::queuePCM(byte *buffer, uint32 bufferSize
 	_audioStream->queueBuffer(buffer, bufferSize, DisposeAfterUse::YES, flags);
 }
 
+uint32 SmackerDecoder::SmackerAudioTrack::getBytesAtTime(const Audio::Timestamp &time) const {
+	uint32 samples = time.convertToFramerate(_audioInfo.sampleRate).totalNumberOfFrames();
+	return samples * (_audioInfo.is16Bits ? 2 : 1) * (_audioInfo.isStereo ? 2 : 1);
+}
+
 SmackerDecoder::SmackerVideoTrack *SmackerDecoder::createVideoTrack(uint32 width, uint32 height, uint32 frameCount, const Common::Rational &frameRate, uint32 flags, uint32 signature) const {
 	return new SmackerVideoTrack(width, height, frameCount, frameRate, flags, signature);
 }
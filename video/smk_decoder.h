@@ -26,6 +26,7 @@
 #include "common/rational.h"
 #include "graphics/pixelformat.h"
 #include "graphics/surface.h"
+#include "video/frame_index_cache.h"
 #include "video/video_decoder.h"
 #include "audio/mixer.h"
 
@@ -66,9 +67,11 @@ public:
 	void close();
 
 	bool rewind();
+	bool isSeekable() const { return isVideoLoaded(); }
 
 protected:
 	void readNextPacket();
+	bool seekIntern(const Audio::Timestamp &time);
 	bool supportsAudioTrackSwitching() const { return true; }
 	AudioTrack *getAudioTrack(int index);
 
@@ -93,9 +96,22 @@ protected:
 
 		void readTrees(Common::BitStream &bs, uint32 mMapSize, uint32 mClrSize, uint32 fullSize, uint32 typeSize);
 		void increaseCurFrame() { _curFrame++; }
-		void decodeFrame(Common::BitStream &bs);
+		void setCurFrame(int frame) { _curFrame = frame; }
+
+		/**
+		 * Decode a frame into the surface.
+		 * @return true if the frame did not need the previous frame
+		 */
+		bool decodeFrame(Common::BitStream &bs);
 		void unpackPalette(Common::SeekableReadStream *stream);
 
+		/** Get the palette without marking it as seen. */
+		const byte *getCurPalette() const { return _palette; }
+		void setPalette(const byte *palette);
+
+		/** Clear the surface and the palette to what they are before the first frame. */
+		void clearFrame();
+
 	protected:
 		Common::Rational getFrameRate() const { return _frameRate; }
 
@@ -169,6 +185,10 @@ private:
 		void queueCompressedBuffer(byte *buffer, uint32 bufferSize, uint32 unpackedSize);
 		void queuePCM(byte *buffer, uint32 bufferSize);
 
+		/** Drop the given number of bytes of the audio queued next, for seeking. */
+		void skipBytes(uint32 bytes) { _skipBytes = bytes; }
+		uint32 getBytesAtTime(const Audio::Timestamp &time) const;
+
 	protected:
 		Audio::AudioStream *getAudioStream() const;
 
@@ -176,8 +196,44 @@ private:
 		Audio::Mixer::SoundType _soundType;
 		Audio::QueuingAudioStream *_audioStream;
 		AudioInfo _audioInfo;
+		uint32 _skipBytes;
 	};
 
+	/**
+	 * What is needed for seeking. Smacker files do not mark any frame as
+	 * a keyframe, so the frames which turn out not to need the previous
+	 * frame are remembered as they are decoded.
+	 */
+	struct SeekIndex : public FrameIndex {
+		struct Palette {
+			byte colors[3 * 256];
+		};
+
+		struct KeyFrame {
+			uint32 frame;
+			uint32 palette; // The palette before the frame, in palettes
+		};
+
+		/** To tell the file from others with the same name and size */
+		uint32 frameCount, firstFrameStart;
+
+		/** The keyframes found so far, in ascending order */
+		Common::Array<KeyFrame> keyFrames;
+		Common::Array<Palette> palettes;
+
+		/**
+		 * For each audio track, the number of bytes of decoded audio before
+		 * each frame. Only filled in when seeking a video with audio.
+		 */
+		Common::Array<uint32> audioOffsets[7];
+	};
+
+	void readFrame(uint32 frame, bool decodeVideo, byte audioTracks);
+	void addKeyFrame(uint32 frame, const byte *palette);
+	const SeekIndex::KeyFrame *findKeyFrame(uint32 frame) const;
+	void buildAudioOffsets();
+	void resetAudio();
+
 	// The FrameTypes section of a Smacker file contains an array of bytes, where
 	// the 8 bits of each byte describe the contents of the corresponding frame.
 	// The highest 7 bits correspond to audio frames (bit 7 is track 6, bit 6 track 5
@@ -187,6 +243,12 @@ private:
 
 	uint32 _firstFrameStart;
 
+	/** Where each frame starts, and where the last one ends */
+	Common::Array<uint32> _frameOffsets;
+
+	SeekIndex *_seekIndex;
+	Common::String _seekIndexKey;
+
 	Audio::Mixer::SoundType _soundType;
 };
 
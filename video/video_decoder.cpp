@@ -30,9 +30,23 @@
 #include "common/system.h"
 
 #include "graphics/palette.h"
+#include "graphics/surface.h"
 
 namespace Video {
 
+struct VideoDecoder::DecodeAheadFrame {
+	DecodeAheadFrame() : hasSurface(false), curFrame(-1), nextFrameStartTime(0), endOfTrack(false), dirtyPalette(false) {}
+	~DecodeAheadFrame() { surface.free(); }
+
+	Graphics::Surface surface;
+	bool hasSurface;
+	int curFrame;
+	uint32 nextFrameStartTime;
+	bool endOfTrack;
+	bool dirtyPalette;
+	byte palette[256 * 3];
+};
+
 VideoDecoder::VideoDecoder() {
 	_startTime = 0;
 	_dirtyPalette = false;
@@ -49,6 +63,14 @@ VideoDecoder::VideoDecoder() {
 	_mainAudioTrack = 0;
 	_canSetDither = true;
 
+	_aheadLimit = 0;
+	_aheadTrack = 0;
+	_decodingAhead = false;
+	_aheadShown = 0;
+	_aheadEnded = false;
+	_aheadStop = false;
+	_aheadLate = 0;
+
 	// Find the best format for output
 	_defaultHighColorFormat = g_system->getScreenFormat();
 
@@ -56,7 +78,14 @@ VideoDecoder::VideoDecoder() {
 		_defaultHighColorFormat = Graphics::PixelFormat(4, 8, 8, 8, 8, 8, 16, 24, 0);
 }
 
+VideoDecoder::~VideoDecoder() {
+	freeDecodeAhead();
+}
+
 void VideoDecoder::close() {
+	// The worker has to be done with the tracks before they go away
+	freeDecodeAhead();
+
 	if (isPlaying())
 		stop();
 
@@ -89,7 +118,10 @@ bool VideoDecoder::loadFile(const Common::String &filename) {
 		return false;
 	}
 
-	return loadStream(file);
+	_loadingFileName = filename;
+	bool result = loadStream(file);
+	_loadingFileName.clear();
+	return result;
 }
 
 bool VideoDecoder::needsUpdate() const {
@@ -175,6 +207,20 @@ const Graphics::Surface *VideoDecoder::decodeNextFrame() {
 	_needsUpdate = false;
 	_canSetDither = false;
 
+	if (_aheadLimit && !_aheadThread.isRunning())
+		startDecodeAhead();
+
+	if (_decodingAhead) {
+		const Graphics::Surface *frame = showDecodedAhead();
+
+		// If the queue ran dry with the worker stopped, the track is back at
+		// the frame shown and the next one is decoded right here
+		if (_decodingAhead) {
+			findNextVideoTrack();
+			return frame;
+		}
+	}
+
 	readNextPacket();
 
 	// If we have no next video track at this point, there shouldn't be
@@ -200,6 +246,10 @@ bool VideoDecoder::setReverse(bool reverse) {
 	if (reverse && hasAudio())
 		return false;
 
+	// Decoding ahead only works forward
+	if (reverse && _aheadLimit)
+		return false;
+
 	// Attempt to make sure all the tracks are in the requested direction
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo && ((VideoTrack *)*it)->isReversed() != reverse) {
@@ -224,7 +274,7 @@ int VideoDecoder::getCurFrame() const {
 
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
 		if ((*it)->getTrackType() == Track::kTrackTypeVideo)
-			frame += ((VideoTrack *)*it)->getCurFrame() + 1;
+			frame += getShownFrame((const VideoTrack *)*it) + 1;
 
 	return frame;
 }
@@ -265,7 +315,7 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 		return 0;
 
 	uint32 currentTime = getTime();
-	uint32 nextFrameStartTime = _nextVideoTrack->getNextFrameStartTime();
+	uint32 nextFrameStartTime = getShownNextFrameStartTime(_nextVideoTrack);
 
 	if (_nextVideoTrack->isReversed()) {
 		// For reversed videos, we need to handle the time difference the opposite way.
@@ -284,7 +334,7 @@ uint32 VideoDecoder::getTimeToNextFrame() const {
 
 bool VideoDecoder::endOfVideo() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if (!(*it)->endOfTrack() && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
+		if (!trackEnded(*it) && (!isPlaying() || (*it)->getTrackType() != Track::kTrackTypeVideo || !_endTimeSet || getShownNextFrameStartTime((const VideoTrack *)*it) < (uint)_endTime.msecs()))
 			return false;
 
 	return true;
@@ -305,6 +355,9 @@ bool VideoDecoder::rewind() {
 	if (!isRewindable())
 		return false;
 
+	// Anything decoded ahead is from the old position
+	flushDecodeAhead();
+
 	// Stop all tracks so they can be rewound
 	if (isPlaying())
 		stopAudio();
@@ -339,6 +392,9 @@ bool VideoDecoder::seek(const Audio::Timestamp &time) {
 	if (!isSeekable())
 		return false;
 
+	// Anything decoded ahead is from the old position
+	flushDecodeAhead();
+
 	// Stop all tracks so they can be seeked
 	if (isPlaying())
 		stopAudio();
@@ -841,7 +897,7 @@ const VideoDecoder::Track *VideoDecoder::getTrack(uint track) const {
 
 bool VideoDecoder::endOfVideoTracks() const {
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack())
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !trackEnded(*it))
 			return false;
 
 	return true;
@@ -852,9 +908,9 @@ VideoDecoder::VideoTrack *VideoDecoder::findNextVideoTrack() {
 	uint32 bestTime = 0xFFFFFFFF;
 
 	for (TrackList::iterator it = _tracks.begin(); it != _tracks.end(); it++) {
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack()) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !trackEnded(*it)) {
 			VideoTrack *track = (VideoTrack *)*it;
-			uint32 time = track->getNextFrameStartTime();
+			uint32 time = getShownNextFrameStartTime(track);
 
 			if (time < bestTime) {
 				bestTime = time;
@@ -896,7 +952,7 @@ bool VideoDecoder::hasFramesLeft() const {
 	// This is only used for needsUpdate() atm so that setEndTime() works properly
 	// And unlike endOfVideoTracks(), this takes into account _endTime
 	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++)
-		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !(*it)->endOfTrack() && (!isPlaying() || !_endTimeSet || ((VideoTrack *)*it)->getNextFrameStartTime() < (uint)_endTime.msecs()))
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo && !trackEnded(*it) && (!isPlaying() || !_endTimeSet || getShownNextFrameStartTime((const VideoTrack *)*it) < (uint)_endTime.msecs()))
 			return true;
 
 	return false;
@@ -910,4 +966,247 @@ bool VideoDecoder::hasAudio() const {
 	return false;
 }
 
+bool VideoDecoder::setDecodeAhead(uint frames) {
+	if (frames && !supportsDecodeAhead())
+		return false;
+
+	// Frames already decoded ahead are still shown, and the worker picks
+	// up the new limit with the next decodeNextFrame() call
+	stopDecodeAheadThread();
+
+	_aheadLimit = frames;
+	_aheadLate = 0;
+	return true;
+}
+
+uint VideoDecoder::getDecodeAheadQueueDepth() const {
+	Common::NativeStackLock lock(_aheadMutex);
+	return _aheadQueue.size();
+}
+
+bool VideoDecoder::waitForDecodeAhead(uint frames, uint32 timeout) {
+	Common::NativeStackLock lock(_aheadMutex);
+
+	if (!_decodingAhead)
+		return true;
+
+	while (_aheadQueue.size() < frames && !_aheadEnded)
+		if (!_aheadReadyCond.wait(_aheadMutex, timeout))
+			return false;
+
+	return true;
+}
+
+uint VideoDecoder::getDecodeAheadLateFrames() const {
+	Common::NativeStackLock lock(_aheadMutex);
+	return _aheadLate;
+}
+
+VideoDecoder::VideoTrack *VideoDecoder::findDecodeAheadTrack() const {
+	VideoTrack *track = 0;
+
+	for (TrackList::const_iterator it = _tracks.begin(); it != _tracks.end(); it++) {
+		if ((*it)->getTrackType() == Track::kTrackTypeVideo) {
+			// Like seekToFrame(), this needs a single video track
+			if (track)
+				return 0;
+
+			track = (VideoTrack *)*it;
+		}
+	}
+
+	return track;
+}
+
+bool VideoDecoder::startDecodeAhead() {
+	if (!_decodingAhead) {
+		_aheadTrack = findDecodeAheadTrack();
+
+		if (!_aheadTrack || _aheadTrack->isReversed() || _aheadTrack->endOfTrack())
+			return false;
+
+		// Until the first frame decoded ahead is shown, the track is seen
+		// as it is now
+		if (!_aheadShown)
+			_aheadShown = new DecodeAheadFrame();
+
+		_aheadShown->curFrame = _aheadTrack->getCurFrame();
+		_aheadShown->nextFrameStartTime = _aheadTrack->getNextFrameStartTime();
+		_aheadShown->endOfTrack = false;
+		_aheadShown->dirtyPalette = false;
+	} else if (_aheadTrack->endOfTrack()) {
+		// The rest of the track is queued already
+		return false;
+	}
+
+	_aheadEnded = false;
+	_aheadStop = false;
+
+	// Without threads, everything is decoded synchronously
+	if (!_aheadThread.start(decodeAheadThreadProc, this))
+		return false;
+
+	_decodingAhead = true;
+	return true;
+}
+
+void VideoDecoder::stopDecodeAheadThread() {
+	if (!_aheadThread.isRunning())
+		return;
+
+	_aheadMutex.lock();
+	_aheadStop = true;
+	_aheadSpaceCond.signal();
+	_aheadMutex.unlock();
+
+	_aheadThread.join();
+	_aheadStop = false;
+}
+
+void VideoDecoder::flushDecodeAhead() {
+	stopDecodeAheadThread();
+
+	// The last frame shown is kept, since the caller may still use it
+	while (!_aheadQueue.empty()) {
+		_aheadFree.push_back(_aheadQueue.front());
+		_aheadQueue.pop_front();
+	}
+
+	_decodingAhead = false;
+}
+
+void VideoDecoder::freeDecodeAhead() {
+	flushDecodeAhead();
+
+	for (DecodeAheadFrameList::iterator it = _aheadFree.begin(); it != _aheadFree.end(); it++)
+		delete *it;
+
+	_aheadFree.clear();
+	delete _aheadShown;
+	_aheadShown = 0;
+	_aheadTrack = 0;
+}
+
+const Graphics::Surface *VideoDecoder::showDecodedAhead() {
+	DecodeAheadFrame *frame = 0;
+
+	_aheadMutex.lock();
+
+	if (_aheadQueue.empty() && _aheadThread.isRunning() && !_aheadEnded) {
+		_aheadLate++;
+
+		while (_aheadQueue.empty() && !_aheadEnded)
+			_aheadReadyCond.wait(_aheadMutex);
+	}
+
+	if (!_aheadQueue.empty()) {
+		frame = _aheadQueue.front();
+		_aheadQueue.pop_front();
+		_aheadFree.push_back(_aheadShown);
+		_aheadSpaceCond.signal();
+	}
+
+	_aheadMutex.unlock();
+
+	if (!frame) {
+		// The worker is done, either at the end of the track or because it
+		// was told to stop
+		stopDecodeAheadThread();
+		_decodingAhead = false;
+		return 0;
+	}
+
+	_aheadShown = frame;
+
+	if (frame->dirtyPalette) {
+		memcpy(_aheadPalette, frame->palette, sizeof(_aheadPalette));
+		_palette = _aheadPalette;
+		_dirtyPalette = true;
+	}
+
+	return frame->hasSurface ? &frame->surface : 0;
+}
+
+void VideoDecoder::decodeAheadThreadProc(void *data) {
+	((VideoDecoder *)data)->decodeAhead();
+}
+
+void VideoDecoder::decodeAhead() {
+	for (;;) {
+		DecodeAheadFrame *frame;
+
+		_aheadMutex.lock();
+
+		while (!_aheadStop && _aheadQueue.size() >= _aheadLimit)
+			_aheadSpaceCond.wait(_aheadMutex);
+
+		if (_aheadStop) {
+			_aheadMutex.unlock();
+			return;
+		}
+
+		if (_aheadFree.empty()) {
+			frame = new DecodeAheadFrame();
+		} else {
+			frame = _aheadFree.front();
+			_aheadFree.pop_front();
+		}
+
+		_aheadMutex.unlock();
+
+		// The same as the synchronous decodeNextFrame(), on the track only
+		readNextPacket();
+		const Graphics::Surface *surface = _aheadTrack->decodeNextFrame();
+
+		frame->hasSurface = surface != 0;
+
+		if (surface) {
+			// Keep the buffer of the frame if it fits
+			if (frame->surface.w != surface->w || frame->surface.h != surface->h || frame->surface.format != surface->format)
+				frame->surface.create(surface->w, surface->h, surface->format);
+
+			for (int y = 0; y < surface->h; y++)
+				memcpy(frame->surface.getBasePtr(0, y), surface->getBasePtr(0, y), surface->w * surface->format.bytesPerPixel);
+		}
+
+		frame->curFrame = _aheadTrack->getCurFrame();
+		frame->nextFrameStartTime = _aheadTrack->getNextFrameStartTime();
+		frame->endOfTrack = _aheadTrack->endOfTrack();
+		frame->dirtyPalette = _aheadTrack->hasDirtyPalette();
+
+		if (frame->dirtyPalette)
+			memcpy(frame->palette, _aheadTrack->getPalette(), sizeof(frame->palette));
+
+		_aheadMutex.lock();
+		_aheadQueue.push_back(frame);
+		_aheadEnded = frame->endOfTrack;
+		_aheadReadyCond.signal();
+		_aheadMutex.unlock();
+
+		if (frame->endOfTrack)
+			return;
+	}
+}
+
+bool VideoDecoder::trackEnded(const Track *track) const {
+	if (_decodingAhead && track == _aheadTrack)
+		return _aheadShown->endOfTrack;
+
+	return track->endOfTrack();
+}
+
+int VideoDecoder::getShownFrame(const VideoTrack *track) const {
+	if (_decodingAhead && track == _aheadTrack)
+		return _aheadShown->curFrame;
+
+	return track->getCurFrame();
+}
+
+uint32 VideoDecoder::getShownNextFrameStartTime(const VideoTrack *track) const {
+	if (_decodingAhead && track == _aheadTrack)
+		return _aheadShown->nextFrameStartTime;
+
+	return track->getNextFrameStartTime();
+}
+
 } // End of namespace Video
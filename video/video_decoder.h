@@ -26,8 +26,10 @@
 #include "audio/mixer.h"
 #include "audio/timestamp.h"	// TODO: Move this to common/ ?
 #include "common/array.h"
+#include "common/list.h"
 #include "common/rational.h"
 #include "common/str.h"
+#include "common/threadpool.h"
 #include "graphics/pixelformat.h"
 
 namespace Audio {
@@ -52,7 +54,7 @@ namespace Video {
 class VideoDecoder {
 public:
 	VideoDecoder();
-	virtual ~VideoDecoder() {}
+	virtual ~VideoDecoder();
 
 	/////////////////////////////////////////
 	// Opening/Closing a Video
@@ -396,6 +398,50 @@ public:
 	 */
 	bool setDitheringPalette(const byte *palette);
 
+	/////////////////////////////////////////
+	// Decoding Ahead
+	/////////////////////////////////////////
+
+	/**
+	 * Decode frames ahead of time on a worker thread.
+	 * With a non-zero count, a worker keeps up to that many frames decoded
+	 * in advance, and decodeNextFrame() hands out the oldest of them. Each
+	 * queued frame is a copy of the track's surface, so this costs one
+	 * surface per frame on top of what the decoder already uses.
+	 * The worker starts with the first decodeNextFrame() call. Seeking or
+	 * rewinding throws the queued frames away. Decoding ahead only works
+	 * with a single, forward playing video track; other videos are decoded
+	 * synchronously as before. Off by default. The setting stays in effect
+	 * when loading another video.
+	 * @note While the worker is running, the decoder may only be used through
+	 * the functions of this class.
+	 * @param frames The number of frames to decode ahead, or 0 to turn it off
+	 * @return false if this decoder does not support decoding ahead
+	 */
+	bool setDecodeAhead(uint frames);
+
+	/**
+	 * Get the number of frames that are decoded ahead and ready to be shown.
+	 */
+	uint getDecodeAheadQueueDepth() const;
+
+	/**
+	 * Wait until the given number of frames are decoded ahead, or the worker
+	 * reached the end of the video. Returns right away when not decoding
+	 * ahead.
+	 * @param frames  The queue depth to wait for
+	 * @param timeout The longest time to wait for each frame, in milliseconds
+	 * @return false if the time ran out
+	 */
+	bool waitForDecodeAhead(uint frames, uint32 timeout);
+
+	/**
+	 * Get the number of frames which were not decoded ahead yet when
+	 * decodeNextFrame() was called, so that it had to wait for the worker.
+	 * This is reset by setDecodeAhead().
+	 */
+	uint getDecodeAheadLateFrames() const;
+
 	/////////////////////////////////////////
 	// Audio Control
 	/////////////////////////////////////////
@@ -857,6 +903,13 @@ protected:
 	 */
 	bool endOfVideoTracks() const;
 
+	/**
+	 * Get the name of the file loadFile() is loading. This is for
+	 * loadStream() to look up what is known about the file, e.g. in the
+	 * FrameIndexCache, and is empty when a stream is loaded directly.
+	 */
+	const Common::String &getLoadingFileName() const { return _loadingFileName; }
+
 	/**
 	 * Get the default high color format
 	 */
@@ -913,6 +966,15 @@ protected:
 	 */
 	virtual AudioTrack *getAudioTrack(int index) { return 0; }
 
+	/**
+	 * Can the frames of this video format be decoded on a worker thread?
+	 * This requires that readNextPacket() and the video track's
+	 * decodeNextFrame() only touch the stream and the video and audio
+	 * tracks, and that no other function running alongside them does.
+	 * @see setDecodeAhead()
+	 */
+	virtual bool supportsDecodeAhead() const { return true; }
+
 private:
 	// Tracks owned by this VideoDecoder
 	TrackList _tracks;
@@ -936,6 +998,9 @@ private:
 	// Default PixelFormat settings
 	Graphics::PixelFormat _defaultHighColorFormat;
 
+	// Set by loadFile() while loadStream() runs
+	Common::String _loadingFileName;
+
 	// Internal helper functions
 	void stopAudio();
 	void startAudio();
@@ -950,6 +1015,44 @@ private:
 	int8 _audioBalance;
 
 	AudioTrack *_mainAudioTrack;
+
+	/** A frame decoded ahead, with the state of its track after decoding it */
+	struct DecodeAheadFrame;
+	typedef Common::List<DecodeAheadFrame *> DecodeAheadFrameList;
+
+	// Decoding ahead. While _decodingAhead is set, the worker owns the
+	// track and the state of the frame last shown is in _aheadShown. The
+	// lists, _aheadEnded, _aheadStop and the counters are guarded by
+	// _aheadMutex.
+	uint _aheadLimit;
+	VideoTrack *_aheadTrack;
+	bool _decodingAhead;
+	DecodeAheadFrame *_aheadShown;
+	DecodeAheadFrameList _aheadQueue;
+	DecodeAheadFrameList _aheadFree;
+	bool _aheadEnded;
+	bool _aheadStop;
+	uint _aheadLate;
+	byte _aheadPalette[256 * 3];
+	Common::NativeThread _aheadThread;
+	mutable Common::NativeMutex _aheadMutex;
+	Common::NativeCondition _aheadReadyCond; ///< Signalled when a frame is queued or the worker ends
+	Common::NativeCondition _aheadSpaceCond; ///< Signalled when a frame is taken or the worker should stop
+
+	VideoTrack *findDecodeAheadTrack() const;
+	bool startDecodeAhead();
+	void stopDecodeAheadThread();
+	void flushDecodeAhead();
+	void freeDecodeAhead();
+	const Graphics::Surface *showDecodedAhead();
+	static void decodeAheadThreadProc(void *data);
+	void decodeAhead();
+
+	// The state of a track as seen by the user of the decoder, which lags
+	// behind the track itself while decoding ahead
+	bool trackEnded(const Track *track) const;
+	int getShownFrame(const VideoTrack *track) const;
+	uint32 getShownNextFrameStartTime(const VideoTrack *track) const;
 };
 
 } // End of namespace Video